@@ -35,6 +35,8 @@ namespace reshade::d3d10
 	struct effect_data
 	{
 		com_ptr<ID3D10Buffer> cb;
+		std::vector<com_ptr<ID3D10SamplerState>> sampler_states;
+		std::unordered_map<std::string, com_ptr<IUnknown>> entry_points; // Shader objects, which are created when the first pass using them is initialized
 	};
 
 	struct technique_data
@@ -50,6 +52,30 @@ namespace reshade::d3d10
 
 extern bool is_windows7();
 
+static DXGI_FORMAT convert_compressed_format(reshadefx::texture_format format)
+{
+	// Use typeless formats where possible, so that sRGB views can be created for them
+	switch (format)
+	{
+	case reshadefx::texture_format::bc1:
+		return DXGI_FORMAT_BC1_TYPELESS;
+	case reshadefx::texture_format::bc2:
+		return DXGI_FORMAT_BC2_TYPELESS;
+	case reshadefx::texture_format::bc3:
+		return DXGI_FORMAT_BC3_TYPELESS;
+	case reshadefx::texture_format::bc4:
+		return DXGI_FORMAT_BC4_UNORM;
+	case reshadefx::texture_format::bc5:
+		return DXGI_FORMAT_BC5_UNORM;
+	case reshadefx::texture_format::bc6h:
+		return DXGI_FORMAT_BC6H_UF16;
+	case reshadefx::texture_format::bc7:
+		return DXGI_FORMAT_BC7_TYPELESS;
+	default:
+		return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
 reshade::d3d10::runtime_d3d10::runtime_d3d10(ID3D10Device1 *device, IDXGISwapChain *swapchain, state_tracking *state_tracking) :
 	_app_state(device), _state_tracking(*state_tracking), _device(device), _swapchain(swapchain)
 {
@@ -57,6 +83,13 @@ reshade::d3d10::runtime_d3d10::runtime_d3d10(ID3D10Device1 *device, IDXGISwapCha
 
 	_renderer_id = _device->GetFeatureLevel();
 
+	// Load HLSL compiler up front, since it is used by multiple worker threads concurrently later on
+	_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
+	if (_d3d_compiler == nullptr)
+		_d3d_compiler = LoadLibraryW(L"d3dcompiler_43.dll");
+	if (_d3d_compiler == nullptr)
+		LOG(ERROR) << "Unable to load HLSL compiler (\"d3dcompiler_47.dll\")!" << " Make sure you have the DirectX end-user runtime (June 2010) installed or a newer version of the library in the application directory.";
+
 	if (com_ptr<IDXGIDevice> dxgi_device;
 		SUCCEEDED(_device->QueryInterface(&dxgi_device)))
 	{
@@ -386,134 +419,108 @@ bool reshade::d3d10::runtime_d3d10::capture_screenshot(uint8_t *buffer) const
 	return true;
 }
 
-bool reshade::d3d10::runtime_d3d10::init_effect(size_t index)
+bool reshade::d3d10::runtime_d3d10::compile_entry_point(const effect &effect, const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &assembly, std::string &errors) const
 {
-	if (_d3d_compiler == nullptr)
-		_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
-	if (_d3d_compiler == nullptr)
-		_d3d_compiler = LoadLibraryW(L"d3dcompiler_43.dll");
-
 	if (_d3d_compiler == nullptr)
 	{
-		LOG(ERROR) << "Unable to load HLSL compiler (\"d3dcompiler_47.dll\")!" << " Make sure you have the DirectX end-user runtime (June 2010) installed or a newer version of the library in the application directory.";
+		errors += "Unable to load HLSL compiler (\"d3dcompiler_47.dll\")! Make sure you have the DirectX end-user runtime (June 2010) installed or a newer version of the library in the application directory.\n";
 		return false;
 	}
 
-	effect &effect = _effects[index];
-
 	const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3d_compiler, "D3DCompile"));
 	const auto D3DDisassemble = reinterpret_cast<pD3DDisassemble>(GetProcAddress(_d3d_compiler, "D3DDisassemble"));
 
 	const std::string hlsl = effect.preamble + effect.module.hlsl;
-	std::unordered_map<std::string, com_ptr<IUnknown>> entry_points;
 
-	// Compile the generated HLSL source code to DX byte code
-	for (const reshadefx::entry_point &entry_point : effect.module.entry_points)
+	std::string profile;
+	switch (entry_point.type)
 	{
-		HRESULT hr = E_FAIL;
-
-		std::string profile;
-		switch (entry_point.type)
-		{
-		case reshadefx::shader_type::vs:
-			profile = "vs";
-			break;
-		case reshadefx::shader_type::ps:
-			profile = "ps";
-			break;
-		case reshadefx::shader_type::cs:
-			effect.errors += "Compute shaders are not supported in ";
-			effect.errors += "D3D10";
-			effect.errors += '.';
-			return false;
-		}
+	case reshadefx::shader_type::vs:
+		profile = "vs";
+		break;
+	case reshadefx::shader_type::ps:
+		profile = "ps";
+		break;
+	case reshadefx::shader_type::cs:
+		errors += "Compute shaders are not supported in ";
+		errors += "D3D10";
+		errors += '.';
+		return false;
+	}
 
-		switch (_renderer_id)
-		{
-		case D3D10_FEATURE_LEVEL_10_1:
-			profile += "_4_1";
-			break;
-		default:
-		case D3D10_FEATURE_LEVEL_10_0:
-			profile += "_4_0";
-			break;
-		case D3D10_FEATURE_LEVEL_9_1:
-		case D3D10_FEATURE_LEVEL_9_2:
-			profile += "_4_0_level_9_1";
-			break;
-		case D3D10_FEATURE_LEVEL_9_3:
-			profile += "_4_0_level_9_3";
-			break;
-		}
+	switch (_renderer_id)
+	{
+	case D3D10_FEATURE_LEVEL_10_1:
+		profile += "_4_1";
+		break;
+	default:
+	case D3D10_FEATURE_LEVEL_10_0:
+		profile += "_4_0";
+		break;
+	case D3D10_FEATURE_LEVEL_9_1:
+	case D3D10_FEATURE_LEVEL_9_2:
+		profile += "_4_0_level_9_1";
+		break;
+	case D3D10_FEATURE_LEVEL_9_3:
+		profile += "_4_0_level_9_3";
+		break;
+	}
 
-		UINT compile_flags = D3DCOMPILE_ENABLE_STRICTNESS;
-		compile_flags |= (_performance_mode ? D3DCOMPILE_OPTIMIZATION_LEVEL3 : D3DCOMPILE_OPTIMIZATION_LEVEL1);
+	UINT compile_flags = D3DCOMPILE_ENABLE_STRICTNESS;
+	compile_flags |= (_performance_mode ? D3DCOMPILE_OPTIMIZATION_LEVEL3 : D3DCOMPILE_OPTIMIZATION_LEVEL1);
 #ifndef NDEBUG
-		compile_flags |= D3DCOMPILE_DEBUG;
+	compile_flags |= D3DCOMPILE_DEBUG;
 #endif
 
-		std::string attributes;
-		attributes += "entrypoint=" + entry_point.name + ';';
-		attributes += "profile=" + profile + ';';
-		attributes += "flags=" + std::to_string(compile_flags) + ';';
+	std::string attributes;
+	attributes += "entrypoint=" + entry_point.name + ';';
+	attributes += "profile=" + profile + ';';
+	attributes += "flags=" + std::to_string(compile_flags) + ';';
 
-		const size_t hash = std::hash<std::string_view>()(attributes) ^ std::hash<std::string_view>()(hlsl);
-		std::vector<char> cso;
-		if (!load_effect_cache(effect.source_file, entry_point.name, hash, cso, effect.assembly[entry_point.name]))
-		{
-			com_ptr<ID3DBlob> d3d_compiled, d3d_errors;
-			hr = D3DCompile(
-				hlsl.data(), hlsl.size(),
-				nullptr, nullptr, nullptr,
-				entry_point.name.c_str(),
-				profile.c_str(),
-				compile_flags, 0,
-				&d3d_compiled, &d3d_errors);
-
-			if (d3d_errors != nullptr) // Append warnings to the output error string as well
-				effect.errors.append(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
-
-			// No need to setup resources if any of the shaders failed to compile
-			if (FAILED(hr))
-				return false;
+	const size_t hash = std::hash<std::string_view>()(attributes) ^ std::hash<std::string_view>()(hlsl);
+	if (load_effect_cache(effect.source_file, entry_point.name, hash, cso, assembly))
+		return true;
 
-			cso.resize(d3d_compiled->GetBufferSize());
-			std::memcpy(cso.data(), d3d_compiled->GetBufferPointer(), cso.size());
+	// Compile the generated HLSL source code to DX byte code
+	com_ptr<ID3DBlob> d3d_compiled, d3d_errors;
+	const HRESULT hr = D3DCompile(
+		hlsl.data(), hlsl.size(),
+		nullptr, nullptr, nullptr,
+		entry_point.name.c_str(),
+		profile.c_str(),
+		compile_flags, 0,
+		&d3d_compiled, &d3d_errors);
+
+	if (d3d_errors != nullptr) // Append warnings to the output error string as well
+		errors.append(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
+
+	if (FAILED(hr))
+		return false;
 
-			if (com_ptr<ID3DBlob> d3d_disassembled; SUCCEEDED(D3DDisassemble(cso.data(), cso.size(), 0, nullptr, &d3d_disassembled)))
-				effect.assembly[entry_point.name].assign(static_cast<const char *>(d3d_disassembled->GetBufferPointer()), d3d_disassembled->GetBufferSize() - 1);
+	cso.resize(d3d_compiled->GetBufferSize());
+	std::memcpy(cso.data(), d3d_compiled->GetBufferPointer(), cso.size());
 
-			save_effect_cache(effect.source_file, entry_point.name, hash, cso, effect.assembly[entry_point.name]);
-		}
+	if (com_ptr<ID3DBlob> d3d_disassembled; SUCCEEDED(D3DDisassemble(cso.data(), cso.size(), 0, nullptr, &d3d_disassembled)))
+		assembly.assign(static_cast<const char *>(d3d_disassembled->GetBufferPointer()), d3d_disassembled->GetBufferSize() - 1);
 
-		// Create runtime shader objects from the compiled DX byte code
-		switch (entry_point.type)
-		{
-		case reshadefx::shader_type::vs:
-			hr = _device->CreateVertexShader(cso.data(), cso.size(), reinterpret_cast<ID3D10VertexShader **>(&entry_points[entry_point.name]));
-			break;
-		case reshadefx::shader_type::ps:
-			hr = _device->CreatePixelShader(cso.data(), cso.size(), reinterpret_cast<ID3D10PixelShader **>(&entry_points[entry_point.name]));
-			break;
-		}
+	save_effect_cache(effect.source_file, entry_point.name, hash, cso, assembly);
 
-		if (FAILED(hr))
-		{
-			LOG(ERROR) << "Failed to create shader for entry point '" << entry_point.name << "'! HRESULT is " << hr << '.';
-			return false;
-		}
-	}
+	return true;
+}
 
-	if (index >= _effect_data.size())
-		_effect_data.resize(index + 1);
-	effect_data &effect_data = _effect_data[index];
+bool reshade::d3d10::runtime_d3d10::init_effect(effect &effect)
+{
+	assert(effect.bytecode.size() == effect.module.entry_points.size());
+
+	auto impl = new effect_data();
+	effect.impl = impl;
 
 	if (!effect.uniform_data_storage.empty())
 	{
 		const D3D10_BUFFER_DESC desc = { static_cast<UINT>(effect.uniform_data_storage.size()), D3D10_USAGE_DYNAMIC, D3D10_BIND_CONSTANT_BUFFER, D3D10_CPU_ACCESS_WRITE };
 		const D3D10_SUBRESOURCE_DATA initial_data = { effect.uniform_data_storage.data(), desc.ByteWidth };
 
-		if (HRESULT hr = _device->CreateBuffer(&desc, &initial_data, &effect_data.cb); FAILED(hr))
+		if (HRESULT hr = _device->CreateBuffer(&desc, &initial_data, &impl->cb); FAILED(hr))
 		{
 			LOG(ERROR) << "Failed to create constant buffer for effect file '" << effect.source_file << "'! HRESULT is " << hr << '.';
 			LOG(DEBUG) << "> Details: Width = " << desc.ByteWidth;
@@ -521,8 +528,7 @@ bool reshade::d3d10::runtime_d3d10::init_effect(size_t index)
 		}
 	}
 
-	technique_data technique_init;
-	technique_init.sampler_states.resize(effect.module.num_sampler_bindings);
+	impl->sampler_states.resize(effect.module.num_sampler_bindings);
 	for (const reshadefx::sampler_info &info : effect.module.samplers)
 	{
 		if (info.binding >= D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT)
@@ -531,7 +537,7 @@ bool reshade::d3d10::runtime_d3d10::init_effect(size_t index)
 			return false;
 		}
 
-		if (technique_init.sampler_states[info.binding] == nullptr)
+		if (impl->sampler_states[info.binding] == nullptr)
 		{
 			D3D10_SAMPLER_DESC desc;
 			desc.Filter = static_cast<D3D10_FILTER>(info.filter);
@@ -564,224 +570,254 @@ bool reshade::d3d10::runtime_d3d10::init_effect(size_t index)
 				it = _effect_sampler_states.emplace(desc_hash, std::move(sampler)).first;
 			}
 
-			technique_init.sampler_states[info.binding] = it->second;
+			impl->sampler_states[info.binding] = it->second;
 		}
 	}
 
-	for (technique &technique : _techniques)
-	{
-		if (technique.impl != nullptr || technique.effect_index != index)
-			continue;
+	return true;
+}
+bool reshade::d3d10::runtime_d3d10::init_technique(effect &effect, technique &technique)
+{
+	auto impl = new technique_data();
+	technique.impl = impl;
+
+	// Copy sampler states, since effect may contain multiple techniques
+	impl->sampler_states = static_cast<effect_data *>(effect.impl)->sampler_states;
+
+	D3D10_QUERY_DESC query_desc = {};
+	query_desc.Query = D3D10_QUERY_TIMESTAMP;
+	_device->CreateQuery(&query_desc, &impl->timestamp_query_beg);
+	_device->CreateQuery(&query_desc, &impl->timestamp_query_end);
+	query_desc.Query = D3D10_QUERY_TIMESTAMP_DISJOINT;
+	_device->CreateQuery(&query_desc, &impl->timestamp_disjoint);
+
+	impl->passes.resize(technique.passes.size());
+
+	return true;
+}
+bool reshade::d3d10::runtime_d3d10::init_pass(effect &effect, technique &technique, size_t pass_index)
+{
+	const auto effect_impl = static_cast<effect_data *>(effect.impl);
+	const auto impl = static_cast<technique_data *>(technique.impl);
+
+	// Create runtime shader objects from the compiled DX byte code when they are first used, so that their cost is spread across the passes
+	const auto create_shader = [this, &effect, effect_impl](const std::string &name) -> IUnknown * {
+		if (const auto it = effect_impl->entry_points.find(name); it != effect_impl->entry_points.end())
+			return it->second.get();
 
-		// Copy construct new technique implementation instead of move because effect may contain multiple techniques
-		auto impl = new technique_data(technique_init);
-		technique.impl = impl;
+		const size_t i = std::distance(effect.module.entry_points.begin(), std::find_if(effect.module.entry_points.begin(), effect.module.entry_points.end(),
+			[&name](const reshadefx::entry_point &entry_point) { return entry_point.name == name; }));
+		assert(i < effect.module.entry_points.size());
 
-		D3D10_QUERY_DESC query_desc = {};
-		query_desc.Query = D3D10_QUERY_TIMESTAMP;
-		_device->CreateQuery(&query_desc, &impl->timestamp_query_beg);
-		_device->CreateQuery(&query_desc, &impl->timestamp_query_end);
-		query_desc.Query = D3D10_QUERY_TIMESTAMP_DISJOINT;
-		_device->CreateQuery(&query_desc, &impl->timestamp_disjoint);
+		HRESULT hr = E_FAIL;
+		com_ptr<IUnknown> shader;
+		const std::vector<char> &cso = effect.bytecode[i];
+		const reshadefx::entry_point &entry_point = effect.module.entry_points[i];
 
-		impl->passes.resize(technique.passes.size());
-		for (size_t pass_index = 0; pass_index < technique.passes.size(); ++pass_index)
+		switch (entry_point.type)
 		{
-			pass_data &pass_data = impl->passes[pass_index];
-			reshadefx::pass_info &pass_info = technique.passes[pass_index];
+		case reshadefx::shader_type::vs:
+			hr = _device->CreateVertexShader(cso.data(), cso.size(), reinterpret_cast<ID3D10VertexShader **>(&shader));
+			break;
+		case reshadefx::shader_type::ps:
+			hr = _device->CreatePixelShader(cso.data(), cso.size(), reinterpret_cast<ID3D10PixelShader **>(&shader));
+			break;
+		}
 
-			entry_points.at(pass_info.ps_entry_point)->QueryInterface(&pass_data.pixel_shader);
-			entry_points.at(pass_info.vs_entry_point)->QueryInterface(&pass_data.vertex_shader);
+		if (FAILED(hr))
+		{
+			LOG(ERROR) << "Failed to create shader for entry point '" << entry_point.name << "'! HRESULT is " << hr << '.';
+			return nullptr;
+		}
 
-			const int srgb_index = pass_info.srgb_write_enable ? 1 : 0;
+		return effect_impl->entry_points.emplace(name, std::move(shader)).first->second.get();
+	};
 
-			for (UINT k = 0; k < 8 && !pass_info.render_target_names[k].empty(); ++k)
-			{
-				tex_data *const tex_impl = static_cast<tex_data *>(
-					look_up_texture_by_name(pass_info.render_target_names[k]).impl);
+	pass_data &pass_data = impl->passes[pass_index];
+	reshadefx::pass_info &pass_info = technique.passes[pass_index];
 
-				D3D10_TEXTURE2D_DESC desc;
-				tex_impl->texture->GetDesc(&desc);
+	IUnknown *const ps = create_shader(pass_info.ps_entry_point);
+	IUnknown *const vs = create_shader(pass_info.vs_entry_point);
+	if (ps == nullptr || vs == nullptr)
+		return false;
 
-				D3D10_RENDER_TARGET_VIEW_DESC rtv_desc = {};
-				rtv_desc.Format = pass_info.srgb_write_enable ?
-					make_dxgi_format_srgb(desc.Format) :
-					make_dxgi_format_normal(desc.Format);
-				rtv_desc.ViewDimension = desc.SampleDesc.Count > 1 ? D3D10_RTV_DIMENSION_TEXTURE2DMS : D3D10_RTV_DIMENSION_TEXTURE2D;
+	ps->QueryInterface(&pass_data.pixel_shader);
+	vs->QueryInterface(&pass_data.vertex_shader);
 
-				// Create render target view for texture on demand when it is first used
-				if (tex_impl->rtv[srgb_index] == nullptr)
-				{
-					if (HRESULT hr = _device->CreateRenderTargetView(tex_impl->texture.get(), &rtv_desc, &tex_impl->rtv[srgb_index]); FAILED(hr))
-					{
-						LOG(ERROR) << "Failed to create render target view for texture '" << pass_info.render_target_names[k] << "'! HRESULT is " << hr << '.';
-						LOG(DEBUG) << "> Details: Format = " << rtv_desc.Format << ", ViewDimension = " << rtv_desc.ViewDimension;
-						return false;
-					}
-				}
+	const int srgb_index = pass_info.srgb_write_enable ? 1 : 0;
 
-				pass_data.render_targets[k] = tex_impl->rtv[srgb_index];
-				pass_data.modified_resources.push_back(tex_impl->srv[srgb_index]);
-			}
+	for (UINT k = 0; k < 8 && !pass_info.render_target_names[k].empty(); ++k)
+	{
+		tex_data *const tex_impl = static_cast<tex_data *>(
+			look_up_texture_by_name(pass_info.render_target_names[k]).impl);
 
-			if (pass_info.render_target_names[0].empty())
+		D3D10_TEXTURE2D_DESC desc;
+		tex_impl->texture->GetDesc(&desc);
+
+		D3D10_RENDER_TARGET_VIEW_DESC rtv_desc = {};
+		rtv_desc.Format = pass_info.srgb_write_enable ?
+			make_dxgi_format_srgb(desc.Format) :
+			make_dxgi_format_normal(desc.Format);
+		rtv_desc.ViewDimension = desc.SampleDesc.Count > 1 ? D3D10_RTV_DIMENSION_TEXTURE2DMS : D3D10_RTV_DIMENSION_TEXTURE2D;
+
+		// Create render target view for texture on demand when it is first used
+		if (tex_impl->rtv[srgb_index] == nullptr)
+		{
+			if (HRESULT hr = _device->CreateRenderTargetView(tex_impl->texture.get(), &rtv_desc, &tex_impl->rtv[srgb_index]); FAILED(hr))
 			{
-				pass_info.viewport_width = _width;
-				pass_info.viewport_height = _height;
-				pass_data.render_targets[0] = _backbuffer_rtv[srgb_index];
-				pass_data.modified_resources.push_back(_backbuffer_texture_srv[srgb_index]);
+				LOG(ERROR) << "Failed to create render target view for texture '" << pass_info.render_target_names[k] << "'! HRESULT is " << hr << '.';
+				LOG(DEBUG) << "> Details: Format = " << rtv_desc.Format << ", ViewDimension = " << rtv_desc.ViewDimension;
+				return false;
 			}
+		}
 
-			{   D3D10_BLEND_DESC desc;
-				desc.AlphaToCoverageEnable = FALSE;
-				desc.BlendEnable[0] = pass_info.blend_enable;
-
-				const auto convert_blend_op = [](reshadefx::pass_blend_op value) {
-					switch (value)
-					{
-					default:
-					case reshadefx::pass_blend_op::add: return D3D10_BLEND_OP_ADD;
-					case reshadefx::pass_blend_op::subtract: return D3D10_BLEND_OP_SUBTRACT;
-					case reshadefx::pass_blend_op::rev_subtract: return D3D10_BLEND_OP_REV_SUBTRACT;
-					case reshadefx::pass_blend_op::min: return D3D10_BLEND_OP_MIN;
-					case reshadefx::pass_blend_op::max: return D3D10_BLEND_OP_MAX;
-					}
-				};
-				const auto convert_blend_func = [](reshadefx::pass_blend_func value) {
-					switch (value) {
-					case reshadefx::pass_blend_func::zero: return D3D10_BLEND_ZERO;
-					default:
-					case reshadefx::pass_blend_func::one: return D3D10_BLEND_ONE;
-					case reshadefx::pass_blend_func::src_color: return D3D10_BLEND_SRC_COLOR;
-					case reshadefx::pass_blend_func::src_alpha: return D3D10_BLEND_SRC_ALPHA;
-					case reshadefx::pass_blend_func::inv_src_color: return D3D10_BLEND_INV_SRC_COLOR;
-					case reshadefx::pass_blend_func::inv_src_alpha: return D3D10_BLEND_INV_SRC_ALPHA;
-					case reshadefx::pass_blend_func::dst_color: return D3D10_BLEND_DEST_COLOR;
-					case reshadefx::pass_blend_func::dst_alpha: return D3D10_BLEND_DEST_ALPHA;
-					case reshadefx::pass_blend_func::inv_dst_color: return D3D10_BLEND_INV_DEST_COLOR;
-					case reshadefx::pass_blend_func::inv_dst_alpha: return D3D10_BLEND_INV_DEST_ALPHA;
-					}
-				};
-
-				desc.SrcBlend = convert_blend_func(pass_info.src_blend);
-				desc.DestBlend = convert_blend_func(pass_info.dest_blend);
-				desc.BlendOp = convert_blend_op(pass_info.blend_op);
-				desc.SrcBlendAlpha = convert_blend_func(pass_info.src_blend_alpha);
-				desc.DestBlendAlpha = convert_blend_func(pass_info.dest_blend_alpha);
-				desc.BlendOpAlpha = convert_blend_op(pass_info.blend_op_alpha);
-				desc.RenderTargetWriteMask[0] = pass_info.color_write_mask;
-
-				for (UINT i = 1; i < 8; ++i)
-				{
-					desc.BlendEnable[i] = desc.BlendEnable[0];
-					desc.RenderTargetWriteMask[i] = desc.RenderTargetWriteMask[0];
-				}
+		pass_data.render_targets[k] = tex_impl->rtv[srgb_index];
+		pass_data.modified_resources.push_back(tex_impl->srv[srgb_index]);
+	}
 
-				if (HRESULT hr = _device->CreateBlendState(&desc, &pass_data.blend_state); FAILED(hr))
-				{
-					LOG(ERROR) << "Failed to create blend state for pass " << pass_index << " in technique '" << technique.name << "'! HRESULT is " << hr << '.';
-					return false;
-				}
-			}
+	if (pass_info.render_target_names[0].empty())
+	{
+		pass_info.viewport_width = _width;
+		pass_info.viewport_height = _height;
+		pass_data.render_targets[0] = _backbuffer_rtv[srgb_index];
+		pass_data.modified_resources.push_back(_backbuffer_texture_srv[srgb_index]);
+	}
 
-			// Rasterizer state is the same for all passes
-			assert(_effect_rasterizer != nullptr);
-
-			{   D3D10_DEPTH_STENCIL_DESC desc;
-				desc.DepthEnable = FALSE;
-				desc.DepthWriteMask = D3D10_DEPTH_WRITE_MASK_ZERO;
-				desc.DepthFunc = D3D10_COMPARISON_ALWAYS;
-
-				const auto convert_stencil_op = [](reshadefx::pass_stencil_op value) {
-					switch (value) {
-					case reshadefx::pass_stencil_op::zero: return D3D10_STENCIL_OP_ZERO;
-					default:
-					case reshadefx::pass_stencil_op::keep: return D3D10_STENCIL_OP_KEEP;
-					case reshadefx::pass_stencil_op::invert: return D3D10_STENCIL_OP_INVERT;
-					case reshadefx::pass_stencil_op::replace: return D3D10_STENCIL_OP_REPLACE;
-					case reshadefx::pass_stencil_op::incr: return D3D10_STENCIL_OP_INCR;
-					case reshadefx::pass_stencil_op::incr_sat: return D3D10_STENCIL_OP_INCR_SAT;
-					case reshadefx::pass_stencil_op::decr: return D3D10_STENCIL_OP_DECR;
-					case reshadefx::pass_stencil_op::decr_sat: return D3D10_STENCIL_OP_DECR_SAT;
-					}
-				};
-				const auto convert_stencil_func = [](reshadefx::pass_stencil_func value) {
-					switch (value)
-					{
-					case reshadefx::pass_stencil_func::never: return D3D10_COMPARISON_NEVER;
-					case reshadefx::pass_stencil_func::equal: return D3D10_COMPARISON_EQUAL;
-					case reshadefx::pass_stencil_func::not_equal: return D3D10_COMPARISON_NOT_EQUAL;
-					case reshadefx::pass_stencil_func::less: return D3D10_COMPARISON_LESS;
-					case reshadefx::pass_stencil_func::less_equal: return D3D10_COMPARISON_LESS_EQUAL;
-					case reshadefx::pass_stencil_func::greater: return D3D10_COMPARISON_GREATER;
-					case reshadefx::pass_stencil_func::greater_equal: return D3D10_COMPARISON_GREATER_EQUAL;
-					default:
-					case reshadefx::pass_stencil_func::always: return D3D10_COMPARISON_ALWAYS;
-					}
-				};
-
-				desc.StencilEnable = pass_info.stencil_enable;
-				desc.StencilReadMask = pass_info.stencil_read_mask;
-				desc.StencilWriteMask = pass_info.stencil_write_mask;
-				desc.FrontFace.StencilFailOp = convert_stencil_op(pass_info.stencil_op_fail);
-				desc.FrontFace.StencilDepthFailOp = convert_stencil_op(pass_info.stencil_op_depth_fail);
-				desc.FrontFace.StencilPassOp = convert_stencil_op(pass_info.stencil_op_pass);
-				desc.FrontFace.StencilFunc = convert_stencil_func(pass_info.stencil_comparison_func);
-				desc.BackFace = desc.FrontFace;
-
-				if (HRESULT hr = _device->CreateDepthStencilState(&desc, &pass_data.depth_stencil_state); FAILED(hr))
-				{
-					LOG(ERROR) << "Failed to create depth-stencil state for pass " << pass_index << " in technique '" << technique.name << "'! HRESULT is " << hr << '.';
-					return false;
-				}
-			}
+	{   D3D10_BLEND_DESC desc;
+		desc.AlphaToCoverageEnable = FALSE;
+		desc.BlendEnable[0] = pass_info.blend_enable;
 
-			pass_data.srvs.resize(effect.module.num_texture_bindings);
-			for (const reshadefx::sampler_info &info : pass_info.samplers)
+		const auto convert_blend_op = [](reshadefx::pass_blend_op value) {
+			switch (value)
 			{
-				if (info.texture_binding >= D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
-				{
-					LOG(ERROR) << "Cannot bind texture '" << info.texture_name << "' since it exceeds the maximum number of allowed resource slots in " << "D3D10" << " (" << info.texture_binding << ", allowed are up to " << D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT << ").";
-					return false;
-				}
+			default:
+			case reshadefx::pass_blend_op::add: return D3D10_BLEND_OP_ADD;
+			case reshadefx::pass_blend_op::subtract: return D3D10_BLEND_OP_SUBTRACT;
+			case reshadefx::pass_blend_op::rev_subtract: return D3D10_BLEND_OP_REV_SUBTRACT;
+			case reshadefx::pass_blend_op::min: return D3D10_BLEND_OP_MIN;
+			case reshadefx::pass_blend_op::max: return D3D10_BLEND_OP_MAX;
+			}
+		};
+		const auto convert_blend_func = [](reshadefx::pass_blend_func value) {
+			switch (value) {
+			case reshadefx::pass_blend_func::zero: return D3D10_BLEND_ZERO;
+			default:
+			case reshadefx::pass_blend_func::one: return D3D10_BLEND_ONE;
+			case reshadefx::pass_blend_func::src_color: return D3D10_BLEND_SRC_COLOR;
+			case reshadefx::pass_blend_func::src_alpha: return D3D10_BLEND_SRC_ALPHA;
+			case reshadefx::pass_blend_func::inv_src_color: return D3D10_BLEND_INV_SRC_COLOR;
+			case reshadefx::pass_blend_func::inv_src_alpha: return D3D10_BLEND_INV_SRC_ALPHA;
+			case reshadefx::pass_blend_func::dst_color: return D3D10_BLEND_DEST_COLOR;
+			case reshadefx::pass_blend_func::dst_alpha: return D3D10_BLEND_DEST_ALPHA;
+			case reshadefx::pass_blend_func::inv_dst_color: return D3D10_BLEND_INV_DEST_COLOR;
+			case reshadefx::pass_blend_func::inv_dst_alpha: return D3D10_BLEND_INV_DEST_ALPHA;
+			}
+		};
 
-				tex_data *const tex_impl = static_cast<tex_data *>(
-					look_up_texture_by_name(info.texture_name).impl);
+		desc.SrcBlend = convert_blend_func(pass_info.src_blend);
+		desc.DestBlend = convert_blend_func(pass_info.dest_blend);
+		desc.BlendOp = convert_blend_op(pass_info.blend_op);
+		desc.SrcBlendAlpha = convert_blend_func(pass_info.src_blend_alpha);
+		desc.DestBlendAlpha = convert_blend_func(pass_info.dest_blend_alpha);
+		desc.BlendOpAlpha = convert_blend_op(pass_info.blend_op_alpha);
+		desc.RenderTargetWriteMask[0] = pass_info.color_write_mask;
 
-				pass_data.srvs[info.texture_binding] = tex_impl->srv[info.srgb ? 1 : 0];
+		for (UINT i = 1; i < 8; ++i)
+		{
+			desc.BlendEnable[i] = desc.BlendEnable[0];
+			desc.RenderTargetWriteMask[i] = desc.RenderTargetWriteMask[0];
+		}
+
+		if (HRESULT hr = _device->CreateBlendState(&desc, &pass_data.blend_state); FAILED(hr))
+		{
+			LOG(ERROR) << "Failed to create blend state for pass " << pass_index << " in technique '" << technique.name << "'! HRESULT is " << hr << '.';
+			return false;
+		}
+	}
+
+	// Rasterizer state is the same for all passes
+	assert(_effect_rasterizer != nullptr);
+
+	{   D3D10_DEPTH_STENCIL_DESC desc;
+		desc.DepthEnable = FALSE;
+		desc.DepthWriteMask = D3D10_DEPTH_WRITE_MASK_ZERO;
+		desc.DepthFunc = D3D10_COMPARISON_ALWAYS;
+
+		const auto convert_stencil_op = [](reshadefx::pass_stencil_op value) {
+			switch (value) {
+			case reshadefx::pass_stencil_op::zero: return D3D10_STENCIL_OP_ZERO;
+			default:
+			case reshadefx::pass_stencil_op::keep: return D3D10_STENCIL_OP_KEEP;
+			case reshadefx::pass_stencil_op::invert: return D3D10_STENCIL_OP_INVERT;
+			case reshadefx::pass_stencil_op::replace: return D3D10_STENCIL_OP_REPLACE;
+			case reshadefx::pass_stencil_op::incr: return D3D10_STENCIL_OP_INCR;
+			case reshadefx::pass_stencil_op::incr_sat: return D3D10_STENCIL_OP_INCR_SAT;
+			case reshadefx::pass_stencil_op::decr: return D3D10_STENCIL_OP_DECR;
+			case reshadefx::pass_stencil_op::decr_sat: return D3D10_STENCIL_OP_DECR_SAT;
+			}
+		};
+		const auto convert_stencil_func = [](reshadefx::pass_stencil_func value) {
+			switch (value)
+			{
+			case reshadefx::pass_stencil_func::never: return D3D10_COMPARISON_NEVER;
+			case reshadefx::pass_stencil_func::equal: return D3D10_COMPARISON_EQUAL;
+			case reshadefx::pass_stencil_func::not_equal: return D3D10_COMPARISON_NOT_EQUAL;
+			case reshadefx::pass_stencil_func::less: return D3D10_COMPARISON_LESS;
+			case reshadefx::pass_stencil_func::less_equal: return D3D10_COMPARISON_LESS_EQUAL;
+			case reshadefx::pass_stencil_func::greater: return D3D10_COMPARISON_GREATER;
+			case reshadefx::pass_stencil_func::greater_equal: return D3D10_COMPARISON_GREATER_EQUAL;
+			default:
+			case reshadefx::pass_stencil_func::always: return D3D10_COMPARISON_ALWAYS;
 			}
+		};
+
+		desc.StencilEnable = pass_info.stencil_enable;
+		desc.StencilReadMask = pass_info.stencil_read_mask;
+		desc.StencilWriteMask = pass_info.stencil_write_mask;
+		desc.FrontFace.StencilFailOp = convert_stencil_op(pass_info.stencil_op_fail);
+		desc.FrontFace.StencilDepthFailOp = convert_stencil_op(pass_info.stencil_op_depth_fail);
+		desc.FrontFace.StencilPassOp = convert_stencil_op(pass_info.stencil_op_pass);
+		desc.FrontFace.StencilFunc = convert_stencil_func(pass_info.stencil_comparison_func);
+		desc.BackFace = desc.FrontFace;
+
+		if (HRESULT hr = _device->CreateDepthStencilState(&desc, &pass_data.depth_stencil_state); FAILED(hr))
+		{
+			LOG(ERROR) << "Failed to create depth-stencil state for pass " << pass_index << " in technique '" << technique.name << "'! HRESULT is " << hr << '.';
+			return false;
 		}
 	}
 
-	return true;
-}
-void reshade::d3d10::runtime_d3d10::unload_effect(size_t index)
-{
-	for (technique &tech : _techniques)
+	pass_data.srvs.resize(effect.module.num_texture_bindings);
+	for (const reshadefx::sampler_info &info : pass_info.samplers)
 	{
-		if (tech.effect_index != index)
-			continue;
+		if (info.texture_binding >= D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
+		{
+			LOG(ERROR) << "Cannot bind texture '" << info.texture_name << "' since it exceeds the maximum number of allowed resource slots in " << "D3D10" << " (" << info.texture_binding << ", allowed are up to " << D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT << ").";
+			return false;
+		}
 
-		delete static_cast<technique_data *>(tech.impl);
-		tech.impl = nullptr;
-	}
+		tex_data *const tex_impl = static_cast<tex_data *>(
+			look_up_texture_by_name(info.texture_name).impl);
 
-	runtime::unload_effect(index);
+		pass_data.srvs[info.texture_binding] = tex_impl->srv[info.srgb ? 1 : 0];
+	}
 
-	if (index < _effect_data.size())
-		_effect_data[index].cb.reset();
+	return true;
+}
+void reshade::d3d10::runtime_d3d10::destroy_technique(technique &technique)
+{
+	delete static_cast<technique_data *>(technique.impl);
+	technique.impl = nullptr;
+}
+void reshade::d3d10::runtime_d3d10::destroy_effect(effect &effect)
+{
+	delete static_cast<effect_data *>(effect.impl);
+	effect.impl = nullptr;
 }
 void reshade::d3d10::runtime_d3d10::unload_effects()
 {
-	for (technique &tech : _techniques)
-	{
-		delete static_cast<technique_data *>(tech.impl);
-		tech.impl = nullptr;
-	}
-
 	runtime::unload_effects();
 
-	_effect_data.clear();
 	_effect_sampler_states.clear();
 }
 
@@ -814,9 +850,12 @@ bool reshade::d3d10::runtime_d3d10::init_texture(texture &texture)
 	desc.Usage = D3D10_USAGE_DEFAULT;
 	desc.BindFlags = D3D10_BIND_SHADER_RESOURCE;
 
-	if (texture.levels > 1)
+	// Block-compressed textures are uploaded with all their mipmap levels, so do not need to generate them
+	const bool generate_mips = texture.levels > 1 && texture.compressed_format == reshadefx::texture_format::unknown;
+
+	if (generate_mips)
 		desc.MiscFlags |= D3D10_RESOURCE_MISC_GENERATE_MIPS; // Requires D3D10_BIND_RENDER_TARGET as well
-	if (texture.render_target || texture.levels > 1)
+	if (texture.render_target || generate_mips)
 		desc.BindFlags |= D3D10_BIND_RENDER_TARGET;
 
 	switch (texture.format)
@@ -859,6 +898,10 @@ bool reshade::d3d10::runtime_d3d10::init_texture(texture &texture)
 		break;
 	}
 
+	// Textures whose image file is uploaded as is are created with the block-compressed format of that file instead
+	if (texture.compressed_format != reshadefx::texture_format::unknown)
+		desc.Format = convert_compressed_format(texture.compressed_format);
+
 	// Clear texture to zero since by default its contents are undefined
 	std::vector<uint8_t> zero_data(desc.Width * desc.Height * 16);
 	std::vector<D3D10_SUBRESOURCE_DATA> initial_data(desc.MipLevels);
@@ -943,6 +986,27 @@ void reshade::d3d10::runtime_d3d10::upload_texture(const texture &texture, const
 	if (texture.levels > 1)
 		_device->GenerateMips(impl->srv[0].get());
 }
+void reshade::d3d10::runtime_d3d10::upload_texture_levels(const texture &texture, const uint8_t *data)
+{
+	auto impl = static_cast<tex_data *>(texture.impl);
+	assert(impl != nullptr && texture.semantic.empty() && data != nullptr);
+
+	// Data of all mipmap levels is stored one after another, so just walk through them
+	for (uint32_t level = 0; level < texture.levels; ++level)
+	{
+		const uint32_t row_pitch = texture_row_pitch(texture.storage_format(), std::max(texture.width >> level, 1u));
+		const uint32_t slice_pitch = row_pitch * texture_row_count(texture.storage_format(), std::max(texture.height >> level, 1u));
+
+		_device->UpdateSubresource(impl->texture.get(), level, nullptr, data, row_pitch, slice_pitch);
+
+		data += slice_pitch;
+	}
+}
+bool reshade::d3d10::runtime_d3d10::supports_compressed_format(reshadefx::texture_format format) const
+{
+	UINT support = 0;
+	return SUCCEEDED(_device->CheckFormatSupport(make_dxgi_format_normal(convert_compressed_format(format)), &support)) && (support & D3D10_FORMAT_SUPPORT_TEXTURE2D) != 0;
+}
 void reshade::d3d10::runtime_d3d10::destroy_texture(texture &texture)
 {
 	delete static_cast<tex_data *>(texture.impl);
@@ -952,7 +1016,7 @@ void reshade::d3d10::runtime_d3d10::destroy_texture(texture &texture)
 void reshade::d3d10::runtime_d3d10::render_technique(technique &technique)
 {
 	const auto impl = static_cast<technique_data *>(technique.impl);
-	effect_data &effect_data = _effect_data[technique.effect_index];
+	effect_data &effect_data = *static_cast<struct effect_data *>(_effects[technique.effect_index].impl);
 
 	// Evaluate queries
 	if (impl->query_in_flight)
@@ -990,11 +1054,17 @@ void reshade::d3d10::runtime_d3d10::render_technique(technique &technique)
 	// Setup shader constants
 	if (ID3D10Buffer *const cb = effect_data.cb.get(); cb != nullptr)
 	{
-		if (void *mapped;
-			SUCCEEDED(cb->Map(D3D10_MAP_WRITE_DISCARD, 0, &mapped)))
+		// Mapping with discard requires writing the entire buffer, so either update all or nothing if no values changed
+		if (effect &effect = _effects[technique.effect_index]; !effect.uniform_data_dirty.empty())
 		{
-			std::memcpy(mapped, _effects[technique.effect_index].uniform_data_storage.data(), _effects[technique.effect_index].uniform_data_storage.size());
-			cb->Unmap();
+			if (void *mapped;
+				SUCCEEDED(cb->Map(D3D10_MAP_WRITE_DISCARD, 0, &mapped)))
+			{
+				std::memcpy(mapped, effect.uniform_data_storage.data(), effect.uniform_data_storage.size());
+				cb->Unmap();
+			}
+
+			effect.uniform_data_dirty.clear();
 		}
 
 		_device->VSSetConstantBuffers(0, 1, &cb);
@@ -1455,12 +1525,10 @@ void reshade::d3d10::runtime_d3d10::update_depth_texture_bindings(com_ptr<ID3D10
 			continue;
 		const auto tex_impl = static_cast<tex_data *>(tex.impl);
 
-		// Update references in technique list
-		for (const technique &tech : _techniques)
+		// Update references in technique list (including techniques of effects that are still being created)
+		for (const technique *tech : techniques_with_device_objects())
 		{
-			const auto tech_impl = static_cast<technique_data *>(tech.impl);
-			if (tech_impl == nullptr)
-				continue;
+			const auto tech_impl = static_cast<technique_data *>(tech->impl);
 
 			for (pass_data &pass_data : tech_impl->passes)
 				// Replace all occurances of the old resource view with the new one
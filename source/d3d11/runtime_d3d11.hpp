@@ -24,12 +24,18 @@ namespace reshade::d3d11
 		bool capture_screenshot(uint8_t *buffer) const override;
 
 	private:
-		bool init_effect(size_t index) override;
-		void unload_effect(size_t index) override;
+		bool compile_entry_point(const effect &effect, const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &assembly, std::string &errors) const override;
+		bool init_effect(effect &effect) override;
+		bool init_technique(effect &effect, technique &technique) override;
+		bool init_pass(effect &effect, technique &technique, size_t pass_index) override;
+		void destroy_technique(technique &technique) override;
+		void destroy_effect(effect &effect) override;
 		void unload_effects() override;
 
 		bool init_texture(texture &texture) override;
 		void upload_texture(const texture &texture, const uint8_t *pixels) override;
+		void upload_texture_levels(const texture &texture, const uint8_t *data) override;
+		bool supports_compressed_format(reshadefx::texture_format format) const override;
 		void destroy_texture(texture &texture) override;
 
 		void render_technique(technique &technique) override;
@@ -57,7 +63,6 @@ namespace reshade::d3d11
 		com_ptr<ID3D11RasterizerState> _effect_rasterizer;
 		std::unordered_map<size_t, com_ptr<ID3D11SamplerState>> _effect_sampler_states;
 		com_ptr<ID3D11DepthStencilView> _effect_stencil;
-		std::vector<struct effect_data> _effect_data;
 
 #if RESHADE_GUI
 		bool init_imgui_resources();
@@ -76,6 +76,30 @@ namespace reshade::d3d12
 		transition.Transition.StateAfter = to;
 		list->ResourceBarrier(1, &transition);
 	}
+
+	static DXGI_FORMAT convert_compressed_format(reshadefx::texture_format format)
+	{
+		// Use typeless formats where possible, so that sRGB views can be created for them
+		switch (format)
+		{
+		case reshadefx::texture_format::bc1:
+			return DXGI_FORMAT_BC1_TYPELESS;
+		case reshadefx::texture_format::bc2:
+			return DXGI_FORMAT_BC2_TYPELESS;
+		case reshadefx::texture_format::bc3:
+			return DXGI_FORMAT_BC3_TYPELESS;
+		case reshadefx::texture_format::bc4:
+			return DXGI_FORMAT_BC4_UNORM;
+		case reshadefx::texture_format::bc5:
+			return DXGI_FORMAT_BC5_UNORM;
+		case reshadefx::texture_format::bc6h:
+			return DXGI_FORMAT_BC6H_UF16;
+		case reshadefx::texture_format::bc7:
+			return DXGI_FORMAT_BC7_TYPELESS;
+		default:
+			return DXGI_FORMAT_UNKNOWN;
+		}
+	}
 }
 
 reshade::d3d12::runtime_d3d12::runtime_d3d12(ID3D12Device *device, ID3D12CommandQueue *queue, IDXGISwapChain3 *swapchain, state_tracking_context *state_tracking) :
@@ -85,6 +109,11 @@ reshade::d3d12::runtime_d3d12::runtime_d3d12(ID3D12Device *device, ID3D12Command
 
 	_renderer_id = D3D_FEATURE_LEVEL_12_0;
 
+	// Load HLSL compiler up front, since it is used by multiple worker threads concurrently later on
+	_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
+	if (_d3d_compiler == nullptr)
+		LOG(ERROR) << "Unable to load HLSL compiler (\"d3dcompiler_47.dll\")!";
+
 	// There is no swap chain in d3d12on7
 	if (com_ptr<IDXGIFactory4> factory;
 		_swapchain != nullptr && SUCCEEDED(_swapchain->GetParent(IID_PPV_ARGS(&factory))))
@@ -568,88 +597,82 @@ bool reshade::d3d12::runtime_d3d12::capture_screenshot(uint8_t *buffer) const
 	return true;
 }
 
-bool reshade::d3d12::runtime_d3d12::init_effect(size_t index)
+bool reshade::d3d12::runtime_d3d12::compile_entry_point(const effect &effect, const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &assembly, std::string &errors) const
 {
-	if (_d3d_compiler == nullptr)
-		_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
-
 	if (_d3d_compiler == nullptr)
 	{
-		LOG(ERROR) << "Unable to load HLSL compiler (\"d3dcompiler_47.dll\")!";
+		errors += "Unable to load HLSL compiler (\"d3dcompiler_47.dll\")!\n";
 		return false;
 	}
 
-	effect &effect = _effects[index];
-
 	const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3d_compiler, "D3DCompile"));
 	const auto D3DDisassemble = reinterpret_cast<pD3DDisassemble>(GetProcAddress(_d3d_compiler, "D3DDisassemble"));
 
 	const std::string hlsl = effect.preamble + effect.module.hlsl;
-	std::unordered_map<std::string, std::vector<char>> entry_points;
 
-	// Compile the generated HLSL source code to DX byte code
-	for (const reshadefx::entry_point &entry_point : effect.module.entry_points)
+	std::string profile;
+	switch (entry_point.type)
 	{
-		HRESULT hr = E_FAIL;
-
-		std::string profile;
-		switch (entry_point.type)
-		{
-		case reshadefx::shader_type::vs:
-			profile = "vs_5_0";
-			break;
-		case reshadefx::shader_type::ps:
-			profile = "ps_5_0";
-			break;
-		case reshadefx::shader_type::cs:
-			profile = "cs_5_0";
-			break;
-		}
+	case reshadefx::shader_type::vs:
+		profile = "vs_5_0";
+		break;
+	case reshadefx::shader_type::ps:
+		profile = "ps_5_0";
+		break;
+	case reshadefx::shader_type::cs:
+		profile = "cs_5_0";
+		break;
+	}
 
-		UINT compile_flags = D3DCOMPILE_ENABLE_STRICTNESS;
-		compile_flags |= (_performance_mode ? D3DCOMPILE_OPTIMIZATION_LEVEL3 : D3DCOMPILE_OPTIMIZATION_LEVEL1);
+	UINT compile_flags = D3DCOMPILE_ENABLE_STRICTNESS;
+	compile_flags |= (_performance_mode ? D3DCOMPILE_OPTIMIZATION_LEVEL3 : D3DCOMPILE_OPTIMIZATION_LEVEL1);
 #ifndef NDEBUG
-		compile_flags |= D3DCOMPILE_DEBUG;
+	compile_flags |= D3DCOMPILE_DEBUG;
 #endif
 
-		std::string attributes;
-		attributes += "entrypoint=" + entry_point.name + ';';
-		attributes += "profile=" + profile + ';';
-		attributes += "flags=" + std::to_string(compile_flags) + ';';
+	std::string attributes;
+	attributes += "entrypoint=" + entry_point.name + ';';
+	attributes += "profile=" + profile + ';';
+	attributes += "flags=" + std::to_string(compile_flags) + ';';
 
-		const size_t hash = std::hash<std::string_view>()(attributes) ^ std::hash<std::string_view>()(hlsl);
-		std::vector<char> &cso = entry_points[entry_point.name];
-		if (!load_effect_cache(effect.source_file, entry_point.name, hash, cso, effect.assembly[entry_point.name]))
-		{
-			com_ptr<ID3DBlob> d3d_compiled, d3d_errors;
-			hr = D3DCompile(
-				hlsl.data(), hlsl.size(),
-				nullptr, nullptr, nullptr,
-				entry_point.name.c_str(),
-				profile.c_str(),
-				compile_flags, 0,
-				&d3d_compiled, &d3d_errors);
-
-			if (d3d_errors != nullptr) // Append warnings to the output error string as well
-				effect.errors.append(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
-
-			// No need to setup resources if any of the shaders failed to compile
-			if (FAILED(hr))
-				return false;
+	const size_t hash = std::hash<std::string_view>()(attributes) ^ std::hash<std::string_view>()(hlsl);
+	if (load_effect_cache(effect.source_file, entry_point.name, hash, cso, assembly))
+		return true;
 
-			cso.resize(d3d_compiled->GetBufferSize());
-			std::memcpy(cso.data(), d3d_compiled->GetBufferPointer(), cso.size());
+	// Compile the generated HLSL source code to DX byte code
+	com_ptr<ID3DBlob> d3d_compiled, d3d_errors;
+	const HRESULT hr = D3DCompile(
+		hlsl.data(), hlsl.size(),
+		nullptr, nullptr, nullptr,
+		entry_point.name.c_str(),
+		profile.c_str(),
+		compile_flags, 0,
+		&d3d_compiled, &d3d_errors);
+
+	if (d3d_errors != nullptr) // Append warnings to the output error string as well
+		errors.append(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
+
+	if (FAILED(hr))
+		return false;
 
-			if (com_ptr<ID3DBlob> d3d_disassembled; SUCCEEDED(D3DDisassemble(cso.data(), cso.size(), 0, nullptr, &d3d_disassembled)))
-				effect.assembly[entry_point.name].assign(static_cast<const char *>(d3d_disassembled->GetBufferPointer()), d3d_disassembled->GetBufferSize() - 1);
+	cso.resize(d3d_compiled->GetBufferSize());
+	std::memcpy(cso.data(), d3d_compiled->GetBufferPointer(), cso.size());
 
-			save_effect_cache(effect.source_file, entry_point.name, hash, cso, effect.assembly[entry_point.name]);
-		}
-	}
+	if (com_ptr<ID3DBlob> d3d_disassembled; SUCCEEDED(D3DDisassemble(cso.data(), cso.size(), 0, nullptr, &d3d_disassembled)))
+		assembly.assign(static_cast<const char *>(d3d_disassembled->GetBufferPointer()), d3d_disassembled->GetBufferSize() - 1);
+
+	save_effect_cache(effect.source_file, entry_point.name, hash, cso, assembly);
+
+	return true;
+}
+
+bool reshade::d3d12::runtime_d3d12::init_effect(effect &effect)
+{
+	assert(effect.bytecode.size() == effect.module.entry_points.size());
 
-	if (index >= _effect_data.size())
-		_effect_data.resize(index + 1);
-	effect_data &effect_data = _effect_data[index];
+	auto impl = new effect_data();
+	effect.impl = impl;
+	effect_data &effect_data = *impl;
 
 	{   D3D12_DESCRIPTOR_RANGE srv_range = {};
 		srv_range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
@@ -792,333 +815,320 @@ bool reshade::d3d12::runtime_d3d12::init_effect(size_t index)
 		}
 	}
 
-	// The render target descriptor table is shared across all techniques in the effect
+	return true;
+}
+bool reshade::d3d12::runtime_d3d12::init_technique(effect &, technique &technique)
+{
+	auto impl = new technique_data();
+	technique.impl = impl;
+
+	impl->passes.resize(technique.passes.size());
+
+	return true;
+}
+bool reshade::d3d12::runtime_d3d12::init_pass(effect &effect, technique &technique, size_t pass_index)
+{
+	effect_data &effect_data = *static_cast<struct effect_data *>(effect.impl);
+	const auto impl = static_cast<technique_data *>(technique.impl);
+
+	// Byte code was already compiled on the worker threads, so only need to look it up by name when building the pipeline below
+	const auto entry_point_bytecode = [&effect](const std::string &name) -> const std::vector<char> & {
+		const size_t i = std::distance(effect.module.entry_points.begin(), std::find_if(effect.module.entry_points.begin(), effect.module.entry_points.end(),
+			[&name](const reshadefx::entry_point &entry_point) { return entry_point.name == name; }));
+		assert(i < effect.module.entry_points.size());
+		return effect.bytecode[i];
+	};
+
+	// The descriptor heaps of the effect have a range for every pass, in the order the techniques and passes appear in the effect module
+	UINT pass_offset = static_cast<UINT>(pass_index);
+	for (size_t i = 0; i < technique.module_index; ++i)
+		pass_offset += static_cast<UINT>(effect.module.techniques[i].passes.size());
+
 	D3D12_GPU_DESCRIPTOR_HANDLE srv_gpu_base = effect_data.srv_gpu_base;
+	srv_gpu_base.ptr += effect.module.num_texture_bindings * pass_offset * _srv_handle_size;
 	D3D12_CPU_DESCRIPTOR_HANDLE srv_cpu_base = effect_data.srv_cpu_base;
+	srv_cpu_base.ptr += effect.module.num_texture_bindings * pass_offset * _srv_handle_size;
 	D3D12_GPU_DESCRIPTOR_HANDLE uav_gpu_base = effect_data.uav_gpu_base;
+	uav_gpu_base.ptr += effect.module.num_storage_bindings * pass_offset * _srv_handle_size;
 	D3D12_CPU_DESCRIPTOR_HANDLE uav_cpu_base = effect_data.uav_cpu_base;
+	uav_cpu_base.ptr += effect.module.num_storage_bindings * pass_offset * _srv_handle_size;
 	D3D12_CPU_DESCRIPTOR_HANDLE rtv_cpu_base = effect_data.rtv_cpu_base;
+	rtv_cpu_base.ptr += 8 * pass_offset * _rtv_handle_size;
 
-	for (technique &technique : _techniques)
-	{
-		if (technique.impl != nullptr || technique.effect_index != index)
-			continue;
+	pass_data &pass_data = impl->passes[pass_index];
+	reshadefx::pass_info &pass_info = technique.passes[pass_index];
 
-		auto impl = new technique_data();
-		technique.impl = impl;
+	if (!pass_info.cs_entry_point.empty())
+	{
+		impl->has_compute_passes = true;
 
-		impl->passes.resize(technique.passes.size());
-		for (size_t pass_index = 0; pass_index < technique.passes.size(); ++pass_index)
-		{
-			pass_data &pass_data = impl->passes[pass_index];
-			reshadefx::pass_info &pass_info = technique.passes[pass_index];
+		D3D12_COMPUTE_PIPELINE_STATE_DESC pso_desc = {};
+		pso_desc.pRootSignature = effect_data.signature.get();
 
-			if (!pass_info.cs_entry_point.empty())
-			{
-				impl->has_compute_passes = true;
+		const auto &CS = entry_point_bytecode(pass_info.cs_entry_point);
+		pso_desc.CS = { CS.data(), CS.size() };
 
-				D3D12_COMPUTE_PIPELINE_STATE_DESC pso_desc = {};
-				pso_desc.pRootSignature = effect_data.signature.get();
+		pso_desc.NodeMask = 1;
 
-				const auto &CS = entry_points.at(pass_info.cs_entry_point);
-				pso_desc.CS = { CS.data(), CS.size() };
+		if (HRESULT hr = _device->CreateComputePipelineState(&pso_desc, IID_PPV_ARGS(&pass_data.pipeline)); FAILED(hr))
+		{
+			LOG(ERROR) << "Failed to create compute pipeline for pass " << pass_index << " in technique '" << technique.name << "'! HRESULT is " << hr << '.';
+			return false;
+		}
+	}
+	else
+	{
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC pso_desc = {};
+		pso_desc.pRootSignature = effect_data.signature.get();
 
-				pso_desc.NodeMask = 1;
+		const auto &VS = entry_point_bytecode(pass_info.vs_entry_point);
+		pso_desc.VS = { VS.data(), VS.size() };
+		const auto &PS = entry_point_bytecode(pass_info.ps_entry_point);
+		pso_desc.PS = { PS.data(), PS.size() };
 
-				if (HRESULT hr = _device->CreateComputePipelineState(&pso_desc, IID_PPV_ARGS(&pass_data.pipeline)); FAILED(hr))
-				{
-					LOG(ERROR) << "Failed to create compute pipeline for pass " << pass_index << " in technique '" << technique.name << "'! HRESULT is " << hr << '.';
-					return false;
-				}
-			}
-			else
-			{
-				D3D12_GRAPHICS_PIPELINE_STATE_DESC pso_desc = {};
-				pso_desc.pRootSignature = effect_data.signature.get();
+		// Keep track of the base handle, which is followed by a contiguous range of render target descriptors
+		pass_data.render_targets = rtv_cpu_base;
 
-				const auto &VS = entry_points.at(pass_info.vs_entry_point);
-				pso_desc.VS = { VS.data(), VS.size() };
-				const auto &PS = entry_points.at(pass_info.ps_entry_point);
-				pso_desc.PS = { PS.data(), PS.size() };
+		for (UINT k = 0; k < 8 && !pass_info.render_target_names[k].empty(); ++k)
+		{
+			tex_data *const tex_impl = static_cast<tex_data *>(
+				look_up_texture_by_name(pass_info.render_target_names[k]).impl);
 
-				// Keep track of the base handle, which is followed by a contiguous range of render target descriptors
-				pass_data.render_targets = rtv_cpu_base;
-				rtv_cpu_base.ptr += 8 * _rtv_handle_size;
+			pass_data.modified_resources.push_back(tex_impl);
 
-				for (UINT k = 0; k < 8 && !pass_info.render_target_names[k].empty(); ++k)
-				{
-					tex_data *const tex_impl = static_cast<tex_data *>(
-						look_up_texture_by_name(pass_info.render_target_names[k]).impl);
+			const D3D12_RESOURCE_DESC desc = tex_impl->resource->GetDesc();
 
-					pass_data.modified_resources.push_back(tex_impl);
+			D3D12_CPU_DESCRIPTOR_HANDLE rtv_handle = pass_data.render_targets;
+			rtv_handle.ptr += k * _rtv_handle_size;
 
-					const D3D12_RESOURCE_DESC desc = tex_impl->resource->GetDesc();
+			D3D12_RENDER_TARGET_VIEW_DESC rtv_desc = {};
+			rtv_desc.Format = pass_info.srgb_write_enable ?
+				make_dxgi_format_srgb(desc.Format) :
+				make_dxgi_format_normal(desc.Format);
+			rtv_desc.ViewDimension = desc.SampleDesc.Count > 1 ? D3D12_RTV_DIMENSION_TEXTURE2DMS : D3D12_RTV_DIMENSION_TEXTURE2D;
 
-					D3D12_CPU_DESCRIPTOR_HANDLE rtv_handle = pass_data.render_targets;
-					rtv_handle.ptr += k * _rtv_handle_size;
+			_device->CreateRenderTargetView(tex_impl->resource.get(), &rtv_desc, rtv_handle);
 
-					D3D12_RENDER_TARGET_VIEW_DESC rtv_desc = {};
-					rtv_desc.Format = pass_info.srgb_write_enable ?
-						make_dxgi_format_srgb(desc.Format) :
-						make_dxgi_format_normal(desc.Format);
-					rtv_desc.ViewDimension = desc.SampleDesc.Count > 1 ? D3D12_RTV_DIMENSION_TEXTURE2DMS : D3D12_RTV_DIMENSION_TEXTURE2D;
+			pso_desc.NumRenderTargets = pass_data.num_render_targets = k + 1;
+			pso_desc.RTVFormats[k] = rtv_desc.Format;
+		}
 
-					_device->CreateRenderTargetView(tex_impl->resource.get(), &rtv_desc, rtv_handle);
+		if (pass_info.render_target_names[0].empty())
+		{
+			pso_desc.NumRenderTargets = 1;
+			pso_desc.RTVFormats[0] = pass_info.srgb_write_enable ?
+				make_dxgi_format_srgb(_backbuffer_format) :
+				make_dxgi_format_normal(_backbuffer_format);
 
-					pso_desc.NumRenderTargets = pass_data.num_render_targets = k + 1;
-					pso_desc.RTVFormats[k] = rtv_desc.Format;
-				}
+			pass_info.viewport_width = _width;
+			pass_info.viewport_height = _height;
+		}
 
-				if (pass_info.render_target_names[0].empty())
-				{
-					pso_desc.NumRenderTargets = 1;
-					pso_desc.RTVFormats[0] = pass_info.srgb_write_enable ?
-						make_dxgi_format_srgb(_backbuffer_format) :
-						make_dxgi_format_normal(_backbuffer_format);
+		pso_desc.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		pso_desc.SampleMask = UINT_MAX;
+		pso_desc.SampleDesc = { 1, 0 };
+		pso_desc.NodeMask = 1;
 
-					pass_info.viewport_width = _width;
-					pass_info.viewport_height = _height;
-				}
+		switch (pass_info.topology)
+		{
+		case reshadefx::primitive_topology::point_list:
+			pso_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT;
+			break;
+		case reshadefx::primitive_topology::line_list:
+		case reshadefx::primitive_topology::line_strip:
+			pso_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE;
+			break;
+		case reshadefx::primitive_topology::triangle_list:
+		case reshadefx::primitive_topology::triangle_strip:
+			pso_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+			break;
+		}
 
-				pso_desc.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
-				pso_desc.SampleMask = UINT_MAX;
-				pso_desc.SampleDesc = { 1, 0 };
-				pso_desc.NodeMask = 1;
+		{   D3D12_BLEND_DESC &desc = pso_desc.BlendState;
+			desc.AlphaToCoverageEnable = FALSE;
+			desc.IndependentBlendEnable = FALSE;
+			desc.RenderTarget[0].BlendEnable = pass_info.blend_enable;
 
-				switch (pass_info.topology)
+			const auto convert_blend_op = [](reshadefx::pass_blend_op value) {
+				switch (value)
 				{
-				case reshadefx::primitive_topology::point_list:
-					pso_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT;
-					break;
-				case reshadefx::primitive_topology::line_list:
-				case reshadefx::primitive_topology::line_strip:
-					pso_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE;
-					break;
-				case reshadefx::primitive_topology::triangle_list:
-				case reshadefx::primitive_topology::triangle_strip:
-					pso_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-					break;
+				default:
+				case reshadefx::pass_blend_op::add: return D3D12_BLEND_OP_ADD;
+				case reshadefx::pass_blend_op::subtract: return D3D12_BLEND_OP_SUBTRACT;
+				case reshadefx::pass_blend_op::rev_subtract: return D3D12_BLEND_OP_REV_SUBTRACT;
+				case reshadefx::pass_blend_op::min: return D3D12_BLEND_OP_MIN;
+				case reshadefx::pass_blend_op::max: return D3D12_BLEND_OP_MAX;
 				}
-
-				{   D3D12_BLEND_DESC &desc = pso_desc.BlendState;
-					desc.AlphaToCoverageEnable = FALSE;
-					desc.IndependentBlendEnable = FALSE;
-					desc.RenderTarget[0].BlendEnable = pass_info.blend_enable;
-
-					const auto convert_blend_op = [](reshadefx::pass_blend_op value) {
-						switch (value)
-						{
-						default:
-						case reshadefx::pass_blend_op::add: return D3D12_BLEND_OP_ADD;
-						case reshadefx::pass_blend_op::subtract: return D3D12_BLEND_OP_SUBTRACT;
-						case reshadefx::pass_blend_op::rev_subtract: return D3D12_BLEND_OP_REV_SUBTRACT;
-						case reshadefx::pass_blend_op::min: return D3D12_BLEND_OP_MIN;
-						case reshadefx::pass_blend_op::max: return D3D12_BLEND_OP_MAX;
-						}
-					};
-					const auto convert_blend_func = [](reshadefx::pass_blend_func value) {
-						switch (value) {
-						case reshadefx::pass_blend_func::zero: return D3D12_BLEND_ZERO;
-						default:
-						case reshadefx::pass_blend_func::one: return D3D12_BLEND_ONE;
-						case reshadefx::pass_blend_func::src_color: return D3D12_BLEND_SRC_COLOR;
-						case reshadefx::pass_blend_func::src_alpha: return D3D12_BLEND_SRC_ALPHA;
-						case reshadefx::pass_blend_func::inv_src_color: return D3D12_BLEND_INV_SRC_COLOR;
-						case reshadefx::pass_blend_func::inv_src_alpha: return D3D12_BLEND_INV_SRC_ALPHA;
-						case reshadefx::pass_blend_func::dst_color: return D3D12_BLEND_DEST_COLOR;
-						case reshadefx::pass_blend_func::dst_alpha: return D3D12_BLEND_DEST_ALPHA;
-						case reshadefx::pass_blend_func::inv_dst_color: return D3D12_BLEND_INV_DEST_COLOR;
-						case reshadefx::pass_blend_func::inv_dst_alpha: return D3D12_BLEND_INV_DEST_ALPHA;
-						}
-					};
-
-					desc.RenderTarget[0].SrcBlend = convert_blend_func(pass_info.src_blend);
-					desc.RenderTarget[0].DestBlend = convert_blend_func(pass_info.dest_blend);
-					desc.RenderTarget[0].BlendOp = convert_blend_op(pass_info.blend_op);
-					desc.RenderTarget[0].SrcBlendAlpha = convert_blend_func(pass_info.src_blend_alpha);
-					desc.RenderTarget[0].DestBlendAlpha = convert_blend_func(pass_info.dest_blend_alpha);
-					desc.RenderTarget[0].BlendOpAlpha = convert_blend_op(pass_info.blend_op_alpha);
-					desc.RenderTarget[0].RenderTargetWriteMask = pass_info.color_write_mask;
+			};
+			const auto convert_blend_func = [](reshadefx::pass_blend_func value) {
+				switch (value) {
+				case reshadefx::pass_blend_func::zero: return D3D12_BLEND_ZERO;
+				default:
+				case reshadefx::pass_blend_func::one: return D3D12_BLEND_ONE;
+				case reshadefx::pass_blend_func::src_color: return D3D12_BLEND_SRC_COLOR;
+				case reshadefx::pass_blend_func::src_alpha: return D3D12_BLEND_SRC_ALPHA;
+				case reshadefx::pass_blend_func::inv_src_color: return D3D12_BLEND_INV_SRC_COLOR;
+				case reshadefx::pass_blend_func::inv_src_alpha: return D3D12_BLEND_INV_SRC_ALPHA;
+				case reshadefx::pass_blend_func::dst_color: return D3D12_BLEND_DEST_COLOR;
+				case reshadefx::pass_blend_func::dst_alpha: return D3D12_BLEND_DEST_ALPHA;
+				case reshadefx::pass_blend_func::inv_dst_color: return D3D12_BLEND_INV_DEST_COLOR;
+				case reshadefx::pass_blend_func::inv_dst_alpha: return D3D12_BLEND_INV_DEST_ALPHA;
 				}
+			};
 
-				{   D3D12_RASTERIZER_DESC &desc = pso_desc.RasterizerState;
-					desc.FillMode = D3D12_FILL_MODE_SOLID;
-					desc.CullMode = D3D12_CULL_MODE_NONE;
-					desc.DepthClipEnable = TRUE;
-				}
+			desc.RenderTarget[0].SrcBlend = convert_blend_func(pass_info.src_blend);
+			desc.RenderTarget[0].DestBlend = convert_blend_func(pass_info.dest_blend);
+			desc.RenderTarget[0].BlendOp = convert_blend_op(pass_info.blend_op);
+			desc.RenderTarget[0].SrcBlendAlpha = convert_blend_func(pass_info.src_blend_alpha);
+			desc.RenderTarget[0].DestBlendAlpha = convert_blend_func(pass_info.dest_blend_alpha);
+			desc.RenderTarget[0].BlendOpAlpha = convert_blend_op(pass_info.blend_op_alpha);
+			desc.RenderTarget[0].RenderTargetWriteMask = pass_info.color_write_mask;
+		}
 
-				{   D3D12_DEPTH_STENCIL_DESC &desc = pso_desc.DepthStencilState;
-					desc.DepthEnable = FALSE;
-					desc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
-					desc.DepthFunc = D3D12_COMPARISON_FUNC_ALWAYS;
-
-					const auto convert_stencil_op = [](reshadefx::pass_stencil_op value) {
-						switch (value) {
-						case reshadefx::pass_stencil_op::zero: return D3D12_STENCIL_OP_ZERO;
-						default:
-						case reshadefx::pass_stencil_op::keep: return D3D12_STENCIL_OP_KEEP;
-						case reshadefx::pass_stencil_op::invert: return D3D12_STENCIL_OP_INVERT;
-						case reshadefx::pass_stencil_op::replace: return D3D12_STENCIL_OP_REPLACE;
-						case reshadefx::pass_stencil_op::incr: return D3D12_STENCIL_OP_INCR;
-						case reshadefx::pass_stencil_op::incr_sat: return D3D12_STENCIL_OP_INCR_SAT;
-						case reshadefx::pass_stencil_op::decr: return D3D12_STENCIL_OP_DECR;
-						case reshadefx::pass_stencil_op::decr_sat: return D3D12_STENCIL_OP_DECR_SAT;
-						}
-					};
-					const auto convert_stencil_func = [](reshadefx::pass_stencil_func value) {
-						switch (value)
-						{
-						case reshadefx::pass_stencil_func::never: return D3D12_COMPARISON_FUNC_NEVER;
-						case reshadefx::pass_stencil_func::equal: return D3D12_COMPARISON_FUNC_EQUAL;
-						case reshadefx::pass_stencil_func::not_equal: return D3D12_COMPARISON_FUNC_NOT_EQUAL;
-						case reshadefx::pass_stencil_func::less: return D3D12_COMPARISON_FUNC_LESS;
-						case reshadefx::pass_stencil_func::less_equal: return D3D12_COMPARISON_FUNC_LESS_EQUAL;
-						case reshadefx::pass_stencil_func::greater: return D3D12_COMPARISON_FUNC_GREATER;
-						case reshadefx::pass_stencil_func::greater_equal: return D3D12_COMPARISON_FUNC_GREATER_EQUAL;
-						default:
-						case reshadefx::pass_stencil_func::always: return D3D12_COMPARISON_FUNC_ALWAYS;
-						}
-					};
-
-					desc.StencilEnable = pass_info.stencil_enable;
-					desc.StencilReadMask = pass_info.stencil_read_mask;
-					desc.StencilWriteMask = pass_info.stencil_write_mask;
-					desc.FrontFace.StencilFailOp = convert_stencil_op(pass_info.stencil_op_fail);
-					desc.FrontFace.StencilDepthFailOp = convert_stencil_op(pass_info.stencil_op_depth_fail);
-					desc.FrontFace.StencilPassOp = convert_stencil_op(pass_info.stencil_op_pass);
-					desc.FrontFace.StencilFunc = convert_stencil_func(pass_info.stencil_comparison_func);
-					desc.BackFace = desc.FrontFace;
-				}
+		{   D3D12_RASTERIZER_DESC &desc = pso_desc.RasterizerState;
+			desc.FillMode = D3D12_FILL_MODE_SOLID;
+			desc.CullMode = D3D12_CULL_MODE_NONE;
+			desc.DepthClipEnable = TRUE;
+		}
 
-				if (HRESULT hr = _device->CreateGraphicsPipelineState(&pso_desc, IID_PPV_ARGS(&pass_data.pipeline)); FAILED(hr))
-				{
-					LOG(ERROR) << "Failed to create graphics pipeline for pass " << pass_index << " in technique '" << technique.name << "'! HRESULT is " << hr << '.';
-					return false;
+		{   D3D12_DEPTH_STENCIL_DESC &desc = pso_desc.DepthStencilState;
+			desc.DepthEnable = FALSE;
+			desc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+			desc.DepthFunc = D3D12_COMPARISON_FUNC_ALWAYS;
+
+			const auto convert_stencil_op = [](reshadefx::pass_stencil_op value) {
+				switch (value) {
+				case reshadefx::pass_stencil_op::zero: return D3D12_STENCIL_OP_ZERO;
+				default:
+				case reshadefx::pass_stencil_op::keep: return D3D12_STENCIL_OP_KEEP;
+				case reshadefx::pass_stencil_op::invert: return D3D12_STENCIL_OP_INVERT;
+				case reshadefx::pass_stencil_op::replace: return D3D12_STENCIL_OP_REPLACE;
+				case reshadefx::pass_stencil_op::incr: return D3D12_STENCIL_OP_INCR;
+				case reshadefx::pass_stencil_op::incr_sat: return D3D12_STENCIL_OP_INCR_SAT;
+				case reshadefx::pass_stencil_op::decr: return D3D12_STENCIL_OP_DECR;
+				case reshadefx::pass_stencil_op::decr_sat: return D3D12_STENCIL_OP_DECR_SAT;
 				}
-			}
-
-			pass_data.srv_handle = srv_gpu_base;
-			for (const reshadefx::sampler_info &info : pass_info.samplers)
-			{
-				if (info.texture_binding >= D3D12_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
+			};
+			const auto convert_stencil_func = [](reshadefx::pass_stencil_func value) {
+				switch (value)
 				{
-					LOG(ERROR) << "Cannot bind texture '" << info.texture_name << "' since it exceeds the maximum number of allowed resource slots in " << "D3D12" << " (" << info.texture_binding << ", allowed are up to " << D3D12_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT << ").";
-					return false;
+				case reshadefx::pass_stencil_func::never: return D3D12_COMPARISON_FUNC_NEVER;
+				case reshadefx::pass_stencil_func::equal: return D3D12_COMPARISON_FUNC_EQUAL;
+				case reshadefx::pass_stencil_func::not_equal: return D3D12_COMPARISON_FUNC_NOT_EQUAL;
+				case reshadefx::pass_stencil_func::less: return D3D12_COMPARISON_FUNC_LESS;
+				case reshadefx::pass_stencil_func::less_equal: return D3D12_COMPARISON_FUNC_LESS_EQUAL;
+				case reshadefx::pass_stencil_func::greater: return D3D12_COMPARISON_FUNC_GREATER;
+				case reshadefx::pass_stencil_func::greater_equal: return D3D12_COMPARISON_FUNC_GREATER_EQUAL;
+				default:
+				case reshadefx::pass_stencil_func::always: return D3D12_COMPARISON_FUNC_ALWAYS;
 				}
+			};
+
+			desc.StencilEnable = pass_info.stencil_enable;
+			desc.StencilReadMask = pass_info.stencil_read_mask;
+			desc.StencilWriteMask = pass_info.stencil_write_mask;
+			desc.FrontFace.StencilFailOp = convert_stencil_op(pass_info.stencil_op_fail);
+			desc.FrontFace.StencilDepthFailOp = convert_stencil_op(pass_info.stencil_op_depth_fail);
+			desc.FrontFace.StencilPassOp = convert_stencil_op(pass_info.stencil_op_pass);
+			desc.FrontFace.StencilFunc = convert_stencil_func(pass_info.stencil_comparison_func);
+			desc.BackFace = desc.FrontFace;
+		}
+
+		if (HRESULT hr = _device->CreateGraphicsPipelineState(&pso_desc, IID_PPV_ARGS(&pass_data.pipeline)); FAILED(hr))
+		{
+			LOG(ERROR) << "Failed to create graphics pipeline for pass " << pass_index << " in technique '" << technique.name << "'! HRESULT is " << hr << '.';
+			return false;
+		}
+	}
 
-				const texture &texture = look_up_texture_by_name(info.texture_name);
+	pass_data.srv_handle = srv_gpu_base;
+	for (const reshadefx::sampler_info &info : pass_info.samplers)
+	{
+		if (info.texture_binding >= D3D12_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
+		{
+			LOG(ERROR) << "Cannot bind texture '" << info.texture_name << "' since it exceeds the maximum number of allowed resource slots in " << "D3D12" << " (" << info.texture_binding << ", allowed are up to " << D3D12_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT << ").";
+			return false;
+		}
 
-				D3D12_CPU_DESCRIPTOR_HANDLE srv_handle = srv_cpu_base;
-				srv_handle.ptr += info.texture_binding * _srv_handle_size;
+		const texture &texture = look_up_texture_by_name(info.texture_name);
 
-				com_ptr<ID3D12Resource> resource = static_cast<tex_data *>(texture.impl)->resource;
-				if (texture.semantic == "COLOR")
-				{
-					resource = _backbuffer_texture;
-				}
+		D3D12_CPU_DESCRIPTOR_HANDLE srv_handle = srv_cpu_base;
+		srv_handle.ptr += info.texture_binding * _srv_handle_size;
+
+		com_ptr<ID3D12Resource> resource = static_cast<tex_data *>(texture.impl)->resource;
+		if (texture.semantic == "COLOR")
+		{
+			resource = _backbuffer_texture;
+		}
 #if RESHADE_DEPTH
-				if (texture.semantic == "DEPTH")
-				{
-					resource = _depth_texture; // Note: This can be a "nullptr"
-					// Keep track of the depth buffer texture descriptors of each pass to simplify updating it
-					effect_data.depth_texture_bindings.push_back(srv_handle);
-				}
+		if (texture.semantic == "DEPTH")
+		{
+			resource = _depth_texture; // Note: This can be a "nullptr"
+			// Keep track of the depth buffer texture descriptors of each pass to simplify updating it
+			effect_data.depth_texture_bindings.push_back(srv_handle);
+		}
 #endif
 
-				if (resource != nullptr)
-				{
-					D3D12_SHADER_RESOURCE_VIEW_DESC desc = {};
-					desc.Format = info.srgb ?
-						make_dxgi_format_srgb(resource->GetDesc().Format) :
-						make_dxgi_format_normal(resource->GetDesc().Format);
-					desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-					desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-					desc.Texture2D.MipLevels = texture.levels;
-
-					_device->CreateShaderResourceView(resource.get(), &desc, srv_handle);
-				}
-			}
-			srv_cpu_base.ptr += effect.module.num_texture_bindings * _srv_handle_size;
-			srv_gpu_base.ptr += effect.module.num_texture_bindings * _srv_handle_size;
+		if (resource != nullptr)
+		{
+			D3D12_SHADER_RESOURCE_VIEW_DESC desc = {};
+			desc.Format = info.srgb ?
+				make_dxgi_format_srgb(resource->GetDesc().Format) :
+				make_dxgi_format_normal(resource->GetDesc().Format);
+			desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+			desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+			desc.Texture2D.MipLevels = texture.levels;
+
+			_device->CreateShaderResourceView(resource.get(), &desc, srv_handle);
+		}
+	}
 
-			pass_data.uav_handle = uav_gpu_base;
-			for (const reshadefx::storage_info &info : pass_info.storages)
-			{
-				if (info.binding >= D3D12_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
-				{
-					LOG(ERROR) << "Cannot bind storage '" << info.unique_name << "' since it exceeds the maximum number of allowed resource slots in " << "D3D12" << " (" << info.binding << ", allowed are up to " << D3D12_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT << ").";
-					return false;
-				}
+	pass_data.uav_handle = uav_gpu_base;
+	for (const reshadefx::storage_info &info : pass_info.storages)
+	{
+		if (info.binding >= D3D12_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
+		{
+			LOG(ERROR) << "Cannot bind storage '" << info.unique_name << "' since it exceeds the maximum number of allowed resource slots in " << "D3D12" << " (" << info.binding << ", allowed are up to " << D3D12_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT << ").";
+			return false;
+		}
 
-				const texture &texture = look_up_texture_by_name(info.texture_name);
+		const texture &texture = look_up_texture_by_name(info.texture_name);
 
-				D3D12_CPU_DESCRIPTOR_HANDLE uav_handle = uav_cpu_base;
-				uav_handle.ptr += info.binding * _srv_handle_size;
+		D3D12_CPU_DESCRIPTOR_HANDLE uav_handle = uav_cpu_base;
+		uav_handle.ptr += info.binding * _srv_handle_size;
 
-				const com_ptr<ID3D12Resource> resource =
-					static_cast<tex_data *>(texture.impl)->resource;
-				if (resource != nullptr)
-				{
-					D3D12_UNORDERED_ACCESS_VIEW_DESC desc = {};
-					desc.Format = make_dxgi_format_normal(resource->GetDesc().Format);
-					desc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-					desc.Texture2D.MipSlice = 0;
+		const com_ptr<ID3D12Resource> resource =
+			static_cast<tex_data *>(texture.impl)->resource;
+		if (resource != nullptr)
+		{
+			D3D12_UNORDERED_ACCESS_VIEW_DESC desc = {};
+			desc.Format = make_dxgi_format_normal(resource->GetDesc().Format);
+			desc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+			desc.Texture2D.MipSlice = 0;
 
-					_device->CreateUnorderedAccessView(resource.get(), nullptr, &desc, uav_handle);
+			_device->CreateUnorderedAccessView(resource.get(), nullptr, &desc, uav_handle);
 
-					pass_data.modified_resources.push_back(static_cast<tex_data *>(texture.impl));
-				}
-			}
-			uav_cpu_base.ptr += effect.module.num_storage_bindings * _srv_handle_size;
-			uav_gpu_base.ptr += effect.module.num_storage_bindings * _srv_handle_size;
+			pass_data.modified_resources.push_back(static_cast<tex_data *>(texture.impl));
 		}
 	}
 
 	return true;
 }
-void reshade::d3d12::runtime_d3d12::unload_effect(size_t index)
+void reshade::d3d12::runtime_d3d12::destroy_technique(technique &technique)
 {
 	// Make sure no effect resources are currently in use
 	wait_for_command_queue();
 
-	for (technique &tech : _techniques)
-	{
-		if (tech.effect_index != index)
-			continue;
-
-		delete static_cast<technique_data *>(tech.impl);
-		tech.impl = nullptr;
-	}
-
-	runtime::unload_effect(index);
-
-	if (index < _effect_data.size())
-	{
-		effect_data &effect_data = _effect_data[index];
-		effect_data.cb.reset();
-		effect_data.signature.reset();
-		effect_data.rtv_heap.reset();
-		effect_data.srv_uav_heap.reset();
-		effect_data.sampler_heap.reset();
-#if RESHADE_DEPTH
-		effect_data.depth_texture_bindings.clear();
-#endif
-	}
+	delete static_cast<technique_data *>(technique.impl);
+	technique.impl = nullptr;
 }
-void reshade::d3d12::runtime_d3d12::unload_effects()
+void reshade::d3d12::runtime_d3d12::destroy_effect(effect &effect)
 {
 	// Make sure no effect resources are currently in use
 	wait_for_command_queue();
 
-	for (technique &tech : _techniques)
-	{
-		delete static_cast<technique_data *>(tech.impl);
-		tech.impl = nullptr;
-	}
-
-	runtime::unload_effects();
-
-	_effect_data.clear();
+	delete static_cast<effect_data *>(effect.impl);
+	effect.impl = nullptr;
 }
 
 bool reshade::d3d12::runtime_d3d12::init_texture(texture &texture)
@@ -1138,9 +1148,12 @@ bool reshade::d3d12::runtime_d3d12::init_texture(texture &texture)
 	desc.SampleDesc = { 1, 0 };
 	desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
 
+	// Block-compressed textures are uploaded with all their mipmap levels, so do not need to generate them
+	const bool generate_mips = texture.levels > 1 && texture.compressed_format == reshadefx::texture_format::unknown;
+
 	if (texture.render_target)
 		desc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
-	if (texture.storage_access || texture.levels > 1) // Need UAV for mipmap generation
+	if (texture.storage_access || generate_mips) // Need UAV for mipmap generation
 		desc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
 
 	switch (texture.format)
@@ -1183,6 +1196,10 @@ bool reshade::d3d12::runtime_d3d12::init_texture(texture &texture)
 		break;
 	}
 
+	// Textures whose image file is uploaded as is are created with the block-compressed format of that file instead
+	if (texture.compressed_format != reshadefx::texture_format::unknown)
+		desc.Format = convert_compressed_format(texture.compressed_format);
+
 	// Render targets are always either cleared to zero or not cleared at all (see 'ClearRenderTargets' pass state), so can set the optimized clear value here to zero
 	D3D12_CLEAR_VALUE clear_value = {};
 	clear_value.Format = make_dxgi_format_normal(desc.Format);
@@ -1226,7 +1243,7 @@ bool reshade::d3d12::runtime_d3d12::init_texture(texture &texture)
 	}
 
 	// Generate UAVs for mipmap generation
-	for (uint32_t level = 1; level < texture.levels; ++level, srv_cpu_handle.ptr += _srv_handle_size)
+	for (uint32_t level = 1; generate_mips && level < texture.levels; ++level, srv_cpu_handle.ptr += _srv_handle_size)
 	{
 		D3D12_UNORDERED_ACCESS_VIEW_DESC uav_desc = {};
 		uav_desc.Format = make_dxgi_format_normal(desc.Format);
@@ -1321,6 +1338,80 @@ void reshade::d3d12::runtime_d3d12::upload_texture(const texture &texture, const
 	// Execute and wait for completion
 	wait_for_command_queue();
 }
+void reshade::d3d12::runtime_d3d12::upload_texture_levels(const texture &texture, const uint8_t *data)
+{
+	auto impl = static_cast<tex_data *>(texture.impl);
+	assert(impl != nullptr && texture.semantic.empty() && data != nullptr);
+
+	const D3D12_RESOURCE_DESC desc = impl->resource->GetDesc();
+
+	// Query the layout of all mipmap levels in a single upload buffer
+	UINT64 total_size = 0;
+	std::vector<UINT> num_rows(texture.levels);
+	std::vector<UINT64> row_sizes(texture.levels);
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(texture.levels);
+	_device->GetCopyableFootprints(&desc, 0, texture.levels, 0, footprints.data(), num_rows.data(), row_sizes.data(), &total_size);
+
+	D3D12_RESOURCE_DESC intermediate_desc = { D3D12_RESOURCE_DIMENSION_BUFFER };
+	intermediate_desc.Width = total_size;
+	intermediate_desc.Height = 1;
+	intermediate_desc.DepthOrArraySize = 1;
+	intermediate_desc.MipLevels = 1;
+	intermediate_desc.SampleDesc = { 1, 0 };
+	intermediate_desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	D3D12_HEAP_PROPERTIES props = { D3D12_HEAP_TYPE_UPLOAD };
+
+	com_ptr<ID3D12Resource> intermediate;
+	if (HRESULT hr = _device->CreateCommittedResource(&props, D3D12_HEAP_FLAG_NONE, &intermediate_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&intermediate)); FAILED(hr))
+	{
+		LOG(ERROR) << "Failed to create system memory buffer for updating texture '" << texture.unique_name << "'! HRESULT is " << hr << '.';
+		LOG(DEBUG) << "> Details: Width = " << intermediate_desc.Width;
+		return;
+	}
+	intermediate->SetName(L"ReShade upload buffer");
+
+	// Fill upload buffer with the block data of each level, which is tightly packed in the source
+	uint8_t *mapped_data;
+	if (FAILED(intermediate->Map(0, nullptr, reinterpret_cast<void **>(&mapped_data))))
+		return;
+
+	for (uint32_t level = 0; level < texture.levels; ++level)
+	{
+		const uint32_t row_pitch = texture_row_pitch(texture.storage_format(), std::max(texture.width >> level, 1u));
+		assert(row_pitch == row_sizes[level]);
+
+		for (UINT y = 0; y < num_rows[level]; ++y, data += row_pitch)
+			std::memcpy(mapped_data + footprints[level].Offset + y * footprints[level].Footprint.RowPitch, data, row_pitch);
+	}
+
+	intermediate->Unmap(0, nullptr);
+
+	if (!begin_command_list())
+		return;
+
+	transition_state(_cmd_list, impl->resource, D3D12_RESOURCE_STATE_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+	for (uint32_t level = 0; level < texture.levels; ++level)
+	{
+		D3D12_TEXTURE_COPY_LOCATION src_location = { intermediate.get() };
+		src_location.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+		src_location.PlacedFootprint = footprints[level];
+
+		D3D12_TEXTURE_COPY_LOCATION dst_location = { impl->resource.get() };
+		dst_location.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		dst_location.SubresourceIndex = level;
+
+		_cmd_list->CopyTextureRegion(&dst_location, 0, 0, 0, &src_location, nullptr);
+	}
+	transition_state(_cmd_list, impl->resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_SHADER_RESOURCE);
+
+	// Execute and wait for completion
+	wait_for_command_queue();
+}
+bool reshade::d3d12::runtime_d3d12::supports_compressed_format(reshadefx::texture_format format) const
+{
+	D3D12_FEATURE_DATA_FORMAT_SUPPORT support = { make_dxgi_format_normal(convert_compressed_format(format)) };
+	return SUCCEEDED(_device->CheckFeatureSupport(D3D12_FEATURE_FORMAT_SUPPORT, &support, sizeof(support))) && (support.Support1 & D3D12_FORMAT_SUPPORT1_TEXTURE2D) != 0;
+}
 void reshade::d3d12::runtime_d3d12::destroy_texture(texture &texture)
 {
 	// Make sure texture is not still in use before destroying it
@@ -1369,7 +1460,7 @@ void reshade::d3d12::runtime_d3d12::generate_mipmaps(const tex_data *impl)
 void reshade::d3d12::runtime_d3d12::render_technique(technique &technique)
 {
 	const auto impl = static_cast<technique_data *>(technique.impl);
-	effect_data &effect_data = _effect_data[technique.effect_index];
+	effect_data &effect_data = *static_cast<struct effect_data *>(_effects[technique.effect_index].impl);
 
 	if (!begin_command_list())
 		return;
@@ -1383,11 +1474,18 @@ void reshade::d3d12::runtime_d3d12::render_technique(technique &technique)
 	// Setup shader constants
 	if (effect_data.cb != nullptr)
 	{
-		if (void *mapped;
-			SUCCEEDED(effect_data.cb->Map(0, nullptr, &mapped)))
+		// Only update the parts that changed since the last technique of this effect was rendered
+		if (effect &effect = _effects[technique.effect_index]; !effect.uniform_data_dirty.empty())
 		{
-			std::memcpy(mapped, _effects[technique.effect_index].uniform_data_storage.data(), _effects[technique.effect_index].uniform_data_storage.size());
-			effect_data.cb->Unmap(0, nullptr);
+			if (uint8_t *mapped;
+				SUCCEEDED(effect_data.cb->Map(0, nullptr, reinterpret_cast<void **>(&mapped))))
+			{
+				for (const auto &[begin, end] : effect.uniform_data_dirty.ranges)
+					std::memcpy(mapped + begin, effect.uniform_data_storage.data() + begin, end - begin);
+				effect_data.cb->Unmap(0, nullptr);
+			}
+
+			effect.uniform_data_dirty.clear();
 		}
 
 		_cmd_list->SetGraphicsRootConstantBufferView(0, effect_data.cbv_gpu_address);
@@ -1934,9 +2032,9 @@ void reshade::d3d12::runtime_d3d12::update_depth_texture_bindings(com_ptr<ID3D12
 		_has_depth_texture = false;
 	}
 
-	// Either create a shader resource view or set a null descriptor
-	for (const effect_data &effect_data : _effect_data)
-		for (D3D12_CPU_DESCRIPTOR_HANDLE binding : effect_data.depth_texture_bindings)
+	// Either create a shader resource view or set a null descriptor (including in effects that are still being created)
+	for (const effect *effect : effects_with_device_objects())
+		for (D3D12_CPU_DESCRIPTOR_HANDLE binding : static_cast<const effect_data *>(effect->impl)->depth_texture_bindings)
 			_device->CreateShaderResourceView(_depth_texture.get(), &srv_desc, binding);
 }
 #endif
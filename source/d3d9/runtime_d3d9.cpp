@@ -36,6 +36,28 @@ namespace reshade::d3d9
 		DWORD constant_register_count = 0;
 		std::vector<pass_data> passes;
 	};
+
+	struct effect_data
+	{
+		technique_data technique_init; // Sampler setup and constant register count, which are the same for all techniques of the effect
+		std::unordered_map<std::string, com_ptr<IUnknown>> entry_points; // Shader objects, which are created when the first pass using them is initialized
+	};
+}
+
+static D3DFORMAT convert_compressed_format(reshadefx::texture_format format)
+{
+	// Only the formats that Direct3D 9 knows about can be uploaded as is, everything else is decoded instead
+	switch (format)
+	{
+	case reshadefx::texture_format::bc1:
+		return D3DFMT_DXT1;
+	case reshadefx::texture_format::bc2:
+		return D3DFMT_DXT3;
+	case reshadefx::texture_format::bc3:
+		return D3DFMT_DXT5;
+	default:
+		return D3DFMT_UNKNOWN;
+	}
 }
 
 reshade::d3d9::runtime_d3d9::runtime_d3d9(IDirect3DDevice9 *device, IDirect3DSwapChain9 *swapchain, state_tracking *state_tracking) :
@@ -53,6 +75,13 @@ reshade::d3d9::runtime_d3d9::runtime_d3d9(IDirect3DDevice9 *device, IDirect3DSwa
 
 	_renderer_id = 0x9000;
 
+	// Load HLSL compiler up front, since it is used by multiple worker threads concurrently later on
+	_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
+	if (_d3d_compiler == nullptr)
+		_d3d_compiler = LoadLibraryW(L"d3dcompiler_43.dll");
+	if (_d3d_compiler == nullptr)
+		LOG(ERROR) << "Unable to load HLSL compiler (\"d3dcompiler_47.dll\")!" << " Make sure you have the DirectX end-user runtime (June 2010) installed or a newer version of the library in the application directory.";
+
 	if (D3DADAPTER_IDENTIFIER9 adapter_desc;
 		SUCCEEDED(_d3d->GetAdapterIdentifier(creation_params.AdapterOrdinal, 0, &adapter_desc)))
 	{
@@ -343,21 +372,14 @@ bool reshade::d3d9::runtime_d3d9::capture_screenshot(uint8_t *buffer) const
 	return true;
 }
 
-bool reshade::d3d9::runtime_d3d9::init_effect(size_t index)
+bool reshade::d3d9::runtime_d3d9::compile_entry_point(const effect &effect, const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &assembly, std::string &errors) const
 {
-	if (_d3d_compiler == nullptr)
-		_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
-	if (_d3d_compiler == nullptr)
-		_d3d_compiler = LoadLibraryW(L"d3dcompiler_43.dll");
-
 	if (_d3d_compiler == nullptr)
 	{
-		LOG(ERROR) << "Unable to load HLSL compiler (\"d3dcompiler_47.dll\")!" << " Make sure you have the DirectX end-user runtime (June 2010) installed or a newer version of the library in the application directory.";
+		errors += "Unable to load HLSL compiler (\"d3dcompiler_47.dll\")! Make sure you have the DirectX end-user runtime (June 2010) installed or a newer version of the library in the application directory.\n";
 		return false;
 	}
 
-	effect &effect = _effects[index];
-
 	const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3d_compiler, "D3DCompile"));
 	const auto D3DDisassemble = reinterpret_cast<pD3DDisassemble>(GetProcAddress(_d3d_compiler, "D3DDisassemble"));
 
@@ -376,84 +398,67 @@ bool reshade::d3d9::runtime_d3d9::init_effect(size_t index)
 		{ "POSITION", "VPOS" }, { nullptr, nullptr }
 	};
 
-	std::unordered_map<std::string, com_ptr<IUnknown>> entry_points;
-
-	// Compile the generated HLSL source code to DX byte code
-	for (const reshadefx::entry_point &entry_point : effect.module.entry_points)
+	std::string profile;
+	switch (entry_point.type)
 	{
-		HRESULT hr = E_FAIL;
+	case reshadefx::shader_type::vs:
+		profile = "vs_3_0";
+		break;
+	case reshadefx::shader_type::ps:
+		profile = "ps_3_0";
+		break;
+	case reshadefx::shader_type::cs:
+		errors += "Compute shaders are not supported in ";
+		errors += "D3D9";
+		errors += '.';
+		return false;
+	}
 
-		std::string profile;
-		com_ptr<ID3DBlob> compiled, d3d_errors;
+	std::string attributes;
+	attributes += "entrypoint=" + entry_point.name + ';';
+	attributes += "profile=" + profile + ';';
+	attributes += "flags=" + std::to_string(_performance_mode ? D3DCOMPILE_OPTIMIZATION_LEVEL3 : D3DCOMPILE_OPTIMIZATION_LEVEL1) + ';';
 
-		switch (entry_point.type)
-		{
-		case reshadefx::shader_type::vs:
-			profile = "vs_3_0";
-			break;
-		case reshadefx::shader_type::ps:
-			profile = "ps_3_0";
-			break;
-		case reshadefx::shader_type::cs:
-			effect.errors += "Compute shaders are not supported in ";
-			effect.errors += "D3D9";
-			effect.errors += '.';
-			return false;
-		}
-
-		std::string attributes;
-		attributes += "entrypoint=" + entry_point.name + ';';
-		attributes += "profile=" + profile + ';';
-		attributes += "flags=" + std::to_string(_performance_mode ? D3DCOMPILE_OPTIMIZATION_LEVEL3 : D3DCOMPILE_OPTIMIZATION_LEVEL1) + ';';
+	const size_t hash = std::hash<std::string_view>()(attributes) ^ std::hash<std::string_view>()(hlsl);
+	if (load_effect_cache(effect.source_file, entry_point.name, hash, cso, assembly))
+		return true;
 
-		const size_t hash = std::hash<std::string_view>()(attributes) ^ std::hash<std::string_view>()(hlsl);
-		std::vector<char> cso;
-		if (!load_effect_cache(effect.source_file, entry_point.name, hash, cso, effect.assembly[entry_point.name]))
-		{
-			hr = D3DCompile(
-				hlsl.data(), hlsl.size(), nullptr,
-				entry_point.type == reshadefx::shader_type::ps ? ps_defines : nullptr,
-				nullptr,
-				entry_point.name.c_str(),
-				profile.c_str(),
-				_performance_mode ? D3DCOMPILE_OPTIMIZATION_LEVEL3 : D3DCOMPILE_OPTIMIZATION_LEVEL1, 0,
-				&compiled, &d3d_errors);
+	// Compile the generated HLSL source code to DX byte code
+	com_ptr<ID3DBlob> compiled, d3d_errors;
+	const HRESULT hr = D3DCompile(
+		hlsl.data(), hlsl.size(), nullptr,
+		entry_point.type == reshadefx::shader_type::ps ? ps_defines : nullptr,
+		nullptr,
+		entry_point.name.c_str(),
+		profile.c_str(),
+		_performance_mode ? D3DCOMPILE_OPTIMIZATION_LEVEL3 : D3DCOMPILE_OPTIMIZATION_LEVEL1, 0,
+		&compiled, &d3d_errors);
+
+	if (d3d_errors != nullptr) // Append warnings to the output error string as well
+		errors.append(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
 
-			if (d3d_errors != nullptr) // Append warnings to the output error string as well
-				effect.errors.append(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
+	if (FAILED(hr))
+		return false;
 
-			// No need to setup resources if any of the shaders failed to compile
-			if (FAILED(hr))
-				return false;
+	cso.resize(compiled->GetBufferSize());
+	std::memcpy(cso.data(), compiled->GetBufferPointer(), cso.size());
 
-			cso.resize(compiled->GetBufferSize());
-			std::memcpy(cso.data(), compiled->GetBufferPointer(), cso.size());
+	if (com_ptr<ID3DBlob> disassembled; SUCCEEDED(D3DDisassemble(cso.data(), cso.size(), 0, nullptr, &disassembled)))
+		assembly.assign(static_cast<const char *>(disassembled->GetBufferPointer()), disassembled->GetBufferSize() - 1);
 
-			if (com_ptr<ID3DBlob> disassembled; SUCCEEDED(D3DDisassemble(cso.data(), cso.size(), 0, nullptr, &disassembled)))
-				effect.assembly[entry_point.name].assign(static_cast<const char *>(disassembled->GetBufferPointer()), disassembled->GetBufferSize() - 1);
+	save_effect_cache(effect.source_file, entry_point.name, hash, cso, assembly);
 
-			save_effect_cache(effect.source_file, entry_point.name, hash, cso, effect.assembly[entry_point.name]);
-		}
+	return true;
+}
 
-		// Create runtime shader objects from the compiled DX byte code
-		switch (entry_point.type)
-		{
-		case reshadefx::shader_type::vs:
-			hr = _device->CreateVertexShader(reinterpret_cast<const DWORD *>(cso.data()), reinterpret_cast<IDirect3DVertexShader9 **>(&entry_points[entry_point.name]));
-			break;
-		case reshadefx::shader_type::ps:
-			hr = _device->CreatePixelShader(reinterpret_cast<const DWORD *>(cso.data()), reinterpret_cast<IDirect3DPixelShader9 **>(&entry_points[entry_point.name]));
-			break;
-		}
+bool reshade::d3d9::runtime_d3d9::init_effect(effect &effect)
+{
+	assert(effect.bytecode.size() == effect.module.entry_points.size());
 
-		if (FAILED(hr))
-		{
-			LOG(ERROR) << "Failed to create shader for entry point '" << entry_point.name << "'! HRESULT is " << hr << '.';
-			return false;
-		}
-	}
+	auto impl = new effect_data();
+	effect.impl = impl;
 
-	technique_data technique_init;
+	technique_data &technique_init = impl->technique_init;
 	assert(effect.module.num_texture_bindings == 0);
 	assert(effect.module.num_storage_bindings == 0);
 	technique_init.num_samplers = effect.module.num_sampler_bindings;
@@ -488,212 +493,250 @@ bool reshade::d3d9::runtime_d3d9::init_effect(size_t index)
 		technique_init.sampler_states[info.binding][D3DSAMP_SRGBTEXTURE] = info.srgb;
 	}
 
-	UINT max_vertices = 3;
+	return true;
+}
+bool reshade::d3d9::runtime_d3d9::init_technique(effect &effect, technique &technique)
+{
+	// Copy construct new technique implementation, since effect may contain multiple techniques
+	auto impl = new technique_data(static_cast<effect_data *>(effect.impl)->technique_init);
+	technique.impl = impl;
 
-	for (technique &technique : _techniques)
-	{
-		if (technique.impl != nullptr || technique.effect_index != index)
-			continue;
+	impl->passes.resize(technique.passes.size());
 
-		// Copy construct new technique implementation instead of move because effect may contain multiple techniques
-		auto impl = new technique_data(technique_init);
-		technique.impl = impl;
+	return true;
+}
+bool reshade::d3d9::runtime_d3d9::init_pass(effect &effect, technique &technique, size_t pass_index)
+{
+	const auto effect_impl = static_cast<effect_data *>(effect.impl);
+	const auto impl = static_cast<technique_data *>(technique.impl);
+
+	// Create runtime shader objects from the compiled DX byte code when they are first used, so that their cost is spread across the passes
+	const auto create_shader = [this, &effect, effect_impl](const std::string &name) -> IUnknown * {
+		if (const auto it = effect_impl->entry_points.find(name); it != effect_impl->entry_points.end())
+			return it->second.get();
+
+		const size_t i = std::distance(effect.module.entry_points.begin(), std::find_if(effect.module.entry_points.begin(), effect.module.entry_points.end(),
+			[&name](const reshadefx::entry_point &entry_point) { return entry_point.name == name; }));
+		assert(i < effect.module.entry_points.size());
 
-		impl->passes.resize(technique.passes.size());
-		for (size_t pass_index = 0; pass_index < technique.passes.size(); ++pass_index)
+		HRESULT hr = E_FAIL;
+		com_ptr<IUnknown> shader;
+		const std::vector<char> &cso = effect.bytecode[i];
+		const reshadefx::entry_point &entry_point = effect.module.entry_points[i];
+
+		switch (entry_point.type)
 		{
-			pass_data &pass_data = impl->passes[pass_index];
-			const reshadefx::pass_info &pass_info = technique.passes[pass_index];
+		case reshadefx::shader_type::vs:
+			hr = _device->CreateVertexShader(reinterpret_cast<const DWORD *>(cso.data()), reinterpret_cast<IDirect3DVertexShader9 **>(&shader));
+			break;
+		case reshadefx::shader_type::ps:
+			hr = _device->CreatePixelShader(reinterpret_cast<const DWORD *>(cso.data()), reinterpret_cast<IDirect3DPixelShader9 **>(&shader));
+			break;
+		}
 
-			max_vertices = std::max(max_vertices, pass_info.num_vertices);
+		if (FAILED(hr))
+		{
+			LOG(ERROR) << "Failed to create shader for entry point '" << entry_point.name << "'! HRESULT is " << hr << '.';
+			return nullptr;
+		}
 
-			entry_points.at(pass_info.ps_entry_point)->QueryInterface(&pass_data.pixel_shader);
-			entry_points.at(pass_info.vs_entry_point)->QueryInterface(&pass_data.vertex_shader);
+		return effect_impl->entry_points.emplace(name, std::move(shader)).first->second.get();
+	};
 
-			pass_data.render_targets[0] = _backbuffer_resolved.get();
+	pass_data &pass_data = impl->passes[pass_index];
+	const reshadefx::pass_info &pass_info = technique.passes[pass_index];
 
-			for (UINT k = 0; k < ARRAYSIZE(pass_data.sampler_textures); ++k)
-				pass_data.sampler_textures[k] = impl->sampler_textures[k];
+	IUnknown *const ps = create_shader(pass_info.ps_entry_point);
+	IUnknown *const vs = create_shader(pass_info.vs_entry_point);
+	if (ps == nullptr || vs == nullptr)
+		return false;
 
-			for (UINT k = 0; k < 8 && !pass_info.render_target_names[k].empty(); ++k)
-			{
-				if (k > _num_simultaneous_rendertargets)
-				{
-					LOG(WARN) << "Device only supports " << _num_simultaneous_rendertargets << " simultaneous render targets, but pass " << pass_index << " in technique '" << technique.name << "' uses more, which are ignored.";
-					break;
-				}
+	ps->QueryInterface(&pass_data.pixel_shader);
+	vs->QueryInterface(&pass_data.vertex_shader);
 
-				tex_data *const tex_impl = static_cast<tex_data *>(
-					look_up_texture_by_name(pass_info.render_target_names[k]).impl);
+	pass_data.render_targets[0] = _backbuffer_resolved.get();
 
-				// Unset textures that are used as render target
-				for (DWORD s = 0; s < impl->num_samplers; ++s)
-					if (tex_impl->texture == pass_data.sampler_textures[s])
-						pass_data.sampler_textures[s] = nullptr;
+	for (UINT k = 0; k < ARRAYSIZE(pass_data.sampler_textures); ++k)
+		pass_data.sampler_textures[k] = impl->sampler_textures[k];
 
-				pass_data.render_targets[k] = tex_impl->surface.get();
-			}
+	for (UINT k = 0; k < 8 && !pass_info.render_target_names[k].empty(); ++k)
+	{
+		if (k > _num_simultaneous_rendertargets)
+		{
+			LOG(WARN) << "Device only supports " << _num_simultaneous_rendertargets << " simultaneous render targets, but pass " << pass_index << " in technique '" << technique.name << "' uses more, which are ignored.";
+			break;
+		}
+
+		tex_data *const tex_impl = static_cast<tex_data *>(
+			look_up_texture_by_name(pass_info.render_target_names[k]).impl);
+
+		// Unset textures that are used as render target
+		for (DWORD s = 0; s < impl->num_samplers; ++s)
+			if (tex_impl->texture == pass_data.sampler_textures[s])
+				pass_data.sampler_textures[s] = nullptr;
+
+		pass_data.render_targets[k] = tex_impl->surface.get();
+	}
 
-			HRESULT hr = _device->BeginStateBlock();
-			if (SUCCEEDED(hr))
+	HRESULT hr = _device->BeginStateBlock();
+	if (SUCCEEDED(hr))
+	{
+		_device->SetVertexShader(pass_data.vertex_shader.get());
+		_device->SetPixelShader(pass_data.pixel_shader.get());
+
+		const auto convert_blend_op = [](reshadefx::pass_blend_op value) {
+			switch (value)
 			{
-				_device->SetVertexShader(pass_data.vertex_shader.get());
-				_device->SetPixelShader(pass_data.pixel_shader.get());
-
-				const auto convert_blend_op = [](reshadefx::pass_blend_op value) {
-					switch (value)
-					{
-					default:
-					case reshadefx::pass_blend_op::add: return D3DBLENDOP_ADD;
-					case reshadefx::pass_blend_op::subtract: return D3DBLENDOP_SUBTRACT;
-					case reshadefx::pass_blend_op::rev_subtract: return D3DBLENDOP_REVSUBTRACT;
-					case reshadefx::pass_blend_op::min: return D3DBLENDOP_MIN;
-					case reshadefx::pass_blend_op::max: return D3DBLENDOP_MAX;
-					}
-				};
-				const auto convert_blend_func = [](reshadefx::pass_blend_func value) {
-					switch (value)
-					{
-					default:
-					case reshadefx::pass_blend_func::one: return D3DBLEND_ONE;
-					case reshadefx::pass_blend_func::zero: return D3DBLEND_ZERO;
-					case reshadefx::pass_blend_func::src_color: return D3DBLEND_SRCCOLOR;
-					case reshadefx::pass_blend_func::src_alpha: return D3DBLEND_SRCALPHA;
-					case reshadefx::pass_blend_func::inv_src_color: return D3DBLEND_INVSRCCOLOR;
-					case reshadefx::pass_blend_func::inv_src_alpha: return D3DBLEND_INVSRCALPHA;
-					case reshadefx::pass_blend_func::dst_alpha: return D3DBLEND_DESTALPHA;
-					case reshadefx::pass_blend_func::dst_color: return D3DBLEND_DESTCOLOR;
-					case reshadefx::pass_blend_func::inv_dst_alpha: return D3DBLEND_INVDESTALPHA;
-					case reshadefx::pass_blend_func::inv_dst_color: return D3DBLEND_INVDESTCOLOR;
-					}
-				};
-				const auto convert_stencil_op = [](reshadefx::pass_stencil_op value) {
-					switch (value)
-					{
-					default:
-					case reshadefx::pass_stencil_op::keep: return D3DSTENCILOP_KEEP;
-					case reshadefx::pass_stencil_op::zero: return D3DSTENCILOP_ZERO;
-					case reshadefx::pass_stencil_op::invert: return D3DSTENCILOP_INVERT;
-					case reshadefx::pass_stencil_op::replace: return D3DSTENCILOP_REPLACE;
-					case reshadefx::pass_stencil_op::incr: return D3DSTENCILOP_INCR;
-					case reshadefx::pass_stencil_op::incr_sat: return D3DSTENCILOP_INCRSAT;
-					case reshadefx::pass_stencil_op::decr: return D3DSTENCILOP_DECR;
-					case reshadefx::pass_stencil_op::decr_sat: return D3DSTENCILOP_DECRSAT;
-					}
-				};
-				const auto convert_stencil_func = [](reshadefx::pass_stencil_func value) {
-					switch (value)
-					{
-					default:
-					case reshadefx::pass_stencil_func::always: return D3DCMP_ALWAYS;
-					case reshadefx::pass_stencil_func::never: return D3DCMP_NEVER;
-					case reshadefx::pass_stencil_func::equal: return D3DCMP_EQUAL;
-					case reshadefx::pass_stencil_func::not_equal: return D3DCMP_NOTEQUAL;
-					case reshadefx::pass_stencil_func::less: return D3DCMP_LESS;
-					case reshadefx::pass_stencil_func::less_equal: return D3DCMP_LESSEQUAL;
-					case reshadefx::pass_stencil_func::greater: return D3DCMP_GREATER;
-					case reshadefx::pass_stencil_func::greater_equal: return D3DCMP_GREATEREQUAL;
-					}
-				};
-
-				_device->SetRenderState(D3DRS_ZENABLE, FALSE);
-				_device->SetRenderState(D3DRS_FILLMODE, D3DFILL_SOLID);
-				// D3DRS_SHADEMODE
-				_device->SetRenderState(D3DRS_ZWRITEENABLE, TRUE);
-				_device->SetRenderState(D3DRS_ALPHATESTENABLE, FALSE);
-				_device->SetRenderState(D3DRS_LASTPIXEL, TRUE);
-				_device->SetRenderState(D3DRS_SRCBLEND, convert_blend_func(pass_info.src_blend));
-				_device->SetRenderState(D3DRS_DESTBLEND, convert_blend_func(pass_info.dest_blend));
-				_device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
-				_device->SetRenderState(D3DRS_ZFUNC, D3DCMP_ALWAYS);
-				// D3DRS_ALPHAREF
-				// D3DRS_ALPHAFUNC
-				_device->SetRenderState(D3DRS_DITHERENABLE, FALSE);
-				_device->SetRenderState(D3DRS_ALPHABLENDENABLE, pass_info.blend_enable);
-				_device->SetRenderState(D3DRS_FOGENABLE, FALSE);
-				_device->SetRenderState(D3DRS_SPECULARENABLE, FALSE);
-				// D3DRS_FOGCOLOR
-				// D3DRS_FOGTABLEMODE
-				// D3DRS_FOGSTART
-				// D3DRS_FOGEND
-				// D3DRS_FOGDENSITY
-				// D3DRS_RANGEFOGENABLE
-				_device->SetRenderState(D3DRS_STENCILENABLE, pass_info.stencil_enable);
-				_device->SetRenderState(D3DRS_STENCILFAIL, convert_stencil_op(pass_info.stencil_op_fail));
-				_device->SetRenderState(D3DRS_STENCILZFAIL, convert_stencil_op(pass_info.stencil_op_depth_fail));
-				_device->SetRenderState(D3DRS_STENCILPASS, convert_stencil_op(pass_info.stencil_op_pass));
-				_device->SetRenderState(D3DRS_STENCILFUNC, convert_stencil_func(pass_info.stencil_comparison_func));
-				_device->SetRenderState(D3DRS_STENCILREF, pass_info.stencil_reference_value);
-				_device->SetRenderState(D3DRS_STENCILMASK, pass_info.stencil_read_mask);
-				_device->SetRenderState(D3DRS_STENCILWRITEMASK, pass_info.stencil_write_mask);
-				// D3DRS_TEXTUREFACTOR
-				// D3DRS_WRAP0 - D3DRS_WRAP7
-				_device->SetRenderState(D3DRS_CLIPPING, FALSE);
-				_device->SetRenderState(D3DRS_LIGHTING, FALSE);
-				// D3DRS_AMBIENT
-				// D3DRS_FOGVERTEXMODE
-				_device->SetRenderState(D3DRS_COLORVERTEX, FALSE);
-				// D3DRS_LOCALVIEWER
-				_device->SetRenderState(D3DRS_NORMALIZENORMALS, FALSE);
-				_device->SetRenderState(D3DRS_DIFFUSEMATERIALSOURCE, D3DMCS_COLOR1);
-				_device->SetRenderState(D3DRS_SPECULARMATERIALSOURCE, D3DMCS_COLOR2);
-				_device->SetRenderState(D3DRS_AMBIENTMATERIALSOURCE, D3DMCS_MATERIAL);
-				_device->SetRenderState(D3DRS_EMISSIVEMATERIALSOURCE, D3DMCS_MATERIAL);
-				_device->SetRenderState(D3DRS_VERTEXBLEND, D3DVBF_DISABLE);
-				_device->SetRenderState(D3DRS_CLIPPLANEENABLE, 0);
-				// D3DRS_POINTSIZE
-				// D3DRS_POINTSIZE_MIN
-				// D3DRS_POINTSPRITEENABLE
-				// D3DRS_POINTSCALEENABLE
-				// D3DRS_POINTSCALE_A - D3DRS_POINTSCALE_C
-				// D3DRS_MULTISAMPLEANTIALIAS
-				// D3DRS_MULTISAMPLEMASK
-				// D3DRS_PATCHEDGESTYLE
-				// D3DRS_DEBUGMONITORTOKEN
-				// D3DRS_POINTSIZE_MAX
-				// D3DRS_INDEXEDVERTEXBLENDENABLE
-				_device->SetRenderState(D3DRS_COLORWRITEENABLE, pass_info.color_write_mask);
-				// D3DRS_TWEENFACTOR
-				_device->SetRenderState(D3DRS_BLENDOP, convert_blend_op(pass_info.blend_op));
-				// D3DRS_POSITIONDEGREE
-				// D3DRS_NORMALDEGREE
-				_device->SetRenderState(D3DRS_SCISSORTESTENABLE, FALSE);
-				_device->SetRenderState(D3DRS_SLOPESCALEDEPTHBIAS, 0);
-				_device->SetRenderState(D3DRS_ANTIALIASEDLINEENABLE, FALSE);
-				// D3DRS_MINTESSELLATIONLEVEL
-				// D3DRS_MAXTESSELLATIONLEVEL
-				// D3DRS_ADAPTIVETESS_X - D3DRS_ADAPTIVETESS_W
-				_device->SetRenderState(D3DRS_ENABLEADAPTIVETESSELLATION, FALSE);
-				_device->SetRenderState(D3DRS_TWOSIDEDSTENCILMODE, FALSE);
-				// D3DRS_CCW_STENCILFAIL
-				// D3DRS_CCW_STENCILZFAIL
-				// D3DRS_CCW_STENCILPASS
-				// D3DRS_CCW_STENCILFUNC
-				_device->SetRenderState(D3DRS_COLORWRITEENABLE1, pass_info.color_write_mask); // See https://docs.microsoft.com/en-us/windows/win32/direct3d9/multiple-render-targets
-				_device->SetRenderState(D3DRS_COLORWRITEENABLE2, pass_info.color_write_mask);
-				_device->SetRenderState(D3DRS_COLORWRITEENABLE3, pass_info.color_write_mask);
-				_device->SetRenderState(D3DRS_BLENDFACTOR, 0xFFFFFFFF);
-				_device->SetRenderState(D3DRS_SRGBWRITEENABLE, pass_info.srgb_write_enable);
-				_device->SetRenderState(D3DRS_DEPTHBIAS, 0);
-				// D3DRS_WRAP8 - D3DRS_WRAP15
-				_device->SetRenderState(D3DRS_SEPARATEALPHABLENDENABLE, TRUE);
-				_device->SetRenderState(D3DRS_SRCBLENDALPHA, convert_blend_func(pass_info.src_blend_alpha));
-				_device->SetRenderState(D3DRS_DESTBLENDALPHA, convert_blend_func(pass_info.dest_blend_alpha));
-				_device->SetRenderState(D3DRS_BLENDOPALPHA, convert_blend_op(pass_info.blend_op_alpha));
-
-				hr = _device->EndStateBlock(&pass_data.stateblock);
+			default:
+			case reshadefx::pass_blend_op::add: return D3DBLENDOP_ADD;
+			case reshadefx::pass_blend_op::subtract: return D3DBLENDOP_SUBTRACT;
+			case reshadefx::pass_blend_op::rev_subtract: return D3DBLENDOP_REVSUBTRACT;
+			case reshadefx::pass_blend_op::min: return D3DBLENDOP_MIN;
+			case reshadefx::pass_blend_op::max: return D3DBLENDOP_MAX;
 			}
-
-			if (FAILED(hr))
+		};
+		const auto convert_blend_func = [](reshadefx::pass_blend_func value) {
+			switch (value)
 			{
-				LOG(ERROR) << "Failed to create state block for pass " << pass_index << " in technique '" << technique.name << "'! HRESULT is " << hr << '.';
-				return false;
+			default:
+			case reshadefx::pass_blend_func::one: return D3DBLEND_ONE;
+			case reshadefx::pass_blend_func::zero: return D3DBLEND_ZERO;
+			case reshadefx::pass_blend_func::src_color: return D3DBLEND_SRCCOLOR;
+			case reshadefx::pass_blend_func::src_alpha: return D3DBLEND_SRCALPHA;
+			case reshadefx::pass_blend_func::inv_src_color: return D3DBLEND_INVSRCCOLOR;
+			case reshadefx::pass_blend_func::inv_src_alpha: return D3DBLEND_INVSRCALPHA;
+			case reshadefx::pass_blend_func::dst_alpha: return D3DBLEND_DESTALPHA;
+			case reshadefx::pass_blend_func::dst_color: return D3DBLEND_DESTCOLOR;
+			case reshadefx::pass_blend_func::inv_dst_alpha: return D3DBLEND_INVDESTALPHA;
+			case reshadefx::pass_blend_func::inv_dst_color: return D3DBLEND_INVDESTCOLOR;
 			}
-		}
+		};
+		const auto convert_stencil_op = [](reshadefx::pass_stencil_op value) {
+			switch (value)
+			{
+			default:
+			case reshadefx::pass_stencil_op::keep: return D3DSTENCILOP_KEEP;
+			case reshadefx::pass_stencil_op::zero: return D3DSTENCILOP_ZERO;
+			case reshadefx::pass_stencil_op::invert: return D3DSTENCILOP_INVERT;
+			case reshadefx::pass_stencil_op::replace: return D3DSTENCILOP_REPLACE;
+			case reshadefx::pass_stencil_op::incr: return D3DSTENCILOP_INCR;
+			case reshadefx::pass_stencil_op::incr_sat: return D3DSTENCILOP_INCRSAT;
+			case reshadefx::pass_stencil_op::decr: return D3DSTENCILOP_DECR;
+			case reshadefx::pass_stencil_op::decr_sat: return D3DSTENCILOP_DECRSAT;
+			}
+		};
+		const auto convert_stencil_func = [](reshadefx::pass_stencil_func value) {
+			switch (value)
+			{
+			default:
+			case reshadefx::pass_stencil_func::always: return D3DCMP_ALWAYS;
+			case reshadefx::pass_stencil_func::never: return D3DCMP_NEVER;
+			case reshadefx::pass_stencil_func::equal: return D3DCMP_EQUAL;
+			case reshadefx::pass_stencil_func::not_equal: return D3DCMP_NOTEQUAL;
+			case reshadefx::pass_stencil_func::less: return D3DCMP_LESS;
+			case reshadefx::pass_stencil_func::less_equal: return D3DCMP_LESSEQUAL;
+			case reshadefx::pass_stencil_func::greater: return D3DCMP_GREATER;
+			case reshadefx::pass_stencil_func::greater_equal: return D3DCMP_GREATEREQUAL;
+			}
+		};
+
+		_device->SetRenderState(D3DRS_ZENABLE, FALSE);
+		_device->SetRenderState(D3DRS_FILLMODE, D3DFILL_SOLID);
+		// D3DRS_SHADEMODE
+		_device->SetRenderState(D3DRS_ZWRITEENABLE, TRUE);
+		_device->SetRenderState(D3DRS_ALPHATESTENABLE, FALSE);
+		_device->SetRenderState(D3DRS_LASTPIXEL, TRUE);
+		_device->SetRenderState(D3DRS_SRCBLEND, convert_blend_func(pass_info.src_blend));
+		_device->SetRenderState(D3DRS_DESTBLEND, convert_blend_func(pass_info.dest_blend));
+		_device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+		_device->SetRenderState(D3DRS_ZFUNC, D3DCMP_ALWAYS);
+		// D3DRS_ALPHAREF
+		// D3DRS_ALPHAFUNC
+		_device->SetRenderState(D3DRS_DITHERENABLE, FALSE);
+		_device->SetRenderState(D3DRS_ALPHABLENDENABLE, pass_info.blend_enable);
+		_device->SetRenderState(D3DRS_FOGENABLE, FALSE);
+		_device->SetRenderState(D3DRS_SPECULARENABLE, FALSE);
+		// D3DRS_FOGCOLOR
+		// D3DRS_FOGTABLEMODE
+		// D3DRS_FOGSTART
+		// D3DRS_FOGEND
+		// D3DRS_FOGDENSITY
+		// D3DRS_RANGEFOGENABLE
+		_device->SetRenderState(D3DRS_STENCILENABLE, pass_info.stencil_enable);
+		_device->SetRenderState(D3DRS_STENCILFAIL, convert_stencil_op(pass_info.stencil_op_fail));
+		_device->SetRenderState(D3DRS_STENCILZFAIL, convert_stencil_op(pass_info.stencil_op_depth_fail));
+		_device->SetRenderState(D3DRS_STENCILPASS, convert_stencil_op(pass_info.stencil_op_pass));
+		_device->SetRenderState(D3DRS_STENCILFUNC, convert_stencil_func(pass_info.stencil_comparison_func));
+		_device->SetRenderState(D3DRS_STENCILREF, pass_info.stencil_reference_value);
+		_device->SetRenderState(D3DRS_STENCILMASK, pass_info.stencil_read_mask);
+		_device->SetRenderState(D3DRS_STENCILWRITEMASK, pass_info.stencil_write_mask);
+		// D3DRS_TEXTUREFACTOR
+		// D3DRS_WRAP0 - D3DRS_WRAP7
+		_device->SetRenderState(D3DRS_CLIPPING, FALSE);
+		_device->SetRenderState(D3DRS_LIGHTING, FALSE);
+		// D3DRS_AMBIENT
+		// D3DRS_FOGVERTEXMODE
+		_device->SetRenderState(D3DRS_COLORVERTEX, FALSE);
+		// D3DRS_LOCALVIEWER
+		_device->SetRenderState(D3DRS_NORMALIZENORMALS, FALSE);
+		_device->SetRenderState(D3DRS_DIFFUSEMATERIALSOURCE, D3DMCS_COLOR1);
+		_device->SetRenderState(D3DRS_SPECULARMATERIALSOURCE, D3DMCS_COLOR2);
+		_device->SetRenderState(D3DRS_AMBIENTMATERIALSOURCE, D3DMCS_MATERIAL);
+		_device->SetRenderState(D3DRS_EMISSIVEMATERIALSOURCE, D3DMCS_MATERIAL);
+		_device->SetRenderState(D3DRS_VERTEXBLEND, D3DVBF_DISABLE);
+		_device->SetRenderState(D3DRS_CLIPPLANEENABLE, 0);
+		// D3DRS_POINTSIZE
+		// D3DRS_POINTSIZE_MIN
+		// D3DRS_POINTSPRITEENABLE
+		// D3DRS_POINTSCALEENABLE
+		// D3DRS_POINTSCALE_A - D3DRS_POINTSCALE_C
+		// D3DRS_MULTISAMPLEANTIALIAS
+		// D3DRS_MULTISAMPLEMASK
+		// D3DRS_PATCHEDGESTYLE
+		// D3DRS_DEBUGMONITORTOKEN
+		// D3DRS_POINTSIZE_MAX
+		// D3DRS_INDEXEDVERTEXBLENDENABLE
+		_device->SetRenderState(D3DRS_COLORWRITEENABLE, pass_info.color_write_mask);
+		// D3DRS_TWEENFACTOR
+		_device->SetRenderState(D3DRS_BLENDOP, convert_blend_op(pass_info.blend_op));
+		// D3DRS_POSITIONDEGREE
+		// D3DRS_NORMALDEGREE
+		_device->SetRenderState(D3DRS_SCISSORTESTENABLE, FALSE);
+		_device->SetRenderState(D3DRS_SLOPESCALEDEPTHBIAS, 0);
+		_device->SetRenderState(D3DRS_ANTIALIASEDLINEENABLE, FALSE);
+		// D3DRS_MINTESSELLATIONLEVEL
+		// D3DRS_MAXTESSELLATIONLEVEL
+		// D3DRS_ADAPTIVETESS_X - D3DRS_ADAPTIVETESS_W
+		_device->SetRenderState(D3DRS_ENABLEADAPTIVETESSELLATION, FALSE);
+		_device->SetRenderState(D3DRS_TWOSIDEDSTENCILMODE, FALSE);
+		// D3DRS_CCW_STENCILFAIL
+		// D3DRS_CCW_STENCILZFAIL
+		// D3DRS_CCW_STENCILPASS
+		// D3DRS_CCW_STENCILFUNC
+		_device->SetRenderState(D3DRS_COLORWRITEENABLE1, pass_info.color_write_mask); // See https://docs.microsoft.com/en-us/windows/win32/direct3d9/multiple-render-targets
+		_device->SetRenderState(D3DRS_COLORWRITEENABLE2, pass_info.color_write_mask);
+		_device->SetRenderState(D3DRS_COLORWRITEENABLE3, pass_info.color_write_mask);
+		_device->SetRenderState(D3DRS_BLENDFACTOR, 0xFFFFFFFF);
+		_device->SetRenderState(D3DRS_SRGBWRITEENABLE, pass_info.srgb_write_enable);
+		_device->SetRenderState(D3DRS_DEPTHBIAS, 0);
+		// D3DRS_WRAP8 - D3DRS_WRAP15
+		_device->SetRenderState(D3DRS_SEPARATEALPHABLENDENABLE, TRUE);
+		_device->SetRenderState(D3DRS_SRCBLENDALPHA, convert_blend_func(pass_info.src_blend_alpha));
+		_device->SetRenderState(D3DRS_DESTBLENDALPHA, convert_blend_func(pass_info.dest_blend_alpha));
+		_device->SetRenderState(D3DRS_BLENDOPALPHA, convert_blend_op(pass_info.blend_op_alpha));
+
+		hr = _device->EndStateBlock(&pass_data.stateblock);
+	}
+
+	if (FAILED(hr))
+	{
+		LOG(ERROR) << "Failed to create state block for pass " << pass_index << " in technique '" << technique.name << "'! HRESULT is " << hr << '.';
+		return false;
 	}
 
 	// Update vertex buffer which holds vertex indices
-	if (max_vertices > _max_vertices)
+	if (const UINT max_vertices = std::max(3u, pass_info.num_vertices);
+		max_vertices > _max_vertices)
 	{
 		_effect_vertex_buffer.reset();
 
@@ -713,28 +756,15 @@ bool reshade::d3d9::runtime_d3d9::init_effect(size_t index)
 
 	return true;
 }
-void reshade::d3d9::runtime_d3d9::unload_effect(size_t index)
+void reshade::d3d9::runtime_d3d9::destroy_technique(technique &technique)
 {
-	for (technique &tech : _techniques)
-	{
-		if (tech.effect_index != index)
-			continue;
-
-		delete static_cast<technique_data *>(tech.impl);
-		tech.impl = nullptr;
-	}
-
-	runtime::unload_effect(index);
+	delete static_cast<technique_data *>(technique.impl);
+	technique.impl = nullptr;
 }
-void reshade::d3d9::runtime_d3d9::unload_effects()
+void reshade::d3d9::runtime_d3d9::destroy_effect(effect &effect)
 {
-	for (technique &tech : _techniques)
-	{
-		delete static_cast<technique_data *>(tech.impl);
-		tech.impl = nullptr;
-	}
-
-	runtime::unload_effects();
+	delete static_cast<effect_data *>(effect.impl);
+	effect.impl = nullptr;
 }
 
 bool reshade::d3d9::runtime_d3d9::init_texture(texture &texture)
@@ -803,7 +833,12 @@ bool reshade::d3d9::runtime_d3d9::init_texture(texture &texture)
 		break;
 	}
 
-	if (levels > 1)
+	// Textures whose image file is uploaded as is are created with the block-compressed format of that file instead (and come with all their mipmap levels)
+	if (texture.compressed_format != reshadefx::texture_format::unknown)
+	{
+		format = convert_compressed_format(texture.compressed_format);
+	}
+	else if (levels > 1)
 	{
 		// Enable auto-generated mipmaps if the format supports it
 		if (_d3d->CheckDeviceFormat(cp.AdapterOrdinal, cp.DeviceType, D3DFMT_X8R8G8B8, D3DUSAGE_AUTOGENMIPMAP, D3DRTYPE_TEXTURE, format) == D3D_OK)
@@ -905,6 +940,86 @@ void reshade::d3d9::runtime_d3d9::upload_texture(const texture &texture, const u
 		return;
 	}
 }
+void reshade::d3d9::runtime_d3d9::upload_texture_levels(const texture &texture, const uint8_t *data)
+{
+	auto impl = static_cast<tex_data *>(texture.impl);
+	assert(impl != nullptr && texture.semantic.empty() && data != nullptr);
+
+	// Textures with auto-generated mipmaps only expose the first level, the others are generated from it on update
+	const UINT levels = std::min(impl->texture->GetLevelCount(), texture.levels);
+
+	D3DSURFACE_DESC desc; impl->texture->GetLevelDesc(0, &desc); // Get D3D texture format
+	com_ptr<IDirect3DTexture9> intermediate;
+	if (HRESULT hr = _device->CreateTexture(texture.width, texture.height, levels, 0, desc.Format, D3DPOOL_SYSTEMMEM, &intermediate, nullptr); FAILED(hr))
+	{
+		LOG(ERROR) << "Failed to create system memory texture for updating texture '" << texture.unique_name << "'! HRESULT is " << hr << '.';
+		LOG(DEBUG) << "> Details: Width = " << texture.width << ", Height = " << texture.height << ", Levels = " << levels << ", Usage = " << "0" << ", Format = " << desc.Format;
+		return;
+	}
+
+	// Data of all mipmap levels is stored one after another, so just walk through them
+	for (UINT level = 0; level < levels; ++level)
+	{
+		const uint32_t width = std::max(texture.width >> level, 1u);
+		const uint32_t row_pitch = texture_row_pitch(texture.storage_format(), width);
+		const uint32_t row_count = texture_row_count(texture.storage_format(), std::max(texture.height >> level, 1u));
+
+		D3DLOCKED_RECT mapped;
+		if (FAILED(intermediate->LockRect(level, &mapped, nullptr, 0)))
+			return;
+		auto mapped_data = static_cast<uint8_t *>(mapped.pBits);
+
+		for (uint32_t y = 0; y < row_count; ++y, mapped_data += mapped.Pitch, data += row_pitch)
+		{
+			switch (texture.storage_format())
+			{
+			case reshadefx::texture_format::r8: // These are actually D3DFMT_X8R8G8B8, see 'init_texture'
+				for (uint32_t x = 0; x < width; ++x)
+					mapped_data[x * 4 + 0] = 0, // Set green and blue channel to zero
+					mapped_data[x * 4 + 1] = 0,
+					mapped_data[x * 4 + 2] = data[x],
+					mapped_data[x * 4 + 3] = 0xFF;
+				break;
+			case reshadefx::texture_format::rg8:
+				for (uint32_t x = 0; x < width; ++x)
+					mapped_data[x * 4 + 0] = 0, // Set blue channel to zero
+					mapped_data[x * 4 + 1] = data[x * 2 + 1],
+					mapped_data[x * 4 + 2] = data[x * 2 + 0],
+					mapped_data[x * 4 + 3] = 0xFF;
+				break;
+			case reshadefx::texture_format::rgba8:
+				for (uint32_t x = 0; x < width; ++x)
+					mapped_data[x * 4 + 0] = data[x * 4 + 2], // Flip RGBA input to BGRA
+					mapped_data[x * 4 + 1] = data[x * 4 + 1],
+					mapped_data[x * 4 + 2] = data[x * 4 + 0],
+					mapped_data[x * 4 + 3] = data[x * 4 + 3];
+				break;
+			default: // All other formats have the same memory layout in Direct3D 9
+				std::memcpy(mapped_data, data, row_pitch);
+				break;
+			}
+		}
+
+		intermediate->UnlockRect(level);
+	}
+
+	if (HRESULT hr = _device->UpdateTexture(intermediate.get(), impl->texture.get()); FAILED(hr))
+	{
+		LOG(ERROR) << "Failed to update texture '" << texture.unique_name << "' from system memory texture! HRESULT is " << hr << '.';
+		return;
+	}
+}
+bool reshade::d3d9::runtime_d3d9::supports_compressed_format(reshadefx::texture_format format) const
+{
+	const D3DFORMAT d3d_format = convert_compressed_format(format);
+	if (d3d_format == D3DFMT_UNKNOWN)
+		return false;
+
+	D3DDEVICE_CREATION_PARAMETERS cp;
+	_device->GetCreationParameters(&cp);
+
+	return _d3d->CheckDeviceFormat(cp.AdapterOrdinal, cp.DeviceType, D3DFMT_X8R8G8B8, 0, D3DRTYPE_TEXTURE, d3d_format) == D3D_OK;
+}
 void reshade::d3d9::runtime_d3d9::destroy_texture(texture &texture)
 {
 	delete static_cast<tex_data *>(texture.impl);
@@ -922,9 +1037,11 @@ void reshade::d3d9::runtime_d3d9::render_technique(technique &technique)
 	// Setup shader constants
 	if (impl->constant_register_count != 0)
 	{
+		// Constant registers are shared with the application, so always have to be set, regardless of whether any values changed
 		const auto uniform_storage_data = reinterpret_cast<const float *>(_effects[technique.effect_index].uniform_data_storage.data());
 		_device->SetPixelShaderConstantF(0, uniform_storage_data, impl->constant_register_count);
 		_device->SetVertexShaderConstantF(0, uniform_storage_data, impl->constant_register_count);
+		_effects[technique.effect_index].uniform_data_dirty.clear();
 	}
 
 	bool is_effect_stencil_cleared = false;
@@ -1348,12 +1465,15 @@ void reshade::d3d9::runtime_d3d9::update_depth_texture_bindings(com_ptr<IDirect3
 			continue;
 		const auto tex_impl = static_cast<tex_data *>(tex.impl);
 
-		// Update references in technique list
-		for (const technique &tech : _techniques)
+		// Update references in technique list (including techniques of effects that are still being created)
+		for (const technique *tech : techniques_with_device_objects())
 		{
-			const auto tech_impl = static_cast<technique_data *>(tech.impl);
-			if (tech_impl == nullptr)
-				continue;
+			const auto tech_impl = static_cast<technique_data *>(tech->impl);
+
+			// Passes that were not created yet copy the sampler textures of the technique
+			for (IDirect3DTexture9 *&sampler_tex : tech_impl->sampler_textures)
+				if (tex_impl->texture == sampler_tex)
+					sampler_tex = _depth_texture.get();
 
 			for (pass_data &pass_data : tech_impl->passes)
 				// Replace all occurances of the old texture with the new one
@@ -1361,6 +1481,11 @@ void reshade::d3d9::runtime_d3d9::update_depth_texture_bindings(com_ptr<IDirect3
 					if (tex_impl->texture == sampler_tex)
 						sampler_tex = _depth_texture.get();
 		}
+		// Techniques that were not created yet copy the sampler textures of the effect
+		for (const effect *effect : effects_with_device_objects())
+			for (IDirect3DTexture9 *&sampler_tex : static_cast<effect_data *>(effect->impl)->technique_init.sampler_textures)
+				if (tex_impl->texture == sampler_tex)
+					sampler_tex = _depth_texture.get();
 
 		tex_impl->texture = _depth_texture;
 		tex_impl->surface = _depth_surface;
@@ -4,45 +4,222 @@
  */
 
 #include "dll_config.hpp"
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <shared_mutex>
 #include <cassert>
 #include <fstream>
-#include <sstream>
+#include <algorithm>
 
-static std::unordered_map<std::wstring, reshade::ini_file> g_ini_cache;
+// Files are written on a background thread, which only runs while there is something to write
+// Declared before the cache, so that they are still valid when the cache is destroyed and writes any remaining modifications
+struct queued_write
+{
+	std::string data;
+	std::filesystem::file_time_type modified_at; // Time the data was last modified in memory, so that older data never replaces newer one
+	const reshade::ini_file *file = nullptr; // Instance the data was generated from
+};
+struct completed_write
+{
+	std::filesystem::file_time_type modified_at; // Time the file was last modified on disk after it was written
+	const reshade::ini_file *file = nullptr; // Instance that wrote the file, which is the only one whose contents match it
+};
+
+static std::mutex s_write_queue_mutex;
+static std::mutex s_write_file_mutex; // Held while a file is written, so that writes to the same file cannot overtake each other
+static std::thread s_write_thread; // Protected by 's_write_queue_mutex'
+static bool s_write_thread_running = false;
+static std::atomic<bool> s_write_failed = false;
+static std::unordered_map<std::filesystem::path::string_type, queued_write> s_write_queue; // Only the most recent data is kept for each file, so that frequent changes result in a single write
+static std::unordered_map<std::filesystem::path::string_type, completed_write> s_write_times; // Last write of every file, to tell these apart from modifications by other programs or other instances
+
+// The cache is split into multiple shards with their own lock, so that threads accessing different files do not contend with each other
+// Elements of an 'std::unordered_map' are not moved on rehash, so references to cached files stay valid until the cache is destroyed
+struct ini_cache_shard
+{
+	std::shared_mutex mutex;
+	std::unordered_map<std::filesystem::path::string_type, reshade::ini_file> files;
+};
+
+static struct ini_cache
+{
+	ini_cache_shard shards[16];
+
+	~ini_cache()
+	{
+		// Wait for the background thread to write all queued files, so that it does not keep running after the module was unloaded
+		std::thread write_thread;
+		{	const std::lock_guard<std::mutex> lock(s_write_queue_mutex);
+			write_thread = std::move(s_write_thread);
+		}
+
+		if (write_thread.joinable())
+			write_thread.join();
+	}
+} g_ini_cache;
+
+static ini_cache_shard &get_cache_shard(const std::filesystem::path::string_type &path)
+{
+	return g_ini_cache.shards[std::hash<std::filesystem::path::string_type>()(path) % std::size(g_ini_cache.shards)];
+}
+
+static bool write_file(const std::filesystem::path &path, const std::string &data, const reshade::ini_file *file)
+{
+	// Write to a temporary file first and then replace the actual one with it, so that it is never left partially written
+	std::filesystem::path temp_path = path;
+	temp_path += L".tmp";
+
+	std::error_code ec;
+
+	if (std::ofstream stream(temp_path); stream)
+	{
+		stream.write(data.data(), data.size());
+
+		// Flush stream to disk before replacing the file
+		stream.close();
+
+		if (!stream.fail())
+		{
+			std::filesystem::rename(temp_path, path, ec);
+
+			if (!ec)
+			{
+				assert(std::filesystem::file_size(path, ec) > 0);
+
+				const std::filesystem::file_time_type modified_at = std::filesystem::last_write_time(path, ec);
+
+				const std::lock_guard<std::mutex> lock(s_write_queue_mutex);
+				s_write_times[path] = { modified_at, file };
+				return true;
+			}
+		}
+	}
+
+	std::filesystem::remove(temp_path, ec);
+	return false;
+}
+static bool write_queued_file(const std::filesystem::path &path)
+{
+	const std::lock_guard<std::mutex> file_lock(s_write_file_mutex);
+
+	std::string data;
+	const reshade::ini_file *file = nullptr;
+	{	const std::lock_guard<std::mutex> lock(s_write_queue_mutex);
+		const auto it = s_write_queue.find(path);
+		if (it == s_write_queue.end())
+			return true;
+		data = std::move(it->second.data);
+		file = it->second.file;
+		s_write_queue.erase(it);
+	}
+
+	return write_file(path, data, file);
+}
+static void write_thread_main()
+{
+	while (true)
+	{
+		const std::lock_guard<std::mutex> file_lock(s_write_file_mutex);
+
+		std::filesystem::path path;
+		std::string data;
+		const reshade::ini_file *file = nullptr;
+		{	const std::lock_guard<std::mutex> lock(s_write_queue_mutex);
+			if (s_write_queue.empty())
+			{
+				s_write_thread_running = false;
+				return;
+			}
+
+			const auto it = s_write_queue.begin();
+			path = it->first;
+			data = std::move(it->second.data);
+			file = it->second.file;
+			s_write_queue.erase(it);
+		}
+
+		if (!write_file(path, data, file))
+			s_write_failed = true;
+	}
+}
+static bool is_own_write(const std::filesystem::path &path, std::filesystem::file_time_type modified_at, const reshade::ini_file *file)
+{
+	const std::lock_guard<std::mutex> lock(s_write_queue_mutex);
+	const auto it = s_write_times.find(path);
+	return it != s_write_times.end() && it->second.modified_at == modified_at && it->second.file == file;
+}
 
 reshade::ini_file::ini_file(const std::filesystem::path &path) : _path(path)
 {
 	load();
 }
+reshade::ini_file::ini_file(const ini_file &other) :
+	_snapshot(true), _path(other._path)
+{
+	const std::shared_lock<std::shared_mutex> lock(other._mutex);
+	_modified_at = other._modified_at;
+	_sections = other._sections;
+}
 reshade::ini_file::~ini_file()
 {
+	// Copies may be outdated by the time they are destroyed, so only the original writes its modifications
+	if (_snapshot)
+		return;
+
 	save();
+	// Do not leave any modifications behind in the queue of the background thread
+	write_queued_file(_path);
+
+	// Another instance may be created at the same address later, which must not mistake the last write for its own
+	const std::lock_guard<std::mutex> lock(s_write_queue_mutex);
+	if (const auto it = s_write_times.find(_path); it != s_write_times.end() && it->second.file == this)
+		s_write_times.erase(it);
+}
+
+static inline std::string_view trim_view(std::string_view str, const char chars[] = " \t\r")
+{
+	const size_t begin = str.find_first_not_of(chars);
+	if (begin == std::string_view::npos)
+		return std::string_view();
+	return str.substr(begin, str.find_last_not_of(chars) - begin + 1);
 }
 
 void reshade::ini_file::load()
 {
 	std::error_code ec;
 	const std::filesystem::file_time_type modified_at = std::filesystem::last_write_time(_path, ec);
-	if (ec || _modified_at >= modified_at)
-		return; // Skip loading if there was an error (e.g. file does not exist) or there was no modification to the file since it was last loaded
+	if (ec || this->modified_at() >= modified_at || is_own_write(_path, modified_at, this))
+		return; // Skip loading if there was an error (e.g. file does not exist) or there was no modification to the file since it was last loaded or saved
+
+	const uintmax_t file_size = std::filesystem::file_size(_path, ec);
+	if (ec)
+		return;
 
 	std::ifstream file;
-	if (file.open(_path); !file)
+	if (file.open(_path, std::ios::binary); !file)
 		return;
 
-	_sections.clear();
-	_modified = false;
-	_modified_at = modified_at;
+	// Read the entire file in one go and then parse it in place, rather than line by line
+	std::string data(static_cast<size_t>(file_size), '\0');
+	data.resize(static_cast<size_t>(file.read(data.data(), data.size()).gcount()));
 
-	file.imbue(std::locale("en-us.UTF-8"));
+	// Parse into a separate list, so that other threads can keep reading the current contents in the meantime
+	std::unordered_map<std::string, section> sections;
+
+	std::string_view remaining = data;
 	// Remove BOM (0xefbbbf means 0xfeff)
-	if (file.get() != 0xef || file.get() != 0xbb || file.get() != 0xbf)
-		file.seekg(0, std::ios::beg);
+	if (remaining.size() >= 3 && remaining.compare(0, 3, "\xef\xbb\xbf") == 0)
+		remaining.remove_prefix(3);
+
+	std::string_view section_name;
+	section *current_section = nullptr; // Only create sections once they have any keys
 
-	std::string line, section;
-	while (std::getline(file, line))
+	while (!remaining.empty())
 	{
-		trim(line);
+		const size_t line_end = std::min(remaining.find('\n'), remaining.size());
+		const std::string_view line = trim_view(remaining.substr(0, line_end));
+		remaining.remove_prefix(std::min(line_end + 1, remaining.size()));
 
 		if (line.empty() || line[0] == ';' || line[0] == '/' || line[0] == '#')
 			continue;
@@ -50,19 +227,24 @@ void reshade::ini_file::load()
 		// Read section name
 		if (line[0] == '[')
 		{
-			section = trim(line.substr(0, line.find(']')), " \t[]");
+			section_name = trim_view(line.substr(0, line.find(']')), " \t[]");
+			current_section = nullptr;
 			continue;
 		}
 
+		if (current_section == nullptr)
+			current_section = &sections[std::string(section_name)];
+
 		// Read section content
 		const auto assign_index = line.find('=');
-		if (assign_index != std::string::npos)
+		if (assign_index != std::string_view::npos)
 		{
-			const std::string key = trim(line.substr(0, assign_index));
-			const std::string value = trim(line.substr(assign_index + 1));
+			const std::string_view key = trim_view(line.substr(0, assign_index));
+			const std::string_view value = trim_view(line.substr(assign_index + 1));
 
 			// Append to key if it already exists
-			reshade::ini_file::value &elements = _sections[section][key];
+			auto &entry = (*current_section)[std::string(key)];
+			std::vector<std::string> &elements = entry.elements;
 			for (size_t offset = 0, base = 0, len = value.size(); offset <= len;)
 			{
 				// Treat ",," as an escaped comma and only split on single ","
@@ -74,146 +256,299 @@ void reshade::ini_file::load()
 				else
 				{
 					std::string &element = elements.emplace_back();
-					element.reserve(found - base);
 
-					while (base < found)
+					// Copy the element in one go if it does not contain any escape sequences
+					if (offset == base)
+					{
+						element.assign(value.data() + base, found - base);
+					}
+					else
 					{
-						const char c = value[base++];
-						element += c;
+						element.reserve(found - base);
+
+						while (base < found)
+						{
+							const char c = value[base++];
+							element += c;
 
-						if (c == ',' && base < found && value[base] == ',')
-							base++; // Skip second comma in a ",," escape sequence
+							if (c == ',' && base < found && value[base] == ',')
+								base++; // Skip second comma in a ",," escape sequence
+						}
 					}
 
 					base = offset = found + 1;
 				}
 			}
+
+			entry.parse();
 		}
 		else
 		{
-			_sections[section].insert({ line, {} });
+			current_section->insert({ std::string(line), {} });
 		}
 	}
+
+	const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+	// Another thread may have loaded the file in the meantime already
+	if (_modified_at >= modified_at)
+		return;
+
+	_sections.swap(sections);
+	_modified = false;
+	_modified_at = modified_at;
 }
-bool reshade::ini_file::save()
+bool reshade::ini_file::save(bool background)
 {
-	if (!_modified)
+	// Reset state even on failure to avoid 'flush_cache' repeatedly trying and failing to save
+	if (_snapshot || !_modified.exchange(false))
 		return true;
 
-	// Reset state even on failure to avoid 'flush_cache' repeatedly trying and failing to save
-	_modified = false;
+	// Hold a shared lock while generating the data only, so that other threads are not blocked while it is written to disk
+	std::shared_lock<std::shared_mutex> lock(_mutex);
 
 	std::error_code ec;
 	const std::filesystem::file_time_type modified_at = std::filesystem::last_write_time(_path, ec);
-	if (!ec && modified_at >= _modified_at)
+	if (!ec && modified_at >= _modified_at && !is_own_write(_path, modified_at, this))
 		return true; // File exists and was modified on disk and therefore may have different data, so cannot save
 
-	std::stringstream data;
-	std::vector<std::string> section_names, key_names;
+	std::string data = serialize();
 
-	section_names.reserve(_sections.size());
-	for (const auto &section : _sections)
-		section_names.push_back(section.first);
+	const std::filesystem::file_time_type data_modified_at = _modified_at;
+	lock.unlock();
+
+	if (background)
+	{
+		const std::lock_guard<std::mutex> queue_lock(s_write_queue_mutex);
+		queued_write &write = s_write_queue[_path];
+		if (write.modified_at > data_modified_at)
+			return true; // Data that was modified more recently is queued already
 
-	// Sort sections to generate consistent files
-	std::sort(section_names.begin(), section_names.end(),
-		[](std::string a, std::string b) {
-			std::transform(a.begin(), a.end(), a.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(toupper(c)); });
-			std::transform(b.begin(), b.end(), b.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(toupper(c)); });
-			return a < b;
-		});
+		write.data = std::move(data);
+		write.modified_at = data_modified_at;
+		write.file = this;
 
-	for (const std::string &section_name : section_names)
+		if (!s_write_thread_running)
+		{
+			// A previous thread has finished writing already, but still has to be joined before it can be replaced
+			if (s_write_thread.joinable())
+				s_write_thread.join();
+
+			s_write_thread_running = true;
+			s_write_thread = std::thread(write_thread_main);
+		}
+
+		return true;
+	}
+	else
 	{
-		const auto &keys = _sections.at(section_name);
+		const std::lock_guard<std::mutex> file_lock(s_write_file_mutex);
+
+		// Drop queued data that is older than this, but keep data that was modified more recently
+		{	const std::lock_guard<std::mutex> queue_lock(s_write_queue_mutex);
+			if (const auto it = s_write_queue.find(_path); it != s_write_queue.end())
+			{
+				if (it->second.modified_at > data_modified_at)
+					return true;
+
+				s_write_queue.erase(it);
+			}
+		}
+
+		return write_file(_path, data, this);
+	}
+}
+bool reshade::ini_file::save_copy(const std::filesystem::path &path) const
+{
+	std::string data;
+	{	const std::shared_lock<std::shared_mutex> lock(_mutex);
+		data = serialize();
+	}
 
-		key_names.clear();
-		key_names.reserve(keys.size());
-		for (const auto &key : keys)
-			key_names.push_back(key.first);
+	const std::lock_guard<std::mutex> file_lock(s_write_file_mutex);
+
+	return write_file(path, data, this);
+}
+std::string reshade::ini_file::serialize() const
+{
+	// Sort sections and keys to generate consistent files, without creating upper case copies of the names for every comparison
+	const auto less_ignore_case = [](const std::string &a, const std::string &b) {
+		return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+			[](char lhs, char rhs) { return toupper(static_cast<unsigned char>(lhs)) < toupper(static_cast<unsigned char>(rhs)); });
+	};
+
+	std::vector<const std::pair<const std::string, section> *> sorted_sections;
+	sorted_sections.reserve(_sections.size());
+	for (const auto &section : _sections)
+		sorted_sections.push_back(&section);
+
+	std::sort(sorted_sections.begin(), sorted_sections.end(),
+		[&less_ignore_case](const auto *a, const auto *b) { return less_ignore_case(a->first, b->first); });
+
+	std::string data;
+	std::vector<const std::pair<const std::string, value> *> sorted_keys;
+
+	for (const auto *section : sorted_sections)
+	{
+		sorted_keys.clear();
+		sorted_keys.reserve(section->second.size());
+		for (const auto &key : section->second)
+			sorted_keys.push_back(&key);
 
-		std::sort(key_names.begin(), key_names.end(),
-			[](std::string a, std::string b) {
-				std::transform(a.begin(), a.end(), a.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(toupper(c)); });
-				std::transform(b.begin(), b.end(), b.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(toupper(c)); });
-				return a < b;
-			});
+		std::sort(sorted_keys.begin(), sorted_keys.end(),
+			[&less_ignore_case](const auto *a, const auto *b) { return less_ignore_case(a->first, b->first); });
 
 		// Empty section should have been sorted to the top, so do not need to append it before keys
-		if (!section_name.empty())
-			data << '[' << section_name << ']' << '\n';
+		if (!section->first.empty())
+			data += '[' + section->first + ']' + '\n';
 
-		for (const std::string &key_name : key_names)
+		for (const auto *key : sorted_keys)
 		{
-			data << key_name << '=';
+			data += key->first;
+			data += '=';
 
-			if (const reshade::ini_file::value &elements = keys.at(key_name); !elements.empty())
+			if (const std::vector<std::string> &elements = key->second.elements; !elements.empty())
 			{
-				std::string value;
 				for (const std::string &element : elements)
 				{
-					value.reserve(value.size() + element.size() + 1);
 					for (const char c : element)
-						value.append(c == ',' ? 2 : 1, c);
-					value += ','; // Separate multiple values with a comma
+						data.append(c == ',' ? 2 : 1, c);
+					data += ','; // Separate multiple values with a comma
 				}
 
 				// Remove the last comma
-				value.pop_back();
-
-				data << value;
+				data.pop_back();
 			}
 
-			data << '\n';
+			data += '\n';
 		}
 
-		data << '\n';
+		data += '\n';
 	}
 
-	std::ofstream file(_path);
-	if (!file)
+	return data;
+}
+
+bool reshade::ini_file::get(const std::string &section, const std::string &key, int *values, size_t count) const
+{
+	const std::shared_lock<std::shared_mutex> lock(_mutex);
+
+	const auto it1 = _sections.find(section);
+	if (it1 == _sections.end())
 		return false;
+	const auto it2 = it1->second.find(key);
+	if (it2 == it1->second.end())
+		return false;
+
+	const value &v = it2->second;
 
-	const std::string str = data.str();
-	file.imbue(std::locale("en-us.UTF-8"));
-	file.write(str.data(), str.size());
+	const size_t num_elements = std::min(count, v.int_elements.size());
+	for (size_t i = 0; i < num_elements; ++i)
+		values[i] = static_cast<int>(v.int_elements[i]);
+	std::fill_n(values + num_elements, count - num_elements, 0);
+	return true;
+}
+bool reshade::ini_file::get(const std::string &section, const std::string &key, unsigned int *values, size_t count) const
+{
+	const std::shared_lock<std::shared_mutex> lock(_mutex);
+
+	const auto it1 = _sections.find(section);
+	if (it1 == _sections.end())
+		return false;
+	const auto it2 = it1->second.find(key);
+	if (it2 == it1->second.end())
+		return false;
+
+	const value &v = it2->second;
+
+	const size_t num_elements = std::min(count, v.int_elements.size());
+	for (size_t i = 0; i < num_elements; ++i)
+		values[i] = static_cast<unsigned int>(v.int_elements[i]);
+	std::fill_n(values + num_elements, count - num_elements, 0u);
+	return true;
+}
+bool reshade::ini_file::get(const std::string &section, const std::string &key, float *values, size_t count) const
+{
+	const std::shared_lock<std::shared_mutex> lock(_mutex);
 
-	// Flush stream to disk before updating last write time
-	file.close();
-	_modified_at = std::filesystem::last_write_time(_path, ec);
+	const auto it1 = _sections.find(section);
+	if (it1 == _sections.end())
+		return false;
+	const auto it2 = it1->second.find(key);
+	if (it2 == it1->second.end())
+		return false;
 
-	assert(std::filesystem::file_size(_path, ec) > 0);
+	const value &v = it2->second;
 
+	const size_t num_elements = std::min(count, v.float_elements.size());
+	for (size_t i = 0; i < num_elements; ++i)
+		values[i] = static_cast<float>(v.float_elements[i]);
+	std::fill_n(values + num_elements, count - num_elements, 0.0f);
 	return true;
 }
 
 reshade::ini_file &reshade::ini_file::load_cache(const std::filesystem::path &path)
 {
-	const auto it = g_ini_cache.try_emplace(path, path);
-	if (it.second || (std::filesystem::file_time_type::clock::now() - it.first->second._modified_at) < std::chrono::seconds(1))
-		return it.first->second; // Don't need to reload file when it was just loaded or there are still modifications pending
-	else
-		return it.first->second.load(), it.first->second;
+	ini_cache_shard &shard = get_cache_shard(path);
+
+	// Most calls find the file already cached and up to date, so only need shared access
+	{	const std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+		if (const auto it = shard.files.find(path); it != shard.files.end())
+		{
+			const std::filesystem::file_time_type cached_modified_at = it->second.modified_at();
+			if (cached_modified_at > std::filesystem::file_time_type::clock::now() - std::chrono::seconds(1))
+				return it->second; // Don't need to reload file when it was just loaded or there are still modifications pending
+
+			std::error_code ec;
+			const std::filesystem::file_time_type modified_at = std::filesystem::last_write_time(path, ec);
+			if (ec || cached_modified_at >= modified_at || is_own_write(path, modified_at, &it->second))
+				return it->second;
+		}
+	}
+
+	const std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+	// Another thread may have added or reloaded the file in the meantime, in which case 'load' returns early
+	const auto it = shard.files.try_emplace(path, path);
+	if (!it.second)
+		it.first->second.load();
+	return it.first->second;
 }
 
 bool reshade::ini_file::flush_cache()
 {
 	bool success = true;
 
-	// Save all files that were modified in one second intervals
-	for (std::pair<const std::wstring, ini_file> &file : g_ini_cache)
+	for (ini_cache_shard &shard : g_ini_cache.shards)
 	{
-		// Check modified status before requesting file time, since the latter is costly and therefore should be avoided when not necessary
-		if (file.second._modified && (std::filesystem::file_time_type::clock::now() - file.second._modified_at) > std::chrono::seconds(1))
-			success &= file.second.save();
+		// Files lock their contents themselves, so the list of files only has to be protected against additions
+		const std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+		// Save all files that were modified in one second intervals
+		for (std::pair<const std::filesystem::path::string_type, ini_file> &file : shard.files)
+		{
+			// Check modified status before anything else, since that does not need to lock the file and is false most of the time
+			if (file.second._modified && file.second.modified_at() < std::filesystem::file_time_type::clock::now() - std::chrono::seconds(1))
+				success &= file.second.save(true);
+		}
 	}
 
+	// Report any failures from writes that happened in the background since the last call
+	if (s_write_failed.exchange(false))
+		success = false;
+
 	return success;
 }
 bool reshade::ini_file::flush_cache(const std::filesystem::path &path)
 {
-	const auto it = g_ini_cache.find(path);
-	return it != g_ini_cache.end() && it->second.save();
+	ini_cache_shard &shard = get_cache_shard(path);
+
+	const std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+	const auto it = shard.files.find(path);
+	// Also write any modifications that are still waiting for the background thread, so that the file is up to date on return
+	return it != shard.files.end() && it->second.save() && write_queued_file(it->first);
 }
 
 reshade::ini_file &reshade::global_config()
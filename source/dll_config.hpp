@@ -5,9 +5,12 @@
 
 #pragma once
 
+#include <mutex>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <shared_mutex>
 #include <unordered_map>
 
 extern std::filesystem::path g_reshade_dll_path;
@@ -36,18 +39,41 @@ namespace reshade
 		/// </summary>
 		/// <param name="path">The path to the INI file to access.</param>
 		explicit ini_file(const std::filesystem::path &path);
+		/// <summary>
+		/// Creates a snapshot of the contents of another INI file, which is never written to disk.
+		/// </summary>
+		ini_file(const ini_file &other);
 		~ini_file();
 
+		ini_file &operator=(const ini_file &) = delete;
+
 		/// <summary>
 		/// Gets the path to this INI file.
 		/// </summary>
 		const std::filesystem::path &path() const { return _path; }
 
+		/// <summary>
+		/// Gets the time this INI file was last modified, either in memory or on disk.
+		/// </summary>
+		std::filesystem::file_time_type modified_at() const
+		{
+			const std::shared_lock<std::shared_mutex> lock(_mutex);
+			return _modified_at;
+		}
+
+		/// <summary>
+		/// Writes the current contents of this INI file to another file on disk, regardless of whether they were modified.
+		/// </summary>
+		/// <param name="path">The path to the file to write.</param>
+		/// <returns><c>true</c> if the file was written successfully, <c>false</c> otherwise.</returns>
+		bool save_copy(const std::filesystem::path &path) const;
+
 		/// <summary>
 		/// Checks whether the specified <paramref name="section"/> and <paramref name="key"/> currently exist in the INI.
 		/// </summary>
 		bool has(const std::string &section, const std::string &key) const
 		{
+			const std::shared_lock<std::shared_mutex> lock(_mutex);
 			const auto it1 = _sections.find(section);
 			if (it1 == _sections.end())
 				return false;
@@ -65,6 +91,7 @@ namespace reshade
 		template <typename T>
 		bool get(const std::string &section, const std::string &key, T &value) const
 		{
+			const std::shared_lock<std::shared_mutex> lock(_mutex);
 			const auto it1 = _sections.find(section);
 			if (it1 == _sections.end())
 				return false;
@@ -77,31 +104,51 @@ namespace reshade
 		template <typename T, size_t SIZE>
 		bool get(const std::string &section, const std::string &key, T(&values)[SIZE]) const
 		{
-			const auto it1 = _sections.find(section);
-			if (it1 == _sections.end())
-				return false;
-			const auto it2 = it1->second.find(key);
-			if (it2 == it1->second.end())
-				return false;
-			for (size_t i = 0; i < SIZE; ++i)
-				values[i] = convert<T>(it2->second, i);
-			return true;
+			if constexpr (std::is_same_v<T, int> || std::is_same_v<T, unsigned int> || std::is_same_v<T, float>)
+			{
+				return get(section, key, values, SIZE);
+			}
+			else
+			{
+				const std::shared_lock<std::shared_mutex> lock(_mutex);
+				const auto it1 = _sections.find(section);
+				if (it1 == _sections.end())
+					return false;
+				const auto it2 = it1->second.find(key);
+				if (it2 == it1->second.end())
+					return false;
+				for (size_t i = 0; i < SIZE; ++i)
+					values[i] = convert<T>(it2->second, i);
+				return true;
+			}
 		}
 		template <typename T>
 		bool get(const std::string &section, const std::string &key, std::vector<T> &values) const
 		{
+			const std::shared_lock<std::shared_mutex> lock(_mutex);
 			const auto it1 = _sections.find(section);
 			if (it1 == _sections.end())
 				return false;
 			const auto it2 = it1->second.find(key);
 			if (it2 == it1->second.end())
 				return false;
-			values.resize(it2->second.size());
-			for (size_t i = 0; i < it2->second.size(); ++i)
+			values.resize(it2->second.elements.size());
+			for (size_t i = 0; i < it2->second.elements.size(); ++i)
 				values[i] = convert<T>(it2->second, i);
 			return true;
 		}
 
+		/// <summary>
+		/// Gets the value of the specified <paramref name="section"/> and <paramref name="key"/> from the INI as a list of numbers.
+		/// This does not convert from text, since numbers are parsed already when the value is loaded or changed.
+		/// </summary>
+		/// <param name="values">A pointer to an array that is filled with the data of this INI entry, with any elements past the end of the entry set to zero.</param>
+		/// <param name="count">The number of elements in the <paramref name="values"/> array.</param>
+		/// <returns><c>true</c> if the key exists, <c>false</c>otherwise.</returns>
+		bool get(const std::string &section, const std::string &key, int *values, size_t count) const;
+		bool get(const std::string &section, const std::string &key, unsigned int *values, size_t count) const;
+		bool get(const std::string &section, const std::string &key, float *values, size_t count) const;
+
 		/// <summary>
 		/// Returns <c>true</c> only if the specified <paramref name="section"/> and <paramref name="key"/> exists and is not zero.
 		/// </summary>
@@ -121,28 +168,23 @@ namespace reshade
 		{
 			set(section, key, std::to_string(value));
 		}
-		template <>
 		void set(const std::string &section, const std::string &key, const bool &value)
 		{
-			set<std::string>(section, key, value ? "1" : "0");
+			set(section, key, std::string(value ? "1" : "0"));
 		}
-		template <>
 		void set(const std::string &section, const std::string &key, const std::string &value)
 		{
-			auto &v = _sections[section][key];
-			v.assign(1, value);
-			_modified = true;
-			_modified_at = std::filesystem::file_time_type::clock::now();
+			modify(section, key, [&value](std::vector<std::string> &elements) {
+				elements.assign(1, value);
+			});
 		}
 		void set(const std::string &section, const std::string &key, std::string &&value)
 		{
-			auto &v = _sections[section][key];
-			v.resize(1);
-			v[0] = std::forward<std::string>(value);
-			_modified = true;
-			_modified_at = std::filesystem::file_time_type::clock::now();
+			modify(section, key, [&value](std::vector<std::string> &elements) {
+				elements.resize(1);
+				elements[0] = std::move(value);
+			});
 		}
-		template <>
 		void set(const std::string &section, const std::string &key, const std::filesystem::path &value)
 		{
 			set(section, key, value.u8string());
@@ -150,127 +192,165 @@ namespace reshade
 		template <typename T, size_t SIZE>
 		void set(const std::string &section, const std::string &key, const T(&values)[SIZE], const size_t size = SIZE)
 		{
-			auto &v = _sections[section][key];
-			v.resize(size);
-			for (size_t i = 0; i < size; ++i)
-				v[i] = std::to_string(values[i]);
-			_modified = true;
-			_modified_at = std::filesystem::file_time_type::clock::now();
+			modify(section, key, [&values, size](std::vector<std::string> &elements) {
+				elements.resize(size);
+				for (size_t i = 0; i < size; ++i)
+					elements[i] = std::to_string(values[i]);
+			});
 		}
-		template <>
 		void set(const std::string &section, const std::string &key, const std::vector<std::string> &values)
 		{
-			auto &v = _sections[section][key];
-			v = values;
-			_modified = true;
-			_modified_at = std::filesystem::file_time_type::clock::now();
+			modify(section, key, [&values](std::vector<std::string> &elements) {
+				elements = values;
+			});
 		}
 		void set(const std::string &section, const std::string &key, std::vector<std::string> &&values)
 		{
-			auto &v = _sections[section][key];
-			v = std::forward<std::vector<std::string>>(values);
-			_modified = true;
-			_modified_at = std::filesystem::file_time_type::clock::now();
+			modify(section, key, [&values](std::vector<std::string> &elements) {
+				elements = std::move(values);
+			});
 		}
-		template <>
 		void set(const std::string &section, const std::string &key, const std::vector<std::filesystem::path> &values)
 		{
-			auto &v = _sections[section][key];
-			v.resize(values.size());
-			for (size_t i = 0; i < values.size(); ++i)
-				v[i] = values[i].u8string();
-			_modified = true;
-			_modified_at = std::filesystem::file_time_type::clock::now();
+			modify(section, key, [&values](std::vector<std::string> &elements) {
+				elements.resize(values.size());
+				for (size_t i = 0; i < values.size(); ++i)
+					elements[i] = values[i].u8string();
+			});
 		}
 
 		/// <summary>
 		/// Gets the specified INI file from cache or opens it when it was not cached yet.
-		/// WARNING: Reference is only valid until the next 'load_cache' call.
+		/// The cache and the contents of every file in it may be accessed from multiple threads, but only individual reads and writes are synchronized.
+		/// WARNING: Contents may be reloaded from disk during the next 'load_cache' call for the same file, so consecutive reads may observe different versions of it.
 		/// </summary>
 		/// <param name="path">The path to the INI file to access.</param>
-		/// <returns>A reference to the cached data. This reference is valid until the next call to <see cref="load_cache"/>.</returns>
+		/// <returns>A reference to the cached data. This reference stays valid until the cache is destroyed.</returns>
 		static reshade::ini_file &load_cache(const std::filesystem::path &path);
 
 		static bool flush_cache();
 		static bool flush_cache(const std::filesystem::path &path);
 
 	private:
-		void load();
-		bool save();
-
-		template <typename T>
-		static const T convert(const std::vector<std::string> &values, size_t i) = delete;
-		template <>
-		static const bool convert(const std::vector<std::string> &values, size_t i)
-		{
-			return convert<int>(values, i) != 0 || i < values.size() && (values[i] == "true" || values[i] == "True" || values[i] == "TRUE");
-		}
-		template <>
-		static const int convert(const std::vector<std::string> &values, size_t i)
-		{
-			return static_cast<int>(convert<long>(values, i));
-		}
-		template <>
-		static const unsigned int convert(const std::vector<std::string> &values, size_t i)
-		{
-			return static_cast<unsigned int>(convert<unsigned long>(values, i));
-		}
-		template <>
-		static const long convert(const std::vector<std::string> &values, size_t i)
-		{
-			return i < values.size() ? std::strtol(values[i].c_str(), nullptr, 10) : 0l;
-		}
-		template <>
-		static const unsigned long convert(const std::vector<std::string> &values, size_t i)
-		{
-			return i < values.size() ? std::strtoul(values[i].c_str(), nullptr, 10) : 0ul;
-		}
-		template <>
-		static const long long convert(const std::vector<std::string> &values, size_t i)
-		{
-			return i < values.size() ? std::strtoll(values[i].c_str(), nullptr, 10) : 0ll;
-		}
-		template <>
-		static const unsigned long long convert(const std::vector<std::string> &values, size_t i)
-		{
-			return i < values.size() ? std::strtoull(values[i].c_str(), nullptr, 10) : 0ull;
-		}
-		template <>
-		static const float convert(const std::vector<std::string> &values, size_t i)
-		{
-			return static_cast<float>(convert<double>(values, i));
-		}
-		template <>
-		static const double convert(const std::vector<std::string> &values, size_t i)
-		{
-			return i < values.size() ? std::strtod(values[i].c_str(), nullptr) : 0.0;
-		}
-		template <>
-		static const std::string convert(const std::vector<std::string> &values, size_t i)
-		{
-			return i < values.size() ? values[i] : std::string();
-		}
-		template <>
-		static const std::filesystem::path convert(const std::vector<std::string> &values, size_t i)
-		{
-			return i < values.size() ? std::filesystem::u8path(values[i]) : std::filesystem::path();
-		}
-
 		/// <summary>
 		/// Describes a single value in an INI file.
 		/// </summary>
-		using value = std::vector<std::string>;
+		struct value
+		{
+			std::vector<std::string> elements;
+
+			// Numeric representation of the elements, which is parsed right away whenever the elements change, so that reading never has to write to the value
+			std::vector<long long> int_elements;
+			std::vector<double> float_elements;
+
+			void parse()
+			{
+				int_elements.resize(elements.size());
+				float_elements.resize(elements.size());
+				for (size_t i = 0; i < elements.size(); ++i)
+				{
+					int_elements[i] = std::strtoll(elements[i].c_str(), nullptr, 10);
+					float_elements[i] = std::strtod(elements[i].c_str(), nullptr);
+				}
+			}
+		};
 		/// <summary>
 		/// Describes a section of multiple key/value pairs in an INI file.
 		/// </summary>
 		using section = std::unordered_map<std::string, value>;
 
-		bool _modified = false;
+		void load();
+		/// <summary>
+		/// Writes any modifications to disk, either right away or from a background thread.
+		/// </summary>
+		bool save(bool background = false);
+		/// <summary>
+		/// Generates the file contents from the sections and keys, sorted by name. The caller has to hold a lock on the contents.
+		/// </summary>
+		std::string serialize() const;
+
+		/// <summary>
+		/// Changes the elements of the specified <paramref name="section"/> and <paramref name="key"/>, which marks the INI as modified and parses the new elements into numbers.
+		/// </summary>
+		/// <param name="assign_elements">A function that is called with the list of elements to change.</param>
+		template <typename F>
+		void modify(const std::string &section, const std::string &key, F &&assign_elements)
+		{
+			const std::unique_lock<std::shared_mutex> lock(_mutex);
+			value &v = _sections[section][key];
+			assign_elements(v.elements);
+			v.parse();
+			_modified = true;
+			_modified_at = std::filesystem::file_time_type::clock::now();
+		}
+
+		template <typename T>
+		static const T convert(const value &v, size_t i) = delete;
+
+		std::atomic<bool> _modified = false;
+		bool _snapshot = false;
 		std::filesystem::path _path;
-		std::filesystem::file_time_type _modified_at;
+		mutable std::shared_mutex _mutex; // Protects the contents and modification time, so that a file may be read and changed from multiple threads
+		std::filesystem::file_time_type _modified_at = std::filesystem::file_time_type::min(); // The clock epoch is not necessarily before any file times, so start with the minimum to have loading work on first use
 		std::unordered_map<std::string, section> _sections;
 	};
 
+	template <>
+	inline const long long ini_file::convert(const value &v, size_t i)
+	{
+		return i < v.elements.size() ? v.int_elements[i] : 0ll;
+	}
+	template <>
+	inline const unsigned long long ini_file::convert(const value &v, size_t i)
+	{
+		return i < v.elements.size() ? std::strtoull(v.elements[i].c_str(), nullptr, 10) : 0ull;
+	}
+	template <>
+	inline const long ini_file::convert(const value &v, size_t i)
+	{
+		return static_cast<long>(convert<long long>(v, i));
+	}
+	template <>
+	inline const unsigned long ini_file::convert(const value &v, size_t i)
+	{
+		return static_cast<unsigned long>(convert<long long>(v, i));
+	}
+	template <>
+	inline const int ini_file::convert(const value &v, size_t i)
+	{
+		return static_cast<int>(convert<long>(v, i));
+	}
+	template <>
+	inline const unsigned int ini_file::convert(const value &v, size_t i)
+	{
+		return static_cast<unsigned int>(convert<unsigned long>(v, i));
+	}
+	template <>
+	inline const bool ini_file::convert(const value &v, size_t i)
+	{
+		return convert<int>(v, i) != 0 || i < v.elements.size() && (v.elements[i] == "true" || v.elements[i] == "True" || v.elements[i] == "TRUE");
+	}
+	template <>
+	inline const double ini_file::convert(const value &v, size_t i)
+	{
+		return i < v.elements.size() ? v.float_elements[i] : 0.0;
+	}
+	template <>
+	inline const float ini_file::convert(const value &v, size_t i)
+	{
+		return static_cast<float>(convert<double>(v, i));
+	}
+	template <>
+	inline const std::string ini_file::convert(const value &v, size_t i)
+	{
+		return i < v.elements.size() ? v.elements[i] : std::string();
+	}
+	template <>
+	inline const std::filesystem::path ini_file::convert(const value &v, size_t i)
+	{
+		return i < v.elements.size() ? std::filesystem::u8path(v.elements[i]) : std::filesystem::path();
+	}
+
 	/// <summary>
 	/// Global configuration that can be used for general settings that are not specific to a runtime instance.
 	/// </summary>
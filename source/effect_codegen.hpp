@@ -8,6 +8,7 @@
 #include "effect_module.hpp"
 #include <memory> // std::unique_ptr
 #include <algorithm> // std::find_if
+#include <unordered_set>
 
 namespace reshadefx
 {
@@ -28,6 +29,18 @@ namespace reshadefx
 		/// <param name="module">The target module to fill.</param>
 		virtual void write_result(module &module) = 0;
 
+		/// <summary>
+		/// Convert only the uniform variables with the specified names to specialization constants, instead of all of them.
+		/// These keep their space in the uniform buffer, so that its layout does not change depending on which variables are converted.
+		/// This has no effect unless the back-end was created with specialization constants enabled.
+		/// </summary>
+		/// <param name="names">The names of the uniform variables to convert.</param>
+		void restrict_spec_constants(std::unordered_set<std::string> names)
+		{
+			_restrict_spec_constants = true;
+			_spec_constant_names = std::move(names);
+		}
+
 	public:
 		/// <summary>
 		/// An opaque ID referring to a SSA value or basic block.
@@ -329,7 +342,68 @@ namespace reshadefx
 			return align_up(size, alignment) * (elements - 1) + size;
 		}
 
+		/// <summary>
+		/// Rearrange the uniform variables in the module to reduce padding in a uniform buffer with std140 layout.
+		/// Variables are placed one after another, so the new layout can also be expressed by changing their declaration order.
+		/// </summary>
+		/// <returns><c>true</c> if the offsets of the uniform variables were changed, or <c>false</c> if rearranging would not make the uniform buffer any smaller.</returns>
+		bool optimize_uniform_layout_std140()
+		{
+			const size_t num_uniforms = _module.uniforms.size();
+
+			// Base alignment of scalars, vectors, arrays and matrices according to the std140 rules
+			const auto alignment_of = [](const uniform_info &info) -> uint32_t {
+				if (info.type.is_array() || info.type.is_matrix())
+					return 16;
+				return (info.type.rows == 3 ? 4 : info.type.rows) * 4;
+			};
+
+			uint32_t total_size = 0;
+			std::vector<uint32_t> offsets(num_uniforms);
+			std::vector<bool> placed(num_uniforms);
+
+			for (size_t i = 0; i < num_uniforms; ++i)
+			{
+				// Pick the variable that needs the least padding at the current offset, preferring those with stricter alignment and then larger ones
+				// That way a scalar is kept around to fill the gap behind a three-component vector, rather than being used up early
+				size_t best = num_uniforms;
+				uint32_t best_padding = 0, best_alignment = 0;
+				for (size_t k = 0; k < num_uniforms; ++k)
+				{
+					if (placed[k])
+						continue;
+
+					const uint32_t alignment = alignment_of(_module.uniforms[k]);
+					const uint32_t padding = align_up(total_size, alignment) - total_size;
+
+					if (best == num_uniforms || padding < best_padding || (padding == best_padding &&
+						(alignment > best_alignment || (alignment == best_alignment && _module.uniforms[k].size > _module.uniforms[best].size))))
+					{
+						best = k;
+						best_padding = padding;
+						best_alignment = alignment;
+					}
+				}
+
+				placed[best] = true;
+				offsets[best] = total_size + best_padding;
+				total_size = offsets[best] + _module.uniforms[best].size;
+			}
+
+			// Keep declaration order if rearranging does not make the uniform buffer any smaller
+			if (total_size >= _module.total_uniform_size)
+				return false;
+
+			for (size_t k = 0; k < num_uniforms; ++k)
+				_module.uniforms[k].offset = offsets[k];
+			_module.total_uniform_size = total_size;
+
+			return true;
+		}
+
 		reshadefx::module _module;
+		bool _restrict_spec_constants = false;
+		std::unordered_set<std::string> _spec_constant_names;
 		std::vector<struct_info> _structs;
 		std::vector<std::unique_ptr<function_info>> _functions;
 		id _next_id = 1;
@@ -344,14 +418,16 @@ namespace reshadefx
 	/// <param name="uniforms_to_spec_constants">Whether to convert uniform variables to specialization constants.</param>
 	/// <param name="enable_16bit_types">Use real 16-bit types for the minimum precision types "min16int", "min16uint" and "min16float".</param>
 	/// <param name="flip_vert_y">Insert code to flip the Y component of the output position in vertex shaders.</param>
-	codegen *create_codegen_glsl(bool debug_info, bool uniforms_to_spec_constants, bool enable_16bit_types = false, bool flip_vert_y = false);
+	/// <param name="optimize_uniform_layout">Rearrange uniform variables in the uniform block to reduce padding.</param>
+	codegen *create_codegen_glsl(bool debug_info, bool uniforms_to_spec_constants, bool enable_16bit_types = false, bool flip_vert_y = false, bool optimize_uniform_layout = false);
 	/// <summary>
 	/// Create a back-end implementation for HLSL code generation.
 	/// </summary>
 	/// <param name="shader_model">The HLSL shader model version (e.g. 30, 41, 50, 60, ...)</param>
 	/// <param name="debug_info">Whether to append debug information like line directives to the generated code.</param>
 	/// <param name="uniforms_to_spec_constants">Whether to convert uniform variables to specialization constants.</param>
-	codegen *create_codegen_hlsl(unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants);
+	/// <param name="optimize_uniform_layout">Rearrange uniform variables in the constant buffer to reduce padding (only applies to shader model 4 and up).</param>
+	codegen *create_codegen_hlsl(unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout = false);
 	/// <summary>
 	/// Create a back-end implementation for SPIR-V code generation.
 	/// </summary>
@@ -360,5 +436,6 @@ namespace reshadefx
 	/// <param name="uniforms_to_spec_constants">Whether to convert uniform variables to specialization constants.</param>
 	/// <param name="enable_16bit_types">Use real 16-bit types for the minimum precision types "min16int", "min16uint" and "min16float".</param>
 	/// <param name="flip_vert_y">Insert code to flip the Y component of the output position in vertex shaders.</param>
-	codegen *create_codegen_spirv(bool vulkan_semantics, bool debug_info, bool uniforms_to_spec_constants, bool enable_16bit_types = false, bool flip_vert_y = false);
+	/// <param name="optimize_uniform_layout">Rearrange uniform variables in the uniform buffer to reduce padding.</param>
+	codegen *create_codegen_spirv(bool vulkan_semantics, bool debug_info, bool uniforms_to_spec_constants, bool enable_16bit_types = false, bool flip_vert_y = false, bool optimize_uniform_layout = false);
 }
@@ -16,8 +16,8 @@ using namespace reshadefx;
 class codegen_glsl final : public codegen
 {
 public:
-	codegen_glsl(bool debug_info, bool uniforms_to_spec_constants, bool enable_16bit_types, bool flip_vert_y)
-		: _debug_info(debug_info), _uniforms_to_spec_constants(uniforms_to_spec_constants), _enable_16bit_types(enable_16bit_types), _flip_vert_y(flip_vert_y)
+	codegen_glsl(bool debug_info, bool uniforms_to_spec_constants, bool enable_16bit_types, bool flip_vert_y, bool optimize_uniform_layout)
+		: _debug_info(debug_info), _uniforms_to_spec_constants(uniforms_to_spec_constants), _enable_16bit_types(enable_16bit_types), _flip_vert_y(flip_vert_y), _optimize_uniform_layout(optimize_uniform_layout)
 	{
 		// Create default block and reserve a memory block to avoid frequent reallocations
 		std::string &block = _blocks.emplace(0, std::string()).first->second;
@@ -37,7 +37,7 @@ private:
 		expression,
 	};
 
-	std::string _ubo_block;
+	std::vector<std::string> _uniform_declarations; // In the same order as '_module.uniforms'
 	std::string _compute_block;
 	std::unordered_map<id, std::string> _names;
 	std::unordered_map<id, std::string> _blocks;
@@ -45,6 +45,7 @@ private:
 	bool _uniforms_to_spec_constants = false;
 	bool _enable_16bit_types = false;
 	bool _flip_vert_y = false;
+	bool _optimize_uniform_layout = false;
 	std::unordered_map<id, id> _remapped_sampler_variables;
 	std::unordered_map<std::string, uint32_t> _semantic_to_location;
 
@@ -56,6 +57,14 @@ private:
 
 	void write_result(module &module) override
 	{
+		// Members of a std140 uniform block are laid out in declaration order, so a different layout is achieved by sorting the declarations by their new offset
+		std::vector<size_t> uniform_order(_uniform_declarations.size());
+		for (size_t i = 0; i < uniform_order.size(); ++i)
+			uniform_order[i] = i;
+		if (_optimize_uniform_layout && optimize_uniform_layout_std140())
+			std::sort(uniform_order.begin(), uniform_order.end(),
+				[this](size_t lhs, size_t rhs) { return _module.uniforms[lhs].offset < _module.uniforms[rhs].offset; });
+
 		module = std::move(_module);
 
 		if (_enable_16bit_types)
@@ -91,10 +100,15 @@ private:
 				"uvec3 compCond(bvec3 cond, uvec3 a, uvec3 b) { return uvec3(cond.x ? a.x : b.x, cond.y ? a.y : b.y, cond.z ? a.z : b.z); }\n"
 				"uvec4 compCond(bvec4 cond, uvec4 a, uvec4 b) { return uvec4(cond.x ? a.x : b.x, cond.y ? a.y : b.y, cond.z ? a.z : b.z, cond.w ? a.w : b.w); }\n";
 
-		if (!_ubo_block.empty())
+		if (!_uniform_declarations.empty())
+		{
 			// Read matrices in column major layout, even though they are actually row major, to avoid transposing them on every access (since GLSL uses column matrices)
 			// TODO: This technically only works with square matrices
-			module.hlsl += "layout(std140, column_major, binding = 0) uniform _Globals {\n" + _ubo_block + "};\n";
+			module.hlsl += "layout(std140, column_major, binding = 0) uniform _Globals {\n";
+			for (const size_t index : uniform_order)
+				module.hlsl += _uniform_declarations[index];
+			module.hlsl += "};\n";
+		}
 		module.hlsl += _blocks.at(0);
 	}
 
@@ -485,30 +499,38 @@ private:
 
 		return info.id;
 	}
-	id   define_uniform(const location &loc, uniform_info &info) override
+	void define_spec_constant(const location &loc, id res, uniform_info info)
 	{
-		const id res = make_id();
+		info.size = info.type.components() * 4;
+		if (info.type.is_array())
+			info.size *= info.type.array_length;
+		info.offset = 0;
 
-		define_name<naming::unique>(res, info.name);
+		std::string &code = _blocks.at(_current_block);
 
-		if (_uniforms_to_spec_constants && info.has_initializer_value)
-		{
-			info.size = info.type.components() * 4;
-			if (info.type.is_array())
-				info.size *= info.type.array_length;
+		write_location(code, loc);
 
-			std::string &code = _blocks.at(_current_block);
+		code += "const ";
+		write_type(code, info.type);
+		code += ' ' + id_to_name(res) + " = ";
+		if (!info.type.is_scalar())
+			write_type<false, false>(code, info.type);
+		code += "(SPEC_CONSTANT_" + info.name + ");\n";
 
-			write_location(code, loc);
+		_module.spec_constants.push_back(std::move(info));
+	}
+	id   define_uniform(const location &loc, uniform_info &info) override
+	{
+		const id res = make_id();
 
-			code += "const ";
-			write_type(code, info.type);
-			code += ' ' + id_to_name(res) + " = ";
-			if (!info.type.is_scalar())
-				write_type<false, false>(code, info.type);
-			code += "(SPEC_CONSTANT_" + info.name + ");\n";
+		define_name<naming::unique>(res, info.name);
 
-			_module.spec_constants.push_back(info);
+		const bool spec_constant = _uniforms_to_spec_constants && info.has_initializer_value &&
+			(!_restrict_spec_constants || _spec_constant_names.find(info.name) != _spec_constant_names.end());
+
+		if (spec_constant && !_restrict_spec_constants)
+		{
+			define_spec_constant(loc, res, info);
 		}
 		else
 		{
@@ -539,19 +561,30 @@ private:
 			info.offset = align_up(info.offset, alignment);
 			_module.total_uniform_size = info.offset + info.size;
 
-			write_location(_ubo_block, loc);
+			// Collect declarations separately, so that their order can still be changed in 'write_result'
+			std::string &ubo_block = _uniform_declarations.emplace_back();
+
+			write_location(ubo_block, loc);
 
-			_ubo_block += '\t';
+			ubo_block += '\t';
 			// Note: All matrices are floating-point, even if the uniform type says different!!
-			write_type(_ubo_block, info.type);
-			_ubo_block += ' ' + id_to_name(res);
+			write_type(ubo_block, info.type);
+			ubo_block += ' ' + id_to_name(res);
 
 			if (info.type.is_array())
-				_ubo_block += '[' + std::to_string(info.type.array_length) + ']';
+				ubo_block += '[' + std::to_string(info.type.array_length) + ']';
 
-			_ubo_block += ";\n";
+			ubo_block += ";\n";
 
 			_module.uniforms.push_back(info);
+
+			// Let code reference a constant instead, but keep the variable in the uniform block, so that its layout stays the same
+			if (spec_constant)
+			{
+				const id spec_res = make_id();
+				define_spec_constant(loc, spec_res, info);
+				return spec_res;
+			}
 		}
 
 		return res;
@@ -1836,7 +1869,7 @@ private:
 	}
 };
 
-codegen *reshadefx::create_codegen_glsl(bool debug_info, bool uniforms_to_spec_constants, bool enable_16bit_types, bool flip_vert_y)
+codegen *reshadefx::create_codegen_glsl(bool debug_info, bool uniforms_to_spec_constants, bool enable_16bit_types, bool flip_vert_y, bool optimize_uniform_layout)
 {
-	return new codegen_glsl(debug_info, uniforms_to_spec_constants, enable_16bit_types, flip_vert_y);
+	return new codegen_glsl(debug_info, uniforms_to_spec_constants, enable_16bit_types, flip_vert_y, optimize_uniform_layout);
 }
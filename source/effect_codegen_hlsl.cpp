@@ -16,8 +16,8 @@ using namespace reshadefx;
 class codegen_hlsl final : public codegen
 {
 public:
-	codegen_hlsl(unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants)
-		: _shader_model(shader_model), _debug_info(debug_info), _uniforms_to_spec_constants(uniforms_to_spec_constants)
+	codegen_hlsl(unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout)
+		: _shader_model(shader_model), _debug_info(debug_info), _uniforms_to_spec_constants(uniforms_to_spec_constants), _optimize_uniform_layout(optimize_uniform_layout)
 	{
 		// Create default block and reserve a memory block to avoid frequent reallocations
 		std::string &block = _blocks.emplace(0, std::string()).first->second;
@@ -36,11 +36,13 @@ private:
 	};
 
 	std::string _cbuffer_block;
+	std::vector<std::string> _uniform_declarations; // Only used in shader model 4 and up, in the same order as '_module.uniforms'
 	std::string _current_location;
 	std::unordered_map<id, std::string> _names;
 	std::unordered_map<id, std::string> _blocks;
 	bool _debug_info = false;
 	bool _uniforms_to_spec_constants = false;
+	bool _optimize_uniform_layout = false;
 	unsigned int _shader_model = 0;
 
 	// Only write compatibility intrinsics to result if they are actually in use
@@ -48,14 +50,22 @@ private:
 
 	void write_result(module &module) override
 	{
+		if (_shader_model >= 40 && _optimize_uniform_layout)
+			optimize_uniform_layout();
+
 		module = std::move(_module);
 
 		if (_shader_model >= 40)
 		{
 			module.hlsl += "struct __sampler2D { Texture2D t; SamplerState s; };\n";
 
-			if (!_cbuffer_block.empty())
-				module.hlsl += "cbuffer _Globals {\n" + _cbuffer_block + "};\n";
+			if (!_uniform_declarations.empty())
+			{
+				module.hlsl += "cbuffer _Globals {\n";
+				for (const std::string &declaration : _uniform_declarations)
+					module.hlsl += declaration;
+				module.hlsl += "};\n";
+			}
 		}
 		else
 		{
@@ -104,6 +114,77 @@ private:
 		module.hlsl += _blocks.at(0);
 	}
 
+	void optimize_uniform_layout()
+	{
+		std::vector<size_t> order(_module.uniforms.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+
+		// Place arrays and matrices first, since they always start at a new register, followed by all other variables from largest to smallest
+		// That way the smaller variables can fill the gaps left behind by the larger ones
+		std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) {
+			const uniform_info &lhs_info = _module.uniforms[lhs];
+			const uniform_info &rhs_info = _module.uniforms[rhs];
+			const bool lhs_aligned = lhs_info.type.is_array() || lhs_info.type.is_matrix();
+			const bool rhs_aligned = rhs_info.type.is_array() || rhs_info.type.is_matrix();
+			if (lhs_aligned != rhs_aligned)
+				return lhs_aligned;
+			return lhs_info.size > rhs_info.size;
+		});
+
+		uint32_t total_size = 0;
+		std::vector<uint32_t> offsets(order.size());
+		std::vector<std::pair<uint32_t, uint32_t>> partial_registers; // Offset of free space in a register and how much space is left there
+
+		for (const size_t index : order)
+		{
+			const uniform_info &info = _module.uniforms[index];
+
+			// Fill remaining space in an existing register first (variables may not cross a 16-byte boundary, which is guaranteed by only choosing registers with enough space left)
+			if (!info.type.is_array() && !info.type.is_matrix())
+			{
+				if (const auto it = std::find_if(partial_registers.begin(), partial_registers.end(),
+						[&info](const std::pair<uint32_t, uint32_t> &reg) { return reg.second >= info.size; });
+					it != partial_registers.end())
+				{
+					offsets[index] = it->first;
+					it->first += info.size;
+					it->second -= info.size;
+					total_size = std::max(total_size, offsets[index] + info.size);
+					continue;
+				}
+			}
+
+			// Otherwise start a new register
+			offsets[index] = align_up(total_size, 16);
+			total_size = offsets[index] + info.size;
+
+			if ((total_size % 16) != 0)
+				partial_registers.emplace_back(total_size, 16 - (total_size % 16));
+		}
+
+		// Keep declaration order if rearranging does not make the constant buffer any smaller
+		if (total_size >= _module.total_uniform_size)
+			return;
+
+		for (size_t index = 0; index < _module.uniforms.size(); ++index)
+		{
+			const uint32_t offset = offsets[index];
+			_module.uniforms[index].offset = offset;
+
+			// Insert explicit offset before the trailing ";\n" of the declaration
+			std::string packoffset = " : packoffset(c" + std::to_string(offset / 16);
+			if ((offset % 16) != 0)
+				packoffset += std::string(1, '.') + "xyzw"[(offset % 16) / 4];
+			packoffset += ')';
+
+			std::string &declaration = _uniform_declarations[index];
+			declaration.insert(declaration.size() - 2, packoffset);
+		}
+
+		_module.total_uniform_size = total_size;
+	}
+
 	template <bool is_param = false, bool is_decl = true>
 	void write_type(std::string &s, const type &type) const
 	{
@@ -502,30 +583,38 @@ private:
 
 		return info.id;
 	}
-	id   define_uniform(const location &loc, uniform_info &info) override
+	void define_spec_constant(const location &loc, id res, uniform_info info)
 	{
-		const id res = make_id();
+		info.size = info.type.components() * 4;
+		if (info.type.is_array())
+			info.size *= info.type.array_length;
+		info.offset = 0;
 
-		define_name<naming::unique>(res, info.name);
+		std::string &code = _blocks.at(_current_block);
 
-		if (_uniforms_to_spec_constants && info.has_initializer_value)
-		{
-			info.size = info.type.components() * 4;
-			if (info.type.is_array())
-				info.size *= info.type.array_length;
+		write_location(code, loc);
 
-			std::string &code = _blocks.at(_current_block);
+		code += "static const ";
+		write_type(code, info.type);
+		code += ' ' + id_to_name(res) + " = ";
+		if (!info.type.is_scalar())
+			write_type<false, false>(code, info.type);
+		code += "(SPEC_CONSTANT_" + info.name + ");\n";
 
-			write_location(code, loc);
+		_module.spec_constants.push_back(std::move(info));
+	}
+	id   define_uniform(const location &loc, uniform_info &info) override
+	{
+		const id res = make_id();
 
-			code += "static const ";
-			write_type(code, info.type);
-			code += ' ' + id_to_name(res) + " = ";
-			if (!info.type.is_scalar())
-				write_type<false, false>(code, info.type);
-			code += "(SPEC_CONSTANT_" + info.name + ");\n";
+		define_name<naming::unique>(res, info.name);
+
+		const bool spec_constant = _uniforms_to_spec_constants && info.has_initializer_value &&
+			(!_restrict_spec_constants || _spec_constant_names.find(info.name) != _spec_constant_names.end());
 
-			_module.spec_constants.push_back(info);
+		if (spec_constant && !_restrict_spec_constants)
+		{
+			define_spec_constant(loc, res, info);
 		}
 		else
 		{
@@ -546,12 +635,15 @@ private:
 				info.offset += remaining;
 			_module.total_uniform_size = info.offset + info.size;
 
-			write_location<true>(_cbuffer_block, loc);
+			// Shader model 4 and up collect declarations separately, so that their layout can still be changed in 'write_result'
+			std::string &cbuffer_block = _shader_model >= 40 ? _uniform_declarations.emplace_back() : _cbuffer_block;
+
+			write_location<true>(cbuffer_block, loc);
 
 			if (_shader_model >= 40)
-				_cbuffer_block += '\t';
+				cbuffer_block += '\t';
 			if (info.type.is_matrix()) // Force row major matrices
-				_cbuffer_block += "row_major ";
+				cbuffer_block += "row_major ";
 
 			type type = info.type;
 			if (_shader_model < 40)
@@ -564,22 +656,30 @@ private:
 				info.offset *= 4;
 			}
 
-			write_type(_cbuffer_block, type);
-			_cbuffer_block += ' ' + id_to_name(res);
+			write_type(cbuffer_block, type);
+			cbuffer_block += ' ' + id_to_name(res);
 
 			if (info.type.is_array())
-				_cbuffer_block += '[' + std::to_string(info.type.array_length) + ']';
+				cbuffer_block += '[' + std::to_string(info.type.array_length) + ']';
 
 			if (_shader_model < 40)
 			{
 				// Every constant register is 16 bytes wide, so divide memory offset by 16 to get the constant register index
 				// Note: All uniforms are floating-point in shader model 3, even if the uniform type says different!!
-				_cbuffer_block += " : register(c" + std::to_string(info.offset / 16) + ')';
+				cbuffer_block += " : register(c" + std::to_string(info.offset / 16) + ')';
 			}
 
-			_cbuffer_block += ";\n";
+			cbuffer_block += ";\n";
 
 			_module.uniforms.push_back(info);
+
+			// Let code reference a constant instead, but keep the variable in the constant buffer, so that its layout stays the same
+			if (spec_constant)
+			{
+				const id spec_res = make_id();
+				define_spec_constant(loc, spec_res, info);
+				return spec_res;
+			}
 		}
 
 		return res;
@@ -1646,7 +1746,7 @@ private:
 	}
 };
 
-codegen *reshadefx::create_codegen_hlsl(unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants)
+codegen *reshadefx::create_codegen_hlsl(unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout)
 {
-	return new codegen_hlsl(shader_model, debug_info, uniforms_to_spec_constants);
+	return new codegen_hlsl(shader_model, debug_info, uniforms_to_spec_constants, optimize_uniform_layout);
 }
@@ -116,8 +116,8 @@ struct spirv_basic_block
 class codegen_spirv final : public codegen
 {
 public:
-	codegen_spirv(bool vulkan_semantics, bool debug_info, bool uniforms_to_spec_constants, bool enable_16bit_types, bool flip_vert_y)
-		: _debug_info(debug_info), _vulkan_semantics(vulkan_semantics), _uniforms_to_spec_constants(uniforms_to_spec_constants), _enable_16bit_types(enable_16bit_types), _flip_vert_y(flip_vert_y)
+	codegen_spirv(bool vulkan_semantics, bool debug_info, bool uniforms_to_spec_constants, bool enable_16bit_types, bool flip_vert_y, bool optimize_uniform_layout)
+		: _debug_info(debug_info), _vulkan_semantics(vulkan_semantics), _uniforms_to_spec_constants(uniforms_to_spec_constants), _enable_16bit_types(enable_16bit_types), _flip_vert_y(flip_vert_y), _optimize_uniform_layout(optimize_uniform_layout)
 	{
 		_glsl_ext = make_id();
 	}
@@ -180,6 +180,7 @@ private:
 	bool _uniforms_to_spec_constants = false;
 	bool _enable_16bit_types = false;
 	bool _flip_vert_y = false;
+	bool _optimize_uniform_layout = false;
 	id _glsl_ext = 0;
 	id _global_ubo_type = 0;
 	id _global_ubo_variable = 0;
@@ -244,6 +245,14 @@ private:
 		// First initialize the UBO type now that all member types are known
 		if (_global_ubo_type != 0)
 		{
+			// Code accesses members by index, so only their offsets change when rearranging them, which SPIR-V allows to be in any order
+			if (_optimize_uniform_layout)
+				optimize_uniform_layout_std140();
+
+			assert(_module.uniforms.size() == _global_ubo_types.size());
+			for (uint32_t member_index = 0; member_index < _module.uniforms.size(); ++member_index)
+				add_member_decoration(_global_ubo_type, member_index, spv::DecorationOffset, { _module.uniforms[member_index].offset });
+
 			spirv_instruction &type_inst = add_instruction_without_result(spv::OpTypeStruct, _types_and_constants);
 			type_inst.add(_global_ubo_types.begin(), _global_ubo_types.end());
 			type_inst.result = _global_ubo_type;
@@ -702,149 +711,156 @@ private:
 
 		return info.id;
 	}
-	id   define_uniform(const location &, uniform_info &info) override
+	id   define_spec_constant(const uniform_info &info)
 	{
-		if (_uniforms_to_spec_constants && info.has_initializer_value)
-		{
-			const id res = emit_constant(info.type, info.initializer_value, true);
+		const id res = emit_constant(info.type, info.initializer_value, true);
 
-			add_name(res, info.name.c_str());
+		add_name(res, info.name.c_str());
 
-			const auto add_spec_constant = [this](const spirv_instruction &inst, const uniform_info &info, const constant &initializer_value, size_t initializer_offset) {
-				assert(inst.op == spv::OpSpecConstant || inst.op == spv::OpSpecConstantTrue || inst.op == spv::OpSpecConstantFalse);
+		const auto add_spec_constant = [this](const spirv_instruction &inst, const uniform_info &info, const constant &initializer_value, size_t initializer_offset) {
+			assert(inst.op == spv::OpSpecConstant || inst.op == spv::OpSpecConstantTrue || inst.op == spv::OpSpecConstantFalse);
 
-				const uint32_t spec_id = static_cast<uint32_t>(_module.spec_constants.size());
-				add_decoration(inst.result, spv::DecorationSpecId, { spec_id });
+			const uint32_t spec_id = static_cast<uint32_t>(_module.spec_constants.size());
+			add_decoration(inst.result, spv::DecorationSpecId, { spec_id });
 
-				uniform_info scalar_info = info;
-				scalar_info.type.rows = 1;
-				scalar_info.type.cols = 1;
-				scalar_info.size = 4;
-				scalar_info.offset = static_cast<uint32_t>(initializer_offset);
-				scalar_info.initializer_value = {};
-				scalar_info.initializer_value.as_uint[0] = initializer_value.as_uint[initializer_offset];
+			uniform_info scalar_info = info;
+			scalar_info.type.rows = 1;
+			scalar_info.type.cols = 1;
+			scalar_info.size = 4;
+			scalar_info.offset = static_cast<uint32_t>(initializer_offset);
+			scalar_info.initializer_value = {};
+			scalar_info.initializer_value.as_uint[0] = initializer_value.as_uint[initializer_offset];
 
-				_module.spec_constants.push_back(scalar_info);
-			};
+			_module.spec_constants.push_back(scalar_info);
+		};
 
-			const spirv_instruction &base_inst = _types_and_constants.instructions.back();
-			assert(base_inst.result == res);
+		const spirv_instruction &base_inst = _types_and_constants.instructions.back();
+		assert(base_inst.result == res);
 
-			// External specialization constants need to be scalars
-			if (info.type.is_scalar())
-			{
-				add_spec_constant(base_inst, info, info.initializer_value, 0);
-			}
-			else
+		// External specialization constants need to be scalars
+		if (info.type.is_scalar())
+		{
+			add_spec_constant(base_inst, info, info.initializer_value, 0);
+		}
+		else
+		{
+			assert(base_inst.op == spv::OpSpecConstantComposite);
+
+			// Add each individual scalar component of the constant as a separate external specialization constant
+			for (size_t i = 0; i < (info.type.is_array() ? base_inst.operands.size() : 1); ++i)
 			{
-				assert(base_inst.op == spv::OpSpecConstantComposite);
+				constant initializer_value = info.initializer_value;
+				spirv_instruction elem_inst = base_inst;
 
-				// Add each individual scalar component of the constant as a separate external specialization constant
-				for (size_t i = 0; i < (info.type.is_array() ? base_inst.operands.size() : 1); ++i)
+				if (info.type.is_array())
 				{
-					constant initializer_value = info.initializer_value;
-					spirv_instruction elem_inst = base_inst;
+					elem_inst = *std::find_if(_types_and_constants.instructions.rbegin(), _types_and_constants.instructions.rend(),
+						[elem = base_inst.operands[i]](const auto &it) { return it.result == elem; });
 
-					if (info.type.is_array())
-					{
-						elem_inst = *std::find_if(_types_and_constants.instructions.rbegin(), _types_and_constants.instructions.rend(),
-							[elem = base_inst.operands[i]](const auto &it) { return it.result == elem; });
+					assert(initializer_value.array_data.size() == base_inst.operands.size());
+					initializer_value = initializer_value.array_data[i];
+				}
 
-						assert(initializer_value.array_data.size() == base_inst.operands.size());
-						initializer_value = initializer_value.array_data[i];
-					}
+				for (size_t row = 0; row < elem_inst.operands.size(); ++row)
+				{
+					const spirv_instruction &row_inst = *std::find_if(_types_and_constants.instructions.rbegin(), _types_and_constants.instructions.rend(),
+						[elem = elem_inst.operands[row]](const auto &it) { return it.result == elem; });
 
-					for (size_t row = 0; row < elem_inst.operands.size(); ++row)
+					if (row_inst.op != spv::OpSpecConstantComposite)
 					{
-						const spirv_instruction &row_inst = *std::find_if(_types_and_constants.instructions.rbegin(), _types_and_constants.instructions.rend(),
-							[elem = elem_inst.operands[row]](const auto &it) { return it.result == elem; });
-
-						if (row_inst.op != spv::OpSpecConstantComposite)
-						{
-							add_spec_constant(row_inst, info, initializer_value, row);
-							continue;
-						}
+						add_spec_constant(row_inst, info, initializer_value, row);
+						continue;
+					}
 
-						for (size_t col = 0; col < row_inst.operands.size(); ++col)
-						{
-							const spirv_instruction &col_inst = *std::find_if(_types_and_constants.instructions.rbegin(), _types_and_constants.instructions.rend(),
-								[elem = row_inst.operands[col]](const auto &it) { return it.result == elem; });
+					for (size_t col = 0; col < row_inst.operands.size(); ++col)
+					{
+						const spirv_instruction &col_inst = *std::find_if(_types_and_constants.instructions.rbegin(), _types_and_constants.instructions.rend(),
+							[elem = row_inst.operands[col]](const auto &it) { return it.result == elem; });
 
-							add_spec_constant(col_inst, info, initializer_value, row * info.type.cols + col);
-						}
+						add_spec_constant(col_inst, info, initializer_value, row * info.type.cols + col);
 					}
 				}
 			}
+		}
 
-			return res;
+		return res;
+	}
+	id   define_uniform(const location &, uniform_info &info) override
+	{
+		const bool spec_constant = _uniforms_to_spec_constants && info.has_initializer_value &&
+			(!_restrict_spec_constants || _spec_constant_names.find(info.name) != _spec_constant_names.end());
+
+		if (spec_constant && !_restrict_spec_constants)
+			return define_spec_constant(info);
+
+		// Create global uniform buffer variable on demand
+		if (_global_ubo_type == 0)
+		{
+			_global_ubo_type = make_id();
+
+			add_decoration(_global_ubo_type, spv::DecorationBlock);
 		}
-		else
+		if (_global_ubo_variable == 0)
 		{
-			// Create global uniform buffer variable on demand
-			if (_global_ubo_type == 0)
-			{
-				_global_ubo_type = make_id();
+			_global_ubo_variable = make_id();
 
-				add_decoration(_global_ubo_type, spv::DecorationBlock);
-			}
-			if (_global_ubo_variable == 0)
-			{
-				_global_ubo_variable = make_id();
+			add_decoration(_global_ubo_variable, spv::DecorationDescriptorSet, { 0 });
+			add_decoration(_global_ubo_variable, spv::DecorationBinding, { 0 });
+		}
 
-				add_decoration(_global_ubo_variable, spv::DecorationDescriptorSet, { 0 });
-				add_decoration(_global_ubo_variable, spv::DecorationBinding, { 0 });
-			}
+		uint32_t alignment = (info.type.rows == 3 ? 4 : info.type.rows) * 4;
+		info.size = info.type.rows * 4;
 
-			uint32_t alignment = (info.type.rows == 3 ? 4 : info.type.rows) * 4;
-			info.size = info.type.rows * 4;
+		uint32_t array_stride = 16;
+		const uint32_t matrix_stride = 16;
 
-			uint32_t array_stride = 16;
-			const uint32_t matrix_stride = 16;
+		if (info.type.is_matrix())
+		{
+			alignment = matrix_stride;
+			info.size = info.type.rows * matrix_stride;
+		}
+		if (info.type.is_array())
+		{
+			alignment = array_stride;
+			array_stride = align_up(info.size, array_stride);
+			// Uniform block rules do not permit anything in the padding of an array
+			info.size = array_stride * info.type.array_length;
+		}
 
-			if (info.type.is_matrix())
-			{
-				alignment = matrix_stride;
-				info.size = info.type.rows * matrix_stride;
-			}
-			if (info.type.is_array())
-			{
-				alignment = array_stride;
-				array_stride = align_up(info.size, array_stride);
-				// Uniform block rules do not permit anything in the padding of an array
-				info.size = array_stride * info.type.array_length;
-			}
+		info.offset = _module.total_uniform_size;
+		info.offset = align_up(info.offset, alignment);
+		_module.total_uniform_size = info.offset + info.size;
 
-			info.offset = _module.total_uniform_size;
-			info.offset = align_up(info.offset, alignment);
-			_module.total_uniform_size = info.offset + info.size;
+		type ubo_type = info.type;
+		// Convert boolean uniform variables to integer type so that they have a defined size
+		if (info.type.is_boolean())
+			ubo_type.base = type::t_uint;
 
-			type ubo_type = info.type;
-			// Convert boolean uniform variables to integer type so that they have a defined size
-			if (info.type.is_boolean())
-				ubo_type.base = type::t_uint;
+		const uint32_t member_index = static_cast<uint32_t>(_global_ubo_types.size());
 
-			const uint32_t member_index = static_cast<uint32_t>(_global_ubo_types.size());
+		// Composite objects in the uniform storage class must be explicitly laid out, which includes array types requiring a stride decoration
+		_global_ubo_types.push_back(
+			convert_type(ubo_type, false, spv::StorageClassUniform, info.type.is_array() ? array_stride : 0u));
 
-			// Composite objects in the uniform storage class must be explicitly laid out, which includes array types requiring a stride decoration
-			_global_ubo_types.push_back(
-				convert_type(ubo_type, false, spv::StorageClassUniform, info.type.is_array() ? array_stride : 0u));
+		add_member_name(_global_ubo_type, member_index, info.name.c_str());
 
-			add_member_name(_global_ubo_type, member_index, info.name.c_str());
+		// Offset decoration is only added in 'write_result', after the layout is final
 
-			add_member_decoration(_global_ubo_type, member_index, spv::DecorationOffset, { info.offset });
+		if (info.type.is_matrix())
+		{
+			// Read matrices in column major layout, even though they are actually row major, to avoid transposing them on every access (since SPIR-V uses column matrices)
+			// TODO: This technically only works with square matrices
+			add_member_decoration(_global_ubo_type, member_index, spv::DecorationColMajor);
+			add_member_decoration(_global_ubo_type, member_index, spv::DecorationMatrixStride, { matrix_stride });
+		}
 
-			if (info.type.is_matrix())
-			{
-				// Read matrices in column major layout, even though they are actually row major, to avoid transposing them on every access (since SPIR-V uses column matrices)
-				// TODO: This technically only works with square matrices
-				add_member_decoration(_global_ubo_type, member_index, spv::DecorationColMajor);
-				add_member_decoration(_global_ubo_type, member_index, spv::DecorationMatrixStride, { matrix_stride });
-			}
+		_module.uniforms.push_back(info);
 
-			_module.uniforms.push_back(info);
+		// Let code reference a constant instead, but keep the variable in the uniform buffer, so that its layout stays the same
+		if (spec_constant)
+			return define_spec_constant(info);
 
-			return 0xF0000000 | member_index;
-		}
+		return 0xF0000000 | member_index;
 	}
 	id   define_variable(const location &loc, const type &type, std::string name, bool global, id initializer_value) override
 	{
@@ -2241,7 +2257,7 @@ private:
 	}
 };
 
-codegen *reshadefx::create_codegen_spirv(bool vulkan_semantics, bool debug_info, bool uniforms_to_spec_constants, bool enable_16bit_types, bool flip_vert_y)
+codegen *reshadefx::create_codegen_spirv(bool vulkan_semantics, bool debug_info, bool uniforms_to_spec_constants, bool enable_16bit_types, bool flip_vert_y, bool optimize_uniform_layout)
 {
-	return new codegen_spirv(vulkan_semantics, debug_info, uniforms_to_spec_constants, enable_16bit_types, flip_vert_y);
+	return new codegen_spirv(vulkan_semantics, debug_info, uniforms_to_spec_constants, enable_16bit_types, flip_vert_y, optimize_uniform_layout);
 }
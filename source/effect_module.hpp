@@ -29,6 +29,15 @@ namespace reshadefx
 		rgba16f,
 		rgba32f,
 		rgb10a2,
+
+		// Block-compressed formats, which cannot be declared in effect code, but are used to create textures whose DDS image file is uploaded as is
+		bc1,
+		bc2,
+		bc3,
+		bc4,
+		bc5,
+		bc6h,
+		bc7,
 	};
 
 	/// <summary>
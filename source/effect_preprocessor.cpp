@@ -75,8 +75,10 @@ static bool read_file(const std::filesystem::path &path, std::string &data)
 		return false;
 #endif
 
-	// Read file contents into memory
-	std::vector<char> file_mem(static_cast<size_t>(std::filesystem::file_size(path) + 1));
+	// Read file contents into memory (effects are preprocessed on worker threads, so use the overload of 'file_size' that does not throw)
+	std::error_code ec;
+	const uintmax_t file_size = std::filesystem::file_size(path, ec);
+	std::vector<char> file_mem((ec ? 0 : static_cast<size_t>(file_size)) + 1);
 	const size_t eof = fread(file_mem.data(), 1, file_mem.size() - 1, file);
 
 	// Append a new line feed to the end of the input string to avoid issues with parsing
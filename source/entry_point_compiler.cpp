@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "entry_point_compiler.hpp"
+#include "runtime_objects.hpp"
+#include "task_scheduler.hpp"
+#include <memory>
+
+void reshade::compile_entry_points_parallel(task_scheduler &worker_pool, effect &effect,
+	std::function<bool(const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &assembly, std::string &errors)> compile,
+	std::function<void()> continuation)
+{
+	const size_t num_entry_points = effect.module.entry_points.size();
+	effect.bytecode.resize(num_entry_points);
+
+	// Every task writes to its own slot, results are then merged in order once all of them finished
+	struct compile_results
+	{
+		std::vector<uint8_t> success;
+		std::vector<std::string> errors;
+		std::vector<std::string> assembly;
+	};
+
+	const auto results = std::make_shared<compile_results>();
+	results->success.resize(num_entry_points);
+	results->errors.resize(num_entry_points);
+	results->assembly.resize(num_entry_points);
+
+	// Shared by all tasks, rather than copied into each of them
+	const auto compile_shared = std::make_shared<decltype(compile)>(std::move(compile));
+
+	std::vector<std::function<void()>> tasks;
+	tasks.reserve(num_entry_points);
+	for (size_t i = 0; i < num_entry_points; ++i)
+	{
+		tasks.push_back([&effect, i, results, compile_shared]() {
+			results->success[i] = (*compile_shared)(effect.module.entry_points[i], effect.bytecode[i], results->assembly[i], results->errors[i]);
+		});
+	}
+
+	worker_pool.submit(std::move(tasks), [&effect, results, continuation = std::move(continuation)]() {
+		for (size_t i = 0; i < effect.module.entry_points.size(); ++i)
+		{
+			effect.errors += results->errors[i];
+
+			if (!results->success[i])
+				effect.compiled = false;
+			else if (!results->assembly[i].empty())
+				effect.assembly[effect.module.entry_points[i].name] = std::move(results->assembly[i]);
+		}
+
+		if (!effect.compiled)
+			effect.bytecode.clear();
+
+		continuation();
+	});
+}
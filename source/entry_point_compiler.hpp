@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "effect_module.hpp"
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace reshade
+{
+	struct effect;
+	class task_scheduler;
+
+	/// <summary>
+	/// Compile all entry points of an effect in parallel on the worker threads and merge the results into the effect once all of them finished.
+	/// The results are merged in the order of 'module.entry_points', so that errors and assembly do not depend on which task finished first.
+	/// If any entry point failed to compile, 'effect.compiled' is cleared and the byte code of all of them is discarded.
+	/// </summary>
+	/// <param name="worker_pool">The pool of worker threads to compile on.</param>
+	/// <param name="effect">The effect to compile, which has to stay alive and must not be modified until the continuation was called.</param>
+	/// <param name="compile">The function that is called on a worker thread for every entry point, which writes its byte code, assembly and errors and returns whether compiling it succeeded.</param>
+	/// <param name="continuation">The function that is called on a worker thread after the results were merged.</param>
+	void compile_entry_points_parallel(task_scheduler &worker_pool, effect &effect,
+		std::function<bool(const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &assembly, std::string &errors)> compile,
+		std::function<void()> continuation);
+}
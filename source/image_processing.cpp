@@ -0,0 +1,519 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "image_processing.hpp"
+#include <cmath>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+	#define RESHADE_IMAGE_SSE2 1
+	#include <emmintrin.h>
+#else
+	#define RESHADE_IMAGE_SSE2 0
+#endif
+
+namespace
+{
+	struct filter_kernel
+	{
+		int first; // Offset of the first source pixel relative to twice the destination pixel coordinate
+		unsigned int count;
+		float weights[12];
+	};
+
+	const filter_kernel &get_kernel(reshade::image::mipmap_filter filter)
+	{
+		static const filter_kernel box_kernel = { 0, 2, { 0.5f, 0.5f } };
+		static const filter_kernel kaiser_kernel = []() {
+			// Kaiser-windowed sinc with a radius of three destination pixels (the same parameters NVIDIA texture tools use), evaluated at the centers of the source pixels
+			const double alpha = 4.0;
+			const double radius = 3.0;
+			const auto bessel_i0 = [](double x) {
+				double sum = 1.0, term = 1.0;
+				for (int k = 1; k < 32; ++k)
+					term *= (x / (2.0 * k)) * (x / (2.0 * k)), sum += term;
+				return sum;
+			};
+
+			filter_kernel kernel = { -5, 12, {} };
+			double weights[12], total = 0.0;
+			for (unsigned int i = 0; i < kernel.count; ++i)
+			{
+				const double x = (kernel.first + static_cast<int>(i) - 0.5) / 2.0; // Distance from the destination pixel center in destination pixels
+				const double sinc = x == 0.0 ? 1.0 : std::sin(3.14159265358979323846 * x) / (3.14159265358979323846 * x);
+				const double t = x / radius;
+				weights[i] = t * t < 1.0 ? sinc * bessel_i0(alpha * std::sqrt(1.0 - t * t)) / bessel_i0(alpha) : 0.0;
+				total += weights[i];
+			}
+
+			// Normalize weights so that flat areas keep their value
+			for (unsigned int i = 0; i < kernel.count; ++i)
+				kernel.weights[i] = static_cast<float>(weights[i] / total);
+
+			return kernel;
+		}();
+
+		return filter == reshade::image::mipmap_filter::kaiser ? kaiser_kernel : box_kernel;
+	}
+
+	inline uint32_t clamp_coordinate(int x, uint32_t size)
+	{
+		return static_cast<uint32_t>(std::min(std::max(x, 0), static_cast<int>(size) - 1));
+	}
+
+	inline float saturate(float v)
+	{
+		return v > 0.0f ? (v < 1.0f ? v : 1.0f) : 0.0f; // Written this way so that NaN results in zero, like the vectorized version
+	}
+
+	inline float srgb_to_linear(float v)
+	{
+		return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+	}
+	inline float linear_to_srgb(float v)
+	{
+		return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+	}
+
+	inline uint8_t to_unorm8(float v)
+	{
+		return static_cast<uint8_t>(saturate(v) * 255.0f + 0.5f);
+	}
+	inline uint32_t to_unorm(float v, float max)
+	{
+		return static_cast<uint32_t>(saturate(v) * max + 0.5f);
+	}
+
+	size_t pixel_size(reshadefx::texture_format format)
+	{
+		switch (format)
+		{
+		case reshadefx::texture_format::r8:
+			return 1;
+		case reshadefx::texture_format::r16f:
+		case reshadefx::texture_format::rg8:
+			return 2;
+		case reshadefx::texture_format::rg16f:
+		case reshadefx::texture_format::rgba8:
+		case reshadefx::texture_format::rgb10a2:
+			return 4;
+		case reshadefx::texture_format::rgba16f:
+			return 8;
+		default:
+			return 0;
+		}
+	}
+
+#if RESHADE_IMAGE_SSE2
+	const unsigned int srgb_encode_table_size = 16384;
+
+	struct srgb_tables
+	{
+		srgb_tables()
+		{
+			for (unsigned int i = 0; i < 256; ++i)
+				decode[i] = srgb_to_linear(i / 255.0f);
+			// This table is fine enough that decoding and encoding again returns the original value for every 8-bit input
+			for (unsigned int i = 0; i < srgb_encode_table_size; ++i)
+				encode[i] = to_unorm8(linear_to_srgb(i / float(srgb_encode_table_size - 1)));
+		}
+
+		float decode[256];
+		uint8_t encode[srgb_encode_table_size];
+	};
+
+	const srgb_tables &get_srgb_tables()
+	{
+		static const srgb_tables tables;
+		return tables;
+	}
+
+	inline __m128 saturate(__m128 v)
+	{
+		return _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+	}
+
+	// Vectorized version of 'reference::float_to_half', see https://gist.github.com/rygorous/2156668
+	inline __m128i float_to_half(__m128 f)
+	{
+		const __m128i c_f16max = _mm_set1_epi32((127 + 16) << 23); // All values greater or equal to this round to infinity
+		const __m128i c_nanbit = _mm_set1_epi32(0x200);
+		const __m128i c_infty_as_fp16 = _mm_set1_epi32(0x7C00);
+		const __m128i c_min_normal = _mm_set1_epi32((127 - 14) << 23); // Smallest value that results in a normalized half
+		const __m128i c_subnorm_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+		const __m128i c_normal_bias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23)); // Adjusts exponent and adds mantissa rounding
+
+		const __m128 justsign = _mm_and_ps(_mm_castsi128_ps(_mm_set1_epi32(0x80000000)), f);
+		const __m128 absf = _mm_xor_ps(f, justsign);
+		const __m128i absf_int = _mm_castps_si128(absf);
+		const __m128 b_isnan = _mm_cmpunord_ps(absf, absf);
+		const __m128i b_isregular = _mm_cmpgt_epi32(c_f16max, absf_int);
+		const __m128i inf_or_nan = _mm_or_si128(_mm_and_si128(_mm_castps_si128(b_isnan), c_nanbit), c_infty_as_fp16);
+		const __m128i b_issub = _mm_cmpgt_epi32(c_min_normal, absf_int);
+
+		// Result is subnormal, so use a magic value to align the mantissa bits at the bottom and let the addition do the rounding
+		const __m128 subnorm1 = _mm_add_ps(absf, _mm_castsi128_ps(c_subnorm_magic));
+		const __m128i subnorm2 = _mm_sub_epi32(_mm_castps_si128(subnorm1), c_subnorm_magic);
+
+		// Result is normal, so round to nearest even by adding a bias that depends on the lowest bit of the resulting mantissa
+		const __m128i mantodd = _mm_srai_epi32(_mm_slli_epi32(absf_int, 31 - 13), 31);
+		const __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absf_int, c_normal_bias), mantodd), 13);
+
+		const __m128i nonspecial = _mm_or_si128(_mm_and_si128(subnorm2, b_issub), _mm_andnot_si128(b_issub, normal));
+		const __m128i joined = _mm_or_si128(_mm_and_si128(nonspecial, b_isregular), _mm_andnot_si128(b_isregular, inf_or_nan));
+
+		// Sign bit is shifted in arithmetically, which keeps the result in the signed 16-bit range for '_mm_packs_epi32'
+		return _mm_or_si128(joined, _mm_srai_epi32(_mm_castps_si128(justsign), 16));
+	}
+#endif
+}
+
+bool reshade::image::is_convertible_format(reshadefx::texture_format format)
+{
+	return pixel_size(format) != 0;
+}
+
+void reshade::image::reference::unpack_rgba8(const uint8_t *src, size_t count, bool srgb, float *dst)
+{
+	for (size_t i = 0; i < count * 4; ++i)
+		dst[i] = srgb && (i % 4) != 3 ? srgb_to_linear(src[i] / 255.0f) : src[i] * (1.0f / 255.0f);
+}
+void reshade::image::reference::pack(const float *src, size_t count, reshadefx::texture_format format, bool srgb, uint8_t *dst)
+{
+	const auto to_color8 = [srgb](float v) { return to_unorm8(srgb ? linear_to_srgb(saturate(v)) : v); };
+
+	for (size_t i = 0; i < count; ++i, src += 4)
+	{
+		switch (format)
+		{
+		case reshadefx::texture_format::r8:
+			dst[i] = to_color8(src[0]);
+			break;
+		case reshadefx::texture_format::rg8:
+			dst[i * 2 + 0] = to_color8(src[0]);
+			dst[i * 2 + 1] = to_color8(src[1]);
+			break;
+		case reshadefx::texture_format::rgba8:
+			dst[i * 4 + 0] = to_color8(src[0]);
+			dst[i * 4 + 1] = to_color8(src[1]);
+			dst[i * 4 + 2] = to_color8(src[2]);
+			dst[i * 4 + 3] = to_unorm8(src[3]);
+			break;
+		case reshadefx::texture_format::r16f:
+		case reshadefx::texture_format::rg16f:
+		case reshadefx::texture_format::rgba16f:
+			for (size_t c = 0, channels = pixel_size(format) / 2; c < channels; ++c)
+			{
+				const uint16_t value = float_to_half(src[c]);
+				std::memcpy(dst + (i * channels + c) * 2, &value, 2);
+			}
+			break;
+		case reshadefx::texture_format::rgb10a2:
+		{
+			const uint32_t value = to_unorm(src[0], 1023.0f) | (to_unorm(src[1], 1023.0f) << 10) | (to_unorm(src[2], 1023.0f) << 20) | (to_unorm(src[3], 3.0f) << 30);
+			std::memcpy(dst + i * 4, &value, 4);
+			break;
+		}
+		default:
+			assert(false);
+			return;
+		}
+	}
+}
+void reshade::image::reference::downsample(const float *src, uint32_t width, uint32_t height, mipmap_filter filter, float *dst)
+{
+	const filter_kernel &kernel = get_kernel(filter);
+	const uint32_t dst_width = std::max(width / 2, 1u);
+	const uint32_t dst_height = std::max(height / 2, 1u);
+
+	// Filter is separable, so first reduce width and then height
+	std::vector<float> temp(size_t(dst_width) * height * 4);
+
+	for (uint32_t y = 0; y < height; ++y)
+		for (uint32_t x = 0; x < dst_width; ++x)
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				float sum = 0.0f;
+				for (uint32_t t = 0; t < kernel.count; ++t)
+					sum += kernel.weights[t] * src[(size_t(y) * width + clamp_coordinate(static_cast<int>(2 * x + t) + kernel.first, width)) * 4 + c];
+				temp[(size_t(y) * dst_width + x) * 4 + c] = sum;
+			}
+
+	for (uint32_t y = 0; y < dst_height; ++y)
+		for (uint32_t x = 0; x < dst_width; ++x)
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				float sum = 0.0f;
+				for (uint32_t t = 0; t < kernel.count; ++t)
+					sum += kernel.weights[t] * temp[(size_t(clamp_coordinate(static_cast<int>(2 * y + t) + kernel.first, height)) * dst_width + x) * 4 + c];
+				dst[(size_t(y) * dst_width + x) * 4 + c] = sum;
+			}
+}
+
+uint16_t reshade::image::reference::float_to_half(float value)
+{
+	uint32_t f;
+	std::memcpy(&f, &value, 4);
+
+	const uint32_t sign = f & 0x80000000;
+	f ^= sign;
+
+	uint32_t result;
+	if (f >= ((127 + 16) << 23)) // Result is infinity or NaN
+	{
+		result = f > 0x7F800000 ? 0x7E00 : 0x7C00;
+	}
+	else if (f < ((127 - 14) << 23)) // Result is subnormal or zero
+	{
+		const uint32_t subnorm_magic = ((127 - 15) + (23 - 10) + 1) << 23;
+		float magic_value, shifted_value;
+		std::memcpy(&magic_value, &subnorm_magic, 4);
+		std::memcpy(&shifted_value, &f, 4);
+		shifted_value += magic_value;
+		std::memcpy(&result, &shifted_value, 4);
+		result -= subnorm_magic;
+	}
+	else
+	{
+		const uint32_t mant_odd = (f >> 13) & 1;
+		f += (uint32_t(15 - 127) << 23) + 0xFFF + mant_odd;
+		result = f >> 13;
+	}
+
+	return static_cast<uint16_t>(result | (sign >> 16));
+}
+
+#if RESHADE_IMAGE_SSE2
+void reshade::image::unpack_rgba8(const uint8_t *src, size_t count, bool srgb, float *dst)
+{
+	size_t i = 0;
+
+	if (srgb)
+	{
+		const srgb_tables &tables = get_srgb_tables();
+
+		for (; i < count; ++i, src += 4, dst += 4)
+			_mm_storeu_ps(dst, _mm_set_ps(src[3] * (1.0f / 255.0f), tables.decode[src[2]], tables.decode[src[1]], tables.decode[src[0]]));
+	}
+	else
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+
+		// Convert four pixels at a time
+		for (; i + 4 <= count; i += 4, src += 16, dst += 16)
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+			const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+			const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+
+			_mm_storeu_ps(dst +  0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+			_mm_storeu_ps(dst +  4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+			_mm_storeu_ps(dst +  8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+			_mm_storeu_ps(dst + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+		}
+	}
+
+	reference::unpack_rgba8(src, count - i, srgb, dst);
+}
+void reshade::image::pack(const float *src, size_t count, reshadefx::texture_format format, bool srgb, uint8_t *dst)
+{
+	size_t i = 0;
+
+	switch (format)
+	{
+	case reshadefx::texture_format::r8:
+	case reshadefx::texture_format::rg8:
+	case reshadefx::texture_format::rgba8:
+		if (srgb)
+		{
+			const srgb_tables &tables = get_srgb_tables();
+			const __m128 scale = _mm_set_ps(255.0f, srgb_encode_table_size - 1.0f, srgb_encode_table_size - 1.0f, srgb_encode_table_size - 1.0f);
+
+			// Color channels are quantized to an index into the encoding table, alpha directly to its 8-bit value
+			for (const size_t channels = pixel_size(format); i < count; ++i, src += 4, dst += channels)
+			{
+				alignas(16) int32_t values[4];
+				_mm_store_si128(reinterpret_cast<__m128i *>(values), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(saturate(_mm_loadu_ps(src)), scale), _mm_set1_ps(0.5f))));
+
+				for (size_t c = 0; c < channels; ++c)
+					dst[c] = c < 3 ? tables.encode[values[c]] : static_cast<uint8_t>(values[c]);
+			}
+		}
+		else
+		{
+			const __m128 scale = _mm_set1_ps(255.0f);
+			const __m128 half = _mm_set1_ps(0.5f);
+
+			// Convert four pixels at a time to 32bpp RGBA
+			for (const size_t channels = pixel_size(format); i + 4 <= count; i += 4, src += 16, dst += channels * 4)
+			{
+				const __m128i p0 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(saturate(_mm_loadu_ps(src +  0)), scale), half));
+				const __m128i p1 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(saturate(_mm_loadu_ps(src +  4)), scale), half));
+				const __m128i p2 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(saturate(_mm_loadu_ps(src +  8)), scale), half));
+				const __m128i p3 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(saturate(_mm_loadu_ps(src + 12)), scale), half));
+				const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+
+				if (channels == 4)
+				{
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), bytes);
+				}
+				else
+				{
+					alignas(16) uint8_t rgba[16];
+					_mm_store_si128(reinterpret_cast<__m128i *>(rgba), bytes);
+
+					for (size_t k = 0; k < 4; ++k)
+						for (size_t c = 0; c < channels; ++c)
+							dst[k * channels + c] = rgba[k * 4 + c];
+				}
+			}
+		}
+		break;
+	case reshadefx::texture_format::r16f:
+		// Gather the red channel of four pixels into a single vector
+		for (; i + 4 <= count; i += 4, src += 16, dst += 8)
+		{
+			__m128 p0 = _mm_loadu_ps(src + 0), p1 = _mm_loadu_ps(src + 4), p2 = _mm_loadu_ps(src + 8), p3 = _mm_loadu_ps(src + 12);
+			_MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+			const __m128i h = float_to_half(p0);
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(dst), _mm_packs_epi32(h, h));
+		}
+		break;
+	case reshadefx::texture_format::rg16f:
+		// Combine the red and green channels of two pixels into a single vector
+		for (; i + 4 <= count; i += 4, src += 16, dst += 16)
+		{
+			const __m128i h0 = float_to_half(_mm_movelh_ps(_mm_loadu_ps(src + 0), _mm_loadu_ps(src +  4)));
+			const __m128i h1 = float_to_half(_mm_movelh_ps(_mm_loadu_ps(src + 8), _mm_loadu_ps(src + 12)));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_packs_epi32(h0, h1));
+		}
+		break;
+	case reshadefx::texture_format::rgba16f:
+		for (; i + 2 <= count; i += 2, src += 8, dst += 16)
+		{
+			const __m128i h0 = float_to_half(_mm_loadu_ps(src + 0));
+			const __m128i h1 = float_to_half(_mm_loadu_ps(src + 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_packs_epi32(h0, h1));
+		}
+		break;
+	case reshadefx::texture_format::rgb10a2:
+	{
+		const __m128 scale = _mm_set_ps(3.0f, 1023.0f, 1023.0f, 1023.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+
+		for (; i < count; ++i, src += 4, dst += 4)
+		{
+			alignas(16) uint32_t values[4];
+			_mm_store_si128(reinterpret_cast<__m128i *>(values), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(saturate(_mm_loadu_ps(src)), scale), half)));
+
+			const uint32_t value = values[0] | (values[1] << 10) | (values[2] << 20) | (values[3] << 30);
+			std::memcpy(dst, &value, 4);
+		}
+		break;
+	}
+	default:
+		assert(false);
+		return;
+	}
+
+	// Convert any remaining pixels that did not fill a whole vector
+	reference::pack(src, count - i, format, srgb, dst);
+}
+void reshade::image::downsample(const float *src, uint32_t width, uint32_t height, mipmap_filter filter, float *dst)
+{
+	const filter_kernel &kernel = get_kernel(filter);
+	const uint32_t dst_width = std::max(width / 2, 1u);
+	const uint32_t dst_height = std::max(height / 2, 1u);
+
+	// Filter is separable, so first reduce width and then height, each pixel being a vector of four channels
+	std::vector<float> temp(size_t(dst_width) * height * 4);
+
+	__m128 weights[12];
+	for (uint32_t t = 0; t < kernel.count; ++t)
+		weights[t] = _mm_set1_ps(kernel.weights[t]);
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		const float *const src_row = src + size_t(y) * width * 4;
+		float *const temp_row = temp.data() + size_t(y) * dst_width * 4;
+
+		for (uint32_t x = 0; x < dst_width; ++x)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (uint32_t t = 0; t < kernel.count; ++t)
+				sum = _mm_add_ps(sum, _mm_mul_ps(weights[t], _mm_loadu_ps(src_row + clamp_coordinate(static_cast<int>(2 * x + t) + kernel.first, width) * 4)));
+			_mm_storeu_ps(temp_row + x * 4, sum);
+		}
+	}
+
+	// Vertical pass works on whole rows, which are contiguous in memory
+	for (uint32_t y = 0; y < dst_height; ++y)
+	{
+		float *const dst_row = dst + size_t(y) * dst_width * 4;
+
+		for (uint32_t x = 0; x < dst_width * 4; x += 4)
+			_mm_storeu_ps(dst_row + x, _mm_setzero_ps());
+
+		for (uint32_t t = 0; t < kernel.count; ++t)
+		{
+			const float *const temp_row = temp.data() + size_t(clamp_coordinate(static_cast<int>(2 * y + t) + kernel.first, height)) * dst_width * 4;
+
+			for (uint32_t x = 0; x < dst_width * 4; x += 4)
+				_mm_storeu_ps(dst_row + x, _mm_add_ps(_mm_loadu_ps(dst_row + x), _mm_mul_ps(weights[t], _mm_loadu_ps(temp_row + x))));
+		}
+	}
+}
+#else
+void reshade::image::unpack_rgba8(const uint8_t *src, size_t count, bool srgb, float *dst)
+{
+	reference::unpack_rgba8(src, count, srgb, dst);
+}
+void reshade::image::pack(const float *src, size_t count, reshadefx::texture_format format, bool srgb, uint8_t *dst)
+{
+	reference::pack(src, count, format, srgb, dst);
+}
+void reshade::image::downsample(const float *src, uint32_t width, uint32_t height, mipmap_filter filter, float *dst)
+{
+	reference::downsample(src, width, height, filter, dst);
+}
+#endif
+
+std::vector<uint8_t> reshade::image::generate_mipmaps(const uint8_t *pixels, uint32_t width, uint32_t height, uint32_t levels, reshadefx::texture_format format, mipmap_filter filter, bool srgb)
+{
+	assert(is_convertible_format(format) && levels != 0);
+
+	size_t data_size = 0;
+	for (uint32_t level = 0; level < levels; ++level)
+		data_size += pixel_size(format) * std::max(width >> level, 1u) * std::max(height >> level, 1u);
+
+	std::vector<uint8_t> data(data_size);
+	uint8_t *level_data = data.data();
+
+	// Work on linear floating-point values, so that filtering does not lose precision between levels
+	std::vector<float> current(size_t(width) * height * 4), next;
+	unpack_rgba8(pixels, size_t(width) * height, srgb, current.data());
+
+	for (uint32_t level = 0; level < levels; ++level)
+	{
+		const uint32_t level_width = std::max(width >> level, 1u);
+		const uint32_t level_height = std::max(height >> level, 1u);
+
+		pack(current.data(), size_t(level_width) * level_height, format, srgb, level_data);
+		level_data += pixel_size(format) * level_width * level_height;
+
+		if (level + 1 < levels)
+		{
+			next.resize(size_t(std::max(level_width / 2, 1u)) * std::max(level_height / 2, 1u) * 4);
+			downsample(current.data(), level_width, level_height, filter, next.data());
+			current.swap(next);
+		}
+	}
+
+	return data;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "effect_module.hpp"
+
+namespace reshade::image
+{
+	/// <summary>
+	/// A filter used to reduce an image to the next mipmap level.
+	/// </summary>
+	enum class mipmap_filter
+	{
+		box, // Average of each 2x2 quad of pixels, which matches what GPU mipmap generation does
+		kaiser, // Kaiser-windowed sinc, which keeps more detail in the smaller levels at a slightly higher cost
+	};
+
+	/// <summary>
+	/// Returns whether 32bpp RGBA image data can be converted to the specified texture format on the CPU.
+	/// </summary>
+	bool is_convertible_format(reshadefx::texture_format format);
+
+	/// <summary>
+	/// Converts 32bpp RGBA pixels to floating-point RGBA values, optionally decoding the color channels from sRGB to linear.
+	/// </summary>
+	/// <param name="src">The 32bpp RGBA pixels to convert.</param>
+	/// <param name="count">The number of pixels to convert.</param>
+	/// <param name="srgb">Set to <c>true</c> if the color channels are sRGB encoded.</param>
+	/// <param name="dst">The output array that receives four floating-point values per pixel.</param>
+	void unpack_rgba8(const uint8_t *src, size_t count, bool srgb, float *dst);
+	/// <summary>
+	/// Converts floating-point RGBA values to pixels in the specified texture format, optionally encoding the color channels of 8-bit formats as sRGB.
+	/// </summary>
+	/// <param name="src">The floating-point RGBA values to convert.</param>
+	/// <param name="count">The number of pixels to convert.</param>
+	/// <param name="format">The texture format to convert to (see <see cref="is_convertible_format"/>).</param>
+	/// <param name="srgb">Set to <c>true</c> to encode the color channels as sRGB.</param>
+	/// <param name="dst">The output array that receives the tightly packed pixels.</param>
+	void pack(const float *src, size_t count, reshadefx::texture_format format, bool srgb, uint8_t *dst);
+	/// <summary>
+	/// Reduces floating-point RGBA image data to the next mipmap level, which is half the size in each dimension (rounded down, but at least one pixel).
+	/// </summary>
+	/// <param name="src">The floating-point RGBA values of the source image.</param>
+	/// <param name="width">The width of the source image.</param>
+	/// <param name="height">The height of the source image.</param>
+	/// <param name="filter">The filter to apply.</param>
+	/// <param name="dst">The output array that receives the floating-point RGBA values of the reduced image.</param>
+	void downsample(const float *src, uint32_t width, uint32_t height, mipmap_filter filter, float *dst);
+
+	/// <summary>
+	/// Builds mipmap levels from 32bpp RGBA image data and converts them to the specified texture format.
+	/// Filtering is done on linear values, so sRGB encoded images are decoded first and encoded again afterwards.
+	/// </summary>
+	/// <param name="pixels">The 32bpp RGBA image data of the first level.</param>
+	/// <param name="width">The width of the image.</param>
+	/// <param name="height">The height of the image.</param>
+	/// <param name="levels">The number of mipmap levels to build, including the first one.</param>
+	/// <param name="format">The texture format to convert to (see <see cref="is_convertible_format"/>).</param>
+	/// <param name="filter">The filter to apply.</param>
+	/// <param name="srgb">Set to <c>true</c> if the color channels of the image and of the output are sRGB encoded.</param>
+	/// <returns>All levels stored one after another without any row padding.</returns>
+	std::vector<uint8_t> generate_mipmaps(const uint8_t *pixels, uint32_t width, uint32_t height, uint32_t levels, reshadefx::texture_format format, mipmap_filter filter, bool srgb);
+
+	/// <summary>
+	/// Straightforward implementations of the conversions above, which the vectorized versions have to match.
+	/// </summary>
+	namespace reference
+	{
+		void unpack_rgba8(const uint8_t *src, size_t count, bool srgb, float *dst);
+		void pack(const float *src, size_t count, reshadefx::texture_format format, bool srgb, uint8_t *dst);
+		void downsample(const float *src, uint32_t width, uint32_t height, mipmap_filter filter, float *dst);
+
+		/// <summary>
+		/// Converts a single-precision floating-point value to half precision (rounding to nearest even).
+		/// </summary>
+		uint16_t float_to_half(float value);
+	}
+}
@@ -6,6 +6,7 @@
 #include "input.hpp"
 #include "dll_log.hpp"
 #include "hook_manager.hpp"
+#include <mutex>
 #include <algorithm>
 #include <unordered_map>
 #include <Windows.h>
@@ -133,11 +134,9 @@ bool reshade::input::handle_window_message(const void *message_data)
 	// Calculate window client mouse position
 	ScreenToClient(static_cast<HWND>(input->_window), &details.pt);
 
-	// Prevent input threads from modifying input while it is accessed elsewhere
-	const std::lock_guard<std::mutex> input_lock = input->lock();
-
-	input->_mouse_position[0] = details.pt.x;
-	input->_mouse_position[1] = details.pt.y;
+	// Only the state for the next frame is updated here, so there is no need to synchronize with the render thread
+	input->_next_mouse_position[0].store(details.pt.x, std::memory_order_relaxed);
+	input->_next_mouse_position[1].store(details.pt.y, std::memory_order_relaxed);
 
 	switch (details.message)
 	{
@@ -156,30 +155,30 @@ bool reshade::input::handle_window_message(const void *message_data)
 				break; // Input is already handled (since legacy mouse messages are enabled), so nothing to do here
 
 			if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_DOWN)
-				input->_keys[VK_LBUTTON] = 0x88;
+				input->key_down(VK_LBUTTON);
 			else if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_UP)
-				input->_keys[VK_LBUTTON] = 0x08;
+				input->key_up(VK_LBUTTON);
 			if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_RIGHT_BUTTON_DOWN)
-				input->_keys[VK_RBUTTON] = 0x88;
+				input->key_down(VK_RBUTTON);
 			else if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_RIGHT_BUTTON_UP)
-				input->_keys[VK_RBUTTON] = 0x08;
+				input->key_up(VK_RBUTTON);
 			if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_MIDDLE_BUTTON_DOWN)
-				input->_keys[VK_MBUTTON] = 0x88;
+				input->key_down(VK_MBUTTON);
 			else if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_MIDDLE_BUTTON_UP)
-				input->_keys[VK_MBUTTON] = 0x08;
+				input->key_up(VK_MBUTTON);
 
 			if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_BUTTON_4_DOWN)
-				input->_keys[VK_XBUTTON1] = 0x88;
+				input->key_down(VK_XBUTTON1);
 			else if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_BUTTON_4_UP)
-				input->_keys[VK_XBUTTON1] = 0x08;
+				input->key_up(VK_XBUTTON1);
 
 			if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_BUTTON_5_DOWN)
-				input->_keys[VK_XBUTTON2] = 0x88;
+				input->key_down(VK_XBUTTON2);
 			else if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_BUTTON_5_UP)
-				input->_keys[VK_XBUTTON2] = 0x08;
+				input->key_up(VK_XBUTTON2);
 
 			if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_WHEEL)
-				input->_mouse_wheel_delta += static_cast<short>(raw_data.data.mouse.usButtonData) / WHEEL_DELTA;
+				input->_next_mouse_wheel_delta.fetch_add(static_cast<short>(static_cast<short>(raw_data.data.mouse.usButtonData) / WHEEL_DELTA), std::memory_order_relaxed);
 			break;
 		case RIM_TYPEKEYBOARD:
 			if (raw_data.data.keyboard.VKey == 0)
@@ -187,7 +186,7 @@ bool reshade::input::handle_window_message(const void *message_data)
 
 			is_keyboard_message = true;
 			// Do not block key up messages if the key down one was not blocked previously
-			if (input->_block_keyboard && (raw_data.data.keyboard.Flags & RI_KEY_BREAK) != 0 && raw_data.data.keyboard.VKey < 0xFF && (input->_keys[raw_data.data.keyboard.VKey] & 0x04) == 0)
+			if (input->_block_keyboard && (raw_data.data.keyboard.Flags & RI_KEY_BREAK) != 0 && raw_data.data.keyboard.VKey < 0xFF && (input->_next_keys[raw_data.data.keyboard.VKey].load(std::memory_order_relaxed) & 0x04) == 0)
 				is_keyboard_message = false;
 
 			if (raw_input_window == s_raw_input_windows.end() || (raw_input_window->second & 0x1) == 0)
@@ -195,74 +194,110 @@ bool reshade::input::handle_window_message(const void *message_data)
 
 			// Filter out prefix messages without a key code
 			if (raw_data.data.keyboard.VKey < 0xFF)
-				input->_keys[raw_data.data.keyboard.VKey] = (raw_data.data.keyboard.Flags & RI_KEY_BREAK) == 0 ? 0x88 : 0x08,
-				input->_keys_time[raw_data.data.keyboard.VKey] = details.time;
+			{
+				input->_next_keys_time[raw_data.data.keyboard.VKey].store(details.time, std::memory_order_relaxed);
+				if ((raw_data.data.keyboard.Flags & RI_KEY_BREAK) == 0)
+					input->key_down(raw_data.data.keyboard.VKey);
+				else
+					input->key_up(raw_data.data.keyboard.VKey);
+			}
 
 			// No 'WM_CHAR' messages are sent if legacy keyboard messages are disabled, so need to generate text input manually here
 			// Cannot use the ToUnicode function always as it seems to reset dead key state and thus calling it can break subsequent application input, should be fine here though since the application is already explicitly using raw input
 			// Since Windows 10 version 1607 this supports the 0x2 flag, which prevents the keyboard state from being changed, so it is not a problem there anymore either way
-			if (WCHAR ch[3] = {}; (raw_data.data.keyboard.Flags & RI_KEY_BREAK) == 0 && ToUnicode(raw_data.data.keyboard.VKey, raw_data.data.keyboard.MakeCode, input->_keys, ch, 2, 0x2))
-				input->_text_input += ch;
+			if ((raw_data.data.keyboard.Flags & RI_KEY_BREAK) == 0)
+			{
+				BYTE keys[256];
+				for (unsigned int i = 0; i < 256; ++i)
+					keys[i] = input->_next_keys[i].load(std::memory_order_relaxed) & 0x80;
+				keys[VK_CAPITAL] |= GetKeyState(VK_CAPITAL) & 0x1;
+
+				WCHAR ch[3] = {};
+				for (int i = 0, count = ToUnicode(raw_data.data.keyboard.VKey, raw_data.data.keyboard.MakeCode, keys, ch, 2, 0x2); i < count; ++i)
+					input->add_text_input(ch[i]);
+			}
 			break;
 		}
 		break;
 	case WM_CHAR:
-		input->_text_input += static_cast<wchar_t>(details.wParam);
+		input->add_text_input(static_cast<wchar_t>(details.wParam));
 		break;
 	case WM_KEYDOWN:
 	case WM_SYSKEYDOWN:
 		assert(details.wParam > 0 && details.wParam < ARRAYSIZE(input->_keys));
-		input->_keys[details.wParam] = 0x88;
-		input->_keys_time[details.wParam] = details.time;
-		if (input->_block_keyboard)
-			input->_keys[details.wParam] |= 0x04;
+		input->_next_keys_time[details.wParam].store(details.time, std::memory_order_relaxed);
+		input->key_down(static_cast<unsigned int>(details.wParam), input->_block_keyboard);
 		break;
 	case WM_KEYUP:
 	case WM_SYSKEYUP:
 		assert(details.wParam > 0 && details.wParam < ARRAYSIZE(input->_keys));
 		// Do not block key up messages if the key down one was not blocked previously (so key does not get stuck for the application)
-		if (input->_block_keyboard && (input->_keys[details.wParam] & 0x04) == 0)
+		if (input->_block_keyboard && (input->_next_keys[details.wParam].load(std::memory_order_relaxed) & 0x04) == 0)
 			is_keyboard_message = false;
-		input->_keys[details.wParam] = 0x08;
-		input->_keys_time[details.wParam] = details.time;
+		input->_next_keys_time[details.wParam].store(details.time, std::memory_order_relaxed);
+		input->key_up(static_cast<unsigned int>(details.wParam));
 		break;
 	case WM_LBUTTONDOWN:
 	case WM_LBUTTONDBLCLK: // Double clicking generates this sequence: WM_LBUTTONDOWN -> WM_LBUTTONUP -> WM_LBUTTONDBLCLK -> WM_LBUTTONUP, so handle it like a normal down
-		input->_keys[VK_LBUTTON] = 0x88;
+		input->key_down(VK_LBUTTON);
 		break;
 	case WM_LBUTTONUP:
-		input->_keys[VK_LBUTTON] = 0x08;
+		input->key_up(VK_LBUTTON);
 		break;
 	case WM_RBUTTONDOWN:
 	case WM_RBUTTONDBLCLK:
-		input->_keys[VK_RBUTTON] = 0x88;
+		input->key_down(VK_RBUTTON);
 		break;
 	case WM_RBUTTONUP:
-		input->_keys[VK_RBUTTON] = 0x08;
+		input->key_up(VK_RBUTTON);
 		break;
 	case WM_MBUTTONDOWN:
 	case WM_MBUTTONDBLCLK:
-		input->_keys[VK_MBUTTON] = 0x88;
+		input->key_down(VK_MBUTTON);
 		break;
 	case WM_MBUTTONUP:
-		input->_keys[VK_MBUTTON] = 0x08;
+		input->key_up(VK_MBUTTON);
 		break;
 	case WM_MOUSEWHEEL:
-		input->_mouse_wheel_delta += GET_WHEEL_DELTA_WPARAM(details.wParam) / WHEEL_DELTA;
+		input->_next_mouse_wheel_delta.fetch_add(static_cast<short>(GET_WHEEL_DELTA_WPARAM(details.wParam) / WHEEL_DELTA), std::memory_order_relaxed);
 		break;
 	case WM_XBUTTONDOWN:
 		assert(HIWORD(details.wParam) == XBUTTON1 || HIWORD(details.wParam) == XBUTTON2);
-		input->_keys[VK_XBUTTON1 + (HIWORD(details.wParam) - XBUTTON1)] = 0x88;
+		input->key_down(VK_XBUTTON1 + (HIWORD(details.wParam) - XBUTTON1));
 		break;
 	case WM_XBUTTONUP:
 		assert(HIWORD(details.wParam) == XBUTTON1 || HIWORD(details.wParam) == XBUTTON2);
-		input->_keys[VK_XBUTTON1 + (HIWORD(details.wParam) - XBUTTON1)] = 0x08;
+		input->key_up(VK_XBUTTON1 + (HIWORD(details.wParam) - XBUTTON1));
 		break;
 	}
 
 	return (is_mouse_message && input->_block_mouse) || (is_keyboard_message && input->_block_keyboard);
 }
 
+void reshade::input::key_down(unsigned int keycode, bool blocked)
+{
+	// Use a compare-exchange loop, since the render thread may clear the pressed and released flags at the same time
+	for (uint8_t state = _next_keys[keycode].load(std::memory_order_relaxed);
+		!_next_keys[keycode].compare_exchange_weak(state, static_cast<uint8_t>((state & ~0x04) | 0x81 | (blocked ? 0x04 : 0x00)), std::memory_order_release, std::memory_order_relaxed);)
+		continue;
+}
+void reshade::input::key_up(unsigned int keycode)
+{
+	for (uint8_t state = _next_keys[keycode].load(std::memory_order_relaxed);
+		!_next_keys[keycode].compare_exchange_weak(state, static_cast<uint8_t>((state & ~0x84) | 0x02), std::memory_order_release, std::memory_order_relaxed);)
+		continue;
+}
+void reshade::input::add_text_input(wchar_t c)
+{
+	// This is a single producer, single consumer ring buffer, so only the write position is modified here
+	const uint32_t write_pos = _next_text_input_write.load(std::memory_order_relaxed);
+	if (write_pos - _next_text_input_read.load(std::memory_order_acquire) >= ARRAYSIZE(_next_text_input))
+		return; // Drop characters if the render thread does not keep up
+
+	_next_text_input[write_pos % ARRAYSIZE(_next_text_input)] = c;
+	_next_text_input_write.store(write_pos + 1, std::memory_order_release);
+}
+
 bool reshade::input::is_key_down(unsigned int keycode) const
 {
 	assert(keycode < ARRAYSIZE(_keys));
@@ -364,38 +399,57 @@ void reshade::input::next_frame()
 {
 	_frame_count++;
 
-	for (auto &state : _keys)
-		state &= ~0x08;
-
 	// Reset any pressed down key states (apart from mouse buttons) that have not been updated for more than 5 seconds
 	// Do not check mouse buttons here, since 'GetAsyncKeyState' always returns the state of the physical mouse buttons, not the logical ones in case they were remapped
 	// See https://docs.microsoft.com/windows/win32/api/winuser/nf-winuser-getasynckeystate
 	// And time is not tracked for mouse buttons anyway
 	const DWORD time = GetTickCount();
 	for (unsigned int i = 8; i < 256; ++i)
-		if ((_keys[i] & 0x80) != 0 &&
-			(time - _keys_time[i]) > 5000 &&
+		if ((_next_keys[i].load(std::memory_order_relaxed) & 0x80) != 0 &&
+			(time - _next_keys_time[i].load(std::memory_order_relaxed)) > 5000 &&
 			(GetAsyncKeyState(i) & 0x8000) == 0)
-			(_keys[i] = 0x08);
-
-	_text_input.clear();
-	_mouse_wheel_delta = 0;
-	_last_mouse_position[0] = _mouse_position[0];
-	_last_mouse_position[1] = _mouse_position[1];
-
-	// Update caps lock state
-	_keys[VK_CAPITAL] |= GetKeyState(VK_CAPITAL) & 0x1;
+			key_up(i);
 
 	// Update modifier key state
-	if ((_keys[VK_MENU] & 0x88) != 0 &&
+	if ((_next_keys[VK_MENU].load(std::memory_order_relaxed) & 0x80) != 0 &&
 		(GetKeyState(VK_MENU) & 0x8000) == 0)
-		(_keys[VK_MENU] = 0x08);
+		key_up(VK_MENU);
 
 	// Update print screen state (there is no key down message, but the key up one is received via the message queue)
-	if ((_keys[VK_SNAPSHOT] & 0x80) == 0 &&
+	if ((_next_keys[VK_SNAPSHOT].load(std::memory_order_relaxed) & 0x80) == 0 &&
 		(GetAsyncKeyState(VK_SNAPSHOT) & 0x8000) != 0)
-		(_keys[VK_SNAPSHOT] = 0x88),
-		(_keys_time[VK_SNAPSHOT] = time);
+		_next_keys_time[VK_SNAPSHOT].store(time, std::memory_order_relaxed),
+		key_down(VK_SNAPSHOT);
+
+	// Take the pressed and released flags, so that every key press is seen for exactly one frame, even if the key was released again before that frame
+	for (unsigned int i = 0; i < 256; ++i)
+	{
+		const uint8_t state = _next_keys[i].fetch_and(static_cast<uint8_t>(~0x03), std::memory_order_acquire);
+
+		if ((state & 0x01) != 0)
+			// Key was pressed, if it was released again already, report that in the next frame (0x02)
+			_keys[i] = (state & 0x80) != 0 ? 0x88 : 0x8A;
+		else if ((state & 0x02) != 0 || (_keys[i] & 0x02) != 0)
+			_keys[i] = 0x08;
+		else
+			_keys[i] = state & 0x80;
+	}
+
+	// Update caps lock state
+	_keys[VK_CAPITAL] |= GetKeyState(VK_CAPITAL) & 0x1;
+
+	_mouse_wheel_delta = _next_mouse_wheel_delta.exchange(0, std::memory_order_relaxed);
+	_last_mouse_position[0] = _mouse_position[0];
+	_last_mouse_position[1] = _mouse_position[1];
+	_mouse_position[0] = _next_mouse_position[0].load(std::memory_order_relaxed);
+	_mouse_position[1] = _next_mouse_position[1].load(std::memory_order_relaxed);
+
+	_text_input.clear();
+	const uint32_t read_pos = _next_text_input_read.load(std::memory_order_relaxed);
+	const uint32_t write_pos = _next_text_input_write.load(std::memory_order_acquire);
+	for (uint32_t pos = read_pos; pos != write_pos; ++pos)
+		_text_input += _next_text_input[pos % ARRAYSIZE(_next_text_input)];
+	_next_text_input_read.store(write_pos, std::memory_order_release);
 }
 
 std::string reshade::input::key_name(unsigned int keycode)
@@ -5,7 +5,7 @@
 
 #pragma once
 
-#include <mutex>
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -73,15 +73,9 @@ namespace reshade
 		void block_keyboard_input(bool enable) { _block_keyboard = enable; }
 		bool is_blocking_keyboard_input() const { return _block_keyboard; }
 
-		/// <summary>
-		/// Locks access to the input data to the current thread.
-		/// </summary>
-		/// <returns>A RAII object holding the lock, which releases it after going out of scope.</returns>
-		auto lock() { return std::lock_guard<std::mutex>(_mutex); }
-
 		/// <summary>
 		/// Notifies the input manager to advance a frame.
-		/// This updates input state to e.g. track whether a key was pressed this frame or before.
+		/// This takes a snapshot of all input received since the last call, which is what the query functions above return until the next frame.
 		/// </summary>
 		void next_frame();
 
@@ -104,16 +98,30 @@ namespace reshade
 		static bool handle_window_message(const void *message_data);
 
 	private:
-		std::mutex _mutex;
+		void key_down(unsigned int keycode, bool blocked = false);
+		void key_up(unsigned int keycode);
+		void add_text_input(wchar_t c);
+
 		window_handle _window;
 		bool _block_mouse = false;
 		bool _block_keyboard = false;
+		uint64_t _frame_count = 0; // Keep track of frame count to identify windows with a lot of rendering
+
+		// Snapshot of the input state for the current frame, which is only accessed by the render thread
 		uint8_t _keys[256] = {};
-		unsigned int _keys_time[256] = {};
 		short _mouse_wheel_delta = 0;
 		unsigned int _mouse_position[2] = {};
 		unsigned int _last_mouse_position[2] = {};
-		uint64_t _frame_count = 0; // Keep track of frame count to identify windows with a lot of rendering
 		std::wstring _text_input;
+
+		// Input state that is written by the window message hooks and copied into the snapshot above in 'next_frame'
+		// Messages for a window are always processed on the thread that created it, so there is only ever a single writer
+		std::atomic<uint8_t> _next_keys[256] = {}; // Key is down (0x80), down message was blocked (0x04), key was released (0x02) or pressed (0x01) since the last frame
+		std::atomic<unsigned int> _next_keys_time[256] = {};
+		std::atomic<short> _next_mouse_wheel_delta = 0;
+		std::atomic<unsigned int> _next_mouse_position[2] = {};
+		wchar_t _next_text_input[256] = {}; // Ring buffer of characters that were entered since the last frame
+		std::atomic<uint32_t> _next_text_input_write = 0;
+		std::atomic<uint32_t> _next_text_input_read = 0;
 	};
 }
@@ -50,6 +50,46 @@ namespace reshade::opengl
 		bool query_in_flight = false;
 		std::vector<pass_data> passes;
 	};
+
+	struct effect_data
+	{
+		GLuint ubo = 0;
+		std::unordered_map<std::string, GLuint> entry_points; // Shader objects, which are compiled when the first pass using them is initialized
+	};
+}
+
+#ifndef GL_EXT_texture_compression_s3tc
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_EXT_texture_sRGB
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT 0x8C4E
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+static GLenum convert_compressed_format(reshadefx::texture_format format, bool srgb = false)
+{
+	switch (format)
+	{
+	case reshadefx::texture_format::bc1:
+		return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case reshadefx::texture_format::bc2:
+		return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT : GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+	case reshadefx::texture_format::bc3:
+		return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case reshadefx::texture_format::bc4:
+		return srgb ? GL_NONE : GL_COMPRESSED_RED_RGTC1;
+	case reshadefx::texture_format::bc5:
+		return srgb ? GL_NONE : GL_COMPRESSED_RG_RGTC2;
+	case reshadefx::texture_format::bc6h:
+		return srgb ? GL_NONE : GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+	case reshadefx::texture_format::bc7:
+		return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	default:
+		return GL_NONE;
+	}
 }
 
 reshade::opengl::runtime_gl::runtime_gl()
@@ -374,29 +414,63 @@ bool reshade::opengl::runtime_gl::capture_screenshot(uint8_t *buffer) const
 	return true;
 }
 
-bool reshade::opengl::runtime_gl::init_effect(size_t index)
+bool reshade::opengl::runtime_gl::init_effect(effect &effect)
 {
 	assert(_app_state.has_state); // Make sure all binds below are reset later when application state is restored
 
-	effect &effect = _effects[index];
+	auto impl = new effect_data();
+	effect.impl = impl;
 
-	// Add specialization constant defines to source code
-	std::vector<GLuint> spec_data;
-	std::vector<GLuint> spec_constants;
-	if (!effect.module.spirv.empty())
+	if (!effect.uniform_data_storage.empty())
 	{
-		for (const reshadefx::uniform_info &constant : effect.module.spec_constants)
+		glGenBuffers(1, &impl->ubo);
+		glBindBuffer(GL_UNIFORM_BUFFER, impl->ubo);
+		glBufferData(GL_UNIFORM_BUFFER, effect.uniform_data_storage.size(), effect.uniform_data_storage.data(), GL_DYNAMIC_DRAW);
+	}
+
+	assert(effect.module.num_texture_bindings == 0); // Use combined texture samplers
+
+	return true;
+}
+bool reshade::opengl::runtime_gl::init_technique(effect &, technique &technique)
+{
+	auto impl = new technique_data();
+	technique.impl = impl;
+
+	glGenQueries(1, &impl->query);
+
+	impl->passes.resize(technique.passes.size());
+
+	return true;
+}
+bool reshade::opengl::runtime_gl::init_pass(effect &effect, technique &technique, size_t pass_index)
+{
+	assert(_app_state.has_state); // Make sure all binds below are reset later when application state is restored
+
+	const auto effect_impl = static_cast<effect_data *>(effect.impl);
+	const auto impl = static_cast<technique_data *>(technique.impl);
+
+	// Compile entry points when they are first used, so that their cost is spread across the passes
+	const auto compile_shader = [this, &effect, effect_impl](const std::string &name) -> GLuint {
+		if (const auto it = effect_impl->entry_points.find(name); it != effect_impl->entry_points.end())
+			return it->second;
+
+		const reshadefx::entry_point &entry_point = *std::find_if(effect.module.entry_points.begin(), effect.module.entry_points.end(),
+			[&name](const reshadefx::entry_point &entry_point) { return entry_point.name == name; });
+
+		// Add specialization constant defines to source code
+		std::vector<GLuint> spec_data;
+		std::vector<GLuint> spec_constants;
+		if (!effect.module.spirv.empty())
 		{
-			const GLuint id = static_cast<GLuint>(spec_constants.size());
-			spec_data.push_back(constant.initializer_value.as_uint[0]);
-			spec_constants.push_back(id);
+			for (const reshadefx::uniform_info &constant : effect.module.spec_constants)
+			{
+				const GLuint id = static_cast<GLuint>(spec_constants.size());
+				spec_data.push_back(constant.initializer_value.as_uint[0]);
+				spec_constants.push_back(id);
+			}
 		}
-	}
 
-	// Compile all entry points
-	std::unordered_map<std::string, GLuint> entry_points;
-	for (const reshadefx::entry_point &entry_point : effect.module.entry_points)
-	{
 		GLuint shader_type = GL_NONE;
 		switch (entry_point.type)
 		{
@@ -411,8 +485,7 @@ bool reshade::opengl::runtime_gl::init_effect(size_t index)
 			break;
 		}
 
-		GLuint shader_object = glCreateShader(shader_type);
-		entry_points[entry_point.name] = shader_object;
+		const GLuint shader_object = glCreateShader(shader_type);
 
 		if (!effect.module.spirv.empty())
 		{
@@ -474,353 +547,298 @@ bool reshade::opengl::runtime_gl::init_effect(size_t index)
 
 			effect.errors += log.data();
 
-			for (auto &it : entry_points)
-				glDeleteShader(it.second);
-
-			// No need to setup resources if any of the shaders failed to compile
-			return false;
+			glDeleteShader(shader_object);
+			return 0;
 		}
-	}
-
-	if (index >= _effect_ubos.size())
-		_effect_ubos.resize(index + 1);
 
-	if (!effect.uniform_data_storage.empty())
-	{
-		GLuint &ubo = _effect_ubos[index];
-		glGenBuffers(1, &ubo);
-		glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-		glBufferData(GL_UNIFORM_BUFFER, effect.uniform_data_storage.size(), effect.uniform_data_storage.data(), GL_DYNAMIC_DRAW);
-	}
+		return effect_impl->entry_points[name] = shader_object;
+	};
 
-	bool success = true;
-	assert(effect.module.num_texture_bindings == 0); // Use combined texture samplers
+	pass_data &pass_data = impl->passes[pass_index];
+	reshadefx::pass_info &pass_info = technique.passes[pass_index];
 
-	for (technique &technique : _techniques)
+	if (!pass_info.cs_entry_point.empty())
 	{
-		if (technique.impl != nullptr || technique.effect_index != index)
-			continue;
-
-		// Copy construct new technique implementation instead of move because effect may contain multiple techniques
-		auto impl = new technique_data();
-		technique.impl = impl;
+		const GLuint cs_shader_id = compile_shader(pass_info.cs_entry_point);
+		if (cs_shader_id == 0)
+			return false;
 
-		glGenQueries(1, &impl->query);
+		pass_data.program = glCreateProgram();
+		glAttachShader(pass_data.program, cs_shader_id);
+		glLinkProgram(pass_data.program);
+		glDetachShader(pass_data.program, cs_shader_id);
 
-		impl->passes.resize(technique.passes.size());
-		for (size_t pass_index = 0; pass_index < technique.passes.size(); ++pass_index)
+		pass_data.storages.resize(effect.module.num_storage_bindings);
+		for (const reshadefx::storage_info &info : pass_info.storages)
 		{
-			pass_data &pass_data = impl->passes[pass_index];
-			reshadefx::pass_info &pass_info = technique.passes[pass_index];
-
-			pass_data.program = glCreateProgram();
+			const texture &texture = look_up_texture_by_name(info.texture_name);
 
-			if (!pass_info.cs_entry_point.empty())
-			{
-				const GLuint cs_shader_id = entry_points.at(pass_info.cs_entry_point);
-				glAttachShader(pass_data.program, cs_shader_id);
-				glLinkProgram(pass_data.program);
-				glDetachShader(pass_data.program, cs_shader_id);
+			pass_data.storages[info.binding] = static_cast<tex_data *>(texture.impl);
+		}
+	}
+	else
+	{
+		// Link program from input shaders
+		const GLuint vs_shader_id = compile_shader(pass_info.vs_entry_point);
+		const GLuint fs_shader_id = compile_shader(pass_info.ps_entry_point);
+		if (vs_shader_id == 0 || fs_shader_id == 0)
+			return false;
 
-				pass_data.storages.resize(effect.module.num_storage_bindings);
-				for (const reshadefx::storage_info &info : pass_info.storages)
-				{
-					const texture &texture = look_up_texture_by_name(info.texture_name);
+		pass_data.program = glCreateProgram();
+		glAttachShader(pass_data.program, vs_shader_id);
+		glAttachShader(pass_data.program, fs_shader_id);
+		glLinkProgram(pass_data.program);
+		glDetachShader(pass_data.program, vs_shader_id);
+		glDetachShader(pass_data.program, fs_shader_id);
 
-					pass_data.storages[info.binding] = static_cast<tex_data *>(texture.impl);
-				}
+		const auto convert_blend_op = [](reshadefx::pass_blend_op value) -> GLenum {
+			switch (value)
+			{
+			default:
+			case reshadefx::pass_blend_op::add: return GL_FUNC_ADD;
+			case reshadefx::pass_blend_op::subtract: return GL_FUNC_SUBTRACT;
+			case reshadefx::pass_blend_op::rev_subtract: return GL_FUNC_REVERSE_SUBTRACT;
+			case reshadefx::pass_blend_op::min: return GL_MIN;
+			case reshadefx::pass_blend_op::max: return GL_MAX;
 			}
-			else
+		};
+		const auto convert_blend_func = [](reshadefx::pass_blend_func value) -> GLenum {
+			switch (value)
 			{
-				// Link program from input shaders
-				const GLuint vs_shader_id = entry_points.at(pass_info.vs_entry_point);
-				const GLuint fs_shader_id = entry_points.at(pass_info.ps_entry_point);
-				glAttachShader(pass_data.program, vs_shader_id);
-				glAttachShader(pass_data.program, fs_shader_id);
-				glLinkProgram(pass_data.program);
-				glDetachShader(pass_data.program, vs_shader_id);
-				glDetachShader(pass_data.program, fs_shader_id);
-
-				const auto convert_blend_op = [](reshadefx::pass_blend_op value) -> GLenum {
-					switch (value)
-					{
-					default:
-					case reshadefx::pass_blend_op::add: return GL_FUNC_ADD;
-					case reshadefx::pass_blend_op::subtract: return GL_FUNC_SUBTRACT;
-					case reshadefx::pass_blend_op::rev_subtract: return GL_FUNC_REVERSE_SUBTRACT;
-					case reshadefx::pass_blend_op::min: return GL_MIN;
-					case reshadefx::pass_blend_op::max: return GL_MAX;
-					}
-				};
-				const auto convert_blend_func = [](reshadefx::pass_blend_func value) -> GLenum {
-					switch (value)
-					{
-					case reshadefx::pass_blend_func::zero: return GL_ZERO;
-					default:
-					case reshadefx::pass_blend_func::one: return GL_ONE;
-					case reshadefx::pass_blend_func::src_color: return GL_SRC_COLOR;
-					case reshadefx::pass_blend_func::src_alpha: return GL_SRC_ALPHA;
-					case reshadefx::pass_blend_func::inv_src_color: return GL_ONE_MINUS_SRC_COLOR;
-					case reshadefx::pass_blend_func::inv_src_alpha: return GL_ONE_MINUS_SRC_ALPHA;
-					case reshadefx::pass_blend_func::dst_color: return GL_DST_COLOR;
-					case reshadefx::pass_blend_func::dst_alpha: return GL_DST_ALPHA;
-					case reshadefx::pass_blend_func::inv_dst_color: return GL_ONE_MINUS_DST_COLOR;
-					case reshadefx::pass_blend_func::inv_dst_alpha: return GL_ONE_MINUS_DST_ALPHA;
-					}
-				};
-				const auto convert_stencil_op = [](reshadefx::pass_stencil_op value) -> GLenum {
-					switch (value)
-					{
-					case reshadefx::pass_stencil_op::zero: return GL_ZERO;
-					default:
-					case reshadefx::pass_stencil_op::keep: return GL_KEEP;
-					case reshadefx::pass_stencil_op::invert: return GL_INVERT;
-					case reshadefx::pass_stencil_op::replace: return GL_REPLACE;
-					case reshadefx::pass_stencil_op::incr: return GL_INCR_WRAP;
-					case reshadefx::pass_stencil_op::incr_sat: return GL_INCR;
-					case reshadefx::pass_stencil_op::decr: return GL_DECR_WRAP;
-					case reshadefx::pass_stencil_op::decr_sat: return GL_DECR;
-					}
-				};
-				const auto convert_stencil_func = [](reshadefx::pass_stencil_func value) -> GLenum {
-					switch (value)
-					{
-					case reshadefx::pass_stencil_func::never: return GL_NEVER;
-					case reshadefx::pass_stencil_func::equal: return GL_EQUAL;
-					case reshadefx::pass_stencil_func::not_equal: return GL_NOTEQUAL;
-					case reshadefx::pass_stencil_func::less: return GL_LESS;
-					case reshadefx::pass_stencil_func::less_equal: return GL_LEQUAL;
-					case reshadefx::pass_stencil_func::greater: return GL_GREATER;
-					case reshadefx::pass_stencil_func::greater_equal: return GL_GEQUAL;
-					default:
-					case reshadefx::pass_stencil_func::always: return GL_ALWAYS;
-					}
-				};
-
-				pass_data.blend_eq_color = convert_blend_op(pass_info.blend_op);
-				pass_data.blend_eq_alpha = convert_blend_op(pass_info.blend_op_alpha);
-				pass_data.blend_src = convert_blend_func(pass_info.src_blend);
-				pass_data.blend_dest = convert_blend_func(pass_info.dest_blend);
-				pass_data.blend_src_alpha = convert_blend_func(pass_info.src_blend_alpha);
-				pass_data.blend_dest_alpha = convert_blend_func(pass_info.dest_blend_alpha);
-				pass_data.stencil_func = convert_stencil_func(pass_info.stencil_comparison_func);
-				pass_data.stencil_op_z_pass = convert_stencil_op(pass_info.stencil_op_pass);
-				pass_data.stencil_op_fail = convert_stencil_op(pass_info.stencil_op_fail);
-				pass_data.stencil_op_z_fail = convert_stencil_op(pass_info.stencil_op_depth_fail);
-
-				glGenFramebuffers(1, &pass_data.fbo);
-				glBindFramebuffer(GL_FRAMEBUFFER, pass_data.fbo);
-
-				if (pass_info.render_target_names[0].empty())
-				{
-					pass_info.viewport_width = _width;
-					pass_info.viewport_height = _height;
+			case reshadefx::pass_blend_func::zero: return GL_ZERO;
+			default:
+			case reshadefx::pass_blend_func::one: return GL_ONE;
+			case reshadefx::pass_blend_func::src_color: return GL_SRC_COLOR;
+			case reshadefx::pass_blend_func::src_alpha: return GL_SRC_ALPHA;
+			case reshadefx::pass_blend_func::inv_src_color: return GL_ONE_MINUS_SRC_COLOR;
+			case reshadefx::pass_blend_func::inv_src_alpha: return GL_ONE_MINUS_SRC_ALPHA;
+			case reshadefx::pass_blend_func::dst_color: return GL_DST_COLOR;
+			case reshadefx::pass_blend_func::dst_alpha: return GL_DST_ALPHA;
+			case reshadefx::pass_blend_func::inv_dst_color: return GL_ONE_MINUS_DST_COLOR;
+			case reshadefx::pass_blend_func::inv_dst_alpha: return GL_ONE_MINUS_DST_ALPHA;
+			}
+		};
+		const auto convert_stencil_op = [](reshadefx::pass_stencil_op value) -> GLenum {
+			switch (value)
+			{
+			case reshadefx::pass_stencil_op::zero: return GL_ZERO;
+			default:
+			case reshadefx::pass_stencil_op::keep: return GL_KEEP;
+			case reshadefx::pass_stencil_op::invert: return GL_INVERT;
+			case reshadefx::pass_stencil_op::replace: return GL_REPLACE;
+			case reshadefx::pass_stencil_op::incr: return GL_INCR_WRAP;
+			case reshadefx::pass_stencil_op::incr_sat: return GL_INCR;
+			case reshadefx::pass_stencil_op::decr: return GL_DECR_WRAP;
+			case reshadefx::pass_stencil_op::decr_sat: return GL_DECR;
+			}
+		};
+		const auto convert_stencil_func = [](reshadefx::pass_stencil_func value) -> GLenum {
+			switch (value)
+			{
+			case reshadefx::pass_stencil_func::never: return GL_NEVER;
+			case reshadefx::pass_stencil_func::equal: return GL_EQUAL;
+			case reshadefx::pass_stencil_func::not_equal: return GL_NOTEQUAL;
+			case reshadefx::pass_stencil_func::less: return GL_LESS;
+			case reshadefx::pass_stencil_func::less_equal: return GL_LEQUAL;
+			case reshadefx::pass_stencil_func::greater: return GL_GREATER;
+			case reshadefx::pass_stencil_func::greater_equal: return GL_GEQUAL;
+			default:
+			case reshadefx::pass_stencil_func::always: return GL_ALWAYS;
+			}
+		};
+
+		pass_data.blend_eq_color = convert_blend_op(pass_info.blend_op);
+		pass_data.blend_eq_alpha = convert_blend_op(pass_info.blend_op_alpha);
+		pass_data.blend_src = convert_blend_func(pass_info.src_blend);
+		pass_data.blend_dest = convert_blend_func(pass_info.dest_blend);
+		pass_data.blend_src_alpha = convert_blend_func(pass_info.src_blend_alpha);
+		pass_data.blend_dest_alpha = convert_blend_func(pass_info.dest_blend_alpha);
+		pass_data.stencil_func = convert_stencil_func(pass_info.stencil_comparison_func);
+		pass_data.stencil_op_z_pass = convert_stencil_op(pass_info.stencil_op_pass);
+		pass_data.stencil_op_fail = convert_stencil_op(pass_info.stencil_op_fail);
+		pass_data.stencil_op_z_fail = convert_stencil_op(pass_info.stencil_op_depth_fail);
+
+		glGenFramebuffers(1, &pass_data.fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, pass_data.fbo);
+
+		if (pass_info.render_target_names[0].empty())
+		{
+			pass_info.viewport_width = _width;
+			pass_info.viewport_height = _height;
 
-					glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _rbo[RBO_COLOR]);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _rbo[RBO_COLOR]);
 
-					pass_data.draw_targets[0] = GL_COLOR_ATTACHMENT0;
-				}
-				else
-				{
-					for (uint32_t k = 0; k < 8 && !pass_info.render_target_names[k].empty(); ++k)
-					{
-						tex_data *const tex_impl = static_cast<tex_data *>(
-							look_up_texture_by_name(pass_info.render_target_names[k]).impl);
+			pass_data.draw_targets[0] = GL_COLOR_ATTACHMENT0;
+		}
+		else
+		{
+			for (uint32_t k = 0; k < 8 && !pass_info.render_target_names[k].empty(); ++k)
+			{
+				tex_data *const tex_impl = static_cast<tex_data *>(
+					look_up_texture_by_name(pass_info.render_target_names[k]).impl);
 
-						pass_data.draw_targets[k] = GL_COLOR_ATTACHMENT0 + k;
+				pass_data.draw_targets[k] = GL_COLOR_ATTACHMENT0 + k;
 
-						glFramebufferTexture(GL_FRAMEBUFFER, pass_data.draw_targets[k], tex_impl->id[pass_info.srgb_write_enable], 0);
+				glFramebufferTexture(GL_FRAMEBUFFER, pass_data.draw_targets[k], tex_impl->id[pass_info.srgb_write_enable], 0);
 
-						// Add texture to list of modified resources so mipmaps are generated at end of pass
-						pass_data.storages.push_back(tex_impl);
-					}
+				// Add texture to list of modified resources so mipmaps are generated at end of pass
+				pass_data.storages.push_back(tex_impl);
+			}
 
-					assert(pass_info.viewport_width != 0 && pass_info.viewport_height != 0);
-				}
+			assert(pass_info.viewport_width != 0 && pass_info.viewport_height != 0);
+		}
 
-				if (pass_info.stencil_enable && // Only need to attach stencil if stencil is actually used in this pass
-					pass_info.viewport_width == _width &&
-					pass_info.viewport_height == _height)
-				{
-					// Only attach stencil when viewport matches back buffer or else the frame buffer will always be resized to those dimensions
-					glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _rbo[RBO_STENCIL]);
-				}
+		if (pass_info.stencil_enable && // Only need to attach stencil if stencil is actually used in this pass
+			pass_info.viewport_width == _width &&
+			pass_info.viewport_height == _height)
+		{
+			// Only attach stencil when viewport matches back buffer or else the frame buffer will always be resized to those dimensions
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _rbo[RBO_STENCIL]);
+		}
 
-				assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
-			}
+		assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	}
 
-			GLint status = GL_FALSE;
-			glGetProgramiv(pass_data.program, GL_LINK_STATUS, &status);
-			if (GL_FALSE == status)
-			{
-				GLint log_size = 0;
-				glGetProgramiv(pass_data.program, GL_INFO_LOG_LENGTH, &log_size);
-				std::vector<char> log(log_size);
-				glGetProgramInfoLog(pass_data.program, log_size, nullptr, log.data());
+	GLint status = GL_FALSE;
+	glGetProgramiv(pass_data.program, GL_LINK_STATUS, &status);
+	if (GL_FALSE == status)
+	{
+		GLint log_size = 0;
+		glGetProgramiv(pass_data.program, GL_INFO_LOG_LENGTH, &log_size);
+		std::vector<char> log(log_size);
+		glGetProgramInfoLog(pass_data.program, log_size, nullptr, log.data());
 
-				effect.errors += log.data();
+		effect.errors += log.data();
+
+		LOG(ERROR) << "Failed to link program for pass " << pass_index << " in technique '" << technique.name << "'!";
+		return false;
+	}
 
-				LOG(ERROR) << "Failed to link program for pass " << pass_index << " in technique '" << technique.name << "'!";
-				success = false;
+	pass_data.samplers.resize(effect.module.num_sampler_bindings);
+	for (const reshadefx::sampler_info &info : pass_info.samplers)
+	{
+		const texture &texture = look_up_texture_by_name(info.texture_name);
+
+		// Hash sampler state to avoid duplicated sampler objects
+		size_t hash = 2166136261;
+		hash = (hash * 16777619) ^ static_cast<uint32_t>(info.address_u);
+		hash = (hash * 16777619) ^ static_cast<uint32_t>(info.address_v);
+		hash = (hash * 16777619) ^ static_cast<uint32_t>(info.address_w);
+		hash = (hash * 16777619) ^ static_cast<uint32_t>(info.filter);
+		hash = (hash * 16777619) ^ reinterpret_cast<const uint32_t &>(info.lod_bias);
+		hash = (hash * 16777619) ^ reinterpret_cast<const uint32_t &>(info.min_lod);
+		hash = (hash * 16777619) ^ reinterpret_cast<const uint32_t &>(info.max_lod);
+
+		std::unordered_map<size_t, GLuint>::iterator it = _effect_sampler_states.find(hash);
+		if (it == _effect_sampler_states.end())
+		{
+			GLenum min_filter = GL_NONE, mag_filter = GL_NONE;
+			switch (info.filter)
+			{
+			case reshadefx::texture_filter::min_mag_mip_point:
+				min_filter = GL_NEAREST_MIPMAP_NEAREST;
+				mag_filter = GL_NEAREST;
+				break;
+			case reshadefx::texture_filter::min_mag_point_mip_linear:
+				min_filter = GL_NEAREST_MIPMAP_LINEAR;
+				mag_filter = GL_NEAREST;
+				break;
+			case reshadefx::texture_filter::min_point_mag_linear_mip_point:
+				min_filter = GL_NEAREST_MIPMAP_NEAREST;
+				mag_filter = GL_LINEAR;
+				break;
+			case reshadefx::texture_filter::min_point_mag_mip_linear:
+				min_filter = GL_NEAREST_MIPMAP_LINEAR;
+				mag_filter = GL_LINEAR;
+				break;
+			case reshadefx::texture_filter::min_linear_mag_mip_point:
+				min_filter = GL_LINEAR_MIPMAP_NEAREST;
+				mag_filter = GL_NEAREST;
+				break;
+			case reshadefx::texture_filter::min_linear_mag_point_mip_linear:
+				min_filter = GL_LINEAR_MIPMAP_LINEAR;
+				mag_filter = GL_NEAREST;
+				break;
+			case reshadefx::texture_filter::min_mag_linear_mip_point:
+				min_filter = GL_LINEAR_MIPMAP_NEAREST;
+				mag_filter = GL_LINEAR;
+				break;
+			case reshadefx::texture_filter::min_mag_mip_linear:
+				min_filter = GL_LINEAR_MIPMAP_LINEAR;
+				mag_filter = GL_LINEAR;
 				break;
 			}
 
-			pass_data.samplers.resize(effect.module.num_sampler_bindings);
-			for (const reshadefx::sampler_info &info : pass_info.samplers)
-			{
-				const texture &texture = look_up_texture_by_name(info.texture_name);
-
-				// Hash sampler state to avoid duplicated sampler objects
-				size_t hash = 2166136261;
-				hash = (hash * 16777619) ^ static_cast<uint32_t>(info.address_u);
-				hash = (hash * 16777619) ^ static_cast<uint32_t>(info.address_v);
-				hash = (hash * 16777619) ^ static_cast<uint32_t>(info.address_w);
-				hash = (hash * 16777619) ^ static_cast<uint32_t>(info.filter);
-				hash = (hash * 16777619) ^ reinterpret_cast<const uint32_t &>(info.lod_bias);
-				hash = (hash * 16777619) ^ reinterpret_cast<const uint32_t &>(info.min_lod);
-				hash = (hash * 16777619) ^ reinterpret_cast<const uint32_t &>(info.max_lod);
-
-				std::unordered_map<size_t, GLuint>::iterator it = _effect_sampler_states.find(hash);
-				if (it == _effect_sampler_states.end())
+			const auto convert_address_mode = [](reshadefx::texture_address_mode value) {
+				switch (value)
 				{
-					GLenum min_filter = GL_NONE, mag_filter = GL_NONE;
-					switch (info.filter)
-					{
-					case reshadefx::texture_filter::min_mag_mip_point:
-						min_filter = GL_NEAREST_MIPMAP_NEAREST;
-						mag_filter = GL_NEAREST;
-						break;
-					case reshadefx::texture_filter::min_mag_point_mip_linear:
-						min_filter = GL_NEAREST_MIPMAP_LINEAR;
-						mag_filter = GL_NEAREST;
-						break;
-					case reshadefx::texture_filter::min_point_mag_linear_mip_point:
-						min_filter = GL_NEAREST_MIPMAP_NEAREST;
-						mag_filter = GL_LINEAR;
-						break;
-					case reshadefx::texture_filter::min_point_mag_mip_linear:
-						min_filter = GL_NEAREST_MIPMAP_LINEAR;
-						mag_filter = GL_LINEAR;
-						break;
-					case reshadefx::texture_filter::min_linear_mag_mip_point:
-						min_filter = GL_LINEAR_MIPMAP_NEAREST;
-						mag_filter = GL_NEAREST;
-						break;
-					case reshadefx::texture_filter::min_linear_mag_point_mip_linear:
-						min_filter = GL_LINEAR_MIPMAP_LINEAR;
-						mag_filter = GL_NEAREST;
-						break;
-					case reshadefx::texture_filter::min_mag_linear_mip_point:
-						min_filter = GL_LINEAR_MIPMAP_NEAREST;
-						mag_filter = GL_LINEAR;
-						break;
-					case reshadefx::texture_filter::min_mag_mip_linear:
-						min_filter = GL_LINEAR_MIPMAP_LINEAR;
-						mag_filter = GL_LINEAR;
-						break;
-					}
-
-					const auto convert_address_mode = [](reshadefx::texture_address_mode value) {
-						switch (value)
-						{
-						case reshadefx::texture_address_mode::wrap:
-							return GL_REPEAT;
-						case reshadefx::texture_address_mode::mirror:
-							return GL_MIRRORED_REPEAT;
-						case reshadefx::texture_address_mode::clamp:
-							return GL_CLAMP_TO_EDGE;
-						case reshadefx::texture_address_mode::border:
-							return GL_CLAMP_TO_BORDER;
-						default:
-							return GL_NONE;
-						}
-					};
-
-					GLuint sampler_id = 0;
-					glGenSamplers(1, &sampler_id);
-					glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_S, convert_address_mode(info.address_u));
-					glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_T, convert_address_mode(info.address_v));
-					glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_R, convert_address_mode(info.address_w));
-					glSamplerParameteri(sampler_id, GL_TEXTURE_MAG_FILTER, mag_filter);
-					glSamplerParameteri(sampler_id, GL_TEXTURE_MIN_FILTER, min_filter);
-					glSamplerParameterf(sampler_id, GL_TEXTURE_LOD_BIAS, info.lod_bias);
-					glSamplerParameterf(sampler_id, GL_TEXTURE_MIN_LOD, info.min_lod);
-					glSamplerParameterf(sampler_id, GL_TEXTURE_MAX_LOD, info.max_lod);
-
-					it = _effect_sampler_states.emplace(hash, sampler_id).first;
+				case reshadefx::texture_address_mode::wrap:
+					return GL_REPEAT;
+				case reshadefx::texture_address_mode::mirror:
+					return GL_MIRRORED_REPEAT;
+				case reshadefx::texture_address_mode::clamp:
+					return GL_CLAMP_TO_EDGE;
+				case reshadefx::texture_address_mode::border:
+					return GL_CLAMP_TO_BORDER;
+				default:
+					return GL_NONE;
 				}
-
-				sampler_data &sampler_data = pass_data.samplers[info.binding];
-				sampler_data.id = it->second;
-				sampler_data.texture = static_cast<tex_data *>(texture.impl);
-				sampler_data.is_srgb_format = info.srgb;
-			}
+			};
+
+			GLuint sampler_id = 0;
+			glGenSamplers(1, &sampler_id);
+			glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_S, convert_address_mode(info.address_u));
+			glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_T, convert_address_mode(info.address_v));
+			glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_R, convert_address_mode(info.address_w));
+			glSamplerParameteri(sampler_id, GL_TEXTURE_MAG_FILTER, mag_filter);
+			glSamplerParameteri(sampler_id, GL_TEXTURE_MIN_FILTER, min_filter);
+			glSamplerParameterf(sampler_id, GL_TEXTURE_LOD_BIAS, info.lod_bias);
+			glSamplerParameterf(sampler_id, GL_TEXTURE_MIN_LOD, info.min_lod);
+			glSamplerParameterf(sampler_id, GL_TEXTURE_MAX_LOD, info.max_lod);
+
+			it = _effect_sampler_states.emplace(hash, sampler_id).first;
 		}
-	}
 
-	for (auto &it : entry_points)
-		glDeleteShader(it.second);
+		sampler_data &sampler_data = pass_data.samplers[info.binding];
+		sampler_data.id = it->second;
+		sampler_data.texture = static_cast<tex_data *>(texture.impl);
+		sampler_data.is_srgb_format = info.srgb;
+	}
 
-	return success;
+	return true;
 }
-void reshade::opengl::runtime_gl::unload_effect(size_t index)
+void reshade::opengl::runtime_gl::destroy_technique(technique &technique)
 {
-	for (technique &tech : _techniques)
-	{
-		if (tech.effect_index != index)
-			continue;
-
-		const auto impl = static_cast<technique_data *>(tech.impl);
-		if (impl == nullptr)
-			continue;
-
-		glDeleteQueries(1, &impl->query);
-
-		for (pass_data &pass_data : impl->passes)
-		{
-			if (pass_data.program)
-				glDeleteProgram(pass_data.program);
-			glDeleteFramebuffers(1, &pass_data.fbo);
-		}
-
-		delete impl;
-		tech.impl = nullptr;
-	}
+	const auto impl = static_cast<technique_data *>(technique.impl);
 
-	runtime::unload_effect(index);
+	glDeleteQueries(1, &impl->query);
 
-	if (index < _effect_ubos.size())
+	for (pass_data &pass_data : impl->passes)
 	{
-		glDeleteBuffers(1, &_effect_ubos[index]);
-		_effect_ubos[index] = 0;
+		if (pass_data.program)
+			glDeleteProgram(pass_data.program);
+		glDeleteFramebuffers(1, &pass_data.fbo);
 	}
+
+	delete impl;
+	technique.impl = nullptr;
 }
-void reshade::opengl::runtime_gl::unload_effects()
+void reshade::opengl::runtime_gl::destroy_effect(effect &effect)
 {
-	for (technique &tech : _techniques)
-	{
-		const auto impl = static_cast<technique_data *>(tech.impl);
-		if (impl == nullptr)
-			continue;
+	const auto impl = static_cast<effect_data *>(effect.impl);
 
-		glDeleteQueries(1, &impl->query);
+	glDeleteBuffers(1, &impl->ubo);
 
-		for (pass_data &pass_data : impl->passes)
-		{
-			if (pass_data.program)
-				glDeleteProgram(pass_data.program);
-			glDeleteFramebuffers(1, &pass_data.fbo);
-		}
-
-		delete impl;
-		tech.impl = nullptr;
-	}
+	for (const auto &[name, shader_object] : impl->entry_points)
+		glDeleteShader(shader_object);
 
+	delete impl;
+	effect.impl = nullptr;
+}
+void reshade::opengl::runtime_gl::unload_effects()
+{
 	runtime::unload_effects();
 
-	glDeleteBuffers(static_cast<GLsizei>(_effect_ubos.size()), _effect_ubos.data());
-	_effect_ubos.clear();
-
 	for (const auto &info : _effect_sampler_states)
 		glDeleteSamplers(1, &info.second);
 	_effect_sampler_states.clear();
@@ -889,6 +907,14 @@ bool reshade::opengl::runtime_gl::init_texture(texture &texture)
 		break;
 	}
 
+	// Textures whose image file is uploaded as is are created with the block-compressed format of that file instead
+	const bool compressed = texture.compressed_format != reshadefx::texture_format::unknown;
+	if (compressed)
+	{
+		internal_format = convert_compressed_format(texture.compressed_format);
+		internal_format_srgb = convert_compressed_format(texture.compressed_format, true);
+	}
+
 	impl->levels = texture.levels;
 	impl->internal_format = internal_format;
 
@@ -918,13 +944,17 @@ bool reshade::opengl::runtime_gl::init_texture(texture &texture)
 
 	// Clear texture to zero since by default its contents are undefined
 	// Use a separate FBO here to make sure there is no mismatch with the dimensions of others
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo[FBO_CLEAR]);
-	glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, impl->id[0], 0);
-	assert(glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
-	glDrawBuffer(GL_COLOR_ATTACHMENT0);
-	const GLuint clear_color[4] = { 0, 0, 0, 0 };
-	glClearBufferuiv(GL_COLOR, 0, clear_color);
-	glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0);
+	// Block-compressed textures cannot be attached to a FBO, but are overwritten on upload anyway
+	if (!compressed)
+	{
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo[FBO_CLEAR]);
+		glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, impl->id[0], 0);
+		assert(glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+		const GLuint clear_color[4] = { 0, 0, 0, 0 };
+		glClearBufferuiv(GL_COLOR, 0, clear_color);
+		glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0);
+	}
 
 	// Restore previous state from application
 	glBindTexture(GL_TEXTURE_2D, previous_tex);
@@ -991,6 +1021,109 @@ void reshade::opengl::runtime_gl::upload_texture(const texture &texture, const u
 	glPixelStorei(GL_UNPACK_SKIP_PIXELS, previous_unpack_skip_pixels);
 	glPixelStorei(GL_UNPACK_SKIP_IMAGES, previous_unpack_skip_images);
 }
+void reshade::opengl::runtime_gl::upload_texture_levels(const texture &texture, const uint8_t *data)
+{
+	auto impl = static_cast<tex_data *>(texture.impl);
+	assert(impl != nullptr && texture.semantic.empty() && data != nullptr);
+
+	GLenum upload_format = GL_NONE, upload_type = GL_NONE;
+	switch (texture.storage_format())
+	{
+	case reshadefx::texture_format::r8:
+		upload_format = GL_RED, upload_type = GL_UNSIGNED_BYTE;
+		break;
+	case reshadefx::texture_format::rg8:
+		upload_format = GL_RG, upload_type = GL_UNSIGNED_BYTE;
+		break;
+	case reshadefx::texture_format::rgba8:
+		upload_format = GL_RGBA, upload_type = GL_UNSIGNED_BYTE;
+		break;
+	case reshadefx::texture_format::r16f:
+		upload_format = GL_RED, upload_type = GL_HALF_FLOAT;
+		break;
+	case reshadefx::texture_format::rg16f:
+		upload_format = GL_RG, upload_type = GL_HALF_FLOAT;
+		break;
+	case reshadefx::texture_format::rgba16f:
+		upload_format = GL_RGBA, upload_type = GL_HALF_FLOAT;
+		break;
+	case reshadefx::texture_format::rgb10a2:
+		upload_format = GL_RGBA, upload_type = GL_UNSIGNED_INT_2_10_10_10_REV;
+		break;
+	default:
+		assert(texture.compressed_format != reshadefx::texture_format::unknown);
+		break;
+	}
+
+	// Get current state
+	GLint previous_tex = 0;
+	GLint previous_unpack = 0;
+	GLint previous_unpack_lsb = GL_FALSE;
+	GLint previous_unpack_swap = GL_FALSE;
+	GLint previous_unpack_alignment = 0;
+	GLint previous_unpack_row_length = 0;
+	GLint previous_unpack_image_height = 0;
+	GLint previous_unpack_skip_rows = 0;
+	GLint previous_unpack_skip_pixels = 0;
+	GLint previous_unpack_skip_images = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_tex);
+	glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &previous_unpack);
+	glGetIntegerv(GL_UNPACK_LSB_FIRST, &previous_unpack_lsb);
+	glGetIntegerv(GL_UNPACK_SWAP_BYTES, &previous_unpack_swap);
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &previous_unpack_alignment);
+	glGetIntegerv(GL_UNPACK_ROW_LENGTH, &previous_unpack_row_length);
+	glGetIntegerv(GL_UNPACK_IMAGE_HEIGHT, &previous_unpack_image_height);
+	glGetIntegerv(GL_UNPACK_SKIP_ROWS, &previous_unpack_skip_rows);
+	glGetIntegerv(GL_UNPACK_SKIP_PIXELS, &previous_unpack_skip_pixels);
+	glGetIntegerv(GL_UNPACK_SKIP_IMAGES, &previous_unpack_skip_images);
+
+	// Unset any existing unpack buffer so pointer is not interpreted as an offset
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	// Clear pixel storage modes to defaults (texture uploads can break otherwise)
+	glPixelStorei(GL_UNPACK_LSB_FIRST, GL_FALSE);
+	glPixelStorei(GL_UNPACK_SWAP_BYTES, GL_FALSE);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Rows are tightly packed
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_IMAGES, 0);
+
+	// Bind and upload data of all mipmap levels, which is stored one after another
+	glBindTexture(GL_TEXTURE_2D, impl->id[0]);
+	for (uint32_t level = 0; level < texture.levels; ++level)
+	{
+		const uint32_t width = std::max(texture.width >> level, 1u);
+		const uint32_t height = std::max(texture.height >> level, 1u);
+		const uint32_t size = texture_row_pitch(texture.storage_format(), width) * texture_row_count(texture.storage_format(), height);
+
+		if (upload_format != GL_NONE)
+			glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, upload_format, upload_type, data);
+		else
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, impl->internal_format, size, data);
+
+		data += size;
+	}
+
+	// Restore previous state from application
+	glBindTexture(GL_TEXTURE_2D, previous_tex);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, previous_unpack);
+	glPixelStorei(GL_UNPACK_LSB_FIRST, previous_unpack_lsb);
+	glPixelStorei(GL_UNPACK_SWAP_BYTES, previous_unpack_swap);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, previous_unpack_alignment);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, previous_unpack_row_length);
+	glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, previous_unpack_image_height);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, previous_unpack_skip_rows);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, previous_unpack_skip_pixels);
+	glPixelStorei(GL_UNPACK_SKIP_IMAGES, previous_unpack_skip_images);
+}
+bool reshade::opengl::runtime_gl::supports_compressed_format(reshadefx::texture_format format) const
+{
+	GLint supported = GL_FALSE;
+	glGetInternalformativ(GL_TEXTURE_2D, convert_compressed_format(format), GL_INTERNALFORMAT_SUPPORTED, 1, &supported);
+	return supported != GL_FALSE;
+}
 void reshade::opengl::runtime_gl::destroy_texture(texture &texture)
 {
 	if (texture.impl == nullptr)
@@ -1071,10 +1204,15 @@ void reshade::opengl::runtime_gl::render_technique(technique &technique)
 	glBindVertexArray(_vao[VAO_FX]);
 
 	// Set up shader constants
-	if (_effect_ubos[technique.effect_index] != 0)
+	if (const GLuint ubo = static_cast<effect_data *>(_effects[technique.effect_index].impl)->ubo; ubo != 0)
 	{
-		glBindBufferBase(GL_UNIFORM_BUFFER, 0, _effect_ubos[technique.effect_index]);
-		glBufferSubData(GL_UNIFORM_BUFFER, 0, _effects[technique.effect_index].uniform_data_storage.size(), _effects[technique.effect_index].uniform_data_storage.data());
+		glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo);
+
+		// Only update the parts that changed since the last technique of this effect was rendered
+		effect &effect = _effects[technique.effect_index];
+		for (const auto &[begin, end] : effect.uniform_data_dirty.ranges)
+			glBufferSubData(GL_UNIFORM_BUFFER, begin, end - begin, effect.uniform_data_storage.data() + begin);
+		effect.uniform_data_dirty.clear();
 	}
 
 	bool is_effect_stencil_cleared = false;
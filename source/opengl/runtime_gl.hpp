@@ -29,12 +29,17 @@ namespace reshade::opengl
 		std::unordered_set<HDC> _hdcs;
 
 	private:
-		bool init_effect(size_t index) override;
-		void unload_effect(size_t index) override;
+		bool init_effect(effect &effect) override;
+		bool init_technique(effect &effect, technique &technique) override;
+		bool init_pass(effect &effect, technique &technique, size_t pass_index) override;
+		void destroy_technique(technique &technique) override;
+		void destroy_effect(effect &effect) override;
 		void unload_effects() override;
 
 		bool init_texture(texture &texture) override;
 		void upload_texture(const texture &texture, const uint8_t *data) override;
+		void upload_texture_levels(const texture &texture, const uint8_t *data) override;
+		bool supports_compressed_format(reshadefx::texture_format format) const override;
 		void destroy_texture(texture &texture) override;
 		void generate_mipmaps(const struct tex_data *impl);
 
@@ -90,7 +95,6 @@ namespace reshade::opengl
 		GLuint _rbo[NUM_RBO] = {};
 		GLuint _mipmap_program = 0;
 		GLenum _default_depth_format = GL_NONE;
-		std::vector<GLuint> _effect_ubos;
 		std::vector<GLuint> _reserved_texture_names;
 		std::unordered_map<size_t, GLuint> _effect_sampler_states;
 
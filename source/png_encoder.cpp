@@ -0,0 +1,744 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "png_encoder.hpp"
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	constexpr size_t window_size = 32768; // Maximum distance a deflate match can reach back
+	constexpr size_t strip_size = 256 * 1024; // Approximate amount of filtered image data per strip
+	constexpr size_t block_size = 32768; // Maximum number of symbols per deflate block
+	constexpr uint32_t min_match = 4; // Deflate allows matches of three bytes, but these rarely pay off and hashing four bytes gives much better candidates
+	constexpr uint32_t max_match = 258;
+	constexpr unsigned int hash_bits = 15;
+
+	struct compression_params
+	{
+		uint32_t max_chain; // Maximum number of match candidates that are checked per position
+		uint32_t nice_length; // Stop searching once a match of this length was found
+		uint32_t max_insert_length; // Longer matches only add their first position to the hash chains (greedy matching only)
+		bool lazy; // Check whether the next position has a longer match before accepting one
+		bool adaptive_filter; // Choose the filter per row, instead of always using the Paeth filter
+	};
+
+	const compression_params &get_params(reshade::image::png_compression level)
+	{
+		static const compression_params params[] = {
+			{    4,  32,  16, false, false },
+			{   32, 128,   0,  true,  true },
+			{ 1024, 258,   0,  true,  true },
+		};
+		return params[static_cast<size_t>(level)];
+	}
+
+	const uint16_t length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const uint8_t length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const uint16_t dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const uint8_t dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	const uint8_t code_length_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	struct lookup_tables
+	{
+		uint8_t length_code[max_match + 1]; // Index of the length code for every match length
+		uint8_t dist_code_low[256]; // Index of the distance code for distances up to 256
+		uint8_t dist_code_high[256]; // Index of the distance code for larger distances, indexed by '(distance - 1) >> 7'
+		uint32_t crc[256];
+	};
+
+	const lookup_tables &get_tables()
+	{
+		static const lookup_tables tables = []() {
+			lookup_tables t = {};
+			for (uint8_t code = 0; code < 29; ++code)
+				for (uint32_t length = length_base[code]; length < length_base[code] + (1u << length_extra[code]) && length <= max_match; ++length)
+					t.length_code[length] = code;
+			for (uint8_t code = 0; code < 30; ++code)
+				for (uint32_t dist = dist_base[code]; dist < dist_base[code] + (1u << dist_extra[code]); ++dist)
+					if (dist <= 256)
+						t.dist_code_low[dist - 1] = code;
+					else
+						t.dist_code_high[(dist - 1) >> 7] = code;
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; ++k)
+					c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+				t.crc[i] = c;
+			}
+			return t;
+		}();
+		return tables;
+	}
+
+	uint32_t crc32(uint32_t crc, const uint8_t *data, size_t size)
+	{
+		const lookup_tables &tables = get_tables();
+		crc = ~crc;
+		for (size_t i = 0; i < size; ++i)
+			crc = tables.crc[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	uint32_t adler32(uint32_t adler, const uint8_t *data, size_t size)
+	{
+		uint32_t a = adler & 0xFFFF, b = adler >> 16;
+		while (size != 0)
+		{
+			// Largest number of bytes that can be summed up before 'b' may overflow
+			const size_t count = std::min<size_t>(size, 5552);
+			for (size_t i = 0; i < count; ++i)
+				a += data[i], b += a;
+			a %= 65521;
+			b %= 65521;
+			data += count;
+			size -= count;
+		}
+		return (b << 16) | a;
+	}
+	uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t size2)
+	{
+		// See 'adler32_combine' in zlib
+		const uint64_t base = 65521;
+		const uint64_t rem = size2 % base;
+		uint64_t sum1 = adler1 & 0xFFFF;
+		uint64_t sum2 = (rem * sum1) % base;
+		sum1 += (adler2 & 0xFFFF) + base - 1;
+		sum2 += (adler1 >> 16) + (adler2 >> 16) + base - rem;
+		sum1 %= base;
+		sum2 %= base;
+		return static_cast<uint32_t>((sum2 << 16) | sum1);
+	}
+
+	void write_be32(uint8_t *dst, uint32_t value)
+	{
+		dst[0] = static_cast<uint8_t>(value >> 24);
+		dst[1] = static_cast<uint8_t>(value >> 16);
+		dst[2] = static_cast<uint8_t>(value >> 8);
+		dst[3] = static_cast<uint8_t>(value);
+	}
+
+	std::vector<uint8_t> make_chunk(const char type[4], const uint8_t *data, uint32_t size)
+	{
+		std::vector<uint8_t> chunk(12 + size);
+		write_be32(chunk.data(), size);
+		std::memcpy(chunk.data() + 4, type, 4);
+		if (size != 0)
+			std::memcpy(chunk.data() + 8, data, size);
+		write_be32(chunk.data() + 8 + size, crc32(0, chunk.data() + 4, 4 + size));
+		return chunk;
+	}
+
+	class bit_writer
+	{
+	public:
+		explicit bit_writer(std::vector<uint8_t> &out) : _out(out) {}
+
+		void put(uint32_t value, unsigned int count)
+		{
+			assert(count <= 24 && (value >> count) == 0);
+
+			_bits |= static_cast<uint64_t>(value) << _count;
+			_count += count;
+
+			if (_count >= 32)
+			{
+				const uint8_t bytes[4] = { static_cast<uint8_t>(_bits), static_cast<uint8_t>(_bits >> 8), static_cast<uint8_t>(_bits >> 16), static_cast<uint8_t>(_bits >> 24) };
+				_out.insert(_out.end(), bytes, bytes + 4);
+				_bits >>= 32;
+				_count -= 32;
+			}
+		}
+		void put_bytes(const uint8_t *data, size_t size)
+		{
+			assert(_count == 0);
+			_out.insert(_out.end(), data, data + size);
+		}
+
+		void align()
+		{
+			for (; _count > 0; _count = _count > 8 ? _count - 8 : 0, _bits >>= 8)
+				_out.push_back(static_cast<uint8_t>(_bits));
+			_bits = 0;
+		}
+
+	private:
+		std::vector<uint8_t> &_out;
+		uint64_t _bits = 0;
+		unsigned int _count = 0;
+	};
+
+	struct symbol
+	{
+		uint16_t value; // Literal byte, or match length if the distance is not zero
+		uint16_t distance;
+	};
+
+	/// <summary>
+	/// Compute Huffman code lengths for the specified symbol frequencies, which do not exceed the specified maximum.
+	/// </summary>
+	void build_code_lengths(const uint32_t *freqs, unsigned int count, unsigned int max_length, uint8_t *lengths)
+	{
+		std::vector<std::pair<uint32_t, uint16_t>> leaves;
+		for (unsigned int s = 0; s < count; ++s)
+			if (freqs[s] != 0)
+				leaves.emplace_back(freqs[s], static_cast<uint16_t>(s));
+		// A code with less than two symbols is incomplete, which not all decoders accept, so add unused ones to fill it up
+		for (unsigned int s = 0; leaves.size() < 2; ++s)
+			if (freqs[s] == 0)
+				leaves.emplace_back(1, static_cast<uint16_t>(s));
+
+		std::sort(leaves.begin(), leaves.end());
+
+		const size_t num_leaves = leaves.size();
+		const size_t num_nodes = 2 * num_leaves - 1;
+		std::vector<uint32_t> weights(num_nodes);
+		std::vector<size_t> parents(num_nodes);
+		std::vector<uint8_t> depths(num_nodes);
+
+		while (true)
+		{
+			for (size_t i = 0; i < num_leaves; ++i)
+				weights[i] = leaves[i].first;
+
+			// Leaves are sorted and internal nodes are created in order of increasing weight, so the two lightest nodes are always at the front of either list
+			for (size_t node = num_leaves, next_leaf = 0, next_node = num_leaves; node < num_nodes; ++node)
+			{
+				weights[node] = 0;
+				for (int k = 0; k < 2; ++k)
+				{
+					const size_t child = (next_leaf < num_leaves && (next_node >= node || weights[next_leaf] <= weights[next_node])) ? next_leaf++ : next_node++;
+					parents[child] = node;
+					weights[node] += weights[child];
+				}
+			}
+
+			// Parents always have a higher index than their children, so walk down from the root
+			unsigned int max_depth = 0;
+			depths[num_nodes - 1] = 0;
+			for (size_t i = num_nodes - 1; i-- > 0;)
+			{
+				depths[i] = depths[parents[i]] + 1;
+				max_depth = std::max<unsigned int>(max_depth, depths[i]);
+			}
+
+			if (max_depth <= max_length)
+				break;
+
+			// Flatten the distribution until the tree is shallow enough (this keeps the order of the leaves intact)
+			for (auto &leaf : leaves)
+				leaf.first = (leaf.first + 1) >> 1;
+		}
+
+		std::fill_n(lengths, count, static_cast<uint8_t>(0));
+		for (size_t i = 0; i < num_leaves; ++i)
+			lengths[leaves[i].second] = depths[i];
+	}
+
+	/// <summary>
+	/// Assign canonical Huffman codes for the specified code lengths, with their bits reversed since deflate writes them starting with the most significant one.
+	/// </summary>
+	void build_codes(const uint8_t *lengths, unsigned int count, uint16_t *codes)
+	{
+		uint32_t length_count[16] = {};
+		for (unsigned int s = 0; s < count; ++s)
+			length_count[lengths[s]]++;
+		length_count[0] = 0;
+
+		uint32_t next_code[16] = {};
+		for (unsigned int bits = 1, code = 0; bits < 16; ++bits)
+			next_code[bits] = code = (code + length_count[bits - 1]) << 1;
+
+		for (unsigned int s = 0; s < count; ++s)
+		{
+			if (lengths[s] == 0)
+				continue;
+
+			uint32_t code = next_code[lengths[s]]++, reversed = 0;
+			for (unsigned int i = 0; i < lengths[s]; ++i, code >>= 1)
+				reversed = (reversed << 1) | (code & 1);
+			codes[s] = static_cast<uint16_t>(reversed);
+		}
+	}
+
+	/// <summary>
+	/// Write a deflate block with dynamic Huffman codes built for the specified symbols.
+	/// </summary>
+	void write_block(bit_writer &writer, const std::vector<symbol> &symbols, bool final)
+	{
+		const lookup_tables &tables = get_tables();
+		const auto dist_code = [&tables](uint32_t distance) {
+			return distance <= 256 ? tables.dist_code_low[distance - 1] : tables.dist_code_high[(distance - 1) >> 7];
+		};
+
+		uint32_t litlen_freqs[286] = {}, dist_freqs[30] = {};
+		for (const symbol &sym : symbols)
+		{
+			if (sym.distance == 0)
+			{
+				litlen_freqs[sym.value]++;
+			}
+			else
+			{
+				litlen_freqs[257 + tables.length_code[sym.value]]++;
+				dist_freqs[dist_code(sym.distance)]++;
+			}
+		}
+		litlen_freqs[256] = 1; // End of block
+
+		uint8_t litlen_lengths[286], dist_lengths[30];
+		uint16_t litlen_codes[286] = {}, dist_codes[30] = {};
+		build_code_lengths(litlen_freqs, 286, 15, litlen_lengths);
+		build_code_lengths(dist_freqs, 30, 15, dist_lengths);
+		build_codes(litlen_lengths, 286, litlen_codes);
+		build_codes(dist_lengths, 30, dist_codes);
+
+		unsigned int num_litlen = 286, num_dist = 30;
+		while (num_litlen > 257 && litlen_lengths[num_litlen - 1] == 0)
+			num_litlen--;
+		while (num_dist > 1 && dist_lengths[num_dist - 1] == 0)
+			num_dist--;
+
+		// Both code length sequences are run-length encoded as one
+		uint8_t lengths[286 + 30];
+		std::memcpy(lengths, litlen_lengths, num_litlen);
+		std::memcpy(lengths + num_litlen, dist_lengths, num_dist);
+		const unsigned int num_lengths = num_litlen + num_dist;
+
+		std::vector<symbol> runs; // Code length symbol and the value of its extra bits
+		uint32_t cl_freqs[19] = {};
+		for (unsigned int i = 0; i < num_lengths;)
+		{
+			const uint8_t length = lengths[i];
+			unsigned int run = 1;
+			while (i + run < num_lengths && lengths[i + run] == length)
+				run++;
+			i += run;
+
+			if (length == 0)
+			{
+				for (; run >= 11; run -= std::min(run, 138u))
+					runs.push_back({ 18, static_cast<uint16_t>(std::min(run, 138u) - 11) });
+				if (run >= 3)
+					runs.push_back({ 17, static_cast<uint16_t>(run - 3) }), run = 0;
+			}
+			else
+			{
+				runs.push_back({ length, 0 }), run--;
+				for (; run >= 3; run -= std::min(run, 6u))
+					runs.push_back({ 16, static_cast<uint16_t>(std::min(run, 6u) - 3) });
+			}
+
+			for (; run > 0; run--)
+				runs.push_back({ length, 0 });
+		}
+		for (const symbol &run : runs)
+			cl_freqs[run.value]++;
+
+		uint8_t cl_lengths[19];
+		uint16_t cl_codes[19] = {};
+		build_code_lengths(cl_freqs, 19, 7, cl_lengths);
+		build_codes(cl_lengths, 19, cl_codes);
+
+		unsigned int num_cl = 19;
+		while (num_cl > 4 && cl_lengths[code_length_order[num_cl - 1]] == 0)
+			num_cl--;
+
+		writer.put(final ? 1 : 0, 1);
+		writer.put(2, 2); // Dynamic Huffman codes
+		writer.put(num_litlen - 257, 5);
+		writer.put(num_dist - 1, 5);
+		writer.put(num_cl - 4, 4);
+		for (unsigned int i = 0; i < num_cl; ++i)
+			writer.put(cl_lengths[code_length_order[i]], 3);
+
+		for (const symbol &run : runs)
+		{
+			writer.put(cl_codes[run.value], cl_lengths[run.value]);
+			if (run.value == 16)
+				writer.put(run.distance, 2);
+			else if (run.value == 17)
+				writer.put(run.distance, 3);
+			else if (run.value == 18)
+				writer.put(run.distance, 7);
+		}
+
+		for (const symbol &sym : symbols)
+		{
+			if (sym.distance == 0)
+			{
+				writer.put(litlen_codes[sym.value], litlen_lengths[sym.value]);
+				continue;
+			}
+
+			const unsigned int length_code = tables.length_code[sym.value];
+			writer.put(litlen_codes[257 + length_code], litlen_lengths[257 + length_code]);
+			if (length_extra[length_code] != 0)
+				writer.put(sym.value - length_base[length_code], length_extra[length_code]);
+
+			const unsigned int distance_code = dist_code(sym.distance);
+			writer.put(dist_codes[distance_code], dist_lengths[distance_code]);
+			if (dist_extra[distance_code] != 0)
+				writer.put(sym.distance - dist_base[distance_code], dist_extra[distance_code]);
+		}
+
+		writer.put(litlen_codes[256], litlen_lengths[256]);
+	}
+
+	uint32_t read32(const uint8_t *data)
+	{
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+	uint32_t hash32(const uint8_t *data)
+	{
+		return (read32(data) * 0x9E3779B1u) >> (32 - hash_bits);
+	}
+
+	uint32_t match_length(const uint8_t *a, const uint8_t *b, uint32_t max_length)
+	{
+		uint32_t length = 0;
+		for (uint64_t x, y; length + 8 <= max_length; length += 8)
+		{
+			std::memcpy(&x, a + length, 8);
+			std::memcpy(&y, b + length, 8);
+			if (x != y)
+				break;
+		}
+		while (length < max_length && a[length] == b[length])
+			length++;
+		return length;
+	}
+
+	/// <summary>
+	/// Compress data with deflate, using everything before the start position as dictionary.
+	/// Unless this is the final part of the stream, the output is terminated with an empty stored block, so that it ends on a byte boundary and the next part can be appended to it.
+	/// </summary>
+	void deflate(const uint8_t *data, size_t begin, size_t end, const compression_params &params, bool final, std::vector<uint8_t> &out)
+	{
+		std::vector<int32_t> head(size_t(1) << hash_bits, -1);
+		std::vector<int32_t> prev(window_size); // Previous position with the same hash, indexed by position modulo the window size
+		const auto insert = [&](size_t pos) {
+			const uint32_t hash = hash32(data + pos);
+			prev[pos & (window_size - 1)] = head[hash];
+			head[hash] = static_cast<int32_t>(pos);
+		};
+		const auto find_match = [&](size_t pos, uint32_t min_length, uint32_t &best_length, uint32_t &best_distance) {
+			const uint32_t max_length = static_cast<uint32_t>(std::min<size_t>(max_match, end - pos));
+			best_length = min_length;
+			if (min_length >= max_length)
+				return;
+
+			const uint8_t *const cur = data + pos;
+			uint32_t chain = params.max_chain;
+			for (int32_t candidate = head[hash32(cur)]; candidate >= 0 && pos - candidate <= window_size && chain-- != 0;)
+			{
+				// Check the byte that would extend the current best match first, since that rules out most candidates
+				const uint8_t *const match = data + candidate;
+				if (match[best_length] == cur[best_length] && read32(match) == read32(cur))
+				{
+					if (const uint32_t length = match_length(match, cur, max_length); length > best_length)
+					{
+						best_length = length;
+						best_distance = static_cast<uint32_t>(pos - candidate);
+						if (length >= params.nice_length || length == max_length)
+							break;
+					}
+				}
+
+				const int32_t next = prev[candidate & (window_size - 1)];
+				if (next >= candidate)
+					break; // Entry was overwritten by a position outside the window
+				candidate = next;
+			}
+		};
+
+		bit_writer writer(out);
+		std::vector<symbol> symbols;
+		symbols.reserve(block_size);
+		const auto emit = [&](uint32_t value, uint32_t distance) {
+			symbols.push_back({ static_cast<uint16_t>(value), static_cast<uint16_t>(distance) });
+			if (symbols.size() == block_size)
+			{
+				write_block(writer, symbols, false);
+				symbols.clear();
+			}
+		};
+
+		// Prime hash chains with the part of the dictionary that is still within reach
+		for (size_t pos = begin > window_size ? begin - window_size : 0; pos < begin && pos + min_match <= end; ++pos)
+			insert(pos);
+
+		if (params.lazy)
+		{
+			uint32_t prev_length = 0, prev_distance = 0;
+			bool has_prev = false; // Whether the previous position was not emitted yet
+
+			for (size_t pos = begin; pos < end;)
+			{
+				uint32_t length = 0, distance = 0;
+				if (pos + min_match <= end)
+				{
+					if (prev_length < params.nice_length)
+						find_match(pos, std::max(prev_length, min_match - 1), length, distance);
+					insert(pos);
+				}
+
+				if (has_prev && prev_length >= min_match && length <= prev_length)
+				{
+					// Match at the previous position is at least as long, so use that one and skip over it
+					emit(prev_length, prev_distance);
+
+					const size_t match_end = pos - 1 + prev_length;
+					for (++pos; pos < match_end; ++pos)
+						if (pos + min_match <= end)
+							insert(pos);
+
+					has_prev = false;
+					prev_length = 0;
+					continue;
+				}
+
+				if (has_prev)
+					emit(data[pos - 1], 0);
+
+				has_prev = true;
+				prev_length = length >= min_match ? length : 0;
+				prev_distance = distance;
+				pos++;
+			}
+
+			if (has_prev)
+			{
+				if (prev_length >= min_match)
+					emit(prev_length, prev_distance);
+				else
+					emit(data[end - 1], 0);
+			}
+		}
+		else
+		{
+			for (size_t pos = begin; pos < end;)
+			{
+				uint32_t length = 0, distance = 0;
+				if (pos + min_match <= end)
+				{
+					find_match(pos, min_match - 1, length, distance);
+					insert(pos);
+				}
+
+				if (length < min_match)
+				{
+					emit(data[pos++], 0);
+					continue;
+				}
+
+				emit(length, distance);
+
+				const size_t match_end = pos + length;
+				// Only the start of long matches is indexed, since these are mostly runs of the same values that provide few useful candidates
+				if (length <= params.max_insert_length)
+					for (++pos; pos < match_end && pos + min_match <= end; ++pos)
+						insert(pos);
+				pos = match_end;
+			}
+		}
+
+		if (final || !symbols.empty())
+			write_block(writer, symbols, final);
+
+		if (!final)
+		{
+			// Empty stored block to align the output to a byte boundary (like 'Z_SYNC_FLUSH' in zlib)
+			writer.put(0, 3);
+			writer.align();
+			const uint8_t stored_length[4] = { 0x00, 0x00, 0xFF, 0xFF };
+			writer.put_bytes(stored_length, 4);
+		}
+		else
+		{
+			writer.align();
+		}
+	}
+
+	uint8_t paeth_predictor(int a, int b, int c)
+	{
+		const int p = a + b - c;
+		const int pa = std::abs(p - a);
+		const int pb = std::abs(p - b);
+		const int pc = std::abs(p - c);
+		return static_cast<uint8_t>(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+	}
+}
+
+reshade::image::png_encoder::png_encoder(const uint8_t *pixels, uint32_t width, uint32_t height, bool include_alpha, png_compression level) :
+	_pixels(pixels), _width(width), _height(height), _bpp(include_alpha ? 4 : 3), _level(level)
+{
+	assert(pixels != nullptr && width != 0 && height != 0);
+
+	const size_t filtered_row_size = 1 + static_cast<size_t>(width) * _bpp;
+	const uint32_t rows_per_strip = static_cast<uint32_t>(std::max<size_t>(strip_size / filtered_row_size, 1));
+
+	for (uint32_t row = 0; row < height; row += rows_per_strip)
+	{
+		strip &s = _strips.emplace_back();
+		s.first_row = row;
+		s.num_rows = std::min(rows_per_strip, height - row);
+	}
+}
+
+void reshade::image::png_encoder::encode_strip(size_t index)
+{
+	strip &s = _strips[index];
+	const size_t filtered_row_size = 1 + static_cast<size_t>(_width) * _bpp;
+
+	// Filter the rows before this strip as well, so that matches can reach back into them like they could if the image was compressed as a whole
+	const uint32_t dictionary_rows = std::min(s.first_row, static_cast<uint32_t>((window_size + filtered_row_size - 1) / filtered_row_size));
+	const uint32_t first_row = s.first_row - dictionary_rows;
+
+	std::vector<uint8_t> data((dictionary_rows + static_cast<size_t>(s.num_rows)) * filtered_row_size);
+	filter_rows(first_row, dictionary_rows + s.num_rows, data.data());
+
+	const size_t begin = dictionary_rows * filtered_row_size;
+	s.adler = adler32(1, data.data() + begin, data.size() - begin);
+
+	// Build the IDAT chunk in place, starting with space for its length and type
+	std::vector<uint8_t> &out = s.idat;
+	out.clear();
+	out.reserve(8 + (data.size() - begin) / 2);
+	out.resize(8);
+	std::memcpy(out.data() + 4, "IDAT", 4);
+
+	// The zlib stream header goes at the start of the first strip
+	if (index == 0)
+	{
+		out.push_back(0x78); // Deflate with a 32 KiB window
+		out.push_back(_level == png_compression::fast ? 0x01 : _level == png_compression::balanced ? 0x9C : 0xDA);
+	}
+
+	deflate(data.data(), begin, data.size(), get_params(_level), index + 1 == _strips.size(), out);
+
+	write_be32(out.data(), static_cast<uint32_t>(out.size() - 8));
+	const uint32_t crc = crc32(0, out.data() + 4, out.size() - 4);
+	out.resize(out.size() + 4);
+	write_be32(out.data() + out.size() - 4, crc);
+}
+
+bool reshade::image::png_encoder::write(const std::function<bool(const uint8_t *data, size_t size)> &write_callback) const
+{
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	if (!write_callback(signature, sizeof(signature)))
+		return false;
+
+	uint8_t header[13];
+	write_be32(header + 0, _width);
+	write_be32(header + 4, _height);
+	header[8] = 8; // Bit depth
+	header[9] = _bpp == 4 ? 6 : 2; // Color type (RGBA or RGB)
+	header[10] = 0; // Compression method
+	header[11] = 0; // Filter method
+	header[12] = 0; // Interlace method
+	const std::vector<uint8_t> header_chunk = make_chunk("IHDR", header, sizeof(header));
+	if (!write_callback(header_chunk.data(), header_chunk.size()))
+		return false;
+
+	// The zlib stream ends with a checksum over all the data, which can be put together from the checksums of the individual strips
+	uint32_t adler = 1;
+	for (const strip &s : _strips)
+	{
+		assert(!s.idat.empty());
+		if (!write_callback(s.idat.data(), s.idat.size()))
+			return false;
+		adler = adler32_combine(adler, s.adler, s.num_rows * (1 + static_cast<size_t>(_width) * _bpp));
+	}
+
+	uint8_t trailer[4];
+	write_be32(trailer, adler);
+	const std::vector<uint8_t> trailer_chunk = make_chunk("IDAT", trailer, sizeof(trailer));
+	if (!write_callback(trailer_chunk.data(), trailer_chunk.size()))
+		return false;
+
+	const std::vector<uint8_t> end_chunk = make_chunk("IEND", nullptr, 0);
+	return write_callback(end_chunk.data(), end_chunk.size());
+}
+
+void reshade::image::png_encoder::filter_rows(uint32_t first_row, uint32_t num_rows, uint8_t *dst) const
+{
+	const size_t row_size = static_cast<size_t>(_width) * _bpp;
+	const bool adaptive = get_params(_level).adaptive_filter;
+
+	std::vector<uint8_t> scratch(row_size * 6);
+	uint8_t *cur_buffer = scratch.data();
+	uint8_t *prior_buffer = cur_buffer + row_size;
+	uint8_t *const candidates = prior_buffer + row_size; // Output of the sub, up, average and Paeth filters
+
+	const auto get_row = [this](uint32_t y, uint8_t *buffer) -> const uint8_t * {
+		const uint8_t *const src = _pixels + static_cast<size_t>(y) * _width * 4;
+		if (_bpp == 4)
+			return src;
+		for (size_t x = 0; x < _width; ++x)
+			buffer[x * 3 + 0] = src[x * 4 + 0],
+			buffer[x * 3 + 1] = src[x * 4 + 1],
+			buffer[x * 3 + 2] = src[x * 4 + 2];
+		return buffer;
+	};
+
+	// The row above the image is treated as all zeros
+	const uint8_t *prior = prior_buffer;
+	if (first_row != 0)
+		prior = get_row(first_row - 1, prior_buffer);
+
+	// Choose the filter whose output has the smallest sum of absolute values when interpreted as signed bytes, which is the heuristic recommended by the PNG specification
+	const auto cost = [](uint8_t value) { return static_cast<uint32_t>(value < 128 ? value : 256 - value); };
+
+	for (uint32_t row = first_row; row < first_row + num_rows; ++row, dst += 1 + row_size)
+	{
+		const uint8_t *const cur = get_row(row, cur_buffer);
+
+		if (!adaptive)
+		{
+			dst[0] = 4;
+			for (size_t i = 0; i < row_size; ++i)
+				dst[1 + i] = cur[i] - paeth_predictor(i >= _bpp ? cur[i - _bpp] : 0, prior[i], i >= _bpp ? prior[i - _bpp] : 0);
+		}
+		else
+		{
+			uint32_t sums[5] = {};
+			uint8_t *const sub = candidates;
+			uint8_t *const up = candidates + row_size;
+			uint8_t *const avg = candidates + row_size * 2;
+			uint8_t *const paeth = candidates + row_size * 3;
+			for (size_t i = 0; i < row_size; ++i)
+			{
+				const uint8_t a = i >= _bpp ? cur[i - _bpp] : 0;
+				const uint8_t b = prior[i];
+				const uint8_t c = i >= _bpp ? prior[i - _bpp] : 0;
+
+				sub[i] = cur[i] - a;
+				up[i] = cur[i] - b;
+				avg[i] = cur[i] - static_cast<uint8_t>((a + b) >> 1);
+				paeth[i] = cur[i] - paeth_predictor(a, b, c);
+
+				sums[0] += cost(cur[i]);
+				sums[1] += cost(sub[i]);
+				sums[2] += cost(up[i]);
+				sums[3] += cost(avg[i]);
+				sums[4] += cost(paeth[i]);
+			}
+
+			const uint8_t type = static_cast<uint8_t>(std::min_element(sums, sums + 5) - sums);
+			dst[0] = type;
+			std::memcpy(dst + 1, type == 0 ? cur : candidates + row_size * (type - 1), row_size);
+		}
+
+		// The current row becomes the prior one, so swap buffers to keep it around without converting it again
+		prior = cur;
+		std::swap(cur_buffer, prior_buffer);
+	}
+}
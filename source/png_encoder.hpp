@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+namespace reshade::image
+{
+	/// <summary>
+	/// The trade-off between encoding speed and file size a PNG encoder makes.
+	/// </summary>
+	enum class png_compression
+	{
+		fast, // Fixed row filter and a single match candidate per position
+		balanced, // Adaptive row filters and lazy matching over short hash chains
+		max, // Adaptive row filters and lazy matching over long hash chains
+	};
+
+	/// <summary>
+	/// An encoder that writes 32bpp RGBA image data to a PNG file.
+	/// The image is split into horizontal strips, which are filtered and compressed independently of each other, so that they can be processed in parallel.
+	/// Every strip is compressed with the data preceding it as dictionary, so that splitting the image barely affects the file size.
+	/// </summary>
+	class png_encoder
+	{
+	public:
+		/// <summary>
+		/// Prepare encoding of the specified image.
+		/// </summary>
+		/// <param name="pixels">The 32bpp RGBA image data, which has to stay valid until the encoder is destroyed.</param>
+		/// <param name="width">The width of the image.</param>
+		/// <param name="height">The height of the image.</param>
+		/// <param name="include_alpha">Set to <c>false</c> to drop the alpha channel and write a RGB image instead.</param>
+		/// <param name="level">The compression level to use.</param>
+		png_encoder(const uint8_t *pixels, uint32_t width, uint32_t height, bool include_alpha, png_compression level);
+
+		/// <summary>
+		/// Return the number of strips the image was split into.
+		/// </summary>
+		size_t num_strips() const { return _strips.size(); }
+
+		/// <summary>
+		/// Filter and compress a single strip of the image.
+		/// This may be called concurrently for different strips.
+		/// </summary>
+		/// <param name="index">The index of the strip to encode.</param>
+		void encode_strip(size_t index);
+
+		/// <summary>
+		/// Write the complete PNG file.
+		/// All strips have to be encoded at this point.
+		/// </summary>
+		/// <param name="write_callback">The function that is called with consecutive parts of the file and returns <c>false</c> if writing them failed.</param>
+		/// <returns><c>true</c> if all parts were written successfully, <c>false</c> if writing stopped because the callback reported a failure.</returns>
+		bool write(const std::function<bool(const uint8_t *data, size_t size)> &write_callback) const;
+
+	private:
+		struct strip
+		{
+			uint32_t first_row = 0, num_rows = 0;
+			uint32_t adler = 1; // Checksum of the filtered data of this strip
+			std::vector<uint8_t> idat; // Complete IDAT chunk holding the compressed data of this strip
+		};
+
+		void filter_rows(uint32_t first_row, uint32_t num_rows, uint8_t *dst) const;
+
+		const uint8_t *_pixels;
+		uint32_t _width, _height;
+		uint32_t _bpp; // Number of bytes per pixel in the output
+		png_compression _level;
+		std::vector<strip> _strips;
+	};
+}
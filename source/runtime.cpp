@@ -13,7 +13,13 @@
 #include "effect_preprocessor.hpp"
 #include "input.hpp"
 #include "input_freepie.hpp"
+#include "task_scheduler.hpp"
+#include "entry_point_compiler.hpp"
+#include "image_processing.hpp"
+#include "png_encoder.hpp"
+#include "screenshot_queue.hpp"
 #include <set>
+#include <future>
 #include <thread>
 #include <algorithm>
 #include <stb_image.h>
@@ -68,10 +74,309 @@ static std::vector<std::filesystem::path> find_files(const std::vector<std::file
 	return files;
 }
 
+static inline bool force_floating_point_value(const reshadefx::type &type, uint32_t renderer_id)
+{
+	if (renderer_id == 0x9000)
+		return true; // All uniform variables are floating-point in D3D9
+	if (type.is_matrix() && (renderer_id & 0x10000))
+		return true; // All matrices are floating-point in GLSL
+	return false;
+}
+
+static inline bool can_be_spec_constant(const reshade::uniform &variable)
+{
+	// Values of special variables change all the time and toggle keys have to take effect immediately, so keep those as actual uniform variables
+	return variable.has_initializer_value && variable.special == reshade::special_uniform::none && variable.toggle_key_data[0] == 0;
+}
+
+static inline void mark_uniform_modified(reshade::effect &effect, reshade::uniform &variable, std::chrono::high_resolution_clock::time_point time)
+{
+	variable.last_modified = time;
+
+	// Flag the effect, so that only effects that actually had changes are checked for whether to compile them again (see 'update_and_render_effects')
+	if (variable.spec_constant || can_be_spec_constant(variable))
+	{
+		effect.spec_constant_modified |= variable.spec_constant;
+		effect.spec_constant_check = true;
+		effect.spec_constant_check_time = time;
+	}
+}
+
+static std::string fill_spec_constants(std::vector<reshadefx::uniform_info> &spec_constants, const reshade::ini_file &preset, const std::string &effect_name)
+{
+	std::string preamble;
+
+	for (reshadefx::uniform_info &constant : spec_constants)
+	{
+		preamble += "#define SPEC_CONSTANT_" + constant.name + ' ';
+
+		switch (constant.type.base)
+		{
+		case reshadefx::type::t_int:
+			preset.get(effect_name, constant.name, constant.initializer_value.as_int);
+			break;
+		case reshadefx::type::t_bool:
+		case reshadefx::type::t_uint:
+			preset.get(effect_name, constant.name, constant.initializer_value.as_uint);
+			break;
+		case reshadefx::type::t_float:
+			preset.get(effect_name, constant.name, constant.initializer_value.as_float);
+			break;
+		}
+
+		// Check if this is a split specialization constant and move data accordingly
+		if (constant.type.is_scalar() && constant.offset != 0)
+			constant.initializer_value.as_uint[0] = constant.initializer_value.as_uint[constant.offset];
+
+		for (unsigned int i = 0; i < constant.type.components(); ++i)
+		{
+			switch (constant.type.base)
+			{
+			case reshadefx::type::t_bool:
+				preamble += constant.initializer_value.as_uint[i] ? "true" : "false";
+				break;
+			case reshadefx::type::t_int:
+				preamble += std::to_string(constant.initializer_value.as_int[i]);
+				break;
+			case reshadefx::type::t_uint:
+				preamble += std::to_string(constant.initializer_value.as_uint[i]);
+				break;
+			case reshadefx::type::t_float:
+				preamble += std::to_string(constant.initializer_value.as_float[i]);
+				break;
+			}
+
+			if (i + 1 < constant.type.components())
+				preamble += ", ";
+		}
+
+		preamble += '\n';
+	}
+
+	return preamble;
+}
+
+static constexpr uint32_t make_fourcc(char a, char b, char c, char d)
+{
+	return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+}
+static bool parse_dds_header(const uint8_t *data, size_t size, reshadefx::texture_format &format, uint32_t &width, uint32_t &height, uint32_t &levels, size_t &data_offset)
+{
+	// See https://docs.microsoft.com/windows/win32/direct3ddds/dx-graphics-dds-pguide for a description of the file layout
+	const auto read_uint32 = [data](size_t offset) {
+		uint32_t value; std::memcpy(&value, data + offset, sizeof(value)); return value;
+	};
+
+	if (size < 128 || read_uint32(0) != make_fourcc('D', 'D', 'S', ' ') || read_uint32(4) != 124)
+		return false;
+
+	height = read_uint32(12);
+	width = read_uint32(16);
+	levels = (read_uint32(8) & 0x20000 /* DDSD_MIPMAPCOUNT */) ? std::max(read_uint32(28), 1u) : 1u;
+
+	// Cube maps and volume textures cannot be uploaded to a 2D texture
+	if ((read_uint32(112) & (0x200 /* DDSCAPS2_CUBEMAP */ | 0x200000 /* DDSCAPS2_VOLUME */)) != 0)
+		return false;
+	// Uncompressed formats are decoded by stb_image_dds instead
+	if ((read_uint32(80) & 0x4 /* DDPF_FOURCC */) == 0)
+		return false;
+
+	data_offset = 128;
+
+	switch (read_uint32(84))
+	{
+	case make_fourcc('D', 'X', 'T', '1'):
+		format = reshadefx::texture_format::bc1;
+		break;
+	case make_fourcc('D', 'X', 'T', '3'):
+		format = reshadefx::texture_format::bc2;
+		break;
+	case make_fourcc('D', 'X', 'T', '5'):
+		format = reshadefx::texture_format::bc3;
+		break;
+	case make_fourcc('A', 'T', 'I', '1'):
+	case make_fourcc('B', 'C', '4', 'U'):
+		format = reshadefx::texture_format::bc4;
+		break;
+	case make_fourcc('A', 'T', 'I', '2'):
+	case make_fourcc('B', 'C', '5', 'U'):
+		format = reshadefx::texture_format::bc5;
+		break;
+	case make_fourcc('D', 'X', '1', '0'):
+		// Only simple 2D textures without array layers are supported
+		if (size < 148 || read_uint32(132) != 3 /* D3D10_RESOURCE_DIMENSION_TEXTURE2D */ || (read_uint32(136) & 0x4 /* D3D10_RESOURCE_MISC_TEXTURECUBE */) != 0 || read_uint32(140) > 1)
+			return false;
+
+		data_offset = 148;
+
+		switch (read_uint32(128))
+		{
+		case 70: // DXGI_FORMAT_BC1_TYPELESS
+		case 71: // DXGI_FORMAT_BC1_UNORM
+		case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+			format = reshadefx::texture_format::bc1;
+			break;
+		case 73: // DXGI_FORMAT_BC2_TYPELESS
+		case 74: // DXGI_FORMAT_BC2_UNORM
+		case 75: // DXGI_FORMAT_BC2_UNORM_SRGB
+			format = reshadefx::texture_format::bc2;
+			break;
+		case 76: // DXGI_FORMAT_BC3_TYPELESS
+		case 77: // DXGI_FORMAT_BC3_UNORM
+		case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+			format = reshadefx::texture_format::bc3;
+			break;
+		case 79: // DXGI_FORMAT_BC4_TYPELESS
+		case 80: // DXGI_FORMAT_BC4_UNORM
+			format = reshadefx::texture_format::bc4;
+			break;
+		case 82: // DXGI_FORMAT_BC5_TYPELESS
+		case 83: // DXGI_FORMAT_BC5_UNORM
+			format = reshadefx::texture_format::bc5;
+			break;
+		case 94: // DXGI_FORMAT_BC6H_TYPELESS
+		case 95: // DXGI_FORMAT_BC6H_UF16
+			format = reshadefx::texture_format::bc6h;
+			break;
+		case 97: // DXGI_FORMAT_BC7_TYPELESS
+		case 98: // DXGI_FORMAT_BC7_UNORM
+		case 99: // DXGI_FORMAT_BC7_UNORM_SRGB
+			format = reshadefx::texture_format::bc7;
+			break;
+		default:
+			return false;
+		}
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+static bool read_dds_header(const std::filesystem::path &path, reshadefx::texture_format &format, uint32_t &width, uint32_t &height, uint32_t &levels)
+{
+	uint8_t header[148];
+	size_t header_size = 0;
+	size_t data_offset = 0;
+
+	if (FILE *file; _wfopen_s(&file, path.c_str(), L"rb") == 0)
+	{
+		header_size = fread(header, 1, sizeof(header), file);
+		fclose(file);
+	}
+
+	return parse_dds_header(header, header_size, format, width, height, levels, data_offset);
+}
+static std::shared_ptr<const std::vector<uint8_t>> load_compressed_image_file(const std::filesystem::path &path, const std::string &texture_name, reshadefx::texture_format texture_format, uint32_t texture_width, uint32_t texture_height, uint32_t texture_levels)
+{
+	std::vector<uint8_t> mem;
+
+	if (FILE *file; _wfopen_s(&file, path.c_str(), L"rb") == 0)
+	{
+		std::error_code ec;
+		const uintmax_t file_size = std::filesystem::file_size(path, ec);
+		mem.resize(ec ? 0 : static_cast<size_t>(file_size));
+		mem.resize(fread(mem.data(), 1, mem.size(), file));
+		fclose(file);
+	}
+
+	reshadefx::texture_format format = reshadefx::texture_format::unknown;
+	uint32_t width = 0, height = 0, levels = 0;
+	size_t data_offset = 0;
+
+	// The file may have changed since the texture was created with the format and dimensions from its header
+	if (!parse_dds_header(mem.data(), mem.size(), format, width, height, levels, data_offset) ||
+		format != texture_format || width != texture_width || height != texture_height || levels < texture_levels)
+	{
+		LOG(ERROR) << "Source " << path << " for texture '" << texture_name << "' changed its format or dimensions and could not be loaded! Reload effects to update the texture.";
+		return nullptr;
+	}
+
+	// Only keep the mipmap levels the texture was created with, which are stored one after another right after the header
+	size_t data_size = 0;
+	for (uint32_t level = 0; level < texture_levels; ++level)
+		data_size += texture_row_pitch(format, std::max(width >> level, 1u)) * texture_row_count(format, std::max(height >> level, 1u));
+
+	if (data_offset + data_size > mem.size())
+	{
+		LOG(ERROR) << "Source " << path << " for texture '" << texture_name << "' is truncated and could not be loaded!";
+		return nullptr;
+	}
+
+	return std::make_shared<std::vector<uint8_t>>(mem.begin() + data_offset, mem.begin() + data_offset + data_size);
+}
+static std::shared_ptr<const std::vector<uint8_t>> load_image_file(const std::filesystem::path &path, const std::string &texture_name, uint32_t texture_width, uint32_t texture_height)
+{
+	unsigned char *filedata = nullptr;
+	int width = 0, height = 0, channels = 0;
+
+	if (FILE *file; _wfopen_s(&file, path.c_str(), L"rb") == 0)
+	{
+		// This is called on worker threads, so use the overload that does not throw
+		std::error_code ec;
+		const uintmax_t file_size = std::filesystem::file_size(path, ec);
+
+		// Read texture data into memory in one go since that is faster than reading chunk by chunk
+		std::vector<uint8_t> mem(ec ? 0 : static_cast<size_t>(file_size));
+		const size_t read_size = fread(mem.data(), 1, mem.size(), file);
+		fclose(file);
+
+		// Do not attempt to decode a partially read file (e.g. because it is still being written to)
+		if (ec || read_size != mem.size())
+		{
+			LOG(ERROR) << "Failed to read source " << path << " for texture '" << texture_name << "'!";
+			return nullptr;
+		}
+
+		if (stbi_dds_test_memory(mem.data(), static_cast<int>(mem.size())))
+			filedata = stbi_dds_load_from_memory(mem.data(), static_cast<int>(mem.size()), &width, &height, &channels, STBI_rgb_alpha);
+		else
+			filedata = stbi_load_from_memory(mem.data(), static_cast<int>(mem.size()), &width, &height, &channels, STBI_rgb_alpha);
+	}
+
+	if (filedata == nullptr)
+	{
+		LOG(ERROR) << "Source " << path << " for texture '" << texture_name << "' could not be loaded! Make sure it is of a compatible file format.";
+		return nullptr;
+	}
+
+	const auto pixels = std::make_shared<std::vector<uint8_t>>(texture_width * texture_height * 4);
+
+	// Need to potentially resize image data to the texture dimensions
+	if (texture_width != uint32_t(width) || texture_height != uint32_t(height))
+	{
+		LOG(INFO) << "Resizing image data for texture '" << texture_name << "' from " << width << "x" << height << " to " << texture_width << "x" << texture_height << " ...";
+
+		stbir_resize_uint8(filedata, width, height, 0, pixels->data(), texture_width, texture_height, 0, 4);
+	}
+	else
+	{
+		std::memcpy(pixels->data(), filedata, pixels->size());
+	}
+
+	stbi_image_free(filedata);
+
+	return pixels;
+}
+
+static bool write_screenshot_file(const std::filesystem::path &path, const std::function<bool(FILE *file)> &encode)
+{
+	FILE *file;
+	if (_wfopen_s(&file, path.c_str(), L"wb") != 0)
+		return false;
+
+	// The stb_image_write callbacks cannot report failures, so check the error indicator of the stream as well
+	const bool success = encode(file) && ferror(file) == 0;
+
+	// Writing may have failed partway through (e.g. because the disk is full), which is only reported on close
+	return fclose(file) == 0 && success;
+}
+
 reshade::runtime::runtime() :
 	_start_time(std::chrono::high_resolution_clock::now()),
 	_last_present_time(std::chrono::high_resolution_clock::now()),
 	_last_frame_duration(std::chrono::milliseconds(1)),
+	_average_frame_duration(std::chrono::milliseconds(1)),
 	_effect_search_paths({ L".\\" }),
 	_texture_search_paths({ L".\\" }),
 	_reload_key_data(),
@@ -81,7 +386,10 @@ reshade::runtime::runtime() :
 	_prev_preset_key_data(),
 	_next_preset_key_data(),
 	_config_path(g_reshade_base_path / L"ReShade.ini"),
-	_screenshot_path(g_reshade_base_path)
+	_screenshot_path(g_reshade_base_path),
+	_loading_tasks(std::make_unique<task_group>()),
+	_worker_pool(std::make_unique<task_scheduler>()),
+	_screenshot_queue(std::make_unique<screenshot_queue>(*_worker_pool))
 {
 	_needs_update = check_for_update(_latest_version);
 
@@ -101,7 +409,6 @@ reshade::runtime::runtime() :
 }
 reshade::runtime::~runtime()
 {
-	assert(_worker_threads.empty());
 	assert(!_is_initialized && _techniques.empty());
 
 #if RESHADE_GUI
@@ -136,8 +443,14 @@ void reshade::runtime::on_reset()
 	else
 		return; // Nothing to do if the runtime was already destroyed or not successfully initialized in the first place
 
+	// Wait for all work on the pool, not just effect loading, since screenshots still being written and a background compilation still access the runtime
+	_worker_pool->wait_idle();
+
 	unload_effects();
 
+	// Any screenshots still being written were waited for above, so just collect their results
+	finish_screenshots();
+
 	_width = _height = 0;
 #if RESHADE_GUI
 	if (_imgui_font_atlas != nullptr)
@@ -153,11 +466,12 @@ void reshade::runtime::on_present()
 	const auto current_time = std::chrono::high_resolution_clock::now();
 	_last_frame_duration = current_time - _last_present_time;
 	_last_present_time = current_time;
+	// Keep a moving average to detect spikes in frame time, during which no background work should be started
+	_average_frame_duration = (_average_frame_duration * 15 + _last_frame_duration) / 16;
 
-#ifdef NDEBUG
-	// Lock input so it cannot be modified by other threads while we are reading it here
-	const auto input_lock = _input->lock();
-#endif
+	// Update status of screenshots that were written in the background before drawing the overlay, which shows it
+	if (_screenshot_queue->num_pending() != 0)
+		finish_screenshots();
 
 #if RESHADE_GUI
 	// Draw overlay
@@ -201,15 +515,18 @@ void reshade::runtime::on_present()
 					_last_preset_switching_time = current_time;
 					_is_in_between_presets_transition = true;
 					save_config();
+
+					// Load the new preset once, which captures the values to interpolate between
+					load_current_preset();
 				}
 			}
-
-			// Continuously update preset values while a transition is in progress
-			if (_is_in_between_presets_transition)
-				load_current_preset();
 		}
 	}
 
+	// Continuously update preset values while a transition is in progress
+	if (_is_in_between_presets_transition)
+		update_preset_transition();
+
 	// Reset input status
 	_input->next_frame();
 
@@ -235,7 +552,7 @@ void reshade::runtime::on_present()
 	_drawcalls = _vertices = 0;
 }
 
-bool reshade::runtime::load_effect(const std::filesystem::path &source_file, const reshade::ini_file &preset, size_t effect_index, bool preprocess_required)
+bool reshade::runtime::load_effect(const std::filesystem::path &source_file, const reshade::ini_file &preset, size_t effect_index, effect &effect, bool preprocess_required)
 {
 	std::string attributes;
 	attributes += "app=" + g_target_executable_path.stem().u8string() + ';';
@@ -279,7 +596,6 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 
 	const size_t source_hash = std::hash<std::string>()(attributes);
 
-	effect &effect = _effects[effect_index];
 	const std::string effect_name = source_file.filename().u8string();
 	if (source_file != effect.source_file || source_hash != effect.source_hash)
 	{
@@ -288,7 +604,7 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		effect.source_hash = source_hash;
 	}
 
-	if (_effect_load_skipping && !_load_option_disable_skipping && !_worker_threads.empty()) // Only skip during 'load_effects'
+	if (_effect_load_skipping && !_load_option_disable_skipping && _reload_remaining_effects != 0 && is_loading()) // Only skip during 'load_effects'
 	{
 		if (std::vector<std::string> techniques;
 			preset.get({}, "Techniques", techniques))
@@ -298,11 +614,22 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 				return at_pos == 0 || technique.find(effect_name, at_pos) == at_pos; }) == techniques.cend();
 
 			if (effect.skipped)
-			{
-				if (_reload_remaining_effects != 0 && _reload_remaining_effects != std::numeric_limits<size_t>::max())
-					_reload_remaining_effects--;
 				return false;
-			}
+		}
+	}
+
+	// The values of specialization constants are baked into the compiled effect, so compile it again if the preset changed any of them (e.g. after switching presets in performance mode)
+	if (effect.compiled && !effect.module.spec_constants.empty())
+	{
+		std::vector<reshadefx::uniform_info> spec_constants = effect.module.spec_constants;
+		if (fill_spec_constants(spec_constants, preset, effect_name) != effect.preamble)
+		{
+			// Run code generation again from the cached pre-processed source (see also 'specialize_effect')
+			effect.compiled = false;
+			effect.preprocessed = false;
+			effect.errors.clear();
+			effect.preamble.clear();
+			effect.bytecode.clear();
 		}
 	}
 
@@ -394,13 +721,19 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		else
 			shader_model = 51; // D3D12
 
+		// Performance mode turns all uniform variables into specialization constants, otherwise only those that were not changed for a while (see 'specialize_effect')
+		const bool spec_constants = _performance_mode || !effect.spec_constant_uniforms.empty();
+
 		std::unique_ptr<reshadefx::codegen> codegen;
 		if ((_renderer_id & 0xF0000) == 0)
-			codegen.reset(reshadefx::create_codegen_hlsl(shader_model, !_no_debug_info, _performance_mode));
+			codegen.reset(reshadefx::create_codegen_hlsl(shader_model, !_no_debug_info, spec_constants, true));
 		else if (_renderer_id < 0x20000)
-			codegen.reset(reshadefx::create_codegen_glsl(!_no_debug_info, _performance_mode, false, true));
+			codegen.reset(reshadefx::create_codegen_glsl(!_no_debug_info, spec_constants, false, true, true));
 		else // Vulkan uses SPIR-V input
-			codegen.reset(reshadefx::create_codegen_spirv(true, !_no_debug_info, _performance_mode, false, true));
+			codegen.reset(reshadefx::create_codegen_spirv(true, !_no_debug_info, spec_constants, false, true, true));
+
+		if (!_performance_mode && !effect.spec_constant_uniforms.empty())
+			codegen->restrict_spec_constants(effect.spec_constant_uniforms);
 
 		reshadefx::parser parser;
 
@@ -416,6 +749,7 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		if (effect.compiled)
 		{
 			effect.uniforms.clear();
+			effect.special_uniforms.clear();
 
 			// Create space for all variables (aligned to 16 bytes)
 			effect.uniform_data_storage.resize((effect.module.total_uniform_size + 15) & ~15);
@@ -424,9 +758,6 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 			{
 				variable.effect_index = effect_index;
 
-				// Copy initial data into uniform storage area
-				reset_uniform_value(variable);
-
 				const std::string_view special = variable.annotation_as_string("source");
 				if (special.empty()) /* Ignore if annotation is missing */;
 				else if (special == "frametime")
@@ -462,188 +793,83 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 				else if (special == "bufready_depth")
 					variable.special = special_uniform::bufready_depth;
 
-				effect.uniforms.push_back(std::move(variable));
-			}
-
-			// Fill all specialization constants with values from the current preset
-			if (_performance_mode)
-			{
-				effect.preamble.clear();
+				// Figure out the storage layout once, so that values can be written without going through it element by element
+				variable.stored_as_float = variable.type.is_floating_point() || force_floating_point_value(variable.type, _renderer_id);
+				variable.contiguous = !variable.type.is_matrix() && (!variable.type.is_array() || variable.type.rows == 4);
+				variable.spec_constant = effect.spec_constant_uniforms.find(variable.name) != effect.spec_constant_uniforms.end();
 
-				for (reshadefx::uniform_info &constant : effect.module.spec_constants)
+				if (variable.special != special_uniform::none)
 				{
-					effect.preamble += "#define SPEC_CONSTANT_" + constant.name + ' ';
+					special_uniform_record record;
+					record.uniform_index = effect.uniforms.size();
+					record.special = variable.special;
 
-					switch (constant.type.base)
+					switch (variable.special)
 					{
-					case reshadefx::type::t_int:
-						preset.get(effect_name, constant.name, constant.initializer_value.as_int);
+					case special_uniform::random:
+						record.min_int = variable.annotation_as_int("min", 0, 0);
+						record.max_int = variable.annotation_as_int("max", 0, RAND_MAX);
 						break;
-					case reshadefx::type::t_bool:
-					case reshadefx::type::t_uint:
-						preset.get(effect_name, constant.name, constant.initializer_value.as_uint);
+					case special_uniform::ping_pong:
+						record.min = variable.annotation_as_float("min", 0, 0.0f);
+						record.max = variable.annotation_as_float("max", 0, 1.0f);
+						record.step[0] = variable.annotation_as_float("step", 0);
+						record.step[1] = variable.annotation_as_float("step", 1);
+						record.smoothing = variable.annotation_as_float("smoothing");
 						break;
-					case reshadefx::type::t_float:
-						preset.get(effect_name, constant.name, constant.initializer_value.as_float);
+					case special_uniform::key:
+					case special_uniform::mouse_button:
+						record.keycode = variable.annotation_as_int("keycode");
+						record.toggle = variable.annotation_as_string("mode") == "toggle" || variable.annotation_as_int("toggle");
+						record.press = !record.toggle && variable.annotation_as_string("mode") == "press";
+						// Variables with an invalid key code are never updated, so do not add them to the list
+						if (variable.special == special_uniform::key ? (record.keycode <= 7 || record.keycode >= 256) : (record.keycode < 0 || record.keycode >= 5))
+							record.special = special_uniform::none;
+						break;
+					case special_uniform::mouse_wheel:
+						record.min = variable.annotation_as_float("min");
+						record.max = variable.annotation_as_float("max");
+						record.step[0] = variable.annotation_as_float("step");
+						if (record.step[0] == 0.0f)
+							record.step[0] = 1.0f;
+						break;
+					case special_uniform::freepie:
+						record.keycode = variable.annotation_as_int("index");
 						break;
 					}
 
-					// Check if this is a split specialization constant and move data accordingly
-					if (constant.type.is_scalar() && constant.offset != 0)
-						constant.initializer_value.as_uint[0] = constant.initializer_value.as_uint[constant.offset];
-
-					for (unsigned int i = 0; i < constant.type.components(); ++i)
-					{
-						switch (constant.type.base)
-						{
-						case reshadefx::type::t_bool:
-							effect.preamble += constant.initializer_value.as_uint[i] ? "true" : "false";
-							break;
-						case reshadefx::type::t_int:
-							effect.preamble += std::to_string(constant.initializer_value.as_int[i]);
-							break;
-						case reshadefx::type::t_uint:
-							effect.preamble += std::to_string(constant.initializer_value.as_uint[i]);
-							break;
-						case reshadefx::type::t_float:
-							effect.preamble += std::to_string(constant.initializer_value.as_float[i]);
-							break;
-						}
-
-						if (i + 1 < constant.type.components())
-							effect.preamble += ", ";
-					}
-
-					effect.preamble += '\n';
+					if (record.special != special_uniform::none)
+						effect.special_uniforms.push_back(record);
 				}
+
+				effect.uniforms.push_back(std::move(variable));
 			}
+
+			// Fill all specialization constants with values from the current preset
+			if (spec_constants)
+				effect.preamble = fill_spec_constants(effect.module.spec_constants, preset, effect_name);
 		}
-	}
 
-	if ( effect.compiled && (effect.preprocessed || source_cached))
-	{
-		const std::lock_guard<std::mutex> lock(_reload_mutex);
+		// Read the headers of DDS image files here already, rather than during texture creation on the render thread
+		// Textures can only be created with a block-compressed format if they are never written to and their file has the same dimensions and at least as many mipmap levels
+		effect.compressed_texture_formats.clear();
 
-		for (texture texture : effect.module.textures)
+		if (effect.compiled)
 		{
-			texture.effect_index = effect_index;
-
-			// Try to share textures with the same name across effects
-			if (const auto existing_texture = std::find_if(_textures.begin(), _textures.end(),
-				[&texture](const auto &item) { return item.unique_name == texture.unique_name; });
-				existing_texture != _textures.end())
-			{
-				// Cannot share texture if this is a normal one, but the existing one is a reference and vice versa
-				if (texture.semantic != existing_texture->semantic)
-				{
-					effect.errors += "error: " + texture.unique_name + ": another effect (";
-					effect.errors += _effects[existing_texture->effect_index].source_file.filename().u8string();
-					effect.errors += ") already created a texture with the same name but different semantic\n";
-					effect.compiled = false;
-					break;
-				}
-
-				if (texture.semantic.empty() && !existing_texture->matches_description(texture))
-				{
-					effect.errors += "warning: " + texture.unique_name + ": another effect (";
-					effect.errors += _effects[existing_texture->effect_index].source_file.filename().u8string();
-					effect.errors += ") already created a texture with the same name but different dimensions\n";
-				}
-				if (texture.semantic.empty() && (existing_texture->annotation_as_string("source") != texture.annotation_as_string("source")))
-				{
-					effect.errors += "warning: " + texture.unique_name + ": another effect (";
-					effect.errors += _effects[existing_texture->effect_index].source_file.filename().u8string();
-					effect.errors += ") already created a texture with a different image file\n";
-				}
-
-				if (existing_texture->semantic == "COLOR" && _color_bit_depth != 8)
-				{
-					for (const auto &sampler_info : effect.module.samplers)
-					{
-						if (sampler_info.srgb && sampler_info.texture_name == texture.unique_name)
-						{
-							effect.errors += "warning: " + sampler_info.unique_name + ": texture does not support sRGB sampling (back buffer format is not RGBA8)";
-						}
-					}
-				}
-
-				if (std::find(existing_texture->shared.begin(), existing_texture->shared.end(), effect_index) == existing_texture->shared.end())
-					existing_texture->shared.push_back(effect_index);
-
-				// Always make shared textures render targets, since they may be used as such in a different effect
-				existing_texture->render_target = true;
-				existing_texture->storage_access = true;
-				continue;
-			}
-
-			if (texture.annotation_as_int("pooled") && texture.semantic.empty())
+			for (const texture tex : effect.module.textures)
 			{
-				// Try to find another pooled texture to share with (and do not share within the same effect)
-				if (const auto existing_texture = std::find_if(_textures.begin(), _textures.end(),
-					[&texture](const auto &item) { return item.annotation_as_int("pooled") && item.effect_index != texture.effect_index && item.matches_description(texture); });
-					existing_texture != _textures.end())
-				{
-					// Overwrite referenced texture in samplers with the pooled one
-					for (auto &sampler_info : effect.module.samplers)
-						if (sampler_info.texture_name == texture.unique_name)
-							sampler_info.texture_name  = existing_texture->unique_name;
-					// Overwrite referenced texture in storages with the pooled one
-					for (auto &storage_info : effect.module.storages)
-						if (storage_info.texture_name == texture.unique_name)
-							storage_info.texture_name  = existing_texture->unique_name;
-					// Overwrite referenced texture in render targets with the pooled one
-					for (auto &technique_info : effect.module.techniques)
-					{
-						for (auto &pass_info : technique_info.passes)
-						{
-							std::replace(std::begin(pass_info.render_target_names), std::end(pass_info.render_target_names),
-								texture.unique_name, existing_texture->unique_name);
-
-							for (auto &sampler_info : pass_info.samplers)
-								if (sampler_info.texture_name == texture.unique_name)
-									sampler_info.texture_name  = existing_texture->unique_name;
-							for (auto &storage_info : pass_info.storages)
-								if (storage_info.texture_name == texture.unique_name)
-									storage_info.texture_name  = existing_texture->unique_name;
-						}
-					}
-
-					if (std::find(existing_texture->shared.begin(), existing_texture->shared.end(), effect_index) == existing_texture->shared.end())
-						existing_texture->shared.push_back(effect_index);
-
-					existing_texture->render_target = true;
-					existing_texture->storage_access = true;
+				std::filesystem::path source_path = std::filesystem::u8path(tex.annotation_as_string("source"));
+				if (source_path.empty() || tex.render_target || tex.storage_access || tex.width % 4 != 0 || tex.height % 4 != 0 || !find_file(_texture_search_paths, source_path))
 					continue;
-				}
-			}
-
-			if (!texture.semantic.empty() && (texture.semantic != "COLOR" && texture.semantic != "DEPTH"))
-				effect.errors += "warning: " + texture.unique_name + ": unknown semantic '" + texture.semantic + "'\n";
-
-			// This is the first effect using this texture
-			texture.shared.push_back(effect_index);
-
-			_textures.push_back(std::move(texture));
-		}
 
-		for (technique technique : effect.module.techniques)
-		{
-			technique.effect_index = effect_index;
-
-			technique.hidden = technique.annotation_as_int("hidden") != 0;
-
-			if (technique.annotation_as_int("enabled"))
-				enable_technique(technique);
-
-			_techniques.push_back(std::move(technique));
+				reshadefx::texture_format format = reshadefx::texture_format::unknown;
+				uint32_t width = 0, height = 0, levels = 0;
+				if (read_dds_header(source_path, format, width, height, levels) && width == tex.width && height == tex.height && levels >= tex.levels)
+					effect.compressed_texture_formats[tex.unique_name] = format;
+			}
 		}
 	}
 
-	if (_reload_remaining_effects != 0 && _reload_remaining_effects != std::numeric_limits<size_t>::max())
-		_reload_remaining_effects--;
-	else
-		_reload_remaining_effects = 0; // Force effect initialization in 'update_and_render_effects'
-
 	if ( effect.compiled && (effect.preprocessed || source_cached))
 	{
 		if (effect.errors.empty())
@@ -663,107 +889,1119 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		return false;
 	}
 }
-void reshade::runtime::load_effects()
-{
-	// Reload preprocessor definitions from current preset before compiling
-	_preset_preprocessor_definitions.clear();
-	ini_file &preset = ini_file::load_cache(_current_preset_path);
-	preset.get({}, "PreprocessorDefinitions", _preset_preprocessor_definitions);
-
-	// Build a list of effect files by walking through the effect search paths
-	const std::vector<std::filesystem::path> effect_files =
-		find_files(_effect_search_paths, { L".fx" });
-
-	if (effect_files.empty())
-		return; // No effect files found, so nothing more to do
-
-	// Allocate space for effects which are placed in this array during the 'load_effect' call
-	const size_t offset = _effects.size();
-	_effects.resize(offset + effect_files.size());
-	_reload_remaining_effects = effect_files.size();
-
-	// Now that we have a list of files, load them in parallel
-	// Split workload into batches instead of launching a thread for every file to avoid launch overhead and stutters due to too many threads being in flight
-	const size_t num_splits = std::min<size_t>(effect_files.size(), std::max<size_t>(std::thread::hardware_concurrency(), 2u) - 1);
-
-	// Keep track of the spawned threads, so the runtime cannot be destroyed while they are still running
-	for (size_t n = 0; n < num_splits; ++n)
-		// Create copy of preset instead of reference, so it stays valid even if 'ini_file::load_cache' is called while effects are still being loaded
-		_worker_threads.emplace_back([this, effect_files, offset, num_splits, n, preset]() {
-			// Abort loading when initialization state changes (indicating that 'on_reset' was called in the meantime)
-			for (size_t i = 0; i < effect_files.size() && _is_initialized; ++i)
-				if (i * num_splits / effect_files.size() == n)
-					load_effect(effect_files[i], preset, offset + i);
-		});
-}
-void reshade::runtime::load_textures()
+void reshade::runtime::link_effect(size_t effect_index)
 {
-	_last_texture_reload_successfull = true;
-
-	LOG(INFO) << "Loading image files for textures ...";
+	effect &effect = _effects[effect_index];
+	if (!effect.compiled)
+		return;
 
-	for (texture &texture : _textures)
+	// Textures that were created for a replacement of another effect cannot be shared before it is swapped in, so swap it in right away and create it from scratch instead
+	for (size_t staged_index = 0; staged_index < _staged_effects.size();)
 	{
-		if (texture.impl == nullptr || !texture.semantic.empty())
-			continue; // Ignore textures that are not created yet and those that are handled in the runtime implementation
-
-		std::filesystem::path source_path = std::filesystem::u8path(
-			texture.annotation_as_string("source"));
-		// Ignore textures that have no image file attached to them (e.g. plain render targets)
-		if (source_path.empty())
-			continue;
-
-		// Search for image file using the provided search paths unless the path provided is already absolute
-		if (!find_file(_texture_search_paths, source_path))
+		staged_effect &staged = _staged_effects[staged_index];
+		if (staged.effect_index == effect_index || std::none_of(staged.textures.begin(), staged.textures.end(),
+			[&effect](const texture &tex) {
+				return std::any_of(effect.module.textures.begin(), effect.module.textures.end(),
+					[&tex](const reshadefx::texture_info &info) { return info.unique_name == tex.unique_name; });
+			}))
 		{
-			LOG(ERROR) << "Source " << source_path << " for texture '" << texture.unique_name << "' could not be found in any of the texture search paths!";
-			_last_texture_reload_successfull = false;
+			staged_index++;
 			continue;
 		}
 
-		unsigned char *filedata = nullptr;
-		int width = 0, height = 0, channels = 0;
+		const size_t replaced_effect_index = staged.effect_index;
+		destroy_staged_effect(staged);
+		reshade::effect replacement = std::move(staged.replacement);
+		_staged_effects.erase(_staged_effects.begin() + staged_index);
 
-		if (FILE *file; _wfopen_s(&file, source_path.c_str(), L"rb") == 0)
-		{
-			// Read texture data into memory in one go since that is faster than reading chunk by chunk
-			std::vector<uint8_t> mem(static_cast<size_t>(std::filesystem::file_size(source_path)));
-			fread(mem.data(), 1, mem.size(), file);
-			fclose(file);
+		swap_in_effect(replaced_effect_index, std::move(replacement));
+	}
 
-			if (stbi_dds_test_memory(mem.data(), static_cast<int>(mem.size())))
-				filedata = stbi_dds_load_from_memory(mem.data(), static_cast<int>(mem.size()), &width, &height, &channels, STBI_rgb_alpha);
-			else
-				filedata = stbi_load_from_memory(mem.data(), static_cast<int>(mem.size()), &width, &height, &channels, STBI_rgb_alpha);
+	// Shared textures that were created already, but need more usage flags for this effect
+	std::vector<std::string> widened_textures;
+
+	for (texture texture : effect.module.textures)
+	{
+		texture.effect_index = effect_index;
+
+		// Try to share textures with the same name across effects
+		if (const auto existing_texture = std::find_if(_textures.begin(), _textures.end(),
+			[&texture](const auto &item) { return item.unique_name == texture.unique_name; });
+			existing_texture != _textures.end())
+		{
+			// Cannot share texture if this is a normal one, but the existing one is a reference and vice versa
+			if (texture.semantic != existing_texture->semantic)
+			{
+				effect.errors += "error: " + texture.unique_name + ": another effect (";
+				effect.errors += _effects[existing_texture->effect_index].source_file.filename().u8string();
+				effect.errors += ") already created a texture with the same name but different semantic\n";
+				effect.compiled = false;
+				break;
+			}
+
+			if (texture.semantic.empty() && !existing_texture->matches_description(texture))
+			{
+				effect.errors += "warning: " + texture.unique_name + ": another effect (";
+				effect.errors += _effects[existing_texture->effect_index].source_file.filename().u8string();
+				effect.errors += ") already created a texture with the same name but different dimensions\n";
+			}
+			if (texture.semantic.empty() && (existing_texture->annotation_as_string("source") != texture.annotation_as_string("source")))
+			{
+				effect.errors += "warning: " + texture.unique_name + ": another effect (";
+				effect.errors += _effects[existing_texture->effect_index].source_file.filename().u8string();
+				effect.errors += ") already created a texture with a different image file\n";
+			}
+
+			if (existing_texture->semantic == "COLOR" && _color_bit_depth != 8)
+			{
+				for (const auto &sampler_info : effect.module.samplers)
+				{
+					if (sampler_info.srgb && sampler_info.texture_name == texture.unique_name)
+					{
+						effect.errors += "warning: " + sampler_info.unique_name + ": texture does not support sRGB sampling (back buffer format is not RGBA8)";
+					}
+				}
+			}
+
+			if (std::find(existing_texture->shared.begin(), existing_texture->shared.end(), effect_index) == existing_texture->shared.end())
+				existing_texture->shared.push_back(effect_index);
+
+			// Add usage of this effect to the shared texture (which may have been created read-only or with a block-compressed format before)
+			if (existing_texture->impl != nullptr && existing_texture->semantic.empty() && (
+				(texture.render_target && !existing_texture->render_target) || (texture.storage_access && !existing_texture->storage_access)))
+				widened_textures.push_back(existing_texture->unique_name);
+			existing_texture->render_target |= texture.render_target;
+			existing_texture->storage_access |= texture.storage_access;
+			continue;
+		}
+
+		if (texture.annotation_as_int("pooled") && texture.semantic.empty())
+		{
+			// Try to find another pooled texture to share with (and do not share within the same effect)
+			if (const auto existing_texture = std::find_if(_textures.begin(), _textures.end(),
+				[&texture](const auto &item) { return item.annotation_as_int("pooled") && item.effect_index != texture.effect_index && item.matches_description(texture); });
+				existing_texture != _textures.end())
+			{
+				// Overwrite referenced texture in samplers with the pooled one
+				for (auto &sampler_info : effect.module.samplers)
+					if (sampler_info.texture_name == texture.unique_name)
+						sampler_info.texture_name  = existing_texture->unique_name;
+				// Overwrite referenced texture in storages with the pooled one
+				for (auto &storage_info : effect.module.storages)
+					if (storage_info.texture_name == texture.unique_name)
+						storage_info.texture_name  = existing_texture->unique_name;
+				// Overwrite referenced texture in render targets with the pooled one
+				for (auto &technique_info : effect.module.techniques)
+				{
+					for (auto &pass_info : technique_info.passes)
+					{
+						std::replace(std::begin(pass_info.render_target_names), std::end(pass_info.render_target_names),
+							texture.unique_name, existing_texture->unique_name);
+
+						for (auto &sampler_info : pass_info.samplers)
+							if (sampler_info.texture_name == texture.unique_name)
+								sampler_info.texture_name  = existing_texture->unique_name;
+						for (auto &storage_info : pass_info.storages)
+							if (storage_info.texture_name == texture.unique_name)
+								storage_info.texture_name  = existing_texture->unique_name;
+					}
+				}
+
+				if (std::find(existing_texture->shared.begin(), existing_texture->shared.end(), effect_index) == existing_texture->shared.end())
+					existing_texture->shared.push_back(effect_index);
+
+				if (existing_texture->impl != nullptr && (
+					(texture.render_target && !existing_texture->render_target) || (texture.storage_access && !existing_texture->storage_access)))
+					widened_textures.push_back(existing_texture->unique_name);
+				existing_texture->render_target |= texture.render_target;
+				existing_texture->storage_access |= texture.storage_access;
+				continue;
+			}
+		}
+
+		if (!texture.semantic.empty() && (texture.semantic != "COLOR" && texture.semantic != "DEPTH"))
+			effect.errors += "warning: " + texture.unique_name + ": unknown semantic '" + texture.semantic + "'\n";
+
+		// This is the first effect using this texture
+		texture.shared.push_back(effect_index);
+
+		if (const auto it = effect.compressed_texture_formats.find(texture.unique_name); it != effect.compressed_texture_formats.end())
+			texture.compressed_format = it->second;
+
+		_textures.push_back(std::move(texture));
+	}
+
+	// Usage flags cannot be changed on an existing texture object, so create widened textures again
+	// The other effects sharing them hold views of the current texture objects, so have to be created again as well
+	if (!widened_textures.empty())
+	{
+		std::vector<size_t> dependent_effects;
+		for (const texture &tex : _textures)
+			if (std::find(widened_textures.begin(), widened_textures.end(), tex.unique_name) != widened_textures.end())
+				for (const size_t shared_effect_index : tex.shared)
+					if (shared_effect_index != effect_index && std::find(dependent_effects.begin(), dependent_effects.end(), shared_effect_index) == dependent_effects.end())
+						dependent_effects.push_back(shared_effect_index);
+		// Replacements that are still being created may use them as well
+		for (const staged_effect &staged : _staged_effects)
+			if (staged.replace && staged.effect_index != effect_index && std::find(dependent_effects.begin(), dependent_effects.end(), staged.effect_index) == dependent_effects.end() &&
+				std::any_of(staged.replacement.module.textures.begin(), staged.replacement.module.textures.end(),
+					[&widened_textures](const reshadefx::texture_info &info) { return std::find(widened_textures.begin(), widened_textures.end(), info.unique_name) != widened_textures.end(); }))
+				dependent_effects.push_back(staged.effect_index);
+
+		for (const size_t dependent_effect_index : dependent_effects)
+		{
+			// Replace right away rather than next to the current effect, since the textures are destroyed below
+			// Use the replacement that is still being created if there is one, so that it is not lost
+			reshade::effect dependent_effect = _effects[dependent_effect_index];
+			if (const auto staged = std::find_if(_staged_effects.begin(), _staged_effects.end(),
+				[dependent_effect_index](const staged_effect &item) { return item.effect_index == dependent_effect_index; });
+				staged != _staged_effects.end())
+			{
+				destroy_staged_effect(*staged);
+				if (staged->replace)
+					dependent_effect = std::move(staged->replacement);
+				_staged_effects.erase(staged);
+			}
+
+			swap_in_effect(dependent_effect_index, std::move(dependent_effect));
+		}
+
+		// Destroy the textures after the dependent effects, so that those do not end up referencing them anymore
+		for (texture &tex : _textures)
+		{
+			if (std::find(widened_textures.begin(), widened_textures.end(), tex.unique_name) == widened_textures.end())
+				continue;
+
+			destroy_texture(tex);
+			tex.loaded = false;
+		}
+	}
+
+	for (size_t module_index = 0; module_index < effect.module.techniques.size(); ++module_index)
+	{
+		technique technique = effect.module.techniques[module_index];
+		technique.effect_index = effect_index;
+		technique.module_index = module_index;
+
+		technique.hidden = technique.annotation_as_int("hidden") != 0;
+
+		if (technique.annotation_as_int("enabled"))
+			enable_technique(technique);
+
+		_techniques.push_back(std::move(technique));
+	}
+
+	if (!effect.compiled)
+	{
+		LOG(ERROR) << "Failed to load " << effect.source_file << ":\n" << effect.errors;
+		_last_reload_successfull = false;
+	}
+}
+void reshade::runtime::swap_effect(size_t effect_index, effect &&loaded_effect)
+{
+	effect &effect = _effects[effect_index];
+
+	// Keep the current effect if its source and specialization constant values did not change, so it does not have to be created again
+	if (effect.compiled && loaded_effect.compiled && effect.source_file == loaded_effect.source_file && effect.source_hash == loaded_effect.source_hash && effect.spec_constant_uniforms == loaded_effect.spec_constant_uniforms && effect.preamble == loaded_effect.preamble)
+	{
+		if (loaded_effect.preprocessed && !effect.preprocessed)
+		{
+			effect.preprocessed = true;
+			effect.definitions = std::move(loaded_effect.definitions);
+			effect.included_files = std::move(loaded_effect.included_files);
+		}
+
+		// A replacement that is still being created is out of date now
+		if (const auto staged = std::find_if(_staged_effects.begin(), _staged_effects.end(),
+			[effect_index](const staged_effect &item) { return item.effect_index == effect_index && item.replace; });
+			staged != _staged_effects.end())
+		{
+			destroy_staged_effect(*staged);
+			_staged_effects.erase(staged);
+		}
+		return;
+	}
+
+	replace_effect(effect_index, std::move(loaded_effect));
+}
+void reshade::runtime::replace_effect(size_t effect_index, effect &&loaded_effect)
+{
+	// A replacement that is still being created is superseded by this one
+	if (const auto staged = std::find_if(_staged_effects.begin(), _staged_effects.end(),
+		[effect_index](const staged_effect &item) { return item.effect_index == effect_index; });
+		staged != _staged_effects.end())
+	{
+		destroy_staged_effect(*staged);
+		_staged_effects.erase(staged);
+	}
+
+	// Only create the replacement next to the current effect if that is visible, otherwise there is no gap in the output to avoid
+	bool create_next_to_current = loaded_effect.compiled && _effects[effect_index].rendering != 0 && std::any_of(_techniques.begin(), _techniques.end(),
+		[effect_index](const technique &tech) { return tech.effect_index == effect_index && tech.enabled && tech.impl != nullptr; });
+
+	staged_effect staged;
+	for (texture texture : loaded_effect.module.textures)
+	{
+		if (!create_next_to_current)
+			break;
+
+		texture.effect_index = effect_index;
+
+		const auto existing_texture = std::find_if(_textures.begin(), _textures.end(),
+			[&texture](const auto &item) { return item.unique_name == texture.unique_name; });
+
+		// Share textures that stay the same and are used by the current effect already, which also keeps their contents (e.g. of effects that accumulate data over multiple frames)
+		// Textures with an image file are created again if the source changed, so that changes to that file are picked up, but not for a specialized version of the same source
+		if (existing_texture != _textures.end() && existing_texture->impl != nullptr && existing_texture->semantic == texture.semantic &&
+			std::find(existing_texture->shared.begin(), existing_texture->shared.end(), effect_index) != existing_texture->shared.end() && (!texture.semantic.empty() || (
+			existing_texture->matches_description(texture) &&
+			existing_texture->annotation_as_string("source") == texture.annotation_as_string("source") &&
+			(texture.annotation_as_string("source").empty() || loaded_effect.source_hash == _effects[effect_index].source_hash) &&
+			(existing_texture->render_target || !texture.render_target) && (existing_texture->storage_access || !texture.storage_access))))
+			continue;
+
+		// Otherwise the replacement needs a texture of its own, which is only possible without affecting other effects if none of them uses a texture of the same name
+		// References and pooled textures are resolved by 'link_effect', so cannot be created next to the current effect either
+		if (!texture.semantic.empty() || texture.annotation_as_int("pooled") ||
+			(existing_texture != _textures.end() && (existing_texture->annotation_as_int("pooled") || existing_texture->shared.size() != 1 || existing_texture->shared[0] != effect_index)))
+		{
+			create_next_to_current = false;
+			break;
+		}
+
+		if (const auto it = loaded_effect.compressed_texture_formats.find(texture.unique_name); it != loaded_effect.compressed_texture_formats.end())
+			texture.compressed_format = it->second;
+
+		texture.shared.push_back(effect_index);
+		staged.textures.push_back(std::move(texture));
+	}
+
+	if (!create_next_to_current)
+	{
+		swap_in_effect(effect_index, std::move(loaded_effect));
+		return;
+	}
+
+	staged.effect_index = effect_index;
+	staged.replace = true;
+
+	for (size_t module_index = 0; module_index < loaded_effect.module.techniques.size(); ++module_index)
+	{
+		technique &technique = staged.techniques.emplace_back(loaded_effect.module.techniques[module_index]);
+		technique.effect_index = effect_index;
+		technique.module_index = module_index;
+
+		technique.hidden = technique.annotation_as_int("hidden") != 0;
+	}
+
+	staged.replacement = std::move(loaded_effect);
+	staged.replacement.impl = nullptr; // The loaded effect may be a copy of the current one
+	_staged_effects.push_back(std::move(staged));
+
+	// Create replacement before any others, to keep the time in which the effect does not reflect the change short
+	// This still goes through the frame time budget in 'update_and_render_effects', so that creating a large effect does not stall a frame
+	_reload_compile_queue.erase(std::remove(_reload_compile_queue.begin(), _reload_compile_queue.end(), effect_index), _reload_compile_queue.end());
+	_reload_compile_queue.push_back(effect_index); // Queue is processed from the back
+}
+void reshade::runtime::swap_in_effect(size_t effect_index, effect &&loaded_effect, staged_effect *staged)
+{
+	effect &effect = _effects[effect_index];
+
+	// Remember state of the previous effect, so it can be carried over to the new one
+	const std::vector<uniform> previous_uniforms = std::move(effect.uniforms);
+	const std::vector<unsigned char> previous_uniform_data = std::move(effect.uniform_data_storage);
+	std::vector<technique> previous_techniques;
+	for (const technique &tech : _techniques)
+		if (tech.effect_index == effect_index)
+			previous_techniques.push_back(tech);
+
+	// The version compiled without specialization constants that was kept around is only still of use if this is another specialized version of the same source, which took over all its textures
+	if (const auto generic = std::find_if(_generic_effects.begin(), _generic_effects.end(),
+		[effect_index](const staged_effect &item) { return item.effect_index == effect_index; });
+		generic != _generic_effects.end() && (staged == nullptr || !staged->textures.empty() ||
+			loaded_effect.spec_constant_uniforms.empty() || loaded_effect.source_hash != generic->replacement.source_hash))
+	{
+		destroy_staged_effect(*generic);
+		_generic_effects.erase(generic);
+	}
+
+	if (staged == nullptr)
+	{
+		unload_effect(effect_index);
+
+		effect = std::move(loaded_effect);
+		effect.impl = nullptr; // Device objects of the previous effect were destroyed above, but the loaded effect may be a copy of it
+	}
+	else
+	{
+#if RESHADE_GUI
+		_preview_texture = nullptr;
+#endif
+
+		// Lock here to be safe in case another effect is still loading
+		const std::lock_guard<std::mutex> lock(_reload_mutex);
+
+		// Keep the current effect if it was compiled without specialization constants and is replaced by a specialized version, so that it can be put back in place right away when one of those changes (see 'update_and_render_effects')
+		// This requires the specialized version to have taken over all its textures, which is the case when they come from the same source
+		if (effect.impl != nullptr && effect.spec_constant_uniforms.empty() && !loaded_effect.spec_constant_uniforms.empty() && effect.source_hash == loaded_effect.source_hash && staged->textures.empty() &&
+			std::none_of(_generic_effects.begin(), _generic_effects.end(),
+				[effect_index](const staged_effect &item) { return item.effect_index == effect_index; }) &&
+			std::all_of(previous_techniques.begin(), previous_techniques.end(),
+				[](const technique &tech) { return tech.impl != nullptr; }))
+		{
+			staged_effect &generic = _generic_effects.emplace_back();
+			generic.effect_index = effect_index;
+			generic.replace = true;
+
+			for (technique &tech : _techniques)
+			{
+				if (tech.effect_index != effect_index)
+					continue;
+
+				// Enabled state is restored from the specialized version when this is put back in place
+				technique &generic_tech = generic.techniques.emplace_back(std::move(tech));
+				generic_tech.enabled = false;
+				generic_tech.time_left = 0;
+				tech.impl = nullptr;
+			}
+
+			generic.replacement = std::move(effect);
+			generic.replacement.uniforms = previous_uniforms;
+			generic.replacement.uniform_data_storage = previous_uniform_data;
+			effect.impl = nullptr;
+		}
+
+		for (technique &tech : _techniques)
+			if (tech.effect_index == effect_index && tech.impl != nullptr)
+				destroy_technique(tech);
+		if (effect.impl != nullptr)
+			destroy_effect(effect);
+
+		// Destroy textures belonging to the previous effect, except for those the replacement shares with it
+		_textures.erase(std::remove_if(_textures.begin(), _textures.end(),
+			[this, effect_index, &loaded_effect, staged](texture &tex) {
+				if (std::any_of(loaded_effect.module.textures.begin(), loaded_effect.module.textures.end(),
+						[&tex](const reshadefx::texture_info &info) { return info.unique_name == tex.unique_name; }) &&
+					std::none_of(staged->textures.begin(), staged->textures.end(),
+						[&tex](const texture &item) { return item.unique_name == tex.unique_name; })) {
+					if (std::find(tex.shared.begin(), tex.shared.end(), effect_index) == tex.shared.end())
+						tex.shared.push_back(effect_index);
+					return false;
+				}
+				tex.shared.erase(std::remove(tex.shared.begin(), tex.shared.end(), effect_index), tex.shared.end());
+				if (tex.shared.empty()) {
+					destroy_texture(tex);
+					return true;
+				}
+				return false;
+			}), _textures.end());
+		// Add textures that were created for the replacement
+		for (texture &tex : staged->textures)
+			_textures.push_back(std::move(tex));
+		staged->textures.clear();
+
+		_techniques.erase(std::remove_if(_techniques.begin(), _techniques.end(),
+			[effect_index](const technique &tech) {
+				return tech.effect_index == effect_index;
+			}), _techniques.end());
+		_technique_render_list_dirty = true;
+
+		// Keep device objects, which were created for the replacement
+		effect = std::move(loaded_effect);
+		loaded_effect.impl = nullptr;
+		_effects_version++;
+	}
+
+	effect.rendering = 0;
+	// Storage was replaced, so everything has to be uploaded again
+	effect.uniform_data_dirty.clear();
+	effect.uniform_data_dirty.add(0, effect.uniform_data_storage.size());
+
+	// Copy initial data into uniform storage area
+	for (uniform &variable : effect.uniforms)
+	{
+		reset_uniform_value(variable);
+		variable.last_modified = _last_present_time;
+
+		// Keep values of variables that exist in both versions of the effect
+		if (const auto it = std::find_if(previous_uniforms.begin(), previous_uniforms.end(),
+			[&variable](const uniform &item) { return item.name == variable.name && item.type == variable.type; });
+			it != previous_uniforms.end() && it->offset + it->size <= previous_uniform_data.size())
+		{
+			std::memcpy(effect.uniform_data_storage.data() + variable.offset, previous_uniform_data.data() + it->offset, variable.size);
+			std::memcpy(variable.toggle_key_data, it->toggle_key_data, sizeof(variable.toggle_key_data));
+			variable.last_modified = it->last_modified;
+		}
+	}
+
+	update_toggle_key_uniforms(effect);
+
+	// Check which variables can be specialization constants once the new effect has been rendering for a while
+	effect.spec_constant_check = true;
+	effect.spec_constant_check_time = _last_present_time;
+
+	if (staged == nullptr)
+	{
+		link_effect(effect_index);
+	}
+	else
+	{
+		// Techniques of the replacement were created already, so only have to be added
+		for (technique &tech : staged->techniques)
+		{
+			if (tech.annotation_as_int("enabled"))
+				enable_technique(tech);
+
+			_techniques.push_back(std::move(tech));
+		}
+		staged->techniques.clear();
+	}
+
+	// Restore enabled state of techniques, so that the effect continues rendering the same way as before
+	for (technique &tech : _techniques)
+	{
+		if (tech.effect_index != effect_index)
+			continue;
+
+		if (const auto it = std::find_if(previous_techniques.begin(), previous_techniques.end(),
+			[&tech](const technique &item) { return item.name == tech.name; });
+			it != previous_techniques.end())
+		{
+			std::memcpy(tech.toggle_key_data, it->toggle_key_data, sizeof(tech.toggle_key_data));
+
+			if (it->enabled)
+			{
+				enable_technique(tech);
+				tech.time_left = it->time_left;
+			}
+		}
+	}
+
+	// Create effect before any others if it was rendering before, to keep the gap in which it is missing from the output short
+	// This still goes through the frame time budget in 'update_and_render_effects', so that swapping in a large effect does not stall a frame
+	if (staged == nullptr && effect.rendering != 0)
+	{
+		_reload_compile_queue.erase(std::remove(_reload_compile_queue.begin(), _reload_compile_queue.end(), effect_index), _reload_compile_queue.end());
+		_reload_compile_queue.push_back(effect_index); // Queue is processed from the back
+	}
+}
+bool reshade::runtime::create_effect_step(size_t effect_index)
+{
+	auto staged = std::find_if(_staged_effects.begin(), _staged_effects.end(),
+		[effect_index](const staged_effect &item) { return item.effect_index == effect_index; });
+
+	// A replacement is created next to the current effect, which keeps rendering until the replacement is swapped in below
+	const bool replacing = staged != _staged_effects.end() && staged->replace;
+	effect &effect = replacing ? staged->replacement : _effects[effect_index];
+
+	// Create textures now, since they are referenced when building samplers and passes in the 'init_effect' and 'init_pass' calls below
+	// Only create one per step, so that initialization of effects with a lot of textures can be spread across multiple frames
+	for (texture &tex : replacing ? staged->textures : _textures)
+	{
+		if (!effect.compiled)
+			break;
+
+		if (tex.impl != nullptr || (
+			// Always create shared textures, since they may be in use by this effect already
+			tex.effect_index != effect_index && tex.shared.size() <= 1))
+			continue;
+
+		// Create textures with a block-compressed format if their image file can be uploaded as is, which avoids decoding it and reduces memory usage
+		// The format was found in 'load_effect' already, but another effect may have since started writing to the texture, and the device has to support it
+		if (tex.compressed_format != reshadefx::texture_format::unknown && (tex.render_target || tex.storage_access || !supports_compressed_format(tex.compressed_format)))
+			tex.compressed_format  = reshadefx::texture_format::unknown;
+
+		if (!init_texture(tex))
+		{
+			effect.errors += "Failed to create texture " + tex.unique_name;
+			effect.compiled = false;
+			break;
+		}
+
+		return false;
+	}
+
+	// Create the effect with the back-end implementation (unless texture creation failed), one pass per step
+	// Techniques are created on copies, so that they are not rendered before all their passes exist
+	if (effect.compiled && staged == _staged_effects.end())
+	{
+		staged_effect record;
+		record.effect_index = effect_index;
+		for (const technique &tech : _techniques)
+			if (tech.effect_index == effect_index && tech.impl == nullptr)
+				record.techniques.push_back(tech);
+
+		// Nothing left to do if all techniques were created already
+		if (record.techniques.empty() && effect.impl != nullptr)
+			return true;
+
+		_staged_effects.push_back(std::move(record));
+		staged = std::prev(_staged_effects.end());
+	}
+
+	if (effect.compiled && effect.impl == nullptr)
+	{
+		if (init_effect(effect))
+			return false;
+
+		effect.compiled = false;
+	}
+
+	if (effect.compiled && staged->technique_index < staged->techniques.size())
+	{
+		technique &tech = staged->techniques[staged->technique_index];
+
+		if (tech.impl == nullptr)
+			effect.compiled = init_technique(effect, tech);
+		if (effect.compiled && staged->pass_index < tech.passes.size())
+			effect.compiled = init_pass(effect, tech, staged->pass_index++);
+
+		if (effect.compiled)
+		{
+			if (staged->pass_index < tech.passes.size())
+				return false;
+
+			staged->pass_index = 0;
+			if (++staged->technique_index < staged->techniques.size())
+				return false;
+		}
+	}
+
+	if (replacing)
+	{
+		if (effect.compiled)
+		{
+			swap_in_effect(effect_index, std::move(staged->replacement), &*staged);
+			_staged_effects.erase(staged);
+		}
+		else
+		{
+			// Creating the replacement failed, so put it in place of the current effect without any device objects, so that its errors are shown
+			destroy_staged_effect(*staged);
+			reshade::effect failed_effect = std::move(staged->replacement);
+			_staged_effects.erase(staged);
+
+			swap_in_effect(effect_index, std::move(failed_effect));
+		}
+	}
+	else if (staged != _staged_effects.end())
+	{
+		for (technique &staged_tech : staged->techniques)
+		{
+			if (effect.compiled)
+			{
+				// Hand over the device objects and the passes (which the back-end may have updated) to the technique that is rendered
+				const auto it = std::find_if(_techniques.begin(), _techniques.end(),
+					[&staged_tech](const technique &item) { return item.effect_index == staged_tech.effect_index && item.module_index == staged_tech.module_index; });
+				assert(it != _techniques.end() && it->impl == nullptr);
+
+				it->impl = staged_tech.impl;
+				it->passes = std::move(staged_tech.passes);
+			}
+			else if (staged_tech.impl != nullptr)
+			{
+				destroy_technique(staged_tech);
+			}
+		}
+
+		_staged_effects.erase(staged);
+	}
+
+	// The replacement was moved into the list of effects above, so only access the effect through that from here on
+	reshade::effect &created_effect = _effects[effect_index];
+
+	// De-duplicate error lines (D3DCompiler sometimes repeats the same error multiple times)
+	for (size_t line_offset = 0, next_line_offset;
+		(next_line_offset = created_effect.errors.find('\n', line_offset)) != std::string::npos; line_offset = next_line_offset + 1)
+	{
+		const std::string_view cur_line(created_effect.errors.c_str() + line_offset, next_line_offset - line_offset);
+
+		if (const size_t end_offset = created_effect.errors.find('\n', next_line_offset + 1);
+			end_offset != std::string::npos)
+		{
+			const std::string_view next_line(created_effect.errors.c_str() + next_line_offset + 1, end_offset - next_line_offset - 1);
+			if (cur_line == next_line)
+			{
+				created_effect.errors.erase(next_line_offset, end_offset - next_line_offset);
+				next_line_offset = line_offset - 1;
+			}
+		}
+
+		// Also remove D3DCompiler warnings about 'groupshared' specifier used in VS/PS modules
+		if (cur_line.find("X3579") != std::string_view::npos)
+		{
+			created_effect.errors.erase(line_offset, next_line_offset + 1 - line_offset);
+			next_line_offset = line_offset - 1;
+		}
+	}
+
+	if (!created_effect.compiled) // Something went wrong, do clean up
+	{
+		if (created_effect.errors.empty())
+			LOG(ERROR) << "Failed initializing " << created_effect.source_file << '!';
+		else
+			LOG(ERROR) << "Failed initializing " << created_effect.source_file << ":\n" << created_effect.errors;
+
+		if (created_effect.impl != nullptr)
+			destroy_effect(effect);
+
+		// Destroy all textures belonging to this effect
+		for (texture &tex : _textures)
+		{
+			if (tex.effect_index != effect_index || tex.shared.size() > 1)
+				continue;
+
+			destroy_texture(tex);
+			tex.loaded = false;
+		}
+		// Disable all techniques belonging to this effect
+		for (technique &tech : _techniques)
+			if (tech.effect_index == effect_index)
+				disable_technique(tech);
+
+		_last_reload_successfull = false;
+	}
+
+	// An effect has changed, need to reload textures
+	_textures_loaded = false;
+
+#if RESHADE_GUI
+	if (created_effect.compiled)
+	{
+		// Update assembly in all editors after a reload
+		for (editor_instance &instance : _editors)
+		{
+			if (instance.entry_point_name.empty() || instance.file_path != created_effect.source_file)
+				continue;
+			assert(instance.effect_index == effect_index);
+
+			if (const auto assembly_it = created_effect.assembly.find(instance.entry_point_name);
+				assembly_it != created_effect.assembly.end())
+				open_code_editor(instance);
 		}
+	}
+#endif
+
+	return true;
+}
+void reshade::runtime::compile_entry_points(effect &effect, std::function<void()> continuation, bool idle_priority)
+{
+	// Skip effects that failed to compile and those whose byte code is still valid from a previous load
+	if (!effect.compiled || effect.bytecode.size() == effect.module.entry_points.size())
+	{
+		continuation();
+		return;
+	}
+
+	compile_entry_points_parallel(*_worker_pool, effect,
+		[this, &effect, idle_priority](const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &assembly, std::string &errors) {
+			if (idle_priority)
+				SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE);
+
+			const bool success = compile_entry_point(effect, entry_point, cso, assembly, errors);
+
+			if (idle_priority)
+				SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_NORMAL);
+
+			return success;
+		},
+		[&effect, continuation = std::move(continuation)]() {
+			if (!effect.compiled)
+				LOG(ERROR) << "Failed to compile " << effect.source_file << ":\n" << effect.errors;
+
+			continuation();
+		});
+}
+void reshade::runtime::load_effects()
+{
+	// Reload preprocessor definitions from current preset before compiling
+	_preset_preprocessor_definitions.clear();
+	ini_file &preset = ini_file::load_cache(_current_preset_path);
+	preset.get({}, "PreprocessorDefinitions", _preset_preprocessor_definitions);
+
+	// Build a list of effect files by walking through the effect search paths
+	const std::vector<std::filesystem::path> effect_files =
+		find_files(_effect_search_paths, { L".fx" });
+
+	if (effect_files.empty())
+		return; // No effect files found, so nothing more to do
+
+	// Effects can only be replaced in place if all of them still exist, otherwise start from scratch
+	if (std::any_of(_effects.begin(), _effects.end(), [&effect_files](const effect &effect) {
+			return std::find(effect_files.begin(), effect_files.end(), effect.source_file) == effect_files.end(); }))
+		unload_effects();
 
-		if (filedata == nullptr)
+	// Figure out where each effect file goes, so that existing effects keep rendering until they are replaced in 'swap_effect'
+	_loading_effects.clear();
+	_loading_effects.resize(effect_files.size());
+	_loading_effect_indices.resize(effect_files.size());
+
+	size_t num_effects = _effects.size();
+	for (size_t i = 0; i < effect_files.size(); ++i)
+	{
+		if (const auto it = std::find_if(_effects.begin(), _effects.end(),
+			[&source_file = effect_files[i]](const effect &effect) { return effect.source_file == source_file; });
+			it != _effects.end())
 		{
-			LOG(ERROR) << "Source " << source_path << " for texture '" << texture.unique_name << "' could not be loaded! Make sure it is of a compatible file format.";
-			_last_texture_reload_successfull = false;
-			continue;
+			_loading_effect_indices[i] = std::distance(_effects.begin(), it);
+
+			// Keep track of compiled effects, so that they are not compiled again if their source did not change
+			if (it->compiled)
+			{
+				_loading_effects[i].compiled = true;
+				_loading_effects[i].source_file = it->source_file;
+				_loading_effects[i].source_hash = it->source_hash;
+				_loading_effects[i].spec_constant_uniforms = it->spec_constant_uniforms;
+				// Keep the specialization constants as well, so that 'load_effect' can tell whether the preset changed their values
+				_loading_effects[i].module.spec_constants = it->module.spec_constants;
+				_loading_effects[i].preamble = it->preamble;
+			}
+		}
+		else
+		{
+			_loading_effect_indices[i] = num_effects++;
+		}
+	}
+
+	// Allocate space for new effects, which are placed in this array during the 'swap_effect' call
+	_effects.resize(num_effects);
+	_effects_version++;
+	_reload_remaining_effects = effect_files.size();
+
+	// Create copy of preset instead of reference, so it stays valid even if 'ini_file::load_cache' is called while effects are still being loaded
+	const auto preset_copy = std::make_shared<const ini_file>(preset);
+
+	// Queue the largest files first, so that they do not end up being the last ones still running while all other workers are idle already
+	std::vector<size_t> load_order(effect_files.size());
+	std::vector<uintmax_t> file_sizes(effect_files.size());
+	for (size_t i = 0; i < effect_files.size(); ++i)
+	{
+		std::error_code ec;
+		load_order[i] = i;
+		file_sizes[i] = std::filesystem::file_size(effect_files[i], ec);
+	}
+	std::stable_sort(load_order.begin(), load_order.end(),
+		[&file_sizes](size_t lhs, size_t rhs) { return file_sizes[lhs] > file_sizes[rhs]; });
+
+	// Now that we have a list of files, load them in parallel
+	// Each file is a separate task, so that idle workers can pick up the remaining ones instead of waiting on a fixed batch to finish
+	for (const size_t i : load_order)
+	{
+		_loading_tasks->add();
+
+		_worker_pool->submit([this, i, source_file = effect_files[i], preset_copy]() {
+			// Abort loading when initialization state changes (indicating that 'on_reset' was called in the meantime)
+			if (!_is_initialized)
+			{
+				_loading_tasks->done();
+				return;
+			}
+
+			load_effect(source_file, *preset_copy, _loading_effect_indices[i], _loading_effects[i]);
+
+			// Compile entry points as separate tasks, so that large effects are spread across all workers too
+			compile_entry_points(_loading_effects[i], [this, i]() {
+				// Notify 'update_and_render_effects' that this effect can be swapped in now
+				{	const std::lock_guard<std::mutex> lock(_reload_mutex);
+					_loaded_effects.push_back(i);
+				}
+
+				_reload_remaining_effects--;
+
+				_loading_tasks->done();
+			});
+		});
+	}
+}
+void reshade::runtime::precompile_effect(size_t effect_index)
+{
+	assert(_precompiling_effect == nullptr);
+
+	_precompile_finished = std::make_shared<std::atomic<bool>>(false);
+	_precompiling_effect_index = effect_index;
+	_precompiling_effect = std::make_shared<effect>(_effects[effect_index]);
+	_precompiling_effect->skipped = false;
+
+	const auto preset_copy = std::make_shared<const ini_file>(ini_file::load_cache(_current_preset_path));
+
+	// The tasks hold on to the effect themselves, since the runtime lets go of it when the compilation is abandoned
+	_worker_pool->submit([this, effect_index, preset_copy, effect = _precompiling_effect, finished = _precompile_finished]() {
+		// Run at idle priority, so that this does not take time away from the application
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE);
+
+		load_effect(effect->source_file, *preset_copy, effect_index, *effect);
+
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_NORMAL);
+
+		// The compile tasks may run on any worker, so have them lower the priority themselves
+		compile_entry_points(*effect, [effect, finished]() {
+			*finished = true;
+		}, true);
+	});
+}
+void reshade::runtime::specialize_effect(size_t effect_index)
+{
+	assert(_precompiling_effect == nullptr);
+
+	_precompile_finished = std::make_shared<std::atomic<bool>>(false);
+	_precompiling_effect_index = effect_index;
+	_precompiling_effect = std::make_shared<effect>(_effects[effect_index]);
+
+	// Force code generation to run again (from the cached pre-processed source if available), but keep the list of definitions and included files
+	_precompiling_effect->compiled = false;
+	_precompiling_effect->preprocessed = false;
+	_precompiling_effect->errors.clear();
+	_precompiling_effect->preamble.clear();
+	_precompiling_effect->bytecode.clear();
+
+	_precompiling_effect->spec_constant_uniforms.clear();
+	for (const uniform &variable : _effects[effect_index].uniforms)
+		if (can_be_spec_constant(variable) && _last_present_time - variable.last_modified >= std::chrono::duration<float>(_spec_constant_delay))
+			_precompiling_effect->spec_constant_uniforms.insert(variable.name);
+
+	const auto preset_copy = std::make_shared<const ini_file>(ini_file::load_cache(_current_preset_path));
+
+	_worker_pool->submit([this, effect_index, preset_copy, effect = _precompiling_effect, finished = _precompile_finished]() {
+		load_effect(effect->source_file, *preset_copy, effect_index, *effect);
+
+		compile_entry_points(*effect, [effect, finished]() {
+			*finished = true;
+		});
+	});
+}
+void reshade::runtime::load_textures()
+{
+	if (!_textures_loading)
+	{
+		_textures_loaded = true; // Set here already, so that textures that are invalidated while loading cause another round afterwards
+		_textures_loading = true;
+		_texture_load_start_time = std::chrono::high_resolution_clock::now();
+		_last_texture_reload_successfull = true;
+
+		LOG(INFO) << "Loading image files for textures ...";
+
+		// Copy search paths, since they may be changed in the settings while images are still being loaded
+		const auto search_paths = std::make_shared<const std::vector<std::filesystem::path>>(_texture_search_paths);
+
+		std::vector<texture_image> images;
+		for (size_t texture_index = 0; texture_index < _textures.size(); ++texture_index)
+		{
+			const texture &texture = _textures[texture_index];
+
+			if (texture.impl == nullptr || !texture.semantic.empty() || texture.loaded)
+				continue; // Ignore textures that are not created yet, those that are handled in the runtime implementation and those that already have their image data
+			// Ignore textures that have no image file attached to them (e.g. plain render targets)
+			if (texture.annotation_as_string("source").empty())
+				continue;
+
+			texture_image &image = images.emplace_back();
+			image.texture_index = texture_index;
+			image.texture_name = texture.unique_name;
+			image.width = texture.width;
+			image.height = texture.height;
+			image.levels = texture.levels;
+			image.format = texture.format;
+			image.compressed_format = texture.compressed_format;
+
+			// Image files are treated as sRGB encoded only if a sampler decodes them that way, otherwise their values are filtered as is
+			for (const effect &effect : _effects)
+				for (const reshadefx::sampler_info &sampler : effect.module.samplers)
+					image.srgb |= sampler.srgb && sampler.texture_name == texture.unique_name;
 		}
 
-		// Need to potentially resize image data to the texture dimensions
-		if (texture.width != uint32_t(width) || texture.height != uint32_t(height))
+		const auto mipmap_filter = _texture_mipmap_filter == 1 ? image::mipmap_filter::kaiser : image::mipmap_filter::box;
+
+		_remaining_texture_images = images.size();
+		_loading_tasks->add(images.size());
+
+		// Read, decode and resize every image file as a separate task, so that they are processed in parallel
+		for (texture_image &image : images)
 		{
-			LOG(INFO) << "Resizing image data for texture '" << texture.unique_name << "' from " << width << "x" << height << " to " << texture.width << "x" << texture.height << " ...";
+			std::filesystem::path source_path = std::filesystem::u8path(
+				_textures[image.texture_index].annotation_as_string("source"));
+
+			_worker_pool->submit([this, image = std::move(image), source_path = std::move(source_path), search_paths, mipmap_filter]() mutable {
+				// Abort loading when initialization state changes (indicating that 'on_reset' was called in the meantime)
+				if (!_is_initialized)
+				{
+					_loading_tasks->done();
+					return;
+				}
+
+				// Search for image file using the provided search paths unless the path provided is already absolute
+				if (!find_file(*search_paths, source_path))
+				{
+					LOG(ERROR) << "Source " << source_path << " for texture '" << image.texture_name << "' could not be found in any of the texture search paths!";
+				}
+				else
+				{
+					// Reuse image data decoded during a previous reload or for another texture using the same file, as long as the file did not change
+					std::error_code ec;
+					texture_cache_entry key;
+					key.path = source_path;
+					key.modified_at = std::filesystem::last_write_time(source_path, ec);
+					key.file_size = ec ? 0 : std::filesystem::file_size(source_path, ec);
+					key.width = image.width;
+					key.height = image.height;
+					key.levels = image.levels;
+					key.compressed_format = image.compressed_format;
+
+					if (!ec)
+						image.pixels = find_cached_texture_image(key);
+
+					if (image.pixels == nullptr)
+					{
+						if (image.compressed_format != reshadefx::texture_format::unknown)
+							image.pixels = load_compressed_image_file(source_path, image.texture_name, image.compressed_format, image.width, image.height, image.levels);
+						else
+							image.pixels = load_image_file(source_path, image.texture_name, image.width, image.height);
+
+						if (image.pixels != nullptr && !ec)
+						{
+							key.pixels = image.pixels;
+							add_cached_texture_image(std::move(key));
+						}
+					}
+
+					if (image.compressed_format != reshadefx::texture_format::unknown)
+					{
+						image.has_levels = true;
+					}
+					// Build mipmap levels and convert to the texture format here rather than on the render thread (8-bit textures without mipmaps can be uploaded directly though)
+					else if (image.pixels != nullptr && image::is_convertible_format(image.format) && (image.levels > 1 ||
+						(image.format != reshadefx::texture_format::r8 && image.format != reshadefx::texture_format::rg8 && image.format != reshadefx::texture_format::rgba8)))
+					{
+						// Only RGBA8 textures have a sRGB view, so image data of all other formats is never sRGB encoded
+						image.pixels = std::make_shared<std::vector<uint8_t>>(image::generate_mipmaps(
+							image.pixels->data(), image.width, image.height, image.levels, image.format, mipmap_filter, image.srgb && image.format == reshadefx::texture_format::rgba8));
+						image.has_levels = true;
+					}
+				}
+
+				// Hand image data over to the render thread for upload
+				{	const std::lock_guard<std::mutex> lock(_reload_mutex);
+					_loaded_texture_images.push_back(std::move(image));
+				}
+
+				_remaining_texture_images--;
 
-			std::vector<uint8_t> resized(texture.width * texture.height * 4);
-			stbir_resize_uint8(filedata, width, height, 0, resized.data(), texture.width, texture.height, 0, 4);
-			upload_texture(texture, resized.data());
+				_loading_tasks->done();
+			});
 		}
-		else
+	}
+
+	// Check remaining count before taking the images, so that none can be added after the last batch was taken
+	const bool finished = _remaining_texture_images == 0;
+
+	std::vector<texture_image> images;
+	{	const std::lock_guard<std::mutex> lock(_reload_mutex);
+		images.swap(_loaded_texture_images);
+	}
+
+	// Upload as many images as fit into the frame time budget, but always at least one, so that progress is made
+	const auto budget = std::chrono::microseconds(static_cast<long long>(_effect_init_budget * 1000));
+	const auto budget_start = std::chrono::high_resolution_clock::now();
+
+	size_t num_uploaded = 0;
+	for (; num_uploaded < images.size() && (num_uploaded == 0 || (std::chrono::high_resolution_clock::now() - budget_start) < budget); ++num_uploaded)
+	{
+		const texture_image &image = images[num_uploaded];
+
+		if (image.pixels == nullptr)
 		{
-			upload_texture(texture, filedata);
+			_last_texture_reload_successfull = false;
+			continue;
 		}
 
-		stbi_image_free(filedata);
+		// Texture may have been destroyed or recreated with a different description in the meantime, in which case the image data is of no use anymore
+		if (image.texture_index >= _textures.size())
+			continue;
+		texture &texture = _textures[image.texture_index];
+		if (texture.impl == nullptr || texture.loaded || texture.unique_name != image.texture_name || texture.width != image.width || texture.height != image.height ||
+			texture.format != image.format || texture.compressed_format != image.compressed_format || texture.levels != image.levels)
+			continue;
+
+		if (image.has_levels)
+			upload_texture_levels(texture, image.pixels->data());
+		else
+			upload_texture(texture, image.pixels->data());
 
 		texture.loaded = true;
 	}
 
-	_textures_loaded = true;
+	// Put images that did not fit into this frame back to be uploaded during the next one
+	if (num_uploaded < images.size())
+	{
+		const std::lock_guard<std::mutex> lock(_reload_mutex);
+		_loaded_texture_images.insert(_loaded_texture_images.begin(),
+			std::make_move_iterator(images.begin() + num_uploaded), std::make_move_iterator(images.end()));
+	}
+	else if (finished)
+	{
+		_textures_loading = false;
+
+		LOG(INFO) << "Finished loading image files for textures in " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - _texture_load_start_time).count() << " ms.";
+	}
+}
+std::shared_ptr<const std::vector<uint8_t>> reshade::runtime::find_cached_texture_image(const texture_cache_entry &key)
+{
+	const std::lock_guard<std::mutex> lock(_texture_cache_mutex);
+
+	const auto it = std::find_if(_texture_cache.begin(), _texture_cache.end(),
+		[&key](const texture_cache_entry &entry) {
+			return entry.width == key.width && entry.height == key.height && entry.levels == key.levels && entry.compressed_format == key.compressed_format &&
+				entry.file_size == key.file_size && entry.modified_at == key.modified_at && entry.path == key.path;
+		});
+	if (it == _texture_cache.end())
+		return nullptr;
+
+	it->last_used = ++_texture_cache_tick;
+	return it->pixels;
+}
+void reshade::runtime::add_cached_texture_image(texture_cache_entry &&entry)
+{
+	const size_t budget = static_cast<size_t>(_texture_cache_budget) * 1024 * 1024;
+	if (entry.pixels->size() > budget)
+		return; // Image data does not fit into the cache at all
+
+	const std::lock_guard<std::mutex> lock(_texture_cache_mutex);
+
+	// Replace any data from an older version of the same file
+	const auto it = std::find_if(_texture_cache.begin(), _texture_cache.end(),
+		[&entry](const texture_cache_entry &existing) {
+			return existing.width == entry.width && existing.height == entry.height && existing.levels == entry.levels && existing.compressed_format == entry.compressed_format && existing.path == entry.path;
+		});
+	if (it != _texture_cache.end())
+	{
+		_texture_cache_size -= it->pixels->size();
+		_texture_cache.erase(it);
+	}
+
+	// Evict least recently used entries until there is enough space for the new one
+	while (_texture_cache_size + entry.pixels->size() > budget)
+	{
+		const auto lru = std::min_element(_texture_cache.begin(), _texture_cache.end(),
+			[](const texture_cache_entry &lhs, const texture_cache_entry &rhs) { return lhs.last_used < rhs.last_used; });
+
+		_texture_cache_size -= lru->pixels->size();
+		_texture_cache.erase(lru);
+	}
+
+	_texture_cache_size += entry.pixels->size();
+
+	entry.last_used = ++_texture_cache_tick;
+	_texture_cache.push_back(std::move(entry));
+}
+
+void reshade::runtime::destroy_staged_effect(staged_effect &staged)
+{
+	for (technique &tech : staged.techniques)
+		if (tech.impl != nullptr)
+			destroy_technique(tech);
+	if (staged.replacement.impl != nullptr)
+		destroy_effect(staged.replacement);
+	for (texture &tex : staged.textures)
+		destroy_texture(tex);
 }
 
 void reshade::runtime::unload_effect(size_t effect_index)
@@ -777,6 +2015,27 @@ void reshade::runtime::unload_effect(size_t effect_index)
 	// Lock here to be safe in case another effect is still loading
 	const std::lock_guard<std::mutex> lock(_reload_mutex);
 
+	// Destroy device objects of the effect, including those of techniques that are still being created
+	if (const auto staged = std::find_if(_staged_effects.begin(), _staged_effects.end(),
+		[effect_index](const staged_effect &item) { return item.effect_index == effect_index; });
+		staged != _staged_effects.end())
+	{
+		destroy_staged_effect(*staged);
+		_staged_effects.erase(staged);
+	}
+	if (const auto generic = std::find_if(_generic_effects.begin(), _generic_effects.end(),
+		[effect_index](const staged_effect &item) { return item.effect_index == effect_index; });
+		generic != _generic_effects.end())
+	{
+		destroy_staged_effect(*generic);
+		_generic_effects.erase(generic);
+	}
+	for (technique &tech : _techniques)
+		if (tech.effect_index == effect_index && tech.impl != nullptr)
+			destroy_technique(tech);
+	if (_effects[effect_index].impl != nullptr)
+		destroy_effect(_effects[effect_index]);
+
 	// Destroy textures belonging to this effect
 	_textures.erase(std::remove_if(_textures.begin(), _textures.end(),
 		[this, effect_index](texture &tex) {
@@ -792,9 +2051,11 @@ void reshade::runtime::unload_effect(size_t effect_index)
 		[effect_index](const technique &tech) {
 			return tech.effect_index == effect_index;
 		}), _techniques.end());
+	_technique_render_list_dirty = true;
 
 	_effects[effect_index].rendering = 0;
 	// Do not clear effect here, since it is common to be re-used immediately
+	_effects_version++;
 }
 void reshade::runtime::unload_effects()
 {
@@ -804,21 +2065,47 @@ void reshade::runtime::unload_effects()
 #endif
 
 	// Make sure no threads are still accessing effect data
-	for (std::thread &thread : _worker_threads)
-		if (thread.joinable())
-			thread.join();
-	_worker_threads.clear();
+	// Only wait for loading tasks, a background compilation works on its own copy of an effect and is simply abandoned
+	_loading_tasks->wait();
+
+	// Throw away any effects that were loaded but not swapped in yet
+	_loading_effects.clear();
+	_loading_effect_indices.clear();
+	_loaded_effects.clear();
+	_queued_effect_reloads.clear();
+	_precompile_queue.clear();
+	_precompiling_effect.reset();
+	_precompile_finished.reset();
+
+	// Destroy device objects of all effects, including those of techniques that are still being created
+	for (staged_effect &staged : _staged_effects)
+		destroy_staged_effect(staged);
+	_staged_effects.clear();
+	for (staged_effect &generic : _generic_effects)
+		destroy_staged_effect(generic);
+	_generic_effects.clear();
+	for (technique &tech : _techniques)
+		if (tech.impl != nullptr)
+			destroy_technique(tech);
+	for (effect &effect : _effects)
+		if (effect.impl != nullptr)
+			destroy_effect(effect);
 
 	// Destroy all textures
 	for (texture &tex : _textures)
 		destroy_texture(tex);
 	_textures.clear();
 	_textures_loaded = false;
+	_textures_loading = false;
+	_loaded_texture_images.clear();
+	_remaining_texture_images = 0;
 	// Clean up all techniques
 	_techniques.clear();
+	_technique_render_list_dirty = true;
 
 	// Reset the effect list after all resources have been destroyed
 	_effects.clear();
+	_effects_version++;
 }
 
 bool reshade::runtime::reload_effect(size_t effect_index, bool preprocess_required)
@@ -827,14 +2114,69 @@ bool reshade::runtime::reload_effect(size_t effect_index, bool preprocess_requir
 	_show_splash = false; // Hide splash bar when reloading a single effect file
 #endif
 
-	const std::filesystem::path source_file = _effects[effect_index].source_file;
-	unload_effect(effect_index);
-	return load_effect(source_file, ini_file::load_cache(_current_preset_path), effect_index, preprocess_required);
+	// Cannot add another loading effect while worker threads are still accessing the list, so reload this effect once all others finished loading
+	if (_reload_remaining_effects != 0 && is_loading())
+	{
+		_queued_effect_reloads.emplace_back(effect_index, preprocess_required);
+		return true;
+	}
+
+	// Discard a replacement for this effect that is still waiting to be swapped in
+	_loaded_effects.erase(std::remove_if(_loaded_effects.begin(), _loaded_effects.end(),
+		[this, effect_index](size_t slot) { return _loading_effect_indices[slot] == effect_index; }), _loaded_effects.end());
+
+	// Compile into a copy, so that the current effect keeps rendering until it is replaced in 'update_and_render_effects'
+	const size_t slot = _loading_effects.size();
+	_loading_effects.push_back(_effects[effect_index]);
+	_loading_effect_indices.push_back(effect_index);
+
+	bool success = load_effect(_effects[effect_index].source_file, ini_file::load_cache(_current_preset_path), effect_index, _loading_effects[slot], preprocess_required);
+
+	// Still compile entry points in parallel, but wait for them to finish, since the result is needed right away
+	// Only wait for the tasks of this effect, since the pool may still be busy with unrelated work (e.g. background compilation, image decoding or screenshot encoding)
+	const auto compiled = std::make_shared<std::promise<void>>();
+	std::future<void> compiled_future = compiled->get_future();
+	compile_entry_points(_loading_effects[slot], [compiled]() {
+		compiled->set_value();
+	});
+	compiled_future.wait();
+	success = success && _loading_effects[slot].compiled;
+
+	// The effect is fully loaded now, so there is no point in compiling it in the background anymore
+	// A background compilation that is still running keeps its copy of the effect alive itself, so it can just be abandoned
+	_precompile_queue.erase(effect_index);
+	if (_precompiling_effect != nullptr && _precompiling_effect_index == effect_index)
+	{
+		_precompiling_effect.reset();
+		_precompile_finished.reset();
+	}
+
+	_loaded_effects.push_back(slot);
+	_reload_remaining_effects = 0; // Force effect swap in 'update_and_render_effects'
+
+	return success;
 }
 void reshade::runtime::reload_effects()
 {
-	// Clear out any previous effects
-	unload_effects();
+	// Wait for any previous reload to finish, since its tasks are still accessing the loading effects
+	// Other work on the pool (screenshots, background compilation) does not touch those, so is not waited for
+	_loading_tasks->wait();
+
+	_loading_effects.clear();
+	_loading_effect_indices.clear();
+	_loaded_effects.clear();
+	_queued_effect_reloads.clear();
+	_precompile_queue.clear();
+	_precompiling_effect.reset();
+	_precompile_finished.reset();
+
+	// Image files may have changed too, so load them again once all effects are loaded
+	for (texture &tex : _textures)
+		tex.loaded = false;
+	_textures_loaded = false;
+	_textures_loading = false;
+	_loaded_texture_images.clear();
+	_remaining_texture_images = 0;
 
 #if RESHADE_GUI
 	_show_splash = true; // Always show splash bar when reloading everything
@@ -845,6 +2187,11 @@ void reshade::runtime::reload_effects()
 	load_effects();
 }
 
+bool reshade::runtime::compile_entry_point(const effect &, const reshadefx::entry_point &, std::vector<char> &, std::string &, std::string &) const
+{
+	return true;
+}
+
 bool reshade::runtime::load_effect_cache(const std::filesystem::path &source_file, const size_t hash, std::string &source) const
 {
 	std::filesystem::path path = g_reshade_base_path / _intermediate_cache_path;
@@ -939,13 +2286,47 @@ void reshade::runtime::update_and_render_effects()
 	if (_framecount == 0 && !_no_reload_on_init)
 		reload_effects();
 
+	// Put the version of an effect that was compiled without specialization constants back in place as soon as one of those changed, so that the new value is used in this frame already
+	// A specialized version is compiled again in the background once the variables did not change for a while (see below)
+	for (size_t generic_index = 0; generic_index < _generic_effects.size();)
+	{
+		const size_t effect_index = _generic_effects[generic_index].effect_index;
+		if (!_effects[effect_index].spec_constant_modified)
+		{
+			generic_index++;
+			continue;
+		}
+
+		// A specialized version that is still being compiled would use the previous value
+		if (_precompiling_effect != nullptr && _precompiling_effect_index == effect_index)
+		{
+			_precompiling_effect.reset();
+			_precompile_finished.reset();
+		}
+
+		staged_effect generic = std::move(_generic_effects[generic_index]);
+		_generic_effects.erase(_generic_effects.begin() + generic_index);
+
+		swap_in_effect(effect_index, std::move(generic.replacement), &generic);
+		_effects[effect_index].spec_constant_modified = false;
+	}
+
+	if (_reload_remaining_effects != std::numeric_limits<size_t>::max())
+	{
+		std::vector<size_t> loaded_effects;
+		{	const std::lock_guard<std::mutex> lock(_reload_mutex);
+			loaded_effects.swap(_loaded_effects);
+		}
+
+		// Replace effects that finished loading, while all others keep rendering with their previous state
+		for (const size_t slot : loaded_effects)
+			swap_effect(_loading_effect_indices[slot], std::move(_loading_effects[slot]));
+	}
+
 	if (_reload_remaining_effects == 0)
 	{
-		// Clear the thread list now that they all have finished
-		for (std::thread &thread : _worker_threads)
-			if (thread.joinable())
-				thread.join(); // Threads have exited, but still need to join them prior to destruction
-		_worker_threads.clear();
+		_loading_effects.clear();
+		_loading_effect_indices.clear();
 
 		// Finished loading effects, so apply preset to figure out which ones need compiling
 		load_current_preset();
@@ -956,6 +2337,15 @@ void reshade::runtime::update_and_render_effects()
 		// Reset all effect loading options
 		_load_option_disable_skipping = false;
 
+		// Compile effects that were skipped in the background, so that they are ready when needed
+		for (size_t effect_index = _effects.size(); effect_index-- > 0;)
+			if (_effects[effect_index].skipped)
+				_precompile_queue.insert(effect_index);
+
+		// Reload effects that were requested to be reloaded while all of them were still being loaded
+		for (const auto &[effect_index, preprocess_required] : std::exchange(_queued_effect_reloads, {}))
+			reload_effect(effect_index, preprocess_required);
+
 #if RESHADE_GUI
 		// Update all editors after a reload
 		for (editor_instance &instance : _editors)
@@ -973,113 +2363,118 @@ void reshade::runtime::update_and_render_effects()
 		}
 #endif
 	}
-	else if (_reload_remaining_effects != std::numeric_limits<size_t>::max())
-	{
-		return; // Cannot render while effects are still being loaded
-	}
 	else if (!_reload_compile_queue.empty())
 	{
-		// Pop an effect from the queue
-		const size_t effect_index = _reload_compile_queue.back();
-		_reload_compile_queue.pop_back();
-		effect &effect = _effects[effect_index];
+		// Run as many initialization steps as fit into the frame time budget, but always at least one, so that progress is made
+		const auto budget = std::chrono::microseconds(static_cast<long long>(_effect_init_budget * 1000));
+		const auto budget_start = std::chrono::high_resolution_clock::now();
 
-		// Create textures now, since they are referenced when building samplers in the 'init_effect' call below
-		for (texture &tex : _textures)
+		do
 		{
-			if (tex.impl != nullptr || (
-				// Always create shared textures, since they may be in use by this effect already
-				tex.effect_index != effect_index && tex.shared.size() <= 1))
-				continue;
+			const size_t effect_index = _reload_compile_queue.back();
 
-			if (!init_texture(tex))
-			{
-				effect.errors += "Failed to create texture " + tex.unique_name;
-				effect.compiled = false;
-				break;
-			}
-		}
+			const auto step_start = std::chrono::high_resolution_clock::now();
+			const bool finished = create_effect_step(effect_index);
+			const auto step_duration = std::chrono::high_resolution_clock::now() - step_start;
 
-		// Compile the effect with the back-end implementation (unless texture creation failed)
-		if (effect.compiled)
-			effect.compiled = init_effect(effect_index);
+			if (step_duration > budget)
+				LOG(WARN) << "Initialization step for " << _effects[effect_index].source_file << " took " << std::chrono::duration_cast<std::chrono::microseconds>(step_duration).count() / 1000.0f << " ms, which exceeds the frame time budget of " << _effect_init_budget << " ms.";
 
-		// De-duplicate error lines (D3DCompiler sometimes repeats the same error multiple times)
-		for (size_t line_offset = 0, next_line_offset;
-			(next_line_offset = effect.errors.find('\n', line_offset)) != std::string::npos; line_offset = next_line_offset + 1)
+			// Pop effect from the queue once it is fully initialized
+			if (finished)
+				_reload_compile_queue.pop_back();
+		} while (!_reload_compile_queue.empty() && (std::chrono::high_resolution_clock::now() - budget_start) < budget);
+	}
+	else if (!_textures_loaded || _textures_loading)
+	{
+		// Now that all effects were compiled, load all textures
+		load_textures();
+	}
+	else if (_precompiling_effect != nullptr)
+	{
+		if (*_precompile_finished)
 		{
-			const std::string_view cur_line(effect.errors.c_str() + line_offset, next_line_offset - line_offset);
+			const size_t effect_index = _precompiling_effect_index;
+			const bool was_skipped = _effects[effect_index].skipped;
 
-			if (const size_t end_offset = effect.errors.find('\n', next_line_offset + 1);
-				end_offset != std::string::npos)
+			// Only replace the effect if compilation succeeded, errors are reported when it is actually loaded
+			if (_precompiling_effect->compiled)
 			{
-				const std::string_view next_line(effect.errors.c_str() + next_line_offset + 1, end_offset - next_line_offset - 1);
-				if (cur_line == next_line)
+				swap_effect(effect_index, std::move(*_precompiling_effect));
+
+				// A skipped effect has no values yet that could have been carried over, so load them from the preset
+				if (was_skipped)
 				{
-					effect.errors.erase(next_line_offset, end_offset - next_line_offset);
-					next_line_offset = line_offset - 1;
+					const preset_snapshot &snapshot = load_preset_snapshot(_current_preset_path);
+					load_preset_values(snapshot, effect_index);
+
+					for (technique &technique : _techniques)
+						if (technique.effect_index == effect_index)
+							std::memcpy(technique.toggle_key_data, snapshot.effects[effect_index].techniques[technique.module_index].toggle_key_data, sizeof(technique.toggle_key_data));
 				}
 			}
-
-			// Also remove D3DCompiler warnings about 'groupshared' specifier used in VS/PS modules
-			if (cur_line.find("X3579") != std::string_view::npos)
+			else if (!was_skipped)
 			{
-				effect.errors.erase(line_offset, next_line_offset + 1 - line_offset);
-				next_line_offset = line_offset - 1;
+				LOG(WARN) << "Failed to compile " << _effects[effect_index].source_file << " with specialization constants, will try again later.";
+
+				// Delay the next attempt, which also makes the effect fall back to plain uniform variables in the meantime
+				for (uniform &variable : _effects[effect_index].uniforms)
+					mark_uniform_modified(_effects[effect_index], variable, _last_present_time);
 			}
-		}
 
-		if (!effect.compiled) // Something went wrong, do clean up
+			_precompiling_effect.reset();
+			_precompile_finished.reset();
+		}
+	}
+	else if (!_precompile_queue.empty() && !is_loading())
+	{
+		// Hold off while frame time is elevated, to avoid adding to a stutter
+		if (_last_frame_duration <= _average_frame_duration * 5 / 4)
 		{
-			if (effect.errors.empty())
-				LOG(ERROR) << "Failed initializing " << effect.source_file << '!';
-			else
-				LOG(ERROR) << "Failed initializing " << effect.source_file << ":\n" << effect.errors;
-
-			// Destroy all textures belonging to this effect
-			for (texture &tex : _textures)
-				if (tex.effect_index == effect_index && tex.shared.size() <= 1)
-					destroy_texture(tex);
-			// Disable all techniques belonging to this effect
-			for (technique &tech : _techniques)
-				if (tech.effect_index == effect_index)
-					disable_technique(tech);
+			const size_t effect_index = *_precompile_queue.begin();
+			_precompile_queue.erase(_precompile_queue.begin());
 
-			_last_reload_successfull = false;
+			precompile_effect(effect_index);
 		}
+	}
+	else if (_spec_constant_delay > 0 && !_performance_mode && !is_loading())
+	{
+		const auto delay = std::chrono::duration<float>(_spec_constant_delay);
 
-		// An effect has changed, need to reload textures
-		_textures_loaded = false;
-
-#if RESHADE_GUI
-		if (effect.compiled)
+		// Only look at the variables of effects that had changes, rather than scanning all of them every frame
+		for (size_t effect_index = 0; effect_index < _effects.size(); ++effect_index)
 		{
-			// Update assembly in all editors after a reload
-			for (editor_instance &instance : _editors)
+			effect &effect = _effects[effect_index];
+			// Only bother with effects that are actually rendering
+			if (!effect.compiled || effect.rendering == 0 || !effect.spec_constant_check)
+				continue;
+
+			// Changing a specialization constant only has an effect after compiling again, so do that right away
+			// Otherwise wait until nothing changed for a while before turning more variables into constants, to avoid compiling again for every single one
+			if (!effect.spec_constant_modified && _last_present_time - effect.spec_constant_check_time < delay)
+				continue;
+
+			bool changed_constant = effect.spec_constant_modified, missing_constant = false;
+			for (const uniform &variable : effect.uniforms)
 			{
-				if (instance.entry_point_name.empty() || instance.file_path != effect.source_file)
-					continue;
-				assert(instance.effect_index == effect_index);
+				if (!can_be_spec_constant(variable))
+					// A toggle key may have been assigned after the variable was turned into a constant
+					changed_constant |= variable.spec_constant;
+				else
+					missing_constant |= !variable.spec_constant && _last_present_time - variable.last_modified >= delay;
+			}
 
-				if (const auto assembly_it = effect.assembly.find(instance.entry_point_name);
-					assembly_it != effect.assembly.end())
-					open_code_editor(instance);
+			effect.spec_constant_check = false;
+			effect.spec_constant_modified = false;
+
+			if (changed_constant || missing_constant)
+			{
+				specialize_effect(effect_index);
+				break;
 			}
 		}
-#endif
-	}
-	else if (!_textures_loaded)
-	{
-		// Now that all effects were compiled, load all textures
-		load_textures();
 	}
 
-#ifdef NDEBUG
-	// Lock input so it cannot be modified by other threads while we are reading it here
-	// TODO: This does not catch input happening between now and 'on_present'
-	const auto input_lock = _input->lock();
-#endif
-
 	if (_should_save_screenshot && (_screenshot_save_before || !_effects_enabled))
 		save_screenshot(_effects_enabled ? L" original" : std::wstring(), !_effects_enabled);
 
@@ -1087,15 +2482,33 @@ void reshade::runtime::update_and_render_effects()
 	if (!_effects_enabled)
 		return;
 
+	// Compute values of frame-invariant special variables once, rather than again for every variable in every effect
+	const float frame_time = _last_frame_duration.count() * 1e-6f;
+	const unsigned int frame_count = static_cast<unsigned int>(_framecount % UINT_MAX);
+	const unsigned int timer = static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::milliseconds>(_last_present_time - _start_time).count());
+	int date[4] = {};
+	{
+		const std::time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+		tm tm; localtime_s(&tm, &t);
+
+		date[0] = tm.tm_year + 1900;
+		date[1] = tm.tm_mon + 1;
+		date[2] = tm.tm_mday;
+		date[3] = tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+	}
+
 	// Update special uniform variables
 	for (effect &effect : _effects)
 	{
 		if (!effect.rendering)
 			continue;
 
-		for (uniform &variable : effect.uniforms)
+		// Only poll variables that actually have a toggle key assigned
+		for (const size_t uniform_index : effect.toggle_key_uniforms)
 		{
-			if (!_ignore_shortcuts && variable.toggle_key_data[0] != 0 && _input->is_key_pressed(variable.toggle_key_data, _force_shortcut_modifiers))
+			uniform &variable = effect.uniforms[uniform_index];
+
+			if (!_ignore_shortcuts && _input->is_key_pressed(variable.toggle_key_data, _force_shortcut_modifiers))
 			{
 				assert(variable.supports_toggle_key());
 
@@ -1125,12 +2538,18 @@ void reshade::runtime::update_and_render_effects()
 				}
 				save_current_preset();
 			}
+		}
+
+		// Only go through special variables here, with all their parameters already resolved in 'load_effect'
+		for (const special_uniform_record &record : effect.special_uniforms)
+		{
+			uniform &variable = effect.uniforms[record.uniform_index];
 
-			switch (variable.special)
+			switch (record.special)
 			{
 				case special_uniform::frame_time:
 				{
-					set_uniform_value(variable, _last_frame_duration.count() * 1e-6f);
+					set_uniform_value(variable, frame_time);
 					break;
 				}
 				case special_uniform::frame_count:
@@ -1138,24 +2557,22 @@ void reshade::runtime::update_and_render_effects()
 					if (variable.type.is_boolean())
 						set_uniform_value(variable, (_framecount % 2) == 0);
 					else
-						set_uniform_value(variable, static_cast<unsigned int>(_framecount % UINT_MAX));
+						set_uniform_value(variable, frame_count);
 					break;
 				}
 				case special_uniform::random:
 				{
-					const int min = variable.annotation_as_int("min", 0, 0);
-					const int max = variable.annotation_as_int("max", 0, RAND_MAX);
-					set_uniform_value(variable, min + (std::rand() % (std::abs(max - min) + 1)));
+					set_uniform_value(variable, record.min_int + (std::rand() % (std::abs(record.max_int - record.min_int) + 1)));
 					break;
 				}
 				case special_uniform::ping_pong:
 				{
-					const float min = variable.annotation_as_float("min", 0, 0.0f);
-					const float max = variable.annotation_as_float("max", 0, 1.0f);
-					const float step_min = variable.annotation_as_float("step", 0);
-					const float step_max = variable.annotation_as_float("step", 1);
+					const float min = record.min;
+					const float max = record.max;
+					const float step_min = record.step[0];
+					const float step_max = record.step[1];
 					float increment = step_max == 0 ? step_min : (step_min + std::fmodf(static_cast<float>(std::rand()), step_max - step_min + 1));
-					const float smoothing = variable.annotation_as_float("smoothing");
+					const float smoothing = record.smoothing;
 
 					float value[2] = { 0, 0 };
 					get_uniform_value(variable, value, 2);
@@ -1180,42 +2597,27 @@ void reshade::runtime::update_and_render_effects()
 				}
 				case special_uniform::date:
 				{
-					const std::time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-					tm tm; localtime_s(&tm, &t);
-
-					const int value[4] = {
-						tm.tm_year + 1900,
-						tm.tm_mon + 1,
-						tm.tm_mday,
-						tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec
-					};
-					set_uniform_value(variable, value, 4);
+					set_uniform_value(variable, date, 4);
 					break;
 				}
 				case special_uniform::timer:
 				{
-					const unsigned long long timer_ms = std::chrono::duration_cast<std::chrono::milliseconds>(_last_present_time - _start_time).count();
-					set_uniform_value(variable, static_cast<unsigned int>(timer_ms));
+					set_uniform_value(variable, timer);
 					break;
 				}
 				case special_uniform::key:
 				{
-					if (const int keycode = variable.annotation_as_int("keycode");
-						keycode > 7 && keycode < 256)
+					if (record.toggle)
 					{
-						if (const std::string_view mode = variable.annotation_as_string("mode");
-							mode == "toggle" || variable.annotation_as_int("toggle"))
-						{
-							bool current_value = false;
-							get_uniform_value(variable, &current_value, 1);
-							if (_input->is_key_pressed(keycode))
-								set_uniform_value(variable, !current_value);
-						}
-						else if (mode == "press")
-							set_uniform_value(variable, _input->is_key_pressed(keycode));
-						else
-							set_uniform_value(variable, _input->is_key_down(keycode));
+						bool current_value = false;
+						get_uniform_value(variable, &current_value, 1);
+						if (_input->is_key_pressed(record.keycode))
+							set_uniform_value(variable, !current_value);
 					}
+					else if (record.press)
+						set_uniform_value(variable, _input->is_key_pressed(record.keycode));
+					else
+						set_uniform_value(variable, _input->is_key_down(record.keycode));
 					break;
 				}
 				case special_uniform::mouse_point:
@@ -1230,40 +2632,29 @@ void reshade::runtime::update_and_render_effects()
 				}
 				case special_uniform::mouse_button:
 				{
-					if (const int keycode = variable.annotation_as_int("keycode");
-						keycode >= 0 && keycode < 5)
+					if (record.toggle)
 					{
-						if (const std::string_view mode = variable.annotation_as_string("mode");
-							mode == "toggle" || variable.annotation_as_int("toggle"))
-						{
-							bool current_value = false;
-							get_uniform_value(variable, &current_value, 1);
-							if (_input->is_mouse_button_pressed(keycode))
-								set_uniform_value(variable, !current_value);
-						}
-						else if (mode == "press")
-							set_uniform_value(variable, _input->is_mouse_button_pressed(keycode));
-						else
-							set_uniform_value(variable, _input->is_mouse_button_down(keycode));
+						bool current_value = false;
+						get_uniform_value(variable, &current_value, 1);
+						if (_input->is_mouse_button_pressed(record.keycode))
+							set_uniform_value(variable, !current_value);
 					}
+					else if (record.press)
+						set_uniform_value(variable, _input->is_mouse_button_pressed(record.keycode));
+					else
+						set_uniform_value(variable, _input->is_mouse_button_down(record.keycode));
 					break;
 				}
 				case special_uniform::mouse_wheel:
 				{
-					const float min = variable.annotation_as_float("min");
-					const float max = variable.annotation_as_float("max");
-					float step = variable.annotation_as_float("step");
-					if (step == 0.0f)
-						step  = 1.0f;
-
 					float value[2] = { 0, 0 };
 					get_uniform_value(variable, value, 2);
 					value[1] = _input->mouse_wheel_delta();
-					value[0] = value[0] + value[1] * step;
-					if (min != max)
+					value[0] = value[0] + value[1] * record.step[0];
+					if (record.min != record.max)
 					{
-						value[0] = std::max(value[0], min);
-						value[0] = std::min(value[0], max);
+						value[0] = std::max(value[0], record.min);
+						value[0] = std::min(value[0], record.max);
 					}
 					set_uniform_value(variable, value, 2);
 					break;
@@ -1271,7 +2662,7 @@ void reshade::runtime::update_and_render_effects()
 				case special_uniform::freepie:
 				{
 					if (freepie_io_data data;
-						freepie_io_read(variable.annotation_as_int("index"), &data))
+						freepie_io_read(record.keycode, &data))
 						set_uniform_value(variable, &data.yaw, 3 * 2);
 					break;
 				}
@@ -1299,17 +2690,37 @@ void reshade::runtime::update_and_render_effects()
 		}
 	}
 
-	// Render all enabled techniques
-	for (technique &technique : _techniques)
+	// Toggle techniques with a shortcut key assigned before building the render list, so that changes take effect this frame
+	if (!_ignore_shortcuts)
 	{
-		if (!_ignore_shortcuts && _input->is_key_pressed(technique.toggle_key_data, _force_shortcut_modifiers))
+		for (technique &technique : _techniques)
 		{
+			if (technique.toggle_key_data[0] == 0 || !_input->is_key_pressed(technique.toggle_key_data, _force_shortcut_modifiers))
+				continue;
+
 			if (!technique.enabled)
 				enable_technique(technique);
 			else
 				disable_technique(technique);
 		}
+	}
+
+	if (_technique_render_list_dirty)
+	{
+		_technique_render_list.clear();
+		for (size_t technique_index = 0; technique_index < _techniques.size(); ++technique_index)
+			if (_techniques[technique_index].enabled)
+				_technique_render_list.push_back(technique_index);
 
+		_technique_render_list_dirty = false;
+	}
+
+	// Render all enabled techniques
+	for (const size_t technique_index : _technique_render_list)
+	{
+		technique &technique = _techniques[technique_index];
+
+		// Techniques can still be disabled by a timeout earlier in this frame, which only updates the render list in the next one
 		if (technique.impl == nullptr || !technique.enabled)
 			continue; // Ignore techniques that are not fully loaded or currently disabled
 
@@ -1348,7 +2759,10 @@ void reshade::runtime::enable_technique(technique &technique)
 		_reload_compile_queue.push_back(technique.effect_index);
 
 	if (status_changed) // Increase rendering reference count
+	{
 		_effects[technique.effect_index].rendering++;
+		_technique_render_list_dirty = true;
+	}
 }
 void reshade::runtime::disable_technique(technique &technique)
 {
@@ -1361,7 +2775,18 @@ void reshade::runtime::disable_technique(technique &technique)
 	technique.average_gpu_duration.clear();
 
 	if (status_changed) // Decrease rendering reference count
+	{
 		_effects[technique.effect_index].rendering--;
+		_technique_render_list_dirty = true;
+	}
+}
+void reshade::runtime::update_toggle_key_uniforms(effect &effect)
+{
+	effect.toggle_key_uniforms.clear();
+
+	for (size_t uniform_index = 0; uniform_index < effect.uniforms.size(); ++uniform_index)
+		if (effect.uniforms[uniform_index].toggle_key_data[0] != 0)
+			effect.toggle_key_uniforms.push_back(uniform_index);
 }
 
 void reshade::runtime::subscribe_to_load_config(std::function<void(const ini_file &)> function)
@@ -1391,16 +2816,21 @@ void reshade::runtime::load_config()
 
 	config.get("GENERAL", "NoDebugInfo", _no_debug_info);
 	config.get("GENERAL", "NoReloadOnInit", _no_reload_on_init);
+	config.get("GENERAL", "EffectInitBudget", _effect_init_budget);
+	config.get("GENERAL", "SpecConstantDelay", _spec_constant_delay);
 
 	config.get("GENERAL", "EffectSearchPaths", _effect_search_paths);
 	config.get("GENERAL", "PerformanceMode", _performance_mode);
 	config.get("GENERAL", "PreprocessorDefinitions", _global_preprocessor_definitions);
 	config.get("GENERAL", "SkipLoadingDisabledEffects", _effect_load_skipping);
 	config.get("GENERAL", "TextureSearchPaths", _texture_search_paths);
+	config.get("GENERAL", "TextureMipmapFilter", _texture_mipmap_filter);
+	config.get("GENERAL", "TextureCacheSize", _texture_cache_budget);
 	config.get("GENERAL", "IntermediateCachePath", _intermediate_cache_path);
 
 	config.get("GENERAL", "PresetPath", _current_preset_path);
 	config.get("GENERAL", "PresetTransitionDelay", _preset_transition_delay);
+	config.get("GENERAL", "PresetTransitionEasing", _preset_transition_easing);
 
 	// Fall back to temp directory if cache path does not exist
 	if (_intermediate_cache_path.empty() || !resolve_path(_intermediate_cache_path))
@@ -1418,6 +2848,8 @@ void reshade::runtime::load_config()
 	config.get("SCREENSHOT", "FileFormat", _screenshot_format);
 	config.get("SCREENSHOT", "FileNamingFormat", _screenshot_naming);
 	config.get("SCREENSHOT", "JPEGQuality", _screenshot_jpeg_quality);
+	config.get("SCREENSHOT", "PNGCompression", _screenshot_png_compression);
+	config.get("SCREENSHOT", "QueueSize", _screenshot_queue_size);
 	config.get("SCREENSHOT", "SaveBeforeShot", _screenshot_save_before);
 	config.get("SCREENSHOT", "SaveOverlayShot", _screenshot_save_ui);
 	config.get("SCREENSHOT", "SavePath", _screenshot_path);
@@ -1453,11 +2885,13 @@ void reshade::runtime::save_config() const
 		relative_preset_path = L"." / relative_preset_path;
 	config.set("GENERAL", "PresetPath", relative_preset_path);
 	config.set("GENERAL", "PresetTransitionDelay", _preset_transition_delay);
+	config.set("GENERAL", "PresetTransitionEasing", _preset_transition_easing);
 
 	config.set("SCREENSHOT", "ClearAlpha", _screenshot_clear_alpha);
 	config.set("SCREENSHOT", "FileFormat", _screenshot_format);
 	config.set("SCREENSHOT", "FileNamingFormat", _screenshot_naming);
 	config.set("SCREENSHOT", "JPEGQuality", _screenshot_jpeg_quality);
+	config.set("SCREENSHOT", "PNGCompression", _screenshot_png_compression);
 	config.set("SCREENSHOT", "SaveBeforeShot", _screenshot_save_before);
 	config.set("SCREENSHOT", "SaveOverlayShot", _screenshot_save_ui);
 	config.set("SCREENSHOT", "SavePath", _screenshot_path);
@@ -1471,139 +2905,321 @@ void reshade::runtime::load_current_preset()
 {
 	_preset_save_success = true;
 
-	ini_file config = ini_file::load_cache(_config_path); // Copy config, because reference becomes invalid in the next line
-	const ini_file &preset = ini_file::load_cache(_current_preset_path);
-
-	std::vector<std::string> technique_list;
-	preset.get({}, "Techniques", technique_list);
-	std::vector<std::string> sorted_technique_list;
-	preset.get({}, "TechniqueSorting", sorted_technique_list);
-	std::vector<std::string> preset_preprocessor_definitions;
-	preset.get({}, "PreprocessorDefinitions", preset_preprocessor_definitions);
+	const preset_snapshot &snapshot = load_preset_snapshot(_current_preset_path);
 
 	// Recompile effects if preprocessor definitions have changed or running in performance mode (in which case all preset values are compile-time constants)
 	if (_reload_remaining_effects != 0) // ... unless this is the 'load_current_preset' call in 'update_and_render_effects'
 	{
-		if (_performance_mode || preset_preprocessor_definitions != _preset_preprocessor_definitions)
+		if (_performance_mode || snapshot.preprocessor_definitions != _preset_preprocessor_definitions)
 		{
-			_preset_preprocessor_definitions = std::move(preset_preprocessor_definitions);
+			_preset_preprocessor_definitions = snapshot.preprocessor_definitions;
 			reload_effects();
 			return; // Preset values are loaded in 'update_and_render_effects' during effect loading
 		}
 
-		if (std::find_if(technique_list.begin(), technique_list.end(), [this](const std::string &technique) {
+		if (std::find_if(snapshot.technique_list.begin(), snapshot.technique_list.end(), [this](const std::string &technique) {
 				if (const size_t at_pos = technique.find('@'); at_pos == std::string::npos)
 					return true;
 				else if (const auto it = std::find_if(_effects.begin(), _effects.end(),
 					[effect_name = static_cast<std::string_view>(technique).substr(at_pos + 1)](const effect &effect) { return effect_name == effect.source_file.filename().u8string(); }); it == _effects.end())
 					return true;
 				else
-					return it->skipped; }) != technique_list.end())
+					return it->skipped; }) != snapshot.technique_list.end())
 		{
 			reload_effects();
 			return;
 		}
 	}
 
+	// Reorder techniques
+	// Sorting by position and then by current index keeps techniques missing from the preset in their current order
+	std::vector<std::pair<size_t, size_t>> technique_order; // Pairs of position in the preset and current index
+	technique_order.reserve(_techniques.size());
+	for (size_t i = 0; i < _techniques.size(); ++i)
+		technique_order.emplace_back(snapshot.effects[_techniques[i].effect_index].techniques[_techniques[i].module_index].position, i);
+
+	std::sort(technique_order.begin(), technique_order.end());
+
+	std::vector<technique> sorted_techniques;
+	sorted_techniques.reserve(_techniques.size());
+	for (const auto &[position, index] : technique_order)
+		sorted_techniques.push_back(std::move(_techniques[index]));
+	_techniques = std::move(sorted_techniques);
+	_technique_render_list_dirty = true;
+
+	for (size_t effect_index = 0; effect_index < _effects.size(); ++effect_index)
+	{
+		effect &effect = _effects[effect_index];
+		effect.transitions.clear();
+		effect.transition_start_values.clear();
+		effect.transition_end_values.clear();
+
+		if (!_is_in_between_presets_transition)
+		{
+			load_preset_values(snapshot, effect_index);
+			continue;
+		}
+
+		// Apply the preset right away and compare against the previous values afterwards, so that the end of a transition matches loading the preset directly
+		const std::vector<unsigned char> start_storage = effect.uniform_data_storage;
+
+		load_preset_values(snapshot, effect_index);
+
+		for (size_t uniform_index = 0; uniform_index < effect.uniforms.size(); ++uniform_index)
+		{
+			const uniform &variable = effect.uniforms[uniform_index];
+			// Only floating-point values are interpolated, everything else switches immediately
+			if (variable.special != special_uniform::none || variable.type.base != reshadefx::type::t_float)
+				continue;
+
+			// Collect runs of values that changed, which also skips any padding in between array elements
+			for (size_t offset = variable.offset, end_offset = variable.offset + variable.size; offset < end_offset; offset += 4)
+			{
+				if (std::memcmp(start_storage.data() + offset, effect.uniform_data_storage.data() + offset, 4) == 0)
+					continue;
+
+				if (effect.transitions.empty() || effect.transitions.back().uniform_index != uniform_index ||
+					effect.transitions.back().offset + effect.transitions.back().count * 4 != offset)
+					effect.transitions.push_back({ uniform_index, offset, 0, effect.transition_start_values.size() });
+
+				effect.transitions.back().count++;
+				effect.transition_start_values.push_back(*reinterpret_cast<const float *>(start_storage.data() + offset));
+				effect.transition_end_values.push_back(*reinterpret_cast<const float *>(effect.uniform_data_storage.data() + offset));
+			}
+		}
+
+		// Restore previous values, which are then moved towards the new ones over the course of the transition
+		for (const uniform_transition &transition : effect.transitions)
+			std::memcpy(effect.uniform_data_storage.data() + transition.offset, start_storage.data() + transition.offset, transition.count * 4);
+	}
+
+	for (technique &technique : _techniques)
+	{
+		const preset_snapshot::technique_state &state = snapshot.effects[technique.effect_index].techniques[technique.module_index];
+
+		if (state.enabled)
+			enable_technique(technique);
+		else
+			disable_technique(technique);
+
+		std::memcpy(technique.toggle_key_data, state.toggle_key_data, sizeof(technique.toggle_key_data));
+	}
+}
+const reshade::preset_snapshot &reshade::runtime::load_preset_snapshot(const std::filesystem::path &path)
+{
+	std::vector<std::string> sorted_technique_list;
+	// Read fallback sorting first, because the preset reference becomes invalid when loading another file
+	ini_file::load_cache(_config_path).get("GENERAL", "TechniqueSorting", sorted_technique_list);
+
+	const ini_file &preset = ini_file::load_cache(path);
+
+	auto snapshot_it = std::find_if(_preset_snapshots.begin(), _preset_snapshots.end(),
+		[&path](const preset_snapshot &snapshot) { return snapshot.path == path; });
+	if (snapshot_it == _preset_snapshots.end())
+	{
+		snapshot_it = _preset_snapshots.emplace(_preset_snapshots.end());
+		snapshot_it->path = path;
+	}
+
+	preset_snapshot &snapshot = *snapshot_it;
+
+	// Snapshots only have to be built again if the preset file was modified or the effects changed since
+	if (snapshot.effects_version == _effects_version && snapshot.modified_at == preset.modified_at())
+		return snapshot;
+
+	snapshot.modified_at = preset.modified_at();
+	snapshot.effects_version = _effects_version;
+
+	snapshot.technique_list.clear();
+	preset.get({}, "Techniques", snapshot.technique_list);
+	snapshot.preprocessor_definitions.clear();
+	preset.get({}, "PreprocessorDefinitions", snapshot.preprocessor_definitions);
+
+	if (std::vector<std::string> preset_sorted_technique_list;
+		preset.get({}, "TechniqueSorting", preset_sorted_technique_list) && !preset_sorted_technique_list.empty())
+		sorted_technique_list = std::move(preset_sorted_technique_list);
 	if (sorted_technique_list.empty())
-		config.get("GENERAL", "TechniqueSorting", sorted_technique_list);
-	if (sorted_technique_list.empty())
-		sorted_technique_list = technique_list;
+		sorted_technique_list = snapshot.technique_list;
 
-	// Reorder techniques
-	std::sort(_techniques.begin(), _techniques.end(), [this, &sorted_technique_list](const technique &lhs, const technique &rhs) {
-		const std::string lhs_unique = lhs.name + '@' + _effects[lhs.effect_index].source_file.filename().u8string();
-		const std::string rhs_unique = rhs.name + '@' + _effects[rhs.effect_index].source_file.filename().u8string();
-		auto lhs_it = std::find(sorted_technique_list.begin(), sorted_technique_list.end(), lhs_unique);
-		auto rhs_it = std::find(sorted_technique_list.begin(), sorted_technique_list.end(), rhs_unique);
-		if (lhs_it == sorted_technique_list.end())
-			lhs_it = std::find(sorted_technique_list.begin(), sorted_technique_list.end(), lhs.name);
-		if (rhs_it == sorted_technique_list.end())
-			rhs_it = std::find(sorted_technique_list.begin(), sorted_technique_list.end(), rhs.name);
-		return lhs_it < rhs_it; });
-
-	// Compute times since the transition has started and how much is left till it should end
-	auto transition_time = std::chrono::duration_cast<std::chrono::microseconds>(_last_present_time - _last_preset_switching_time).count();
-	auto transition_ms_left = _preset_transition_delay - transition_time / 1000;
-	auto transition_ms_left_from_last_frame = transition_ms_left + std::chrono::duration_cast<std::chrono::microseconds>(_last_frame_duration).count() / 1000;
-
-	if (_is_in_between_presets_transition && transition_ms_left <= 0)
-		_is_in_between_presets_transition = false;
+	// Look up the position of every technique in the sorted list once, instead of searching the list for every technique
+	std::unordered_map<std::string_view, size_t> sorted_technique_positions;
+	sorted_technique_positions.reserve(sorted_technique_list.size());
+	for (size_t i = 0; i < sorted_technique_list.size(); ++i)
+		sorted_technique_positions.emplace(sorted_technique_list[i], i); // Keeps the first position if a name appears multiple times
 
-	for (effect &effect : _effects)
+	const std::unordered_set<std::string_view> enabled_techniques(snapshot.technique_list.begin(), snapshot.technique_list.end());
+
+	snapshot.effects.resize(_effects.size());
+
+	for (size_t effect_index = 0; effect_index < _effects.size(); ++effect_index)
 	{
-		for (uniform &variable : effect.uniforms)
+		const effect &effect = _effects[effect_index];
+		preset_snapshot::effect_state &effect_state = snapshot.effects[effect_index];
+		const std::string section = effect.source_file.filename().u8string();
+
+		effect_state.uniforms.clear();
+		effect_state.techniques.assign(effect.module.techniques.size(), {});
+
+		for (size_t uniform_index = 0; uniform_index < effect.uniforms.size(); ++uniform_index)
 		{
+			const uniform &variable = effect.uniforms[uniform_index];
 			if (variable.special != special_uniform::none)
 				continue;
-			const std::string section = effect.source_file.filename().u8string();
+
+			preset_snapshot::uniform_value &value = effect_state.uniforms.emplace_back();
+			value.uniform_index = uniform_index;
 
 			if (variable.supports_toggle_key())
 			{
-				// Load shortcut key, but first reset it, since it may not exist in the preset file
-				std::memset(variable.toggle_key_data, 0, sizeof(variable.toggle_key_data));
-				preset.get(section, "Key" + variable.name, variable.toggle_key_data);
+				// Load shortcut key, which stays reset if it does not exist in the preset file
+				value.has_toggle_key = true;
+				preset.get(section, "Key" + variable.name, value.toggle_key_data);
 			}
 
-			if (!_is_in_between_presets_transition)
-				// Reset values to defaults before loading from a new preset
-				reset_uniform_value(variable);
+			// Start out with the default values, which are used for anything not in the preset
+			if (variable.has_initializer_value)
+				value.values = variable.type.is_array() ? variable.initializer_value.array_data[0] : variable.initializer_value;
 
-			reshadefx::constant values, values_old;
 			switch (variable.type.base)
 			{
 			case reshadefx::type::t_int:
-				get_uniform_value(variable, values.as_int, variable.type.components());
-				preset.get(section, variable.name, values.as_int);
-				set_uniform_value(variable, values.as_int, variable.type.components());
+				preset.get(section, variable.name, value.values.as_int);
 				break;
 			case reshadefx::type::t_bool:
 			case reshadefx::type::t_uint:
-				get_uniform_value(variable, values.as_uint, variable.type.components());
-				preset.get(section, variable.name, values.as_uint);
-				set_uniform_value(variable, values.as_uint, variable.type.components());
+				preset.get(section, variable.name, value.values.as_uint);
 				break;
 			case reshadefx::type::t_float:
-				get_uniform_value(variable, values.as_float, variable.type.components());
-				values_old = values;
-				preset.get(section, variable.name, values.as_float);
-				if (_is_in_between_presets_transition)
-				{
-					// Perform smooth transition on floating point values
-					for (unsigned int i = 0; i < variable.type.components(); i++)
-					{
-						const auto transition_ratio = (values.as_float[i] - values_old.as_float[i]) / transition_ms_left_from_last_frame;
-						values.as_float[i] = values.as_float[i] - transition_ratio * transition_ms_left;
-					}
-				}
-				set_uniform_value(variable, values.as_float, variable.type.components());
+				preset.get(section, variable.name, value.values.as_float);
 				break;
 			}
 		}
 	}
 
-	for (technique &technique : _techniques)
+	for (const technique &technique : _techniques)
 	{
+		preset_snapshot::technique_state &state = snapshot.effects[technique.effect_index].techniques[technique.module_index];
+
 		const std::string unique_name =
 			technique.name + '@' + _effects[technique.effect_index].source_file.filename().u8string();
 
+		auto it = sorted_technique_positions.find(unique_name);
+		if (it == sorted_technique_positions.end())
+			it = sorted_technique_positions.find(technique.name);
+		state.position = it != sorted_technique_positions.end() ? it->second : sorted_technique_list.size();
+
 		// Ignore preset if "enabled" annotation is set
-		if (technique.annotation_as_int("enabled") ||
-			std::find(technique_list.begin(), technique_list.end(), unique_name) != technique_list.end() ||
-			std::find(technique_list.begin(), technique_list.end(), technique.name) != technique_list.end())
-			enable_technique(technique);
-		else
-			disable_technique(technique);
+		state.enabled = technique.annotation_as_int("enabled") ||
+			enabled_techniques.find(unique_name) != enabled_techniques.end() ||
+			enabled_techniques.find(technique.name) != enabled_techniques.end();
 
 		// Reset toggle key to the value set via annotation first, since it may not exist in the preset
-		technique.toggle_key_data[0] = technique.annotation_as_int("toggle");
-		technique.toggle_key_data[1] = technique.annotation_as_int("togglectrl");
-		technique.toggle_key_data[2] = technique.annotation_as_int("toggleshift");
-		technique.toggle_key_data[3] = technique.annotation_as_int("togglealt");
-		if (!preset.get({}, "Key" + unique_name, technique.toggle_key_data) &&
-			!preset.get({}, "Key" + technique.name, technique.toggle_key_data))
-			std::memset(technique.toggle_key_data, 0, std::size(technique.toggle_key_data));
+		state.toggle_key_data[0] = technique.annotation_as_int("toggle");
+		state.toggle_key_data[1] = technique.annotation_as_int("togglectrl");
+		state.toggle_key_data[2] = technique.annotation_as_int("toggleshift");
+		state.toggle_key_data[3] = technique.annotation_as_int("togglealt");
+		if (!preset.get({}, "Key" + unique_name, state.toggle_key_data) &&
+			!preset.get({}, "Key" + technique.name, state.toggle_key_data))
+			std::memset(state.toggle_key_data, 0, sizeof(state.toggle_key_data));
+	}
+
+	return snapshot;
+}
+void reshade::runtime::load_preset_values(const preset_snapshot &snapshot, size_t effect_index)
+{
+	effect &effect = _effects[effect_index];
+	assert(snapshot.effects_version == _effects_version && effect_index < snapshot.effects.size());
+
+	// Collect all values first and then update them in one batch
+	const std::vector<preset_snapshot::uniform_value> &preset_values = snapshot.effects[effect_index].uniforms;
+	std::vector<uniform_write> writes;
+	writes.reserve(preset_values.size());
+
+	for (const preset_snapshot::uniform_value &value : preset_values)
+	{
+		uniform &variable = effect.uniforms[value.uniform_index];
+
+		if (value.has_toggle_key && std::memcmp(variable.toggle_key_data, value.toggle_key_data, sizeof(variable.toggle_key_data)) != 0)
+		{
+			std::memcpy(variable.toggle_key_data, value.toggle_key_data, sizeof(variable.toggle_key_data));
+			mark_uniform_modified(effect, variable, _last_present_time);
+		}
+
+		// Reset values to defaults before loading from a new preset (only array elements after the first one are not overwritten below)
+		if (variable.type.is_array())
+			reset_uniform_value(variable);
+
+		switch (variable.type.base)
+		{
+		case reshadefx::type::t_int:
+			writes.push_back({ &variable, reshadefx::type::t_int, value.values.as_int, variable.type.components() });
+			break;
+		case reshadefx::type::t_bool:
+		case reshadefx::type::t_uint:
+			writes.push_back({ &variable, reshadefx::type::t_uint, value.values.as_uint, variable.type.components() });
+			break;
+		case reshadefx::type::t_float:
+			writes.push_back({ &variable, reshadefx::type::t_float, value.values.as_float, variable.type.components() });
+			break;
+		}
+	}
+
+	set_uniform_values(writes.data(), writes.size());
+
+	update_toggle_key_uniforms(effect);
+}
+void reshade::runtime::update_preset_transition()
+{
+	const auto transition_time = std::chrono::duration_cast<std::chrono::microseconds>(_last_present_time - _last_preset_switching_time).count();
+	const bool finished = transition_time >= static_cast<int64_t>(_preset_transition_delay) * 1000;
+
+	float t = finished ? 1.0f : static_cast<float>(transition_time) / (_preset_transition_delay * 1000.0f);
+	switch (_preset_transition_easing)
+	{
+	case 1: // Smooth
+		t = t * t * (3.0f - 2.0f * t);
+		break;
+	case 2: // Ease in
+		t = t * t;
+		break;
+	case 3: // Ease out
+		t = t * (2.0f - t);
+		break;
+	}
+
+	for (effect &effect : _effects)
+	{
+		if (effect.transitions.empty())
+			continue;
+
+		const float *const start_values = effect.transition_start_values.data();
+		const float *const end_values = effect.transition_end_values.data();
+
+		for (const uniform_transition &transition : effect.transitions)
+		{
+			float *const data = reinterpret_cast<float *>(effect.uniform_data_storage.data() + transition.offset);
+
+			// Write the end values unmodified once done, to avoid any rounding errors in the last step
+			if (finished)
+				std::memcpy(data, end_values + transition.value_index, transition.count * 4);
+			else
+				for (size_t i = 0, k = transition.value_index; i < transition.count; ++i, ++k)
+					data[i] = start_values[k] + (end_values[k] - start_values[k]) * t;
+
+			effect.uniform_data_dirty.add(transition.offset, transition.offset + transition.count * 4);
+			mark_uniform_modified(effect, effect.uniforms[transition.uniform_index], _last_present_time);
+		}
+
+		if (finished)
+		{
+			effect.transitions.clear();
+			effect.transition_start_values.clear();
+			effect.transition_end_values.clear();
+		}
 	}
+
+	if (finished)
+		_is_in_between_presets_transition = false;
 }
 void reshade::runtime::save_current_preset() const
 {
@@ -1694,19 +3310,36 @@ bool reshade::runtime::switch_to_next_preset(std::filesystem::path filter_path,
 		if (filter_text = filter_path.filename(); !filter_text.empty())
 			filter_path = filter_path.parent_path();
 
+	// Only enumerate the directory again if its contents changed since the last time
+	if (const std::filesystem::file_time_type modified_at = std::filesystem::last_write_time(filter_path, ec);
+		filter_path != _preset_list_path || modified_at != _preset_list_modified_at)
+	{
+		_preset_list.clear();
+		_preset_list_path = filter_path;
+		_preset_list_modified_at = modified_at;
+
+		for (std::filesystem::path preset_path : std::filesystem::directory_iterator(filter_path, std::filesystem::directory_options::skip_permission_denied, ec))
+		{
+			// Skip anything that is not a valid preset file
+			if (resolve_preset_path(preset_path))
+				_preset_list.push_back(std::move(preset_path));
+		}
+	}
+
 	size_t current_preset_index = std::numeric_limits<size_t>::max();
 	std::vector<std::filesystem::path> preset_paths;
+	preset_paths.reserve(_preset_list.size());
 
-	for (std::filesystem::path preset_path : std::filesystem::directory_iterator(filter_path, std::filesystem::directory_options::skip_permission_denied, ec))
-	{
-		// Skip anything that is not a valid preset file
-		if (!resolve_preset_path(preset_path))
-			continue;
+	const std::wstring current_preset_filename = _current_preset_path.filename();
 
+	for (const std::filesystem::path &preset_path : _preset_list)
+	{
 		// Keep track of the index of the current preset in the list of found preset files that is being build
-		if (std::filesystem::equivalent(preset_path, _current_preset_path, ec)) {
+		// Compare file names first, so that the file system only has to be queried for the one likely match
+		if (_wcsicmp(preset_path.filename().c_str(), current_preset_filename.c_str()) == 0 &&
+			std::filesystem::equivalent(preset_path, _current_preset_path, ec)) {
 			current_preset_index = preset_paths.size();
-			preset_paths.push_back(std::move(preset_path));
+			preset_paths.push_back(preset_path);
 			continue;
 		}
 
@@ -1714,7 +3347,7 @@ bool reshade::runtime::switch_to_next_preset(std::filesystem::path filter_path,
 		// Only add those files that are matching the filter text
 		if (filter_text.empty() || std::search(preset_name.begin(), preset_name.end(), filter_text.native().begin(), filter_text.native().end(),
 			[](wchar_t c1, wchar_t c2) { return towlower(c1) == towlower(c2); }) != preset_name.end())
-			preset_paths.push_back(std::move(preset_path));
+			preset_paths.push_back(preset_path);
 	}
 
 	if (preset_paths.begin() == preset_paths.end())
@@ -1758,61 +3391,81 @@ void reshade::runtime::save_screenshot(const std::wstring &postfix, const bool s
 
 	LOG(INFO) << "Saving screenshot to " << screenshot_path << " ...";
 
-	_screenshot_save_success = false; // Default to a save failure unless it is reported to succeed below
-
-	if (std::vector<uint8_t> data(_width * _height * 4); capture_screenshot(data.data()))
-	{
-		// Clear alpha channel
-		// The alpha channel doesn't need to be cleared if we're saving a JPEG, stbi ignores it
-		if (_screenshot_clear_alpha && _screenshot_format != 2)
-			for (uint32_t h = 0; h < _height; ++h)
-				for (uint32_t w = 0; w < _width; ++w)
-					data[(h * _width + w) * 4 + 3] = 0xFF;
-
-		if (FILE *file; _wfopen_s(&file, screenshot_path.c_str(), L"wb") == 0)
-		{
-			const auto write_callback = [](void *context, void *data, int size) {
-				fwrite(data, 1, size, static_cast<FILE *>(context));
-			};
-
-			switch (_screenshot_format)
-			{
-			case 0:
-				_screenshot_save_success = stbi_write_bmp_to_func(write_callback, file, _width, _height, 4, data.data()) != 0;
-				break;
-			case 1:
-				_screenshot_save_success = stbi_write_png_to_func(write_callback, file, _width, _height, 4, data.data(), 0) != 0;
-				break;
-			case 2:
-				_screenshot_save_success = stbi_write_jpg_to_func(write_callback, file, _width, _height, 4, data.data(), _screenshot_jpeg_quality) != 0;
-				break;
-			}
-
-			fclose(file);
-		}
-	}
+	// Capture into the buffer of an earlier screenshot if possible, which waits for earlier screenshots when too many are still in flight
+	std::vector<uint8_t> data = _screenshot_queue->acquire_buffer(static_cast<size_t>(_width) * _height * 4, _screenshot_queue_size);
 
 	_last_screenshot_file = screenshot_path;
 	_last_screenshot_time = std::chrono::high_resolution_clock::now();
 
-	if (!_screenshot_save_success)
+	if (!capture_screenshot(data.data()))
 	{
-		LOG(ERROR) << "Failed to write screenshot to " << screenshot_path << '!';
+		_screenshot_save_success = false;
+		_screenshot_queue->release_buffer(std::move(data));
+
+		LOG(ERROR) << "Failed to capture screenshot for " << screenshot_path << '!';
+		return;
 	}
-	else if (_screenshot_include_preset && should_save_preset && ini_file::flush_cache(_current_preset_path))
+
+	// Take a copy of the preset now, since it may change before the screenshot is written, which would then no longer match the captured frame
+	std::shared_ptr<const ini_file> preset;
+	if (_screenshot_include_preset && should_save_preset)
+		preset = std::make_shared<const ini_file>(ini_file::load_cache(_current_preset_path));
+
+	// Encode and write the image file on a worker thread, so that the render thread does not stall for the duration
+	// Everything it needs is copied, since settings may change before it runs
+	const auto finish = [preset](const std::filesystem::path &screenshot_path, bool success) {
+		if (!success)
+			LOG(ERROR) << "Failed to write screenshot to " << screenshot_path << '!';
+		else if (preset != nullptr && !preset->save_copy(std::filesystem::path(screenshot_path).replace_extension(L".ini")))
+			LOG(ERROR) << "Failed to write preset next to screenshot " << screenshot_path << '!';
+		return success;
+	};
+
+	if (_screenshot_format == 1)
 	{
-		// Preset was flushed to disk, so can just copy it over to the new location
-		std::error_code ec; std::filesystem::copy_file(_current_preset_path, screenshot_path.replace_extension(L".ini"), std::filesystem::copy_options::overwrite_existing, ec);
+		// The alpha channel is dropped rather than cleared, which makes for smaller files
+		_screenshot_queue->submit_png(std::move(screenshot_path), std::move(data), _width, _height, !_screenshot_clear_alpha, static_cast<image::png_compression>(std::min(_screenshot_png_compression, 2u)),
+			[finish](const std::filesystem::path &screenshot_path, const image::png_encoder &encoder) {
+				return finish(screenshot_path, write_screenshot_file(screenshot_path, [&encoder](FILE *file) {
+					return encoder.write([file](const uint8_t *data, size_t size) { return fwrite(data, 1, size, file) == size; });
+				}));
+			});
+		return;
 	}
-}
 
-static inline bool force_floating_point_value(const reshadefx::type &type, uint32_t renderer_id)
+	_screenshot_queue->submit(std::move(screenshot_path), std::move(data),
+		[finish, width = _width, height = _height, format = _screenshot_format, jpeg_quality = _screenshot_jpeg_quality, clear_alpha = _screenshot_clear_alpha](const std::filesystem::path &screenshot_path, std::vector<uint8_t> &data) {
+			// Clear alpha channel
+			// The alpha channel doesn't need to be cleared if we're saving a JPEG, stbi ignores it
+			if (clear_alpha && format != 2)
+				for (size_t i = 3; i < data.size(); i += 4)
+					data[i] = 0xFF;
+
+			return finish(screenshot_path, write_screenshot_file(screenshot_path, [&](FILE *file) {
+				const auto write_callback = [](void *context, void *data, int size) {
+					fwrite(data, 1, size, static_cast<FILE *>(context));
+				};
+
+				switch (format)
+				{
+				case 0:
+					return stbi_write_bmp_to_func(write_callback, file, width, height, 4, data.data()) != 0;
+				case 2:
+					return stbi_write_jpg_to_func(write_callback, file, width, height, 4, data.data(), jpeg_quality) != 0;
+				default:
+					return false;
+				}
+			}));
+		});
+}
+void reshade::runtime::finish_screenshots(bool wait)
 {
-	if (renderer_id == 0x9000)
-		return true; // All uniform variables are floating-point in D3D9
-	if (type.is_matrix() && (renderer_id & 0x10000))
-		return true; // All matrices are floating-point in GLSL
-	return false;
+	for (const screenshot_queue::result &result : _screenshot_queue->finish(wait))
+	{
+		_screenshot_save_success = result.success;
+		_last_screenshot_file = result.path;
+		_last_screenshot_time = std::chrono::high_resolution_clock::now();
+	}
 }
 
 void reshade::runtime::get_uniform_value(const uniform &variable, uint8_t *data, size_t size, size_t base_index) const
@@ -1904,101 +3557,42 @@ void reshade::runtime::get_uniform_value(const uniform &variable, float *values,
 }
 void reshade::runtime::set_uniform_value(uniform &variable, const uint8_t *data, size_t size, size_t base_index)
 {
-	size = std::min(size, static_cast<size_t>(variable.size));
-	assert(data != nullptr && (size % 4) == 0);
-
-	auto &data_storage = _effects[variable.effect_index].uniform_data_storage;
-	assert(variable.offset + size <= data_storage.size());
+	effect &effect = _effects[variable.effect_index];
 
-	const size_t array_length = (variable.type.is_array() ? variable.type.array_length : 1);
-	assert(base_index < array_length);
-
-	if (variable.type.is_matrix())
-	{
-		for (size_t a = base_index, i = 0; a < array_length; ++a)
-			// Each row of a matrix is 16-byte aligned, so needs special handling
-			for (size_t row = 0; row < variable.type.rows; ++row)
-				for (size_t col = 0; i < (size / 4) && col < variable.type.cols; ++col, ++i)
-					std::memcpy(
-						data_storage.data() + variable.offset + (a * variable.type.rows * 4 + (row * 4 + col)) * 4,
-						data + ((a - base_index) * variable.type.components() + (row * variable.type.cols + col)) * 4, 4);
-	}
-	else if (array_length > 1)
-	{
-		for (size_t a = base_index, i = 0; a < array_length; ++a)
-			// Each element in the array is 16-byte aligned, so needs special handling
-			for (size_t row = 0; i < (size / 4) && row < variable.type.rows; ++row, ++i)
-				std::memcpy(
-					data_storage.data() + variable.offset + (a * 4 + row) * 4,
-					data + ((a - base_index) * variable.type.components() + row) * 4, 4);
-	}
-	else
-	{
-		std::memcpy(data_storage.data() + variable.offset, data, size);
-	}
+	if (write_uniform_data(effect, variable, data, size, base_index))
+		mark_uniform_modified(effect, variable, _last_present_time);
 }
 void reshade::runtime::set_uniform_value(uniform &variable, const bool *values, size_t count, size_t array_index)
 {
-	if (variable.type.is_floating_point() || force_floating_point_value(variable.type, _renderer_id))
-	{
-		const auto data = static_cast<float *>(alloca(count * sizeof(float)));
-		for (size_t i = 0; i < count; ++i)
-			data[i] = values[i] ? 1.0f : 0.0f;
-
-		set_uniform_value(variable, reinterpret_cast<const uint8_t *>(data), count * sizeof(float), array_index);
-	}
-	else
-	{
-		const auto data = static_cast<uint32_t *>(alloca(count * sizeof(uint32_t)));
-		for (size_t i = 0; i < count; ++i)
-			data[i] = values[i] ? 1 : 0;
-
-		set_uniform_value(variable, reinterpret_cast<const uint8_t *>(data), count * sizeof(uint32_t), array_index);
-	}
+	const uniform_write write = { &variable, reshadefx::type::t_bool, values, count, array_index };
+	set_uniform_values(&write, 1);
 }
 void reshade::runtime::set_uniform_value(uniform &variable, const int32_t *values, size_t count, size_t array_index)
 {
-	if (variable.type.is_floating_point() || force_floating_point_value(variable.type, _renderer_id))
-	{
-		const auto data = static_cast<float *>(alloca(count * sizeof(float)));
-		for (size_t i = 0; i < count; ++i)
-			data[i] = static_cast<float>(values[i]);
-
-		set_uniform_value(variable, reinterpret_cast<const uint8_t *>(data), count * sizeof(float), array_index);
-	}
-	else
-	{
-		set_uniform_value(variable, reinterpret_cast<const uint8_t *>(values), count * sizeof(int32_t), array_index);
-	}
+	const uniform_write write = { &variable, reshadefx::type::t_int, values, count, array_index };
+	set_uniform_values(&write, 1);
 }
 void reshade::runtime::set_uniform_value(uniform &variable, const uint32_t *values, size_t count, size_t array_index)
 {
-	if (variable.type.is_floating_point() || force_floating_point_value(variable.type, _renderer_id))
-	{
-		const auto data = static_cast<float *>(alloca(count * sizeof(float)));
-		for (size_t i = 0; i < count; ++i)
-			data[i] = static_cast<float>(values[i]);
-
-		set_uniform_value(variable, reinterpret_cast<const uint8_t *>(data), count * sizeof(float), array_index);
-	}
-	else
-	{
-		set_uniform_value(variable, reinterpret_cast<const uint8_t *>(values), count * sizeof(uint32_t), array_index);
-	}
+	const uniform_write write = { &variable, reshadefx::type::t_uint, values, count, array_index };
+	set_uniform_values(&write, 1);
 }
 void reshade::runtime::set_uniform_value(uniform &variable, const float *values, size_t count, size_t array_index)
 {
-	if (variable.type.is_floating_point() || force_floating_point_value(variable.type, _renderer_id))
-	{
-		set_uniform_value(variable, reinterpret_cast<const uint8_t *>(values), count * sizeof(float), array_index);
-	}
-	else
+	const uniform_write write = { &variable, reshadefx::type::t_float, values, count, array_index };
+	set_uniform_values(&write, 1);
+}
+void reshade::runtime::set_uniform_values(const uniform_write *writes, size_t num_writes)
+{
+	assert(writes != nullptr || num_writes == 0);
+
+	for (size_t w = 0; w < num_writes; ++w)
 	{
-		const auto data = static_cast<int32_t *>(alloca(count * sizeof(int32_t)));
-		for (size_t i = 0; i < count; ++i)
-			data[i] = static_cast<int32_t>(values[i]);
+		uniform &variable = *writes[w].variable;
+		effect &effect = _effects[variable.effect_index];
 
-		set_uniform_value(variable, reinterpret_cast<const uint8_t *>(data), count * sizeof(int32_t), array_index);
+		if (write_uniform_values(effect, writes[w]))
+			mark_uniform_modified(effect, variable, _last_present_time);
 	}
 }
 
@@ -2007,6 +3601,7 @@ void reshade::runtime::reset_uniform_value(uniform &variable)
 	if (!variable.has_initializer_value)
 	{
 		std::memset(_effects[variable.effect_index].uniform_data_storage.data() + variable.offset, 0, variable.size);
+		_effects[variable.effect_index].uniform_data_dirty.add(variable.offset, variable.offset + variable.size);
 		return;
 	}
 
@@ -2034,8 +3629,43 @@ void reshade::runtime::reset_uniform_value(uniform &variable)
 
 reshade::texture &reshade::runtime::look_up_texture_by_name(const std::string &unique_name)
 {
+	// Textures of a replacement that is being created take precedence over those of the current effect with the same name
+	for (staged_effect &staged : _staged_effects)
+		for (texture &tex : staged.textures)
+			if (tex.unique_name == unique_name && tex.impl != nullptr)
+				return tex;
+
 	const auto it = std::find_if(_textures.begin(), _textures.end(),
 		[&unique_name](const auto &item) { return item.unique_name == unique_name && item.impl != nullptr; });
 	assert(it != _textures.end());
 	return *it;
 }
+
+std::vector<const reshade::effect *> reshade::runtime::effects_with_device_objects() const
+{
+	std::vector<const effect *> effects;
+	for (const effect &effect : _effects)
+		if (effect.impl != nullptr)
+			effects.push_back(&effect);
+	for (const staged_effect &staged : _staged_effects)
+		if (staged.replacement.impl != nullptr)
+			effects.push_back(&staged.replacement);
+	for (const staged_effect &generic : _generic_effects)
+		effects.push_back(&generic.replacement);
+	return effects;
+}
+std::vector<const reshade::technique *> reshade::runtime::techniques_with_device_objects() const
+{
+	std::vector<const technique *> techniques;
+	for (const technique &tech : _techniques)
+		if (tech.impl != nullptr)
+			techniques.push_back(&tech);
+	for (const staged_effect &staged : _staged_effects)
+		for (const technique &tech : staged.techniques)
+			if (tech.impl != nullptr)
+				techniques.push_back(&tech);
+	for (const staged_effect &generic : _generic_effects)
+		for (const technique &tech : generic.techniques)
+			techniques.push_back(&tech);
+	return techniques;
+}
@@ -5,12 +5,14 @@
 
 #pragma once
 
+#include <set>
 #include <mutex>
 #include <memory>
 #include <atomic>
 #include <chrono>
 #include <functional>
 #include <filesystem>
+#include <condition_variable>
 
 #if RESHADE_GUI
 #include "imgui_editor.hpp"
@@ -21,13 +23,27 @@ struct ImGuiContext;
 
 extern volatile long g_network_traffic;
 
+namespace reshadefx
+{
+	struct entry_point;
+	enum class texture_format;
+}
+
 namespace reshade
 {
 	class ini_file; // Forward declarations to avoid excessive #include
+	class task_group;
+	class task_scheduler;
+	class screenshot_queue;
 	struct effect;
 	struct uniform;
+	struct uniform_write;
 	struct texture;
 	struct technique;
+	struct staged_effect;
+	struct preset_snapshot;
+	struct texture_image;
+	struct texture_cache_entry;
 
 	/// <summary>
 	/// Platform independent base class for the main ReShade runtime.
@@ -73,6 +89,17 @@ namespace reshade
 		/// <param name="pixels">The 32bpp RGBA image data to update the texture with.</param>
 		virtual void upload_texture(const texture &texture, const uint8_t *pixels) = 0;
 		/// <summary>
+		/// Upload the image data of a texture including all of its mipmap levels, so that they do not need to be generated.
+		/// </summary>
+		/// <param name="texture">The texture to update.</param>
+		/// <param name="data">The image data of all mipmap levels in the <see cref="texture::storage_format"/> of the texture, stored one after another without any row padding (rows of 4x4 blocks for block-compressed formats).</param>
+		virtual void upload_texture_levels(const texture &texture, const uint8_t *data) = 0;
+		/// <summary>
+		/// Check whether textures can be created with the specified block-compressed format.
+		/// </summary>
+		/// <param name="format">The block-compressed format to check.</param>
+		virtual bool supports_compressed_format(reshadefx::texture_format format) const = 0;
+		/// <summary>
 		/// Destroy an existing texture.
 		/// </summary>
 		/// <param name="texture">The texture to destroy.</param>
@@ -109,6 +136,13 @@ namespace reshade
 			const T data[4] = { x, y, z, w };
 			set_uniform_value(variable, data, 4);
 		}
+		/// <summary>
+		/// Update the values of multiple uniform variables at once.
+		/// Values are converted to the storage type of each variable in a single pass and copied as a whole where the storage layout allows it.
+		/// </summary>
+		/// <param name="writes">The list of variables and values to update them to.</param>
+		/// <param name="num_writes">The number of entries in the <paramref name="writes"/> list.</param>
+		void set_uniform_values(const uniform_write *writes, size_t num_writes);
 
 		/// <summary>
 		/// Reset a uniform variable to its initial value.
@@ -154,26 +188,120 @@ namespace reshade
 		void on_present();
 
 		/// <summary>
-		/// Compile effect from the specified source file and initialize textures, uniforms and techniques.
+		/// Compile effect from the specified source file and initialize uniforms.
+		/// This does not touch any of the active runtime state, so it is safe to call from a worker thread while rendering continues.
 		/// </summary>
 		/// <param name="source_file">The path to an effect source code file.</param>
 		/// <param name="preset">The preset to be used to fill specialization constants or check whether loading can be skipped.</param>
+		/// <param name="effect_index">The ID the effect will be placed at.</param>
+		/// <param name="effect">The effect object to compile into.</param>
+		bool load_effect(const std::filesystem::path &source_file, const reshade::ini_file &preset, size_t effect_index, effect &effect, bool preprocess_required = false);
+		/// <summary>
+		/// Replace the effect at the specified index with a newly loaded one, unless that is the same as the current one.
+		/// The previous effect keeps rendering up to this call and the replacement is queued for initialization before any other effects.
+		/// </summary>
 		/// <param name="effect_index">The ID of the effect.</param>
-		bool load_effect(const std::filesystem::path &source_file, const reshade::ini_file &preset, size_t effect_index, bool preprocess_required = false);
+		/// <param name="loaded_effect">The effect data returned by <see cref="load_effect"/>.</param>
+		void swap_effect(size_t effect_index, effect &&loaded_effect);
+		/// <summary>
+		/// Replace the effect at the specified index with the specified one, keeping uniform values and enabled techniques.
+		/// If the current effect is rendering, the replacement is created next to it in <see cref="create_effect_step"/> and only swapped in once it was fully created, so that the effect does not disappear from the output in the meantime.
+		/// </summary>
+		/// <param name="effect_index">The ID of the effect.</param>
+		/// <param name="loaded_effect">The effect data to replace the current one with.</param>
+		void replace_effect(size_t effect_index, effect &&loaded_effect);
+		/// <summary>
+		/// Destroy the effect at the specified index and put the specified one in its place, keeping uniform values and enabled techniques.
+		/// </summary>
+		/// <param name="effect_index">The ID of the effect.</param>
+		/// <param name="loaded_effect">The effect data to replace the current one with.</param>
+		/// <param name="staged">The record the replacement was created in, whose textures and techniques are taken over, or <c>nullptr</c> to link the replacement from scratch.</param>
+		void swap_in_effect(size_t effect_index, effect &&loaded_effect, staged_effect *staged = nullptr);
+		/// <summary>
+		/// Add textures and techniques of the effect to the runtime.
+		/// </summary>
+		/// <param name="effect_index">The ID of the effect.</param>
+		void link_effect(size_t effect_index);
+		/// <summary>
+		/// Perform the next step of creating the effect, which is either creating one of its textures, the effect objects or a single pass with the back-end implementation.
+		/// Techniques are only handed over to rendering once all of their passes were created.
+		/// </summary>
+		/// <param name="effect_index">The ID of the effect.</param>
+		/// <returns><c>true</c> when the effect is fully created, <c>false</c> when there are steps left.</returns>
+		bool create_effect_step(size_t effect_index);
+		/// <summary>
+		/// Compile all entry points of the effect in parallel on the worker pool and execute the continuation once they finished.
+		/// </summary>
+		/// <param name="effect">The effect to compile the entry points of.</param>
+		/// <param name="continuation">The function to execute after all entry points were compiled.</param>
+		/// <param name="idle_priority">Set to <c>true</c> to compile at idle thread priority, so that this does not take time away from the application.</param>
+		void compile_entry_points(effect &effect, std::function<void()> continuation, bool idle_priority = false);
 		/// <summary>
 		/// Load all effects found in the effect search paths.
 		/// </summary>
 		void load_effects();
 		/// <summary>
-		/// Initialize resources for the effect and load the effect module.
+		/// Compile an effect that was skipped during loading in the background at idle priority, so that enabling it later only has to create the device objects.
+		/// The result is swapped in by <see cref="update_and_render_effects"/> once it is ready.
+		/// </summary>
+		/// <param name="effect_index">The ID of the skipped effect.</param>
+		void precompile_effect(size_t effect_index);
+		/// <summary>
+		/// Compile an effect again in the background, with all uniform variables that were not changed for a while turned into specialization constants.
+		/// The result is swapped in by <see cref="update_and_render_effects"/> once it is ready.
 		/// </summary>
 		/// <param name="effect_index">The ID of the effect.</param>
-		virtual bool init_effect(size_t effect_index) = 0;
+		void specialize_effect(size_t effect_index);
+		/// <summary>
+		/// Compile a single entry point of an effect to the byte code the back-end implementation creates its shader objects from.
+		/// This is called concurrently for all entry points of an effect on worker threads, so it must not access any device state.
+		/// The default implementation leaves the byte code empty, for back-ends that can only compile shaders on the render thread.
+		/// </summary>
+		/// <param name="effect">The effect the entry point belongs to.</param>
+		/// <param name="entry_point">The entry point to compile.</param>
+		/// <param name="cso">The output byte code.</param>
+		/// <param name="assembly">The output disassembly of the byte code.</param>
+		/// <param name="errors">The output compiler warnings and errors.</param>
+		virtual bool compile_entry_point(const effect &effect, const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &assembly, std::string &errors) const;
+		/// <summary>
+		/// Create the device objects shared by all techniques of the effect (constant buffer, samplers, ...).
+		/// This is called on the render thread after all entry points were compiled with <see cref="compile_entry_point"/>, so only has to create the device objects.
+		/// </summary>
+		/// <param name="effect">The effect to create the device objects for.</param>
+		virtual bool init_effect(effect &effect) = 0;
+		/// <summary>
+		/// Create the device objects of a technique, but none of its passes yet.
+		/// </summary>
+		/// <param name="effect">The effect the technique belongs to, which was initialized with <see cref="init_effect"/>.</param>
+		/// <param name="technique">The technique to create the device objects for.</param>
+		virtual bool init_technique(effect &effect, technique &technique) = 0;
+		/// <summary>
+		/// Create the shaders and pipeline state of a single pass, so that creating an effect can be spread across multiple frames.
+		/// </summary>
+		/// <param name="effect">The effect the technique belongs to.</param>
+		/// <param name="technique">The technique the pass belongs to, which was initialized with <see cref="init_technique"/>.</param>
+		/// <param name="pass_index">The index of the pass in the technique.</param>
+		virtual bool init_pass(effect &effect, technique &technique, size_t pass_index) = 0;
+		/// <summary>
+		/// Destroy the device objects of a technique, including those of all passes that were created.
+		/// </summary>
+		/// <param name="technique">The technique to destroy the device objects of.</param>
+		virtual void destroy_technique(technique &technique) = 0;
+		/// <summary>
+		/// Destroy the device objects shared by all techniques of the effect.
+		/// </summary>
+		/// <param name="effect">The effect to destroy the device objects of.</param>
+		virtual void destroy_effect(effect &effect) = 0;
+		/// <summary>
+		/// Destroy all device objects that were created for an effect that is still being created.
+		/// </summary>
+		/// <param name="staged">The record of the effect that is being created.</param>
+		void destroy_staged_effect(staged_effect &staged);
 		/// <summary>
 		/// Unload the specified effect.
 		/// </summary>
 		/// <param name="effect_index">The ID of the effect.</param>
-		virtual void unload_effect(size_t effect_index);
+		void unload_effect(size_t effect_index);
 		/// <summary>
 		/// Unload all effects currently loaded.
 		/// </summary>
@@ -181,6 +309,7 @@ namespace reshade
 
 		/// <summary>
 		/// Reload only the specified effect.
+		/// If all effects are still being loaded, the reload is queued until those finished.
 		/// </summary>
 		/// <param name="effect_index">The ID of the effect.</param>
 		bool reload_effect(size_t effect_index, bool preprocess_required = false);
@@ -201,9 +330,18 @@ namespace reshade
 		bool save_effect_cache(const std::filesystem::path &source_file, const std::string &entry_point, const size_t hash, const std::vector<char> &cso, const std::string &dasm) const;
 
 		/// <summary>
-		/// Load image files and update textures with image data.
+		/// Load image files on the worker threads and update textures with image data as they become available.
+		/// This is called every frame until all textures are loaded and only uploads as many as fit into the frame time budget.
 		/// </summary>
 		void load_textures();
+		/// <summary>
+		/// Find image data that was previously loaded from the file and with the dimensions and format described by the specified key.
+		/// </summary>
+		std::shared_ptr<const std::vector<uint8_t>> find_cached_texture_image(const texture_cache_entry &key);
+		/// <summary>
+		/// Keep decoded image data in memory for later reloads, evicting the least recently used data when the cache exceeds its size budget.
+		/// </summary>
+		void add_cached_texture_image(texture_cache_entry &&entry);
 
 		/// <summary>
 		/// Apply post-processing effects to the frame.
@@ -227,6 +365,14 @@ namespace reshade
 		/// </summary>
 		/// <param name="unique_name">The name of the texture to find.</param>
 		texture &look_up_texture_by_name(const std::string &unique_name);
+		/// <summary>
+		/// Returns all effects that have device objects, which includes effects and replacements that are still being created and effects that were replaced by a specialized version.
+		/// </summary>
+		std::vector<const effect *> effects_with_device_objects() const;
+		/// <summary>
+		/// Returns all techniques that have device objects, which includes techniques that are still being created or were replaced by a specialized version and are not rendered.
+		/// </summary>
+		std::vector<const technique *> techniques_with_device_objects() const;
 
 		bool _is_initialized = false;
 		bool _performance_mode = false;
@@ -273,6 +419,12 @@ namespace reshade
 		/// <param name="technique"></param>
 		void disable_technique(technique &technique);
 
+		/// <summary>
+		/// Rebuild the list of variables in an effect that have a toggle key assigned. Needs to be called whenever a toggle key of a variable changed.
+		/// </summary>
+		/// <param name="effect"></param>
+		void update_toggle_key_uniforms(effect &effect);
+
 		/// <summary>
 		/// Load user configuration from disk.
 		/// </summary>
@@ -283,6 +435,19 @@ namespace reshade
 		/// </summary>
 		void load_current_preset();
 		/// <summary>
+		/// Get the snapshot of a preset, which is built from the preset file first if it does not exist yet or is outdated.
+		/// </summary>
+		/// <param name="path">The path to the preset file.</param>
+		const preset_snapshot &load_preset_snapshot(const std::filesystem::path &path);
+		/// <summary>
+		/// Load values of all uniform variables of the specified effect from a preset snapshot.
+		/// </summary>
+		void load_preset_values(const preset_snapshot &snapshot, size_t effect_index);
+		/// <summary>
+		/// Interpolate floating-point uniform variables between the values they had before and after the last preset switch.
+		/// </summary>
+		void update_preset_transition();
+		/// <summary>
 		/// Save the current value configuration to the currently selected preset.
 		/// </summary>
 		void save_current_preset() const;
@@ -299,6 +464,11 @@ namespace reshade
 		/// Create a copy of the current frame and write it to an image file on disk.
 		/// </summary>
 		void save_screenshot(const std::wstring &postfix = std::wstring(), bool should_save_preset = false);
+		/// <summary>
+		/// Update the screenshot status with the results of all screenshots that finished writing on a worker thread.
+		/// </summary>
+		/// <param name="wait">Set to <c>true</c> to block until at least one screenshot finished, if none did yet.</param>
+		void finish_screenshots(bool wait = false);
 
 		// === Status ===
 		bool _effects_enabled = true;
@@ -307,6 +477,7 @@ namespace reshade
 		unsigned int _effects_key_data[4];
 		std::shared_ptr<class input> _input;
 		std::chrono::high_resolution_clock::duration _last_frame_duration;
+		std::chrono::high_resolution_clock::duration _average_frame_duration;
 		std::chrono::high_resolution_clock::time_point _start_time;
 		std::chrono::high_resolution_clock::time_point _last_present_time;
 
@@ -321,16 +492,39 @@ namespace reshade
 		bool _no_debug_info = 0;
 		bool _no_reload_on_init = false;
 		bool _effect_load_skipping = false;
+		float _effect_init_budget = 4.0f; // Maximum time in milliseconds spent per frame on initializing effects
+		float _spec_constant_delay = 0.0f; // Time in seconds after which unchanged uniform variables are compiled as specialization constants (zero disables this)
 		bool _load_option_disable_skipping = false;
 		std::atomic<int> _last_reload_successfull = true;
 		bool _last_texture_reload_successfull = true;
 		bool _textures_loaded = false;
+		bool _textures_loading = false;
+		std::atomic<size_t> _remaining_texture_images = 0;
+		std::vector<texture_image> _loaded_texture_images; // Protected by '_reload_mutex'
+		std::chrono::high_resolution_clock::time_point _texture_load_start_time;
+		unsigned int _texture_mipmap_filter = 0; // Filter used to generate mipmap levels of textures with an image file (0 = box, 1 = kaiser)
+		unsigned int _texture_cache_budget = 256; // Maximum size in MiB of decoded image data kept in memory between reloads (zero disables the cache)
+		size_t _texture_cache_size = 0; // Protected by '_texture_cache_mutex'
+		uint64_t _texture_cache_tick = 0; // Protected by '_texture_cache_mutex'
+		std::mutex _texture_cache_mutex;
+		std::vector<texture_cache_entry> _texture_cache; // Protected by '_texture_cache_mutex'
 		unsigned int _reload_key_data[4];
 		unsigned int _performance_mode_key_data[4];
 		std::vector<size_t> _reload_compile_queue;
+		std::vector<staged_effect> _staged_effects; // Effects whose passes are being created by 'create_effect_step'
+		std::vector<staged_effect> _generic_effects; // Effects compiled without specialization constants, which are kept while a specialized version of them is rendering
 		std::atomic<size_t> _reload_remaining_effects = 0;
 		std::mutex _reload_mutex;
-		std::vector<std::thread> _worker_threads;
+		std::vector<effect> _loading_effects;
+		std::vector<size_t> _loading_effect_indices;
+		std::vector<size_t> _loaded_effects; // Protected by '_reload_mutex'
+		std::vector<std::pair<size_t, bool>> _queued_effect_reloads; // Effects (and whether they have to be preprocessed again) that 'reload_effect' was called for while 'load_effects' was still running
+		std::unique_ptr<task_group> _loading_tasks; // Tasks that access the loading effects and texture images, declared before the pool, so that it outlives the worker threads
+		std::unique_ptr<task_scheduler> _worker_pool;
+		std::set<size_t> _precompile_queue; // Effects that were skipped during loading and are compiled in idle time (a set, so that an effect is only queued once no matter how often it was skipped)
+		std::shared_ptr<effect> _precompiling_effect; // Shared with the background compilation, so that it can be abandoned without waiting for it to finish
+		size_t _precompiling_effect_index = std::numeric_limits<size_t>::max();
+		std::shared_ptr<std::atomic<bool>> _precompile_finished;
 		std::vector<std::string> _global_preprocessor_definitions;
 		std::vector<std::string> _preset_preprocessor_definitions;
 		std::vector<std::filesystem::path> _effect_search_paths;
@@ -338,6 +532,10 @@ namespace reshade
 		std::filesystem::path _intermediate_cache_path;
 		std::chrono::high_resolution_clock::time_point _last_reload_time;
 
+		// === Effect Rendering ===
+		bool _technique_render_list_dirty = true; // Set whenever techniques are reordered, added, removed, enabled or disabled
+		std::vector<size_t> _technique_render_list; // Indices into '_techniques' of all enabled techniques, in render order
+
 		// === Screenshots ===
 		bool _should_save_screenshot = false;
 		bool _screenshot_save_ui = false;
@@ -352,6 +550,9 @@ namespace reshade
 		std::filesystem::path _last_screenshot_file;
 		std::chrono::high_resolution_clock::time_point _last_screenshot_time;
 		unsigned int _screenshot_jpeg_quality = 90;
+		unsigned int _screenshot_png_compression = 1; // 0 = fast, 1 = balanced, 2 = smallest file
+		unsigned int _screenshot_queue_size = 3; // Maximum number of screenshots that are encoded in the background at once, before taking another one waits for them
+		std::unique_ptr<screenshot_queue> _screenshot_queue; // Screenshots that are still being encoded and written on the worker threads
 
 		// === Preset Switching ===
 		bool _preset_save_success = true;
@@ -359,8 +560,14 @@ namespace reshade
 		unsigned int _prev_preset_key_data[4];
 		unsigned int _next_preset_key_data[4];
 		unsigned int _preset_transition_delay = 1000;
+		unsigned int _preset_transition_easing = 0;
 		std::filesystem::path _current_preset_path;
 		std::chrono::high_resolution_clock::time_point _last_preset_switching_time;
+		size_t _effects_version = 1; // Incremented whenever effects are added, removed or replaced
+		std::vector<preset_snapshot> _preset_snapshots;
+		std::filesystem::path _preset_list_path;
+		std::filesystem::file_time_type _preset_list_modified_at;
+		std::vector<std::filesystem::path> _preset_list; // Cached list of preset files in '_preset_list_path'
 
 #if RESHADE_GUI
 		struct editor_instance
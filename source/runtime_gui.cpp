@@ -11,6 +11,7 @@
 #include "dll_resources.hpp"
 #include "runtime.hpp"
 #include "runtime_objects.hpp"
+#include "screenshot_queue.hpp"
 #include "input.hpp"
 #include "imgui_widgets.hpp"
 #include "fonts/forkawesome.inl"
@@ -528,7 +529,7 @@ void reshade::runtime::draw_gui()
 
 	bool show_splash = _show_splash && (is_loading() || !_reload_compile_queue.empty() || (_reload_count <= 1 && (_last_present_time - _last_reload_time) < std::chrono::seconds(5)));
 	// Do not show this message in the same frame the screenshot is taken (so that it won't show up on the UI screenshot)
-	const bool show_screenshot_message = (_show_screenshot_message || !_screenshot_save_success) && !_should_save_screenshot && (_last_present_time - _last_screenshot_time) < std::chrono::seconds(_screenshot_save_success ? 3 : 5);
+	const bool show_screenshot_message = (_show_screenshot_message || !_screenshot_save_success) && !_should_save_screenshot && (_screenshot_queue->num_pending() != 0 || (_last_present_time - _last_screenshot_time) < std::chrono::seconds(_screenshot_save_success ? 3 : 5));
 
 	if (show_screenshot_message || !_preset_save_success || (!_show_overlay && _tutorial_index == 0))
 		show_splash = true;
@@ -612,7 +613,9 @@ void reshade::runtime::draw_gui()
 		}
 		else if (show_screenshot_message)
 		{
-			if (!_screenshot_save_success)
+			if (_screenshot_queue->num_pending() != 0)
+				ImGui::Text("Saving screenshot to %s ...", _last_screenshot_file.u8string().c_str());
+			else if (!_screenshot_save_success)
 				if (std::error_code ec; std::filesystem::exists(_screenshot_path, ec))
 					ImGui::TextColored(COLOR_RED, "Unable to save screenshot because of an internal error (the format may not be supported).");
 				else
@@ -639,11 +642,11 @@ void reshade::runtime::draw_gui()
 
 			if (_reload_remaining_effects != 0 && _reload_remaining_effects != std::numeric_limits<size_t>::max())
 			{
-				ImGui::ProgressBar((_effects.size() - _reload_remaining_effects) / float(_effects.size()), ImVec2(-1, 0), "");
+				ImGui::ProgressBar((_loading_effects.size() - _reload_remaining_effects) / float(_loading_effects.size()), ImVec2(-1, 0), "");
 				ImGui::SameLine(15);
 				ImGui::Text(
 					"Loading (%zu effects remaining) ... "
-					"This might take a while. The application could become unresponsive for some time.",
+					"This might take a while. Effects that were loaded previously keep running in the meantime.",
 					_reload_remaining_effects.load());
 			}
 			else if (!_reload_compile_queue.empty())
@@ -862,9 +865,6 @@ void reshade::runtime::draw_gui()
 			ImGui::End();
 		}
 
-		// The preview texture is unset in 'unload_effects', so should not be able to reach this while loading
-		assert(!is_loading() && _reload_compile_queue.empty());
-
 		// Scale image to fill the entire viewport by default
 		ImVec2 preview_min = ImVec2(0, 0);
 		ImVec2 preview_max = imgui_io.DisplaySize;
@@ -1148,6 +1148,7 @@ void reshade::runtime::draw_gui_home()
 					});
 			}
 
+			_technique_render_list_dirty = true;
 			save_current_preset();
 		}
 
@@ -1326,6 +1327,8 @@ void reshade::runtime::draw_gui_settings()
 		if (ImGui::IsItemHovered())
 			ImGui::SetTooltip("Makes a smooth transition, but only for floating point values.\nRecommended for multiple presets that contain the same effects, otherwise set this to zero.\nValues are in milliseconds.");
 
+		modified |= ImGui::Combo("Preset transition curve", reinterpret_cast<int *>(&_preset_transition_easing), "Linear\0Smooth\0Ease in\0Ease out\0");
+
 		modified |= ImGui::Combo("Input processing", &_input_processing_mode,
 			"Pass on all input\0"
 			"Block input when cursor is on overlay\0"
@@ -1380,6 +1383,8 @@ void reshade::runtime::draw_gui_settings()
 			modified |= ImGui::SliderInt("JPEG quality", reinterpret_cast<int *>(&_screenshot_jpeg_quality), 1, 100);
 		else
 			modified |= ImGui::Checkbox("Clear alpha channel", &_screenshot_clear_alpha);
+		if (_screenshot_format == 1)
+			modified |= ImGui::Combo("PNG compression", reinterpret_cast<int *>(&_screenshot_png_compression), "Fast\0Balanced\0Smallest file\0");
 
 		modified |= ImGui::Checkbox("Save current preset file", &_screenshot_include_preset);
 		modified |= ImGui::Checkbox("Save before and after images", &_screenshot_save_before);
@@ -1691,12 +1696,13 @@ void reshade::runtime::draw_gui_statistics()
 			"unknown",
 			"R8", "R16F", "R32F", "RG8", "RG16", "RG16F", "RG32F", "RGBA8", "RGBA16", "RGBA16F", "RGBA32F", "RGB10A2"
 		};
-		const unsigned int pixel_sizes[] = {
-			0,
-			1 /*R8*/, 2 /*R16F*/, 4 /*R32F*/, 2 /*RG8*/, 4 /*RG16*/, 4 /*RG16F*/, 8 /*RG32F*/, 4 /*RGBA8*/, 8 /*RGBA16*/, 8 /*RGBA16F*/, 16 /*RGBA32F*/, 4 /*RGB10A2*/
+
+		const char *compressed_texture_formats[] = {
+			"BC1", "BC2", "BC3", "BC4", "BC5", "BC6H", "BC7"
 		};
 
 		static_assert(std::size(texture_formats) - 1 == static_cast<size_t>(reshadefx::texture_format::rgb10a2));
+		static_assert(std::size(compressed_texture_formats) - 1 == static_cast<size_t>(reshadefx::texture_format::bc7) - static_cast<size_t>(reshadefx::texture_format::bc1));
 
 		const float total_width = ImGui::GetWindowContentRegionWidth();
 		unsigned int texture_index = 0;
@@ -1718,7 +1724,7 @@ void reshade::runtime::draw_gui_statistics()
 
 			uint32_t memory_size = 0;
 			for (uint32_t level = 0, width = tex.width, height = tex.height; level < tex.levels; ++level, width /= 2, height /= 2)
-				memory_size += width * height * pixel_sizes[static_cast<unsigned int>(tex.format)];
+				memory_size += texture_row_pitch(tex.storage_format(), std::max(width, 1u)) * texture_row_count(tex.storage_format(), std::max(height, 1u));
 
 			post_processing_memory_size += memory_size;
 
@@ -1737,7 +1743,9 @@ void reshade::runtime::draw_gui_statistics()
 				tex.width,
 				tex.height,
 				tex.levels - 1,
-				texture_formats[static_cast<unsigned int>(tex.format)],
+				tex.compressed_format != reshadefx::texture_format::unknown ?
+					compressed_texture_formats[static_cast<unsigned int>(tex.compressed_format) - static_cast<unsigned int>(reshadefx::texture_format::bc1)] :
+					texture_formats[static_cast<unsigned int>(tex.format)],
 				memory_view.quot, memory_view.rem, memory_size_unit);
 
 			size_t num_referenced_passes = 0;
@@ -2460,7 +2468,13 @@ void reshade::runtime::draw_variable_editor()
 			{
 				if (variable.supports_toggle_key() &&
 					widgets::key_input_box("##toggle_key", variable.toggle_key_data, *_input))
+				{
 					modified = true;
+					update_toggle_key_uniforms(_effects[variable.effect_index]);
+					// Toggle keys only work on actual uniform variables, so compile the effect again if this one was turned into a constant
+					if (variable.spec_constant)
+						_effects[variable.effect_index].spec_constant_modified = _effects[variable.effect_index].spec_constant_check = true;
+				}
 
 				const float button_width = ImGui::CalcItemWidth();
 
@@ -2720,6 +2734,7 @@ void reshade::runtime::draw_technique_editor()
 			{
 				_techniques.insert(_techniques.begin(), std::move(_techniques[index]));
 				_techniques.erase(_techniques.begin() + 1 + index);
+				_technique_render_list_dirty = true;
 				save_current_preset();
 				ImGui::CloseCurrentPopup();
 			}
@@ -2727,6 +2742,7 @@ void reshade::runtime::draw_technique_editor()
 			{
 				_techniques.push_back(std::move(_techniques[index]));
 				_techniques.erase(_techniques.begin() + index);
+				_technique_render_list_dirty = true;
 				save_current_preset();
 				ImGui::CloseCurrentPopup();
 			}
@@ -2855,6 +2871,7 @@ void reshade::runtime::draw_technique_editor()
 			}
 
 			_selected_technique = hovered_technique_index;
+			_technique_render_list_dirty = true;
 			save_current_preset();
 			return;
 		}
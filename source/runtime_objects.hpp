@@ -6,6 +6,14 @@
 #pragma once
 
 #include "effect_module.hpp"
+#include <memory>
+#include <cassert>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace reshade
 {
@@ -60,6 +68,130 @@ namespace reshade
 		T _average, _tick_sum, _tick_list[SAMPLES];
 	};
 
+	/// <summary>
+	/// A sorted list of disjoint byte ranges that were modified since the list was last cleared.
+	/// </summary>
+	struct dirty_range_list final
+	{
+		static constexpr size_t max_ranges = 8;
+
+		void add(size_t begin, size_t end)
+		{
+			// Merge with all ranges that overlap or touch the new one, so that the list stays sorted and disjoint
+			auto first = std::lower_bound(ranges.begin(), ranges.end(), begin,
+				[](const std::pair<size_t, size_t> &range, size_t offset) { return range.second < offset; });
+			auto last = first;
+			for (; last != ranges.end() && last->first <= end; ++last)
+			{
+				begin = std::min(begin, last->first);
+				end = std::max(end, last->second);
+			}
+
+			first = ranges.erase(first, last);
+			ranges.insert(first, { begin, end });
+
+			// Every range is uploaded separately, so collapse into a single one once there are too many
+			if (ranges.size() > max_ranges)
+			{
+				ranges.front().second = ranges.back().second;
+				ranges.resize(1);
+			}
+		}
+
+		void clear() { ranges.clear(); }
+		bool empty() const { return ranges.empty(); }
+
+		std::vector<std::pair<size_t, size_t>> ranges;
+	};
+
+	/// <summary>
+	/// Converts uniform values of the specified type to the 32-bit integer or floating-point storage format used in uniform buffers.
+	/// </summary>
+	inline void convert_uniform_values(reshadefx::type::datatype source_type, const void *source, bool to_floating_point, uint32_t *dest, size_t count)
+	{
+		// Each case is a plain loop over contiguous arrays, so that the compiler can vectorize the conversion
+		switch (source_type)
+		{
+		case reshadefx::type::t_bool:
+			if (to_floating_point)
+				for (size_t i = 0; i < count; ++i)
+					reinterpret_cast<float *>(dest)[i] = static_cast<const bool *>(source)[i] ? 1.0f : 0.0f;
+			else
+				for (size_t i = 0; i < count; ++i)
+					dest[i] = static_cast<const bool *>(source)[i] ? 1 : 0;
+			break;
+		case reshadefx::type::t_int:
+			if (to_floating_point)
+				for (size_t i = 0; i < count; ++i)
+					reinterpret_cast<float *>(dest)[i] = static_cast<float>(static_cast<const int32_t *>(source)[i]);
+			else
+				std::memcpy(dest, source, count * sizeof(int32_t));
+			break;
+		case reshadefx::type::t_uint:
+			if (to_floating_point)
+				for (size_t i = 0; i < count; ++i)
+					reinterpret_cast<float *>(dest)[i] = static_cast<float>(static_cast<const uint32_t *>(source)[i]);
+			else
+				std::memcpy(dest, source, count * sizeof(uint32_t));
+			break;
+		case reshadefx::type::t_float:
+			if (to_floating_point)
+				std::memcpy(dest, source, count * sizeof(float));
+			else
+				for (size_t i = 0; i < count; ++i)
+					reinterpret_cast<int32_t *>(dest)[i] = static_cast<int32_t>(static_cast<const float *>(source)[i]);
+			break;
+		default:
+			assert(false);
+			break;
+		}
+	}
+
+	/// <summary>
+	/// Returns the size in bytes of a row of pixels (or of 4x4 blocks in block-compressed formats) in a mipmap level of the specified width, without any padding.
+	/// </summary>
+	inline uint32_t texture_row_pitch(reshadefx::texture_format format, uint32_t width)
+	{
+		switch (format)
+		{
+		case reshadefx::texture_format::r8:
+			return width;
+		case reshadefx::texture_format::r16f:
+		case reshadefx::texture_format::rg8:
+			return width * 2;
+		case reshadefx::texture_format::r32f:
+		case reshadefx::texture_format::rg16:
+		case reshadefx::texture_format::rg16f:
+		case reshadefx::texture_format::rgba8:
+		case reshadefx::texture_format::rgb10a2:
+			return width * 4;
+		case reshadefx::texture_format::rg32f:
+		case reshadefx::texture_format::rgba16:
+		case reshadefx::texture_format::rgba16f:
+			return width * 8;
+		case reshadefx::texture_format::rgba32f:
+			return width * 16;
+		case reshadefx::texture_format::bc1:
+		case reshadefx::texture_format::bc4:
+			return std::max(1u, (width + 3) / 4) * 8;
+		case reshadefx::texture_format::bc2:
+		case reshadefx::texture_format::bc3:
+		case reshadefx::texture_format::bc5:
+		case reshadefx::texture_format::bc6h:
+		case reshadefx::texture_format::bc7:
+			return std::max(1u, (width + 3) / 4) * 16;
+		default:
+			return 0;
+		}
+	}
+	/// <summary>
+	/// Returns the number of rows of pixels (or of 4x4 blocks in block-compressed formats) in a mipmap level of the specified height.
+	/// </summary>
+	inline uint32_t texture_row_count(reshadefx::texture_format format, uint32_t height)
+	{
+		return format >= reshadefx::texture_format::bc1 ? std::max(1u, (height + 3) / 4) : height;
+	}
+
 	struct texture final : reshadefx::texture_info
 	{
 		texture() {} // For standalone textures like the font atlas
@@ -92,10 +224,19 @@ namespace reshade
 			return width == desc.width && height == desc.height && levels == desc.levels && format == desc.format;
 		}
 
+		/// <summary>
+		/// Returns the format the texture data is actually stored in, which differs from the declared one for block-compressed textures.
+		/// </summary>
+		reshadefx::texture_format storage_format() const
+		{
+			return compressed_format != reshadefx::texture_format::unknown ? compressed_format : format;
+		}
+
 		void *impl = nullptr;
 		size_t effect_index = std::numeric_limits<size_t>::max();
 		std::vector<size_t> shared;
 		bool loaded = false;
+		reshadefx::texture_format compressed_format = reshadefx::texture_format::unknown; // Block-compressed format the texture was created with instead of 'format', because its image file is uploaded as is
 	};
 
 	struct uniform final : reshadefx::uniform_info
@@ -137,6 +278,63 @@ namespace reshade
 		size_t effect_index = std::numeric_limits<size_t>::max();
 		special_uniform special = special_uniform::none;
 		uint32_t toggle_key_data[4] = {};
+		bool contiguous = false; // Values are stored without any padding in between, so can be copied in one go
+		bool stored_as_float = false; // Values are stored as floating-point, regardless of the declared type (e.g. in D3D9)
+		bool spec_constant = false; // Value was compiled into the effect as a specialization constant, so changing it requires compiling the effect again
+		std::chrono::high_resolution_clock::time_point last_modified; // Time of the last frame the value was changed in
+	};
+
+	struct uniform_write final
+	{
+		uniform *variable = nullptr;
+		reshadefx::type::datatype type = reshadefx::type::t_float; // Type of the source values, which is one of 't_bool', 't_int', 't_uint' or 't_float'
+		const void *values = nullptr;
+		size_t count = 0;
+		size_t array_index = 0;
+	};
+
+	struct special_uniform_record final
+	{
+		size_t uniform_index = 0; // Index into 'effect.uniforms'
+		special_uniform special = special_uniform::none;
+
+		// Parameters resolved from the annotations of the variable, so that they do not have to be looked up every frame
+		bool toggle = false;
+		bool press = false;
+		int keycode = 0; // Also used as the FreePIE index
+		int min_int = 0, max_int = 0;
+		float min = 0.0f, max = 0.0f, step[2] = {}, smoothing = 0.0f;
+	};
+
+	struct uniform_transition final
+	{
+		size_t uniform_index = 0; // Index into 'effect.uniforms'
+		size_t offset = 0; // Byte offset of the first value in 'effect.uniform_data_storage'
+		size_t count = 0; // Number of consecutive floating-point values that are interpolated
+		size_t value_index = 0; // Index of the first value in 'effect.transition_start_values' and 'effect.transition_end_values'
+	};
+
+	struct texture_image final
+	{
+		size_t texture_index = 0; // Index into 'runtime::_textures'
+		std::string texture_name; // Unique name of the texture, to detect whether it was replaced while the image was loaded
+		uint32_t width = 0, height = 0, levels = 0;
+		reshadefx::texture_format format = reshadefx::texture_format::unknown;
+		reshadefx::texture_format compressed_format = reshadefx::texture_format::unknown; // Block-compressed format of the image data, or unknown if it was decoded to RGBA
+		bool srgb = false; // Whether the texture is sampled with sRGB decoding, in which case mipmap levels are filtered in linear space
+		bool has_levels = false; // Whether the image data holds all mipmap levels in the storage format of the texture, rather than only the first one as 32bpp RGBA
+		std::shared_ptr<const std::vector<uint8_t>> pixels; // Image data with the dimensions above, or empty if loading failed
+	};
+
+	struct texture_cache_entry final
+	{
+		std::filesystem::path path; // Image file the data was decoded from
+		std::filesystem::file_time_type modified_at;
+		uintmax_t file_size = 0;
+		uint32_t width = 0, height = 0, levels = 0; // Dimensions the image data was resized to
+		reshadefx::texture_format compressed_format = reshadefx::texture_format::unknown;
+		uint64_t last_used = 0; // Value of 'runtime::_texture_cache_tick' when this entry was last accessed
+		std::shared_ptr<const std::vector<uint8_t>> pixels;
 	};
 
 	struct technique final : reshadefx::technique_info
@@ -167,6 +365,7 @@ namespace reshade
 
 		void *impl = nullptr;
 		size_t effect_index = std::numeric_limits<size_t>::max();
+		size_t module_index = 0; // Index into 'effect.module.techniques'
 		bool hidden = false;
 		bool enabled = false;
 		int64_t time_left = 0;
@@ -175,8 +374,38 @@ namespace reshade
 		moving_average<uint64_t, 60> average_gpu_duration;
 	};
 
+	struct preset_snapshot final
+	{
+		struct uniform_value
+		{
+			size_t uniform_index = 0; // Index into 'effect.uniforms'
+			bool has_toggle_key = false;
+			reshadefx::constant values = {}; // Values in the base type of the variable, which are the default values if the preset does not contain any
+			uint32_t toggle_key_data[4] = {};
+		};
+		struct technique_state
+		{
+			bool enabled = false;
+			size_t position = 0; // Position in the technique sorting of the preset
+			uint32_t toggle_key_data[4] = {};
+		};
+		struct effect_state
+		{
+			std::vector<uniform_value> uniforms;
+			std::vector<technique_state> techniques; // Indexed like 'effect.module.techniques'
+		};
+
+		std::filesystem::path path;
+		std::filesystem::file_time_type modified_at;
+		size_t effects_version = 0; // Value of 'runtime::_effects_version' when this snapshot was built, since it references variables and techniques by index
+		std::vector<std::string> technique_list;
+		std::vector<std::string> preprocessor_definitions;
+		std::vector<effect_state> effects; // Indexed like 'runtime::_effects'
+	};
+
 	struct effect final
 	{
+		void *impl = nullptr;
 		unsigned int rendering = 0;
 		bool skipped = false;
 		bool compiled = false;
@@ -189,7 +418,116 @@ namespace reshade
 		std::vector<std::filesystem::path> included_files;
 		std::vector<std::pair<std::string, std::string>> definitions;
 		std::unordered_map<std::string, std::string> assembly;
+		std::vector<std::vector<char>> bytecode; // Compiled byte code for each entry in 'module.entry_points'
 		std::vector<uniform> uniforms;
+		std::vector<special_uniform_record> special_uniforms;
+		std::vector<size_t> toggle_key_uniforms; // Indices into 'uniforms' of variables that have a toggle key assigned, which are the only ones polled for key presses every frame
+		std::unordered_map<std::string, reshadefx::texture_format> compressed_texture_formats; // Block-compressed formats of the DDS image files of textures that can be uploaded as is, found while loading the effect
+		std::unordered_set<std::string> spec_constant_uniforms; // Names of uniform variables that are compiled as specialization constants
+		bool spec_constant_modified = false; // A variable that is compiled as specialization constant changed, so the effect has to be compiled again right away
+		bool spec_constant_check = false; // A variable that is or may become a specialization constant changed, so the effect has to be checked again once no changes happened for a while
+		std::chrono::high_resolution_clock::time_point spec_constant_check_time; // Time of the last change that set 'spec_constant_check'
 		std::vector<unsigned char> uniform_data_storage;
+		dirty_range_list uniform_data_dirty; // Parts of 'uniform_data_storage' that changed since the last upload to the GPU
+		std::vector<uniform_transition> transitions; // Floating-point values that are interpolated during a transition between presets
+		std::vector<float> transition_start_values;
+		std::vector<float> transition_end_values;
 	};
+
+	struct staged_effect final
+	{
+		size_t effect_index = 0; // Index into 'runtime::_effects'
+		bool replace = false; // Whether this creates 'replacement' next to the current effect, rather than the remaining techniques of the current effect
+		effect replacement; // Swapped in for the current effect once all its techniques were created
+		std::vector<texture> textures; // Textures the replacement cannot share with the current effect, which are added to 'runtime::_textures' when it is swapped in
+		std::vector<technique> techniques; // Copies of the techniques that are created, which are handed over to those in 'runtime::_techniques' once all their passes were created
+		size_t technique_index = 0; // Index into 'techniques' of the technique that is created in the next step
+		size_t pass_index = 0; // Index of the pass of that technique that is created in the next step
+	};
+
+	/// <summary>
+	/// Copies values that are already in the storage format of a variable into the uniform storage of its effect, following the padding rules for matrices and arrays.
+	/// </summary>
+	/// <returns><c>true</c> if the storage was modified, <c>false</c> if the values did not change.</returns>
+	inline bool write_uniform_data(effect &effect, const uniform &variable, const uint8_t *data, size_t size, size_t base_index)
+	{
+		size = std::min(size, static_cast<size_t>(variable.size));
+		assert(data != nullptr && (size % 4) == 0);
+
+		auto &data_storage = effect.uniform_data_storage;
+		assert(variable.offset + size <= data_storage.size());
+
+		const size_t array_length = (variable.type.is_array() ? variable.type.array_length : 1);
+		assert(base_index < array_length);
+
+		if (variable.type.is_matrix())
+		{
+			for (size_t a = base_index, i = 0; a < array_length; ++a)
+				// Each row of a matrix is 16-byte aligned, so needs special handling
+				for (size_t row = 0; row < variable.type.rows; ++row)
+					for (size_t col = 0; i < (size / 4) && col < variable.type.cols; ++col, ++i)
+						std::memcpy(
+							data_storage.data() + variable.offset + (a * variable.type.rows * 4 + (row * 4 + col)) * 4,
+							data + ((a - base_index) * variable.type.components() + (row * variable.type.cols + col)) * 4, 4);
+		}
+		else if (array_length > 1)
+		{
+			for (size_t a = base_index, i = 0; a < array_length; ++a)
+				// Each element in the array is 16-byte aligned, so needs special handling
+				for (size_t row = 0; i < (size / 4) && row < variable.type.rows; ++row, ++i)
+					std::memcpy(
+						data_storage.data() + variable.offset + (a * 4 + row) * 4,
+						data + ((a - base_index) * variable.type.components() + row) * 4, 4);
+		}
+		else
+		{
+			// Most variables are set to the same value every frame, so avoid marking them as modified in that case
+			if (std::memcmp(data_storage.data() + variable.offset, data, size) == 0)
+				return false;
+
+			std::memcpy(data_storage.data() + variable.offset, data, size);
+		}
+
+		effect.uniform_data_dirty.add(variable.offset, variable.offset + variable.size);
+		return true;
+	}
+
+	/// <summary>
+	/// Converts the values of a write to the storage format of its variable and copies them into the uniform storage of the effect.
+	/// </summary>
+	/// <returns><c>true</c> if the storage was modified, <c>false</c> if the values did not change.</returns>
+	inline bool write_uniform_values(effect &effect, const uniform_write &write)
+	{
+		assert(write.variable != nullptr && write.values != nullptr);
+		const uniform &variable = *write.variable;
+
+		uint32_t stack_data[16];
+		std::vector<uint32_t> heap_data;
+
+		const size_t count = std::min(write.count, static_cast<size_t>(variable.size / 4));
+		uint32_t *data = stack_data;
+		if (count > std::size(stack_data))
+		{
+			heap_data.resize(count);
+			data = heap_data.data();
+		}
+
+		// Convert all values to the storage type at once
+		convert_uniform_values(write.type, write.values, variable.stored_as_float, data, count);
+
+		if (!variable.contiguous)
+			return write_uniform_data(effect, variable, reinterpret_cast<const uint8_t *>(data), count * 4, write.array_index);
+
+		// Array elements are 16 bytes in size here, so the offset of an element is easy to compute
+		const size_t offset = variable.offset + write.array_index * 16;
+		assert(offset <= variable.offset + variable.size);
+		const size_t size = std::min(count * 4, variable.offset + variable.size - offset);
+
+		if (std::memcmp(effect.uniform_data_storage.data() + offset, data, size) == 0)
+			return false;
+
+		std::memcpy(effect.uniform_data_storage.data() + offset, data, size);
+		effect.uniform_data_dirty.add(offset, offset + size);
+		return true;
+	}
 }
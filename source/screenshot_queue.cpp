@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "screenshot_queue.hpp"
+#include "task_scheduler.hpp"
+#include <memory>
+#include <cassert>
+#include <utility>
+#include <algorithm>
+
+reshade::screenshot_queue::~screenshot_queue()
+{
+	// Tasks still reference this queue, so cannot go away before all of them finished
+	finish_all();
+}
+
+std::vector<uint8_t> reshade::screenshot_queue::acquire_buffer(size_t size, unsigned int max_pending)
+{
+	_max_buffers = std::max(max_pending, 1u);
+
+	while (_num_pending >= _max_buffers)
+		collect(true);
+
+	std::vector<uint8_t> buffer;
+	if (!_buffers.empty())
+	{
+		buffer = std::move(_buffers.back());
+		_buffers.pop_back();
+	}
+
+	buffer.resize(size);
+	return buffer;
+}
+void reshade::screenshot_queue::release_buffer(std::vector<uint8_t> &&buffer)
+{
+	if (_buffers.size() < _max_buffers)
+		_buffers.push_back(std::move(buffer));
+}
+
+void reshade::screenshot_queue::submit_png(std::filesystem::path path, std::vector<uint8_t> &&pixels, uint32_t width, uint32_t height, bool include_alpha, image::png_compression level, std::function<bool(const std::filesystem::path &path, const image::png_encoder &encoder)> write)
+{
+	assert(pixels.size() >= size_t(width) * height * 4);
+
+	_num_pending++;
+
+	// Filter and compress strips of the image in parallel and write the file once all of them are done
+	const auto data = std::make_shared<std::vector<uint8_t>>(std::move(pixels));
+	const auto encoder = std::make_shared<image::png_encoder>(data->data(), width, height, include_alpha, level);
+
+	std::vector<std::function<void()>> tasks;
+	tasks.reserve(encoder->num_strips());
+	for (size_t i = 0; i < encoder->num_strips(); ++i)
+		tasks.push_back([encoder, i]() { encoder->encode_strip(i); });
+
+	_worker_pool.submit(std::move(tasks), [this, data, encoder, path = std::move(path), write = std::move(write)]() mutable {
+		const bool success = write(path, *encoder);
+
+		complete(std::move(path), std::move(*data), success);
+	});
+}
+void reshade::screenshot_queue::submit(std::filesystem::path path, std::vector<uint8_t> &&pixels, std::function<bool(const std::filesystem::path &path, std::vector<uint8_t> &pixels)> write)
+{
+	_num_pending++;
+
+	_worker_pool.submit([this, pixels = std::move(pixels), path = std::move(path), write = std::move(write)]() mutable {
+		const bool success = write(path, pixels);
+
+		complete(std::move(path), std::move(pixels), success);
+	});
+}
+
+std::vector<reshade::screenshot_queue::result> reshade::screenshot_queue::finish(bool wait)
+{
+	collect(wait && _results.empty() && _num_pending != 0);
+
+	return std::exchange(_results, {});
+}
+std::vector<reshade::screenshot_queue::result> reshade::screenshot_queue::finish_all()
+{
+	while (_num_pending != 0)
+		collect(true);
+
+	return std::exchange(_results, {});
+}
+
+void reshade::screenshot_queue::collect(bool wait)
+{
+	std::vector<std::pair<result, std::vector<uint8_t>>> finished;
+
+	{	std::unique_lock<std::mutex> lock(_mutex);
+		if (wait)
+			_finished_condition.wait(lock, [this]() { return !_finished.empty(); });
+		finished.swap(_finished);
+	}
+
+	assert(finished.size() <= _num_pending);
+	_num_pending -= finished.size();
+
+	for (auto &[result, buffer] : finished)
+	{
+		_results.push_back(std::move(result));
+
+		// Keep buffers around for reuse, but not more than could be in flight at once
+		release_buffer(std::move(buffer));
+	}
+}
+void reshade::screenshot_queue::complete(std::filesystem::path &&path, std::vector<uint8_t> &&buffer, bool success)
+{
+	{	const std::lock_guard<std::mutex> lock(_mutex);
+		_finished.push_back({ { std::move(path), success }, std::move(buffer) });
+	}
+
+	_finished_condition.notify_one();
+}
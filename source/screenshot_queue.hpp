@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "png_encoder.hpp"
+#include <mutex>
+#include <vector>
+#include <filesystem>
+#include <functional>
+#include <condition_variable>
+
+namespace reshade
+{
+	class task_scheduler;
+
+	/// <summary>
+	/// Screenshots that are encoded and written to disk on worker threads, so that the render thread does not stall for the duration.
+	/// Only a limited number of them can be in flight at once, so that holding down the screenshot key cannot pile up captured frames in memory, and their capture buffers are reused.
+	/// </summary>
+	class screenshot_queue
+	{
+	public:
+		struct result
+		{
+			std::filesystem::path path; // Image file the screenshot was written to
+			bool success = false;
+		};
+
+		/// <summary>
+		/// Create a new screenshot queue.
+		/// </summary>
+		/// <param name="worker_pool">The pool of worker threads to encode and write screenshots on, which has to outlive this queue.</param>
+		explicit screenshot_queue(task_scheduler &worker_pool) : _worker_pool(worker_pool) {}
+		~screenshot_queue();
+
+		/// <summary>
+		/// Return the number of screenshots that were submitted, but whose results were not yet collected in <see cref="finish"/>.
+		/// </summary>
+		size_t num_pending() const { return _num_pending; }
+
+		/// <summary>
+		/// Get a buffer to capture the next screenshot into, which reuses the allocation of an earlier screenshot if possible.
+		/// Waits for earlier screenshots to finish first if too many of them are still in flight.
+		/// </summary>
+		/// <param name="size">The size of the buffer in bytes.</param>
+		/// <param name="max_pending">The maximum number of screenshots that may be in flight at once, which is also the number of buffers that are kept for reuse.</param>
+		std::vector<uint8_t> acquire_buffer(size_t size, unsigned int max_pending);
+		/// <summary>
+		/// Give back a buffer that was not submitted (e.g. because capturing into it failed), so that it can be reused.
+		/// </summary>
+		void release_buffer(std::vector<uint8_t> &&buffer);
+
+		/// <summary>
+		/// Encode a PNG image in strips on the worker threads and write it once all of them are done.
+		/// </summary>
+		/// <param name="path">The path of the image file, which is passed on to the write callback.</param>
+		/// <param name="pixels">The 32bpp RGBA image data, which was captured into a buffer from <see cref="acquire_buffer"/>.</param>
+		/// <param name="width">The width of the image.</param>
+		/// <param name="height">The height of the image.</param>
+		/// <param name="include_alpha">Set to <c>false</c> to drop the alpha channel and write a RGB image instead.</param>
+		/// <param name="level">The compression level to use.</param>
+		/// <param name="write">The function that is called on a worker thread with the fully encoded image and returns whether writing it succeeded.</param>
+		void submit_png(std::filesystem::path path, std::vector<uint8_t> &&pixels, uint32_t width, uint32_t height, bool include_alpha, image::png_compression level,
+			std::function<bool(const std::filesystem::path &path, const image::png_encoder &encoder)> write);
+		/// <summary>
+		/// Encode and write an image in a single task on a worker thread.
+		/// </summary>
+		/// <param name="path">The path of the image file, which is passed on to the write callback.</param>
+		/// <param name="pixels">The 32bpp RGBA image data, which was captured into a buffer from <see cref="acquire_buffer"/>.</param>
+		/// <param name="write">The function that is called on a worker thread to encode and write the image and returns whether that succeeded.</param>
+		void submit(std::filesystem::path path, std::vector<uint8_t> &&pixels,
+			std::function<bool(const std::filesystem::path &path, std::vector<uint8_t> &pixels)> write);
+
+		/// <summary>
+		/// Collect the results of all screenshots that finished since the last call.
+		/// </summary>
+		/// <param name="wait">Set to <c>true</c> to block until at least one screenshot finished, if none did yet and any are still in flight.</param>
+		std::vector<result> finish(bool wait = false);
+		/// <summary>
+		/// Block until all screenshots that are still in flight finished and collect their results.
+		/// </summary>
+		std::vector<result> finish_all();
+
+	private:
+		void collect(bool wait);
+		void complete(std::filesystem::path &&path, std::vector<uint8_t> &&buffer, bool success);
+
+		task_scheduler &_worker_pool;
+		size_t _num_pending = 0;
+		unsigned int _max_buffers = 1;
+		std::vector<std::vector<uint8_t>> _buffers; // Capture buffers of finished screenshots, kept for reuse
+		std::vector<result> _results; // Results that were collected while waiting for a buffer, but not yet returned from 'finish'
+		std::mutex _mutex;
+		std::condition_variable _finished_condition;
+		std::vector<std::pair<result, std::vector<uint8_t>>> _finished; // Protected by '_mutex'
+	};
+}
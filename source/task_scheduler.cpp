@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "task_scheduler.hpp"
+#include <cassert>
+#include <algorithm>
+
+// Keep track of the pool and queue the current thread belongs to, so that tasks spawned from within a task are queued locally
+static thread_local const reshade::task_scheduler *s_current_scheduler = nullptr;
+static thread_local size_t s_current_worker_index = 0;
+
+reshade::task_scheduler::task_scheduler(size_t num_threads)
+{
+	// Leave one core for the render thread
+	if (num_threads == 0)
+		num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 2u) - 1;
+
+	_num_threads = num_threads;
+	_queues.reset(new worker_queue[num_threads]);
+
+	_threads.reserve(num_threads);
+	for (size_t i = 0; i < num_threads; ++i)
+		_threads.emplace_back(&task_scheduler::worker_main, this, i);
+}
+reshade::task_scheduler::~task_scheduler()
+{
+	{	const std::lock_guard<std::mutex> lock(_wait_mutex);
+		_exit = true;
+	}
+
+	_work_available.notify_all();
+
+	for (std::thread &thread : _threads)
+		thread.join();
+}
+
+void reshade::task_scheduler::submit(std::function<void()> task)
+{
+	assert(task != nullptr);
+
+	// Spread tasks submitted from outside the pool evenly, workers then balance the rest by stealing
+	const size_t queue_index = s_current_scheduler == this ? s_current_worker_index : _next_queue++ % _num_threads;
+
+	_pending_tasks++;
+
+	{	const std::lock_guard<std::mutex> lock(_queues[queue_index].mutex);
+		_queues[queue_index].tasks.push_back(std::move(task));
+	}
+
+	{	const std::lock_guard<std::mutex> lock(_wait_mutex);
+		_queued_tasks++;
+	}
+
+	_work_available.notify_one();
+}
+void reshade::task_scheduler::submit(std::vector<std::function<void()>> tasks, std::function<void()> continuation)
+{
+	if (tasks.empty())
+	{
+		submit(std::move(continuation));
+		return;
+	}
+
+	// The last task to finish queues the continuation
+	const auto remaining = std::make_shared<std::atomic<size_t>>(tasks.size());
+	const auto shared_continuation = std::make_shared<std::function<void()>>(std::move(continuation));
+
+	for (std::function<void()> &task : tasks)
+	{
+		submit([this, task = std::move(task), remaining, shared_continuation]() {
+			task();
+			if (--(*remaining) == 0)
+				submit(std::move(*shared_continuation));
+		});
+	}
+}
+
+void reshade::task_scheduler::wait_idle()
+{
+	assert(s_current_scheduler != this);
+
+	std::unique_lock<std::mutex> lock(_wait_mutex);
+	_work_finished.wait(lock, [this]() { return _pending_tasks == 0; });
+}
+
+void reshade::task_scheduler::worker_main(size_t worker_index)
+{
+	s_current_scheduler = this;
+	s_current_worker_index = worker_index;
+
+	while (true)
+	{
+		if (std::function<void()> task; pop_task(worker_index, task))
+		{
+			task();
+
+			if (--_pending_tasks == 0)
+			{
+				// Acquire lock before notifying, so that a thread in 'wait_idle' cannot miss the update between checking the condition and going to sleep
+				{ const std::lock_guard<std::mutex> lock(_wait_mutex); }
+				_work_finished.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_wait_mutex);
+		_work_available.wait(lock, [this]() { return _exit || _queued_tasks != 0; });
+		if (_exit)
+			break;
+	}
+}
+
+bool reshade::task_scheduler::pop_task(size_t worker_index, std::function<void()> &task)
+{
+	// Take most recently added work from own queue first, since it is most likely to still be in cache
+	{	worker_queue &queue = _queues[worker_index];
+		const std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			_queued_tasks--;
+			return true;
+		}
+	}
+
+	// Otherwise steal the oldest work from the other workers
+	for (size_t i = 1; i < _num_threads; ++i)
+	{
+		worker_queue &queue = _queues[(worker_index + i) % _num_threads];
+		const std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			_queued_tasks--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void reshade::task_group::add(size_t count)
+{
+	_num_pending += count;
+}
+void reshade::task_group::done()
+{
+	// Hold the lock while notifying, so that 'wait' cannot miss the last task finishing between checking the count and starting to wait
+	const std::lock_guard<std::mutex> lock(_mutex);
+
+	assert(_num_pending != 0);
+	if (--_num_pending == 0)
+		_finished.notify_all();
+}
+
+void reshade::task_group::wait()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_finished.wait(lock, [this]() { return _num_pending == 0; });
+}
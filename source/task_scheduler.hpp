@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace reshade
+{
+	/// <summary>
+	/// A pool of worker threads that execute queued tasks.
+	/// Every worker has its own task queue and steals work from the others once it runs dry, so that a single long-running task does not hold back any others.
+	/// </summary>
+	class task_scheduler
+	{
+	public:
+		/// <summary>
+		/// Create a new pool of worker threads.
+		/// </summary>
+		/// <param name="num_threads">The number of worker threads to spawn, or zero to choose one based on the number of available cores.</param>
+		explicit task_scheduler(size_t num_threads = 0);
+		~task_scheduler();
+
+		/// <summary>
+		/// Return the number of worker threads in this pool.
+		/// </summary>
+		size_t num_threads() const { return _num_threads; }
+
+		/// <summary>
+		/// Queue a task for execution on any of the worker threads.
+		/// When called from a worker thread, the task is added to the queue of that worker, so that dependent work stays local unless another worker is idle.
+		/// </summary>
+		/// <param name="task">The function to execute.</param>
+		void submit(std::function<void()> task);
+		/// <summary>
+		/// Queue a group of independent tasks and another one that is executed after all of them finished.
+		/// </summary>
+		/// <param name="tasks">The functions to execute in parallel.</param>
+		/// <param name="continuation">The function to execute after all tasks completed.</param>
+		void submit(std::vector<std::function<void()>> tasks, std::function<void()> continuation);
+
+		/// <summary>
+		/// Block the calling thread until all queued tasks (including those queued while waiting) have finished.
+		/// This must not be called from a worker thread of this pool.
+		/// </summary>
+		void wait_idle();
+
+	private:
+		struct worker_queue
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		void worker_main(size_t worker_index);
+		bool pop_task(size_t worker_index, std::function<void()> &task);
+
+		bool _exit = false;
+		size_t _num_threads = 0;
+		std::vector<std::thread> _threads;
+		std::unique_ptr<worker_queue[]> _queues;
+		std::atomic<size_t> _next_queue = 0;
+		std::atomic<size_t> _queued_tasks = 0;
+		std::atomic<size_t> _pending_tasks = 0;
+		std::mutex _wait_mutex;
+		std::condition_variable _work_available;
+		std::condition_variable _work_finished;
+	};
+
+	/// <summary>
+	/// Keeps track of a group of related tasks, so that they can be waited for without also waiting for all other work queued on the pool.
+	/// Every task has to be added to the group before it is submitted and marked as done as the very last thing it does, which for a chain of tasks is the end of the last one.
+	/// </summary>
+	class task_group
+	{
+	public:
+		/// <summary>
+		/// Return the number of tasks in this group that did not finish yet.
+		/// </summary>
+		size_t num_pending() const { return _num_pending; }
+
+		/// <summary>
+		/// Add tasks to this group, before submitting them.
+		/// </summary>
+		void add(size_t count = 1);
+		/// <summary>
+		/// Mark a task of this group as finished, after which it must no longer access anything the waiting thread may destroy.
+		/// </summary>
+		void done();
+
+		/// <summary>
+		/// Block the calling thread until all tasks of this group have finished.
+		/// This must not be called from a task of this group.
+		/// </summary>
+		void wait();
+
+	private:
+		std::atomic<size_t> _num_pending = 0;
+		std::mutex _mutex;
+		std::condition_variable _finished;
+	};
+}
@@ -48,9 +48,13 @@ namespace reshade::vulkan
 		VkBuffer ubo = VK_NULL_HANDLE;
 		VmaAllocation ubo_mem = VK_NULL_HANDLE;
 		VkDescriptorSet ubo_set = VK_NULL_HANDLE;
+		std::vector<VkDescriptorImageInfo> sampler_bindings;
+		std::vector<VkDescriptorImageInfo> storage_bindings;
+		std::vector<uint8_t> spec_data;
+		std::vector<VkSpecializationMapEntry> spec_constants;
+		std::unordered_map<std::string, VkShaderModule> entry_points; // Shader modules, which are created when the first pass using them is initialized
 #if RESHADE_DEPTH
 		std::unordered_map<uint32_t, std::vector<VkDescriptorSet>> depth_image_bindings;
-		std::vector<VkDescriptorImageInfo> image_bindings;
 #endif
 	};
 
@@ -128,6 +132,29 @@ namespace reshade::vulkan
 
 		vk.CmdPipelineBarrier(cmd_list, layout_to_stage(old_layout), layout_to_stage(new_layout), 0, 0, nullptr, 0, nullptr, 1, &transition);
 	}
+
+	VkFormat convert_compressed_format(reshadefx::texture_format format, bool srgb = false)
+	{
+		switch (format)
+		{
+		case reshadefx::texture_format::bc1:
+			return srgb ? VK_FORMAT_BC1_RGBA_SRGB_BLOCK : VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		case reshadefx::texture_format::bc2:
+			return srgb ? VK_FORMAT_BC2_SRGB_BLOCK : VK_FORMAT_BC2_UNORM_BLOCK;
+		case reshadefx::texture_format::bc3:
+			return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+		case reshadefx::texture_format::bc4:
+			return srgb ? VK_FORMAT_UNDEFINED : VK_FORMAT_BC4_UNORM_BLOCK;
+		case reshadefx::texture_format::bc5:
+			return srgb ? VK_FORMAT_UNDEFINED : VK_FORMAT_BC5_UNORM_BLOCK;
+		case reshadefx::texture_format::bc6h:
+			return srgb ? VK_FORMAT_UNDEFINED : VK_FORMAT_BC6H_UFLOAT_BLOCK;
+		case reshadefx::texture_format::bc7:
+			return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+		default:
+			return VK_FORMAT_UNDEFINED;
+		}
+	}
 }
 
 reshade::vulkan::runtime_vk::runtime_vk(VkDevice device, VkPhysicalDevice physical_device, uint32_t queue_family_index, const VkLayerInstanceDispatchTable &instance_table, const VkLayerDispatchTable &device_table, state_tracking_context *state_tracking) :
@@ -170,6 +197,24 @@ reshade::vulkan::runtime_vk::runtime_vk(VkDevice device, VkPhysicalDevice physic
 		}
 	}
 
+	// Find out which block-compressed formats can be sampled from (those are only available if the device supports and had enabled the feature, see 'vkCreateDevice')
+	VkPhysicalDeviceFeatures features = {};
+	instance_table.GetPhysicalDeviceFeatures(physical_device, &features);
+
+	if (features.textureCompressionBC)
+	{
+		for (const reshadefx::texture_format format : {
+				reshadefx::texture_format::bc1, reshadefx::texture_format::bc2, reshadefx::texture_format::bc3, reshadefx::texture_format::bc4,
+				reshadefx::texture_format::bc5, reshadefx::texture_format::bc6h, reshadefx::texture_format::bc7 })
+		{
+			VkFormatProperties format_props = {};
+			instance_table.GetPhysicalDeviceFormatProperties(physical_device, convert_compressed_format(format), &format_props);
+
+			if ((format_props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0)
+				_supported_compressed_formats |= 1u << static_cast<uint32_t>(format);
+		}
+	}
+
 	// Get the main graphics queue for command submission
 	// There has to be at least one queue, or else this runtime would not have been created with this queue family index
 	// So it should be safe to just get the first one
@@ -428,7 +473,8 @@ bool reshade::vulkan::runtime_vk::on_init(VkSwapchainKHR swapchain, const VkSwap
 		};
 
 		VkDescriptorPoolCreateInfo create_info { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
-		// No VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT set, so that all descriptors can be reset in one go via vkResetDescriptorPool
+		// Descriptor sets are allocated with every pass and freed again when the technique is destroyed, so that effects can be replaced one at a time
+		create_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 		create_info.maxSets = MAX_EFFECT_DESCRIPTOR_SETS;
 		create_info.poolSizeCount = static_cast<uint32_t>(std::size(pool_sizes));
 		create_info.pPoolSizes = pool_sizes;
@@ -756,134 +802,96 @@ bool reshade::vulkan::runtime_vk::capture_screenshot(uint8_t *buffer) const
 	return mapped_data != nullptr;
 }
 
-bool reshade::vulkan::runtime_vk::init_effect(size_t index)
+bool reshade::vulkan::runtime_vk::compile_entry_point(const effect &effect, const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &, std::string &) const
 {
-	effect &effect = _effects[index];
-
-	// Load shader modules
-	struct shader_modules
+	// There are various issues with SPIR-V modules that have multiple entry points on all major GPU vendors.
+	// On AMD for instance creating a graphics pipeline just fails with a generic VK_ERROR_OUT_OF_HOST_MEMORY. On NVIDIA artifacts occur on some driver versions.
+	// To work around these problems, create a separate shader module for every entry point and rewrite the SPIR-V module for each to removes all but a single entry point (and associated functions/variables).
+	uint32_t current_function = 0, current_function_offset = 0;
+	std::vector<uint32_t> spirv = effect.module.spirv;
+	std::vector<uint32_t> functions_to_remove, variables_to_remove;
+
+	for (uint32_t inst = 5 /* Skip SPIR-V header information */; inst < spirv.size();)
 	{
-		bool loaded = false;
-		runtime_vk *const runtime;
-		std::vector<VkShaderModule> list;
-		std::unordered_map<std::string, VkShaderModule> entry_points;
+		const uint32_t op = spirv[inst] & 0xFFFF;
+		const uint32_t len = (spirv[inst] >> 16) & 0xFFFF;
+		assert(len != 0);
 
-		shader_modules(runtime_vk *runtime, const reshadefx::module &effect_module) : runtime(runtime)
+		switch (op)
 		{
-			VkResult res = VK_SUCCESS;
-
-			// There are various issues with SPIR-V modules that have multiple entry points on all major GPU vendors.
-			// On AMD for instance creating a graphics pipeline just fails with a generic VK_ERROR_OUT_OF_HOST_MEMORY. On NVIDIA artifacts occur on some driver versions.
-			// To work around these problems, create a separate shader module for every entry point and rewrite the SPIR-V module for each to removes all but a single entry point (and associated functions/variables).
-			for (size_t i = 0; i < effect_module.entry_points.size() && res == VK_SUCCESS; ++i)
+		case 15: // OpEntryPoint
+			// Look for any non-matching entry points
+			if (entry_point.name != reinterpret_cast<const char *>(&spirv[inst + 3]))
 			{
-				const reshadefx::entry_point &entry_point = effect_module.entry_points[i];
+				functions_to_remove.push_back(spirv[inst + 2]);
 
-				uint32_t current_function = 0, current_function_offset = 0;
-				std::vector<uint32_t> spirv = effect_module.spirv;
-				std::vector<uint32_t> functions_to_remove, variables_to_remove;
+				// Get interface variables
+				for (size_t k = inst + 3 + ((strlen(reinterpret_cast<const char *>(&spirv[inst + 3])) + 4) / 4); k < inst + len; ++k)
+					variables_to_remove.push_back(spirv[k]);
 
-				for (uint32_t inst = 5 /* Skip SPIR-V header information */; inst < spirv.size();)
-				{
-					const uint32_t op = spirv[inst] & 0xFFFF;
-					const uint32_t len = (spirv[inst] >> 16) & 0xFFFF;
-					assert(len != 0);
-
-					switch (op)
-					{
-					case 15: // OpEntryPoint
-						// Look for any non-matching entry points
-						if (entry_point.name != reinterpret_cast<const char *>(&spirv[inst + 3]))
-						{
-							functions_to_remove.push_back(spirv[inst + 2]);
-
-							// Get interface variables
-							for (size_t k = inst + 3 + ((strlen(reinterpret_cast<const char *>(&spirv[inst + 3])) + 4) / 4); k < inst + len; ++k)
-								variables_to_remove.push_back(spirv[k]);
-
-							// Remove this entry point from the module
-							spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
-							continue;
-						}
-						break;
-					case 16: // OpExecutionMode
-						if (std::find(functions_to_remove.begin(), functions_to_remove.end(), spirv[inst + 1]) != functions_to_remove.end())
-						{
-							spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
-							continue;
-						}
-						break;
-					case 59: // OpVariable
-						// Remove all declarations of the interface variables for non-matching entry points
-						if (std::find(variables_to_remove.begin(), variables_to_remove.end(), spirv[inst + 2]) != variables_to_remove.end())
-						{
-							spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
-							continue;
-						}
-						break;
-					case 71: // OpDecorate
-						// Remove all decorations targeting any of the interface variables for non-matching entry points
-						if (std::find(variables_to_remove.begin(), variables_to_remove.end(), spirv[inst + 1]) != variables_to_remove.end())
-						{
-							spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
-							continue;
-						}
-						break;
-					case 54: // OpFunction
-						current_function = spirv[inst + 2];
-						current_function_offset = inst;
-						break;
-					case 56: // OpFunctionEnd
-						// Remove all function definitions for non-matching entry points
-						if (std::find(functions_to_remove.begin(), functions_to_remove.end(), current_function) != functions_to_remove.end())
-						{
-							spirv.erase(spirv.begin() + current_function_offset, spirv.begin() + inst + len);
-							inst = current_function_offset;
-							continue;
-						}
-						break;
-					}
-
-					inst += len;
-				}
-
-				VkShaderModuleCreateInfo create_info { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
-				create_info.codeSize = spirv.size() * sizeof(uint32_t);
-				create_info.pCode = spirv.data();
-
-				res = runtime->vk.CreateShaderModule(runtime->_device, &create_info, nullptr, &list.emplace_back());
-
-				entry_points[entry_point.name] = list.back();
+				// Remove this entry point from the module
+				spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
+				continue;
 			}
-
-			if (res != VK_SUCCESS)
+			break;
+		case 16: // OpExecutionMode
+			if (std::find(functions_to_remove.begin(), functions_to_remove.end(), spirv[inst + 1]) != functions_to_remove.end())
 			{
-				LOG(ERROR) << "Failed to create shader module! Vulkan error code is " << res << '.';
-				return;
+				spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
+				continue;
 			}
-
-			loaded = true;
-		}
-		~shader_modules()
-		{
-			for (const VkShaderModule module : list)
-				runtime->vk.DestroyShaderModule(runtime->_device, module, nullptr);
+			break;
+		case 59: // OpVariable
+			// Remove all declarations of the interface variables for non-matching entry points
+			if (std::find(variables_to_remove.begin(), variables_to_remove.end(), spirv[inst + 2]) != variables_to_remove.end())
+			{
+				spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
+				continue;
+			}
+			break;
+		case 71: // OpDecorate
+			// Remove all decorations targeting any of the interface variables for non-matching entry points
+			if (std::find(variables_to_remove.begin(), variables_to_remove.end(), spirv[inst + 1]) != variables_to_remove.end())
+			{
+				spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
+				continue;
+			}
+			break;
+		case 54: // OpFunction
+			current_function = spirv[inst + 2];
+			current_function_offset = inst;
+			break;
+		case 56: // OpFunctionEnd
+			// Remove all function definitions for non-matching entry points
+			if (std::find(functions_to_remove.begin(), functions_to_remove.end(), current_function) != functions_to_remove.end())
+			{
+				spirv.erase(spirv.begin() + current_function_offset, spirv.begin() + inst + len);
+				inst = current_function_offset;
+				continue;
+			}
+			break;
 		}
+
+		inst += len;
 	}
-	shader_modules(this, effect.module);
-	if (!shader_modules.loaded)
-		return false;
 
-	if (_effect_data.size() <= index)
-		_effect_data.resize(index + 1);
-	effect_data &effect_data = _effect_data[index];
+	cso.resize(spirv.size() * sizeof(uint32_t));
+	std::memcpy(cso.data(), spirv.data(), cso.size());
+
+	return true;
+}
+
+bool reshade::vulkan::runtime_vk::init_effect(effect &effect)
+{
+	auto impl = new effect_data();
+	effect.impl = impl;
 
 	// Create query pool for time measurements
 	{   VkQueryPoolCreateInfo create_info { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
 		create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
 		create_info.queryCount = static_cast<uint32_t>(effect.module.techniques.size() * 2 * NUM_COMMAND_FRAMES);
 
-		check_result(vk.CreateQueryPool(_device, &create_info, nullptr, &effect_data.query_pool)) false;
+		check_result(vk.CreateQueryPool(_device, &create_info, nullptr, &impl->query_pool)) false;
 	}
 
 	// Initialize pipeline layout
@@ -896,7 +904,7 @@ bool reshade::vulkan::runtime_vk::init_effect(size_t index)
 		create_info.bindingCount = uint32_t(bindings.size());
 		create_info.pBindings = bindings.data();
 
-		check_result(vk.CreateDescriptorSetLayout(_device, &create_info, nullptr, &effect_data.sampler_layout)) false;
+		check_result(vk.CreateDescriptorSetLayout(_device, &create_info, nullptr, &impl->sampler_layout)) false;
 	}
 
 	if (effect.module.num_storage_bindings != 0)
@@ -910,39 +918,39 @@ bool reshade::vulkan::runtime_vk::init_effect(size_t index)
 		create_info.bindingCount = uint32_t(bindings.size());
 		create_info.pBindings = bindings.data();
 
-		check_result(vk.CreateDescriptorSetLayout(_device, &create_info, nullptr, &effect_data.storage_layout)) false;
+		check_result(vk.CreateDescriptorSetLayout(_device, &create_info, nullptr, &impl->storage_layout)) false;
 	}
 
-	const VkDescriptorSetLayout set_layouts[3] = { _effect_descriptor_layout, effect_data.sampler_layout, effect_data.storage_layout };
+	const VkDescriptorSetLayout set_layouts[3] = { _effect_descriptor_layout, impl->sampler_layout, impl->storage_layout };
 
 	{   VkPipelineLayoutCreateInfo create_info { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
 		create_info.setLayoutCount = effect.module.num_storage_bindings == 0 ? 2 : 3; // [0] = Global UBO, [1] = Samplers, [2] = Storage Images
 		create_info.pSetLayouts = set_layouts;
 
-		check_result(vk.CreatePipelineLayout(_device, &create_info, nullptr, &effect_data.pipeline_layout)) false;
+		check_result(vk.CreatePipelineLayout(_device, &create_info, nullptr, &impl->pipeline_layout)) false;
 	}
 
 	// Create global uniform buffer object
 	if (!effect.uniform_data_storage.empty())
 	{
-		effect_data.ubo = create_buffer(
+		impl->ubo = create_buffer(
 			effect.uniform_data_storage.size(),
 			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
-			0, 0, &effect_data.ubo_mem);
-		if (effect_data.ubo == VK_NULL_HANDLE)
+			0, 0, &impl->ubo_mem);
+		if (impl->ubo == VK_NULL_HANDLE)
 			return false;
 	}
 
 	// Initialize image and sampler bindings
 	assert(effect.module.num_texture_bindings == 0); // Use combined image samplers
-	std::vector<VkDescriptorImageInfo> sampler_bindings(effect.module.num_sampler_bindings);
-	std::vector<VkDescriptorImageInfo> storage_bindings(effect.module.num_storage_bindings);
+	impl->sampler_bindings.resize(effect.module.num_sampler_bindings);
+	impl->storage_bindings.resize(effect.module.num_storage_bindings);
 
 	for (const reshadefx::sampler_info &info : effect.module.samplers)
 	{
 		const texture &texture = look_up_texture_by_name(info.texture_name);
 
-		VkDescriptorImageInfo &image_binding = sampler_bindings[info.binding];
+		VkDescriptorImageInfo &image_binding = impl->sampler_bindings[info.binding];
 		image_binding.imageView = static_cast<tex_data *>(texture.impl)->view[info.srgb];
 		image_binding.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
@@ -958,7 +966,7 @@ bool reshade::vulkan::runtime_vk::init_effect(size_t index)
 			if (_depth_image_view != VK_NULL_HANDLE)
 				image_binding.imageView = _depth_image_view;
 			// Keep track of the depth buffer texture descriptor to simplify updating it
-			effect_data.depth_image_bindings.emplace(info.binding, std::vector<VkDescriptorSet>());
+			impl->depth_image_bindings.emplace(info.binding, std::vector<VkDescriptorSet>());
 #endif
 		}
 
@@ -1042,7 +1050,7 @@ bool reshade::vulkan::runtime_vk::init_effect(size_t index)
 	{
 		const texture &texture = look_up_texture_by_name(info.texture_name);
 
-		VkDescriptorImageInfo &image_binding = storage_bindings[info.binding];
+		VkDescriptorImageInfo &image_binding = impl->storage_bindings[info.binding];
 		image_binding.imageView = static_cast<tex_data *>(texture.impl)->view[0];
 		image_binding.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
@@ -1051,520 +1059,503 @@ bool reshade::vulkan::runtime_vk::init_effect(size_t index)
 			return false;
 	}
 
-	uint32_t num_passes = 0;
-	for (const reshadefx::technique_info &info : effect.module.techniques)
-		num_passes += static_cast<uint32_t>(info.passes.size());
-
-	std::vector<VkDescriptorSet> sets(1 + 2 * num_passes);
-	std::vector<VkWriteDescriptorSet> writes;
-	writes.reserve(sets.size());
-
+	// Descriptor sets for the passes are allocated when those are initialized, only the one for the global uniform buffer is allocated here
 	{   VkDescriptorSetAllocateInfo alloc_info { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
 		alloc_info.descriptorPool = _effect_descriptor_pool;
-		alloc_info.descriptorSetCount = 1 + (effect.module.num_storage_bindings == 0 ? 1 : 2) * num_passes;
-
-		std::vector<VkDescriptorSetLayout> alloc_set_layouts(sets.size());
-		alloc_set_layouts[0] = _effect_descriptor_layout;
-		for (size_t i = 0; i < num_passes; ++i)
-		{
-			alloc_set_layouts[1 + i] = effect_data.sampler_layout;
-			alloc_set_layouts[1 + num_passes + i] = effect_data.storage_layout;
-		}
-		alloc_info.pSetLayouts = alloc_set_layouts.data();
+		alloc_info.descriptorSetCount = 1;
+		alloc_info.pSetLayouts = &_effect_descriptor_layout;
 
-		if (vk.AllocateDescriptorSets(_device, &alloc_info, sets.data()) != VK_SUCCESS)
+		if (vk.AllocateDescriptorSets(_device, &alloc_info, &impl->ubo_set) != VK_SUCCESS)
 		{
 			LOG(ERROR) << "Too many effects loaded. Only " << (MAX_EFFECT_DESCRIPTOR_SETS / 2) << " effects can be active simultaneously in Vulkan.";
 			return false;
 		}
 	}
 
-	effect_data.ubo_set = sets[0];
-	const VkDescriptorBufferInfo ubo_info = { effect_data.ubo, 0, VK_WHOLE_SIZE };
-	if (effect_data.ubo != VK_NULL_HANDLE)
+	if (impl->ubo != VK_NULL_HANDLE)
 	{
-		VkWriteDescriptorSet &write = writes.emplace_back();
-		write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-		write.dstSet = effect_data.ubo_set;
+		const VkDescriptorBufferInfo ubo_info = { impl->ubo, 0, VK_WHOLE_SIZE };
+
+		VkWriteDescriptorSet write { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		write.dstSet = impl->ubo_set;
 		write.dstBinding = 0;
 		write.descriptorCount = 1;
 		write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		write.pBufferInfo = &ubo_info;
+
+		vk.UpdateDescriptorSets(_device, 1, &write, 0, nullptr);
 	}
 
-	std::vector<uint8_t> spec_data;
-	std::vector<VkSpecializationMapEntry> spec_constants;
 	for (const reshadefx::uniform_info &constant : effect.module.spec_constants)
 	{
-		const uint32_t id = static_cast<uint32_t>(spec_constants.size());
-		const uint32_t offset = static_cast<uint32_t>(spec_data.size());
-		spec_data.resize(offset + constant.size);
-		spec_constants.push_back({ id, offset, constant.size });
-		std::memcpy(spec_data.data() + offset, &constant.initializer_value.as_uint[0], constant.size);
+		const uint32_t id = static_cast<uint32_t>(impl->spec_constants.size());
+		const uint32_t offset = static_cast<uint32_t>(impl->spec_data.size());
+		impl->spec_data.resize(offset + constant.size);
+		impl->spec_constants.push_back({ id, offset, constant.size });
+		std::memcpy(impl->spec_data.data() + offset, &constant.initializer_value.as_uint[0], constant.size);
 	}
 
+	return true;
+}
+bool reshade::vulkan::runtime_vk::init_technique(effect &, technique &technique)
+{
+	auto impl = new technique_data();
+	technique.impl = impl;
+
+	// Offset index so that a query exists for each command frame and two subsequent ones are used for before/after stamps
+	impl->query_base_index = static_cast<uint32_t>(technique.module_index * 2 * NUM_COMMAND_FRAMES);
+
+	impl->passes.resize(technique.passes.size());
+
+	return true;
+}
+bool reshade::vulkan::runtime_vk::init_pass(effect &effect, technique &technique, size_t pass_index)
+{
+	const auto effect_impl = static_cast<effect_data *>(effect.impl);
+	const auto impl = static_cast<technique_data *>(technique.impl);
+
+	// Create shader modules when they are first used, so that their cost is spread across the passes (every entry point has its own shader module, see 'compile_entry_point')
+	const auto create_shader_module = [this, &effect, effect_impl](const std::string &name) -> VkShaderModule {
+		if (const auto it = effect_impl->entry_points.find(name); it != effect_impl->entry_points.end())
+			return it->second;
+
+		const size_t i = std::distance(effect.module.entry_points.begin(), std::find_if(effect.module.entry_points.begin(), effect.module.entry_points.end(),
+			[&name](const reshadefx::entry_point &entry_point) { return entry_point.name == name; }));
+		assert(i < effect.module.entry_points.size());
+
+		const std::vector<char> &spirv = effect.bytecode[i];
+
+		VkShaderModuleCreateInfo create_info { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+		create_info.codeSize = spirv.size();
+		create_info.pCode = reinterpret_cast<const uint32_t *>(spirv.data());
+
+		VkShaderModule module = VK_NULL_HANDLE;
+		if (const VkResult res = vk.CreateShaderModule(_device, &create_info, nullptr, &module); res != VK_SUCCESS)
+		{
+			LOG(ERROR) << "Failed to create shader module for entry point '" << name << "'! Vulkan error code is " << res << '.';
+			return VK_NULL_HANDLE;
+		}
+
+		return effect_impl->entry_points.emplace(name, module).first->second;
+	};
+
+	pass_data &pass_data = impl->passes[pass_index];
+	const reshadefx::pass_info &pass_info = technique.passes[pass_index];
+
 	const VkSpecializationInfo spec_info {
-		static_cast<uint32_t>(spec_constants.size()), spec_constants.data(),
-		spec_data.size(), spec_data.data()
+		static_cast<uint32_t>(effect_impl->spec_constants.size()), effect_impl->spec_constants.data(),
+		effect_impl->spec_data.size(), effect_impl->spec_data.data()
 	};
 
-	uint32_t technique_index = 0;
-	uint32_t total_pass_index = 0;
-	for (technique &technique : _techniques)
+	if (!pass_info.cs_entry_point.empty())
 	{
-		if (technique.impl != nullptr || technique.effect_index != index)
-			continue;
+		impl->has_compute_passes = true;
 
-		auto impl = new technique_data();
-		technique.impl = impl;
+		const VkShaderModule cs = create_shader_module(pass_info.cs_entry_point);
+		if (cs == VK_NULL_HANDLE)
+			return false;
 
-		// Offset index so that a query exists for each command frame and two subsequent ones are used for before/after stamps
-		impl->query_base_index = technique_index++ * 2 * NUM_COMMAND_FRAMES;
+		VkComputePipelineCreateInfo create_info { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+		create_info.stage = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+		create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		create_info.stage.module = cs;
+		create_info.stage.pName = pass_info.cs_entry_point.c_str();
+		create_info.stage.pSpecializationInfo = &spec_info;
+		create_info.layout = effect_impl->pipeline_layout;
 
-		impl->passes.resize(technique.passes.size());
-		for (size_t pass_index = 0; pass_index < technique.passes.size(); ++pass_index, ++total_pass_index)
+		const VkResult res = vk.CreateComputePipelines(_device, VK_NULL_HANDLE, 1, &create_info, nullptr, &pass_data.pipeline);
+		if (res != VK_SUCCESS)
 		{
-			pass_data &pass_data = impl->passes[pass_index];
-			const reshadefx::pass_info &pass_info = technique.passes[pass_index];
+			LOG(ERROR) << "Failed to create compute pipeline for pass " << pass_index << " in technique '" << technique.name << "'! Vulkan error code is " << res << '.';
+			return false;
+		}
+	}
+	else
+	{
+		const VkShaderModule vs = create_shader_module(pass_info.vs_entry_point);
+		const VkShaderModule ps = create_shader_module(pass_info.ps_entry_point);
+		if (vs == VK_NULL_HANDLE || ps == VK_NULL_HANDLE)
+			return false;
 
-			if (!pass_info.cs_entry_point.empty())
+		const auto convert_blend_op = [](reshadefx::pass_blend_op value) -> VkBlendOp {
+			switch (value)
 			{
-				impl->has_compute_passes = true;
-
-				VkComputePipelineCreateInfo create_info { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
-				create_info.stage = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
-				create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-				create_info.stage.module = shader_modules.entry_points.at(pass_info.cs_entry_point);;
-				create_info.stage.pName = pass_info.cs_entry_point.c_str();
-				create_info.stage.pSpecializationInfo = &spec_info;
-				create_info.layout = effect_data.pipeline_layout;
-
-				const VkResult res = vk.CreateComputePipelines(_device, VK_NULL_HANDLE, 1, &create_info, nullptr, &pass_data.pipeline);
-				if (res != VK_SUCCESS)
-				{
-					LOG(ERROR) << "Failed to create compute pipeline for pass " << pass_index << " in technique '" << technique.name << "'! Vulkan error code is " << res << '.';
-					return false;
-				}
+			default:
+			case reshadefx::pass_blend_op::add: return VK_BLEND_OP_ADD;
+			case reshadefx::pass_blend_op::subtract: return VK_BLEND_OP_SUBTRACT;
+			case reshadefx::pass_blend_op::rev_subtract: return VK_BLEND_OP_REVERSE_SUBTRACT;
+			case reshadefx::pass_blend_op::min: return VK_BLEND_OP_MIN;
+			case reshadefx::pass_blend_op::max: return VK_BLEND_OP_MAX;
 			}
-			else
+		};
+		const auto convert_blend_func = [](reshadefx::pass_blend_func value) -> VkBlendFactor {
+			switch (value)
 			{
-				const auto convert_blend_op = [](reshadefx::pass_blend_op value) -> VkBlendOp {
-					switch (value)
-					{
-					default:
-					case reshadefx::pass_blend_op::add: return VK_BLEND_OP_ADD;
-					case reshadefx::pass_blend_op::subtract: return VK_BLEND_OP_SUBTRACT;
-					case reshadefx::pass_blend_op::rev_subtract: return VK_BLEND_OP_REVERSE_SUBTRACT;
-					case reshadefx::pass_blend_op::min: return VK_BLEND_OP_MIN;
-					case reshadefx::pass_blend_op::max: return VK_BLEND_OP_MAX;
-					}
-				};
-				const auto convert_blend_func = [](reshadefx::pass_blend_func value) -> VkBlendFactor {
-					switch (value)
-					{
-					case reshadefx::pass_blend_func::zero: return VK_BLEND_FACTOR_ZERO;
-					default:
-					case reshadefx::pass_blend_func::one: return VK_BLEND_FACTOR_ONE;
-					case reshadefx::pass_blend_func::src_color: return VK_BLEND_FACTOR_SRC_COLOR;
-					case reshadefx::pass_blend_func::src_alpha: return VK_BLEND_FACTOR_SRC_ALPHA;
-					case reshadefx::pass_blend_func::inv_src_color: return VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
-					case reshadefx::pass_blend_func::inv_src_alpha: return VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-					case reshadefx::pass_blend_func::dst_color: return VK_BLEND_FACTOR_DST_COLOR;
-					case reshadefx::pass_blend_func::dst_alpha: return VK_BLEND_FACTOR_DST_ALPHA;
-					case reshadefx::pass_blend_func::inv_dst_color: return VK_BLEND_FACTOR_ONE_MINUS_DST_COLOR;
-					case reshadefx::pass_blend_func::inv_dst_alpha: return VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA;
-					}
-				};
-				const auto convert_stencil_op = [](reshadefx::pass_stencil_op value) -> VkStencilOp {
-					switch (value)
-					{
-					case reshadefx::pass_stencil_op::zero: return VK_STENCIL_OP_ZERO;
-					default:
-					case reshadefx::pass_stencil_op::keep: return VK_STENCIL_OP_KEEP;
-					case reshadefx::pass_stencil_op::invert: return VK_STENCIL_OP_INVERT;
-					case reshadefx::pass_stencil_op::replace: return VK_STENCIL_OP_REPLACE;
-					case reshadefx::pass_stencil_op::incr: return VK_STENCIL_OP_INCREMENT_AND_WRAP;
-					case reshadefx::pass_stencil_op::incr_sat: return VK_STENCIL_OP_INCREMENT_AND_CLAMP;
-					case reshadefx::pass_stencil_op::decr: return VK_STENCIL_OP_DECREMENT_AND_WRAP;
-					case reshadefx::pass_stencil_op::decr_sat: return VK_STENCIL_OP_DECREMENT_AND_CLAMP;
-					}
-				};
-				const auto convert_stencil_func = [](reshadefx::pass_stencil_func value) -> VkCompareOp {
-					switch (value)
-					{
-					case reshadefx::pass_stencil_func::never: return VK_COMPARE_OP_NEVER;
-					case reshadefx::pass_stencil_func::equal: return VK_COMPARE_OP_EQUAL;
-					case reshadefx::pass_stencil_func::not_equal: return VK_COMPARE_OP_NOT_EQUAL;
-					case reshadefx::pass_stencil_func::less: return VK_COMPARE_OP_LESS;
-					case reshadefx::pass_stencil_func::less_equal: return VK_COMPARE_OP_LESS_OR_EQUAL;
-					case reshadefx::pass_stencil_func::greater: return VK_COMPARE_OP_GREATER;
-					case reshadefx::pass_stencil_func::greater_equal: return VK_COMPARE_OP_GREATER_OR_EQUAL;
-					default:
-					case reshadefx::pass_stencil_func::always: return VK_COMPARE_OP_ALWAYS;
-					}
-				};
-
-				const VkRect2D scissor_rect = {
-					{ 0, 0 },
-					{ pass_info.viewport_width ? pass_info.viewport_width : _width,
-					  pass_info.viewport_height ? pass_info.viewport_height : _height }
-				};
-				const VkViewport viewport_rect = {
-					0.0f, 0.0f,
-					static_cast<float>(scissor_rect.extent.width), static_cast<float>(scissor_rect.extent.height),
-					0.0f, 1.0f
-				};
-
-				pass_data.begin_info.renderArea = scissor_rect;
-
-				uint32_t num_color_attachments = 0;
-				VkImageView attachment_views[9] = {};
-				VkAttachmentReference attachment_refs[9] = {};
-				VkAttachmentDescription attachment_descs[9] = {};
-				VkPipelineColorBlendAttachmentState attachment_blends[8];
-				attachment_blends[0].blendEnable = pass_info.blend_enable;
-				attachment_blends[0].srcColorBlendFactor = convert_blend_func(pass_info.src_blend);
-				attachment_blends[0].dstColorBlendFactor = convert_blend_func(pass_info.dest_blend);
-				attachment_blends[0].colorBlendOp = convert_blend_op(pass_info.blend_op);
-				attachment_blends[0].srcAlphaBlendFactor = convert_blend_func(pass_info.src_blend_alpha);
-				attachment_blends[0].dstAlphaBlendFactor = convert_blend_func(pass_info.dest_blend_alpha);
-				attachment_blends[0].alphaBlendOp = convert_blend_op(pass_info.blend_op_alpha);
-				attachment_blends[0].colorWriteMask = pass_info.color_write_mask;
-
-				for (uint32_t k = 0; k < 8 && !pass_info.render_target_names[k].empty(); ++k, ++num_color_attachments)
-				{
-					tex_data *const tex_impl = static_cast<tex_data *>(
-						look_up_texture_by_name(pass_info.render_target_names[k]).impl);
-
-					pass_data.modified_resources.push_back(tex_impl);
-
-					attachment_views[k] = tex_impl->view[2 + pass_info.srgb_write_enable];
-					attachment_blends[k] = attachment_blends[0];
-
-					VkAttachmentReference &attachment_ref = attachment_refs[k];
-					attachment_ref.attachment = k;
-					attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-					VkAttachmentDescription &attachment_desc = attachment_descs[k];
-					attachment_desc.format = tex_impl->formats[pass_info.srgb_write_enable];
-					attachment_desc.samples = VK_SAMPLE_COUNT_1_BIT;
-					attachment_desc.loadOp = pass_info.clear_render_targets ? VK_ATTACHMENT_LOAD_OP_CLEAR : pass_info.blend_enable ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-					attachment_desc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-					attachment_desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-					attachment_desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-					attachment_desc.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-					attachment_desc.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				}
-
-				if (pass_info.clear_render_targets)
-				{
-					pass_data.begin_info.clearValueCount = num_color_attachments;
-					pass_data.begin_info.pClearValues = pass_data.clear_values; // These are initialized to zero already
-				}
+			case reshadefx::pass_blend_func::zero: return VK_BLEND_FACTOR_ZERO;
+			default:
+			case reshadefx::pass_blend_func::one: return VK_BLEND_FACTOR_ONE;
+			case reshadefx::pass_blend_func::src_color: return VK_BLEND_FACTOR_SRC_COLOR;
+			case reshadefx::pass_blend_func::src_alpha: return VK_BLEND_FACTOR_SRC_ALPHA;
+			case reshadefx::pass_blend_func::inv_src_color: return VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
+			case reshadefx::pass_blend_func::inv_src_alpha: return VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+			case reshadefx::pass_blend_func::dst_color: return VK_BLEND_FACTOR_DST_COLOR;
+			case reshadefx::pass_blend_func::dst_alpha: return VK_BLEND_FACTOR_DST_ALPHA;
+			case reshadefx::pass_blend_func::inv_dst_color: return VK_BLEND_FACTOR_ONE_MINUS_DST_COLOR;
+			case reshadefx::pass_blend_func::inv_dst_alpha: return VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA;
+			}
+		};
+		const auto convert_stencil_op = [](reshadefx::pass_stencil_op value) -> VkStencilOp {
+			switch (value)
+			{
+			case reshadefx::pass_stencil_op::zero: return VK_STENCIL_OP_ZERO;
+			default:
+			case reshadefx::pass_stencil_op::keep: return VK_STENCIL_OP_KEEP;
+			case reshadefx::pass_stencil_op::invert: return VK_STENCIL_OP_INVERT;
+			case reshadefx::pass_stencil_op::replace: return VK_STENCIL_OP_REPLACE;
+			case reshadefx::pass_stencil_op::incr: return VK_STENCIL_OP_INCREMENT_AND_WRAP;
+			case reshadefx::pass_stencil_op::incr_sat: return VK_STENCIL_OP_INCREMENT_AND_CLAMP;
+			case reshadefx::pass_stencil_op::decr: return VK_STENCIL_OP_DECREMENT_AND_WRAP;
+			case reshadefx::pass_stencil_op::decr_sat: return VK_STENCIL_OP_DECREMENT_AND_CLAMP;
+			}
+		};
+		const auto convert_stencil_func = [](reshadefx::pass_stencil_func value) -> VkCompareOp {
+			switch (value)
+			{
+			case reshadefx::pass_stencil_func::never: return VK_COMPARE_OP_NEVER;
+			case reshadefx::pass_stencil_func::equal: return VK_COMPARE_OP_EQUAL;
+			case reshadefx::pass_stencil_func::not_equal: return VK_COMPARE_OP_NOT_EQUAL;
+			case reshadefx::pass_stencil_func::less: return VK_COMPARE_OP_LESS;
+			case reshadefx::pass_stencil_func::less_equal: return VK_COMPARE_OP_LESS_OR_EQUAL;
+			case reshadefx::pass_stencil_func::greater: return VK_COMPARE_OP_GREATER;
+			case reshadefx::pass_stencil_func::greater_equal: return VK_COMPARE_OP_GREATER_OR_EQUAL;
+			default:
+			case reshadefx::pass_stencil_func::always: return VK_COMPARE_OP_ALWAYS;
+			}
+		};
 
-				if (pass_info.render_target_names[0].empty())
-				{
-					num_color_attachments = 1;
-					pass_data.begin_info.renderPass = _default_render_pass[pass_info.srgb_write_enable];
-					pass_data.begin_info.framebuffer = VK_NULL_HANDLE; // Select the correct swap chain frame buffer during rendering
-				}
-				else
-				{
-					uint32_t num_stencil_attachments = 0;
-
-					if (pass_info.stencil_enable && // Only need to attach stencil if stencil is actually used in this pass
-						scissor_rect.extent.width == _width &&
-						scissor_rect.extent.height == _height)
-					{
-						num_stencil_attachments = 1;
-						const uint32_t stencil_idx = num_color_attachments;
-
-						attachment_views[stencil_idx] = _effect_stencil_view;
-
-						VkAttachmentReference &attachment_ref = attachment_refs[stencil_idx];
-						attachment_ref.attachment = stencil_idx;
-						attachment_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-						VkAttachmentDescription &attachment_desc = attachment_descs[stencil_idx];
-						attachment_desc.format = _effect_stencil_format;
-						attachment_desc.samples = VK_SAMPLE_COUNT_1_BIT;
-						attachment_desc.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-						attachment_desc.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-						attachment_desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-						attachment_desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-						attachment_desc.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-						attachment_desc.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-					}
-
-					{   // Synchronize any writes to render targets in previous passes with reads from them in this pass
-						VkSubpassDependency subdep = {};
-						subdep.srcSubpass = VK_SUBPASS_EXTERNAL;
-						subdep.dstSubpass = 0;
-						subdep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-						subdep.dstStageMask = VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
-						subdep.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-						subdep.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-						VkSubpassDescription subpass = {};
-						subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-						subpass.colorAttachmentCount = num_color_attachments;
-						subpass.pColorAttachments = attachment_refs;
-						subpass.pDepthStencilAttachment = num_stencil_attachments ? &attachment_refs[num_color_attachments] : nullptr;
-
-						VkRenderPassCreateInfo create_info { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
-						create_info.attachmentCount = num_color_attachments + num_stencil_attachments;
-						create_info.pAttachments = attachment_descs;
-						create_info.subpassCount = 1;
-						create_info.pSubpasses = &subpass;
-						create_info.dependencyCount = 1;
-						create_info.pDependencies = &subdep;
-
-						check_result(vk.CreateRenderPass(_device, &create_info, nullptr, &pass_data.begin_info.renderPass)) false;
-					}
-
-					{   VkFramebufferCreateInfo create_info { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
-						create_info.renderPass = pass_data.begin_info.renderPass;
-						create_info.attachmentCount = num_color_attachments + num_stencil_attachments;
-						create_info.pAttachments = attachment_views;
-						create_info.width = scissor_rect.extent.width;
-						create_info.height = scissor_rect.extent.height;
-						create_info.layers = 1;
-
-						check_result(vk.CreateFramebuffer(_device, &create_info, nullptr, &pass_data.begin_info.framebuffer)) false;
-					}
-				}
+		const VkRect2D scissor_rect = {
+			{ 0, 0 },
+			{ pass_info.viewport_width ? pass_info.viewport_width : _width,
+			  pass_info.viewport_height ? pass_info.viewport_height : _height }
+		};
+		const VkViewport viewport_rect = {
+			0.0f, 0.0f,
+			static_cast<float>(scissor_rect.extent.width), static_cast<float>(scissor_rect.extent.height),
+			0.0f, 1.0f
+		};
 
-				VkPipelineShaderStageCreateInfo stages[2];
-				stages[0] = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
-				stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-				stages[0].module = shader_modules.entry_points.at(pass_info.vs_entry_point);
-				stages[0].pName = pass_info.vs_entry_point.c_str();
-				stages[0].pSpecializationInfo = &spec_info;
-				stages[1] = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
-				stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-				stages[1].module = shader_modules.entry_points.at(pass_info.ps_entry_point);
-				stages[1].pName = pass_info.ps_entry_point.c_str();
-				stages[1].pSpecializationInfo = &spec_info;
-
-				VkPipelineVertexInputStateCreateInfo vertex_info { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
-				// No vertex attributes
-
-				VkPipelineInputAssemblyStateCreateInfo ia_info { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
-				switch (pass_info.topology)
-				{
-				case reshadefx::primitive_topology::point_list:
-					ia_info.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
-					break;
-				case reshadefx::primitive_topology::line_list:
-					ia_info.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
-					break;
-				case reshadefx::primitive_topology::line_strip:
-					ia_info.topology = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP;
-					break;
-				default:
-				case reshadefx::primitive_topology::triangle_list:
-					ia_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-					break;
-				case reshadefx::primitive_topology::triangle_strip:
-					ia_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
-					break;
-				}
+		pass_data.begin_info.renderArea = scissor_rect;
+
+		uint32_t num_color_attachments = 0;
+		VkImageView attachment_views[9] = {};
+		VkAttachmentReference attachment_refs[9] = {};
+		VkAttachmentDescription attachment_descs[9] = {};
+		VkPipelineColorBlendAttachmentState attachment_blends[8];
+		attachment_blends[0].blendEnable = pass_info.blend_enable;
+		attachment_blends[0].srcColorBlendFactor = convert_blend_func(pass_info.src_blend);
+		attachment_blends[0].dstColorBlendFactor = convert_blend_func(pass_info.dest_blend);
+		attachment_blends[0].colorBlendOp = convert_blend_op(pass_info.blend_op);
+		attachment_blends[0].srcAlphaBlendFactor = convert_blend_func(pass_info.src_blend_alpha);
+		attachment_blends[0].dstAlphaBlendFactor = convert_blend_func(pass_info.dest_blend_alpha);
+		attachment_blends[0].alphaBlendOp = convert_blend_op(pass_info.blend_op_alpha);
+		attachment_blends[0].colorWriteMask = pass_info.color_write_mask;
+
+		for (uint32_t k = 0; k < 8 && !pass_info.render_target_names[k].empty(); ++k, ++num_color_attachments)
+		{
+			tex_data *const tex_impl = static_cast<tex_data *>(
+				look_up_texture_by_name(pass_info.render_target_names[k]).impl);
+
+			pass_data.modified_resources.push_back(tex_impl);
+
+			attachment_views[k] = tex_impl->view[2 + pass_info.srgb_write_enable];
+			attachment_blends[k] = attachment_blends[0];
+
+			VkAttachmentReference &attachment_ref = attachment_refs[k];
+			attachment_ref.attachment = k;
+			attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+			VkAttachmentDescription &attachment_desc = attachment_descs[k];
+			attachment_desc.format = tex_impl->formats[pass_info.srgb_write_enable];
+			attachment_desc.samples = VK_SAMPLE_COUNT_1_BIT;
+			attachment_desc.loadOp = pass_info.clear_render_targets ? VK_ATTACHMENT_LOAD_OP_CLEAR : pass_info.blend_enable ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment_desc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachment_desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment_desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment_desc.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			attachment_desc.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		}
 
-				VkPipelineViewportStateCreateInfo viewport_info { VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
-				viewport_info.viewportCount = 1;
-				viewport_info.pViewports = &viewport_rect;
-				viewport_info.scissorCount = 1;
-				viewport_info.pScissors = &scissor_rect;
-
-				VkPipelineRasterizationStateCreateInfo raster_info { VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
-				raster_info.polygonMode = VK_POLYGON_MODE_FILL;
-				raster_info.cullMode = VK_CULL_MODE_NONE;
-				raster_info.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-				raster_info.lineWidth = 1.0f;
-
-				VkPipelineMultisampleStateCreateInfo ms_info { VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
-				ms_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-				VkPipelineColorBlendStateCreateInfo blend_info { VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
-				blend_info.attachmentCount = num_color_attachments;
-				blend_info.pAttachments = attachment_blends;
-
-				VkPipelineDepthStencilStateCreateInfo depth_info { VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
-				depth_info.depthTestEnable = VK_FALSE;
-				depth_info.depthWriteEnable = VK_FALSE;
-				depth_info.depthCompareOp = VK_COMPARE_OP_ALWAYS;
-				depth_info.stencilTestEnable = pass_info.stencil_enable;
-				depth_info.front.failOp = convert_stencil_op(pass_info.stencil_op_fail);
-				depth_info.front.passOp = convert_stencil_op(pass_info.stencil_op_pass);
-				depth_info.front.depthFailOp = convert_stencil_op(pass_info.stencil_op_depth_fail);
-				depth_info.front.compareOp = convert_stencil_func(pass_info.stencil_comparison_func);
-				depth_info.front.compareMask = pass_info.stencil_read_mask;
-				depth_info.front.writeMask = pass_info.stencil_write_mask;
-				depth_info.front.reference = pass_info.stencil_reference_value;
-				depth_info.back = depth_info.front;
-				depth_info.minDepthBounds = 0.0f;
-				depth_info.maxDepthBounds = 1.0f;
-
-				VkGraphicsPipelineCreateInfo create_info { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
-				create_info.stageCount = static_cast<uint32_t>(std::size(stages));
-				create_info.pStages = stages;
-				create_info.pVertexInputState = &vertex_info;
-				create_info.pInputAssemblyState = &ia_info;
-				create_info.pViewportState = &viewport_info;
-				create_info.pRasterizationState = &raster_info;
-				create_info.pMultisampleState = &ms_info;
-				create_info.pDepthStencilState = &depth_info;
-				create_info.pColorBlendState = &blend_info;
-				create_info.layout = effect_data.pipeline_layout;
-				create_info.renderPass = pass_data.begin_info.renderPass;
+		if (pass_info.clear_render_targets)
+		{
+			pass_data.begin_info.clearValueCount = num_color_attachments;
+			pass_data.begin_info.pClearValues = pass_data.clear_values; // These are initialized to zero already
+		}
 
-				const VkResult res = vk.CreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &create_info, nullptr, &pass_data.pipeline);
-				if (res != VK_SUCCESS)
-				{
-					LOG(ERROR) << "Failed to create graphics pipeline for pass " << pass_index << " in technique '" << technique.name << "'! Vulkan error code is " << res << '.';
-					return false;
-				}
-			}
+		if (pass_info.render_target_names[0].empty())
+		{
+			num_color_attachments = 1;
+			pass_data.begin_info.renderPass = _default_render_pass[pass_info.srgb_write_enable];
+			pass_data.begin_info.framebuffer = VK_NULL_HANDLE; // Select the correct swap chain frame buffer during rendering
+		}
+		else
+		{
+			uint32_t num_stencil_attachments = 0;
 
-			pass_data.set[0] = sets[1 + total_pass_index];
-			for (const reshadefx::sampler_info &info : pass_info.samplers)
+			if (pass_info.stencil_enable && // Only need to attach stencil if stencil is actually used in this pass
+				scissor_rect.extent.width == _width &&
+				scissor_rect.extent.height == _height)
 			{
-				VkWriteDescriptorSet &write = writes.emplace_back();
-				write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-				write.dstSet = pass_data.set[0];
-				write.dstBinding = info.binding;
-				write.descriptorCount = 1;
-				write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-				write.pImageInfo = &sampler_bindings[info.binding];
+				num_stencil_attachments = 1;
+				const uint32_t stencil_idx = num_color_attachments;
+
+				attachment_views[stencil_idx] = _effect_stencil_view;
+
+				VkAttachmentReference &attachment_ref = attachment_refs[stencil_idx];
+				attachment_ref.attachment = stencil_idx;
+				attachment_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+				VkAttachmentDescription &attachment_desc = attachment_descs[stencil_idx];
+				attachment_desc.format = _effect_stencil_format;
+				attachment_desc.samples = VK_SAMPLE_COUNT_1_BIT;
+				attachment_desc.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				attachment_desc.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachment_desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+				attachment_desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+				attachment_desc.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+				attachment_desc.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			}
 
-#if RESHADE_DEPTH
-				if (const auto it = effect_data.depth_image_bindings.find(info.binding); it != effect_data.depth_image_bindings.end())
-					it->second.push_back(pass_data.set[0]);
-#endif
+			{   // Synchronize any writes to render targets in previous passes with reads from them in this pass
+				VkSubpassDependency subdep = {};
+				subdep.srcSubpass = VK_SUBPASS_EXTERNAL;
+				subdep.dstSubpass = 0;
+				subdep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				subdep.dstStageMask = VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
+				subdep.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+				subdep.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+				VkSubpassDescription subpass = {};
+				subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+				subpass.colorAttachmentCount = num_color_attachments;
+				subpass.pColorAttachments = attachment_refs;
+				subpass.pDepthStencilAttachment = num_stencil_attachments ? &attachment_refs[num_color_attachments] : nullptr;
+
+				VkRenderPassCreateInfo create_info { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+				create_info.attachmentCount = num_color_attachments + num_stencil_attachments;
+				create_info.pAttachments = attachment_descs;
+				create_info.subpassCount = 1;
+				create_info.pSubpasses = &subpass;
+				create_info.dependencyCount = 1;
+				create_info.pDependencies = &subdep;
+
+				check_result(vk.CreateRenderPass(_device, &create_info, nullptr, &pass_data.begin_info.renderPass)) false;
 			}
-			pass_data.set[1] = sets[1 + num_passes + total_pass_index];
-			for (const reshadefx::storage_info &info : pass_info.storages)
-			{
-				VkWriteDescriptorSet &write = writes.emplace_back();
-				write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-				write.dstSet = pass_data.set[1];
-				write.dstBinding = info.binding;
-				write.descriptorCount = 1;
-				write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-				write.pImageInfo = &storage_bindings[info.binding];
 
-				tex_data *const tex_impl = static_cast<tex_data *>(
-					look_up_texture_by_name(info.texture_name).impl);
+			{   VkFramebufferCreateInfo create_info { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+				create_info.renderPass = pass_data.begin_info.renderPass;
+				create_info.attachmentCount = num_color_attachments + num_stencil_attachments;
+				create_info.pAttachments = attachment_views;
+				create_info.width = scissor_rect.extent.width;
+				create_info.height = scissor_rect.extent.height;
+				create_info.layers = 1;
 
-				pass_data.modified_resources.push_back(tex_impl);
+				check_result(vk.CreateFramebuffer(_device, &create_info, nullptr, &pass_data.begin_info.framebuffer)) false;
 			}
 		}
-	}
 
-	vk.UpdateDescriptorSets(_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
-
-#if RESHADE_DEPTH
-	effect_data.image_bindings = std::move(sampler_bindings);
-#endif
+		VkPipelineShaderStageCreateInfo stages[2];
+		stages[0] = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+		stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+		stages[0].module = vs;
+		stages[0].pName = pass_info.vs_entry_point.c_str();
+		stages[0].pSpecializationInfo = &spec_info;
+		stages[1] = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+		stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		stages[1].module = ps;
+		stages[1].pName = pass_info.ps_entry_point.c_str();
+		stages[1].pSpecializationInfo = &spec_info;
+
+		VkPipelineVertexInputStateCreateInfo vertex_info { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+		// No vertex attributes
+
+		VkPipelineInputAssemblyStateCreateInfo ia_info { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+		switch (pass_info.topology)
+		{
+		case reshadefx::primitive_topology::point_list:
+			ia_info.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+			break;
+		case reshadefx::primitive_topology::line_list:
+			ia_info.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+			break;
+		case reshadefx::primitive_topology::line_strip:
+			ia_info.topology = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP;
+			break;
+		default:
+		case reshadefx::primitive_topology::triangle_list:
+			ia_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+			break;
+		case reshadefx::primitive_topology::triangle_strip:
+			ia_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+			break;
+		}
 
-	return true;
-}
-void reshade::vulkan::runtime_vk::unload_effect(size_t index)
-{
-	// Make sure no effect resources are currently in use
-	wait_for_command_buffers();
+		VkPipelineViewportStateCreateInfo viewport_info { VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+		viewport_info.viewportCount = 1;
+		viewport_info.pViewports = &viewport_rect;
+		viewport_info.scissorCount = 1;
+		viewport_info.pScissors = &scissor_rect;
+
+		VkPipelineRasterizationStateCreateInfo raster_info { VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+		raster_info.polygonMode = VK_POLYGON_MODE_FILL;
+		raster_info.cullMode = VK_CULL_MODE_NONE;
+		raster_info.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		raster_info.lineWidth = 1.0f;
+
+		VkPipelineMultisampleStateCreateInfo ms_info { VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+		ms_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		VkPipelineColorBlendStateCreateInfo blend_info { VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+		blend_info.attachmentCount = num_color_attachments;
+		blend_info.pAttachments = attachment_blends;
+
+		VkPipelineDepthStencilStateCreateInfo depth_info { VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+		depth_info.depthTestEnable = VK_FALSE;
+		depth_info.depthWriteEnable = VK_FALSE;
+		depth_info.depthCompareOp = VK_COMPARE_OP_ALWAYS;
+		depth_info.stencilTestEnable = pass_info.stencil_enable;
+		depth_info.front.failOp = convert_stencil_op(pass_info.stencil_op_fail);
+		depth_info.front.passOp = convert_stencil_op(pass_info.stencil_op_pass);
+		depth_info.front.depthFailOp = convert_stencil_op(pass_info.stencil_op_depth_fail);
+		depth_info.front.compareOp = convert_stencil_func(pass_info.stencil_comparison_func);
+		depth_info.front.compareMask = pass_info.stencil_read_mask;
+		depth_info.front.writeMask = pass_info.stencil_write_mask;
+		depth_info.front.reference = pass_info.stencil_reference_value;
+		depth_info.back = depth_info.front;
+		depth_info.minDepthBounds = 0.0f;
+		depth_info.maxDepthBounds = 1.0f;
+
+		VkGraphicsPipelineCreateInfo create_info { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+		create_info.stageCount = static_cast<uint32_t>(std::size(stages));
+		create_info.pStages = stages;
+		create_info.pVertexInputState = &vertex_info;
+		create_info.pInputAssemblyState = &ia_info;
+		create_info.pViewportState = &viewport_info;
+		create_info.pRasterizationState = &raster_info;
+		create_info.pMultisampleState = &ms_info;
+		create_info.pDepthStencilState = &depth_info;
+		create_info.pColorBlendState = &blend_info;
+		create_info.layout = effect_impl->pipeline_layout;
+		create_info.renderPass = pass_data.begin_info.renderPass;
+
+		const VkResult res = vk.CreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &create_info, nullptr, &pass_data.pipeline);
+		if (res != VK_SUCCESS)
+		{
+			LOG(ERROR) << "Failed to create graphics pipeline for pass " << pass_index << " in technique '" << technique.name << "'! Vulkan error code is " << res << '.';
+			return false;
+		}
+	}
 
-	for (technique &tech : _techniques)
-	{
-		if (tech.effect_index != index)
-			continue;
+	{   const VkDescriptorSetLayout set_layouts[2] = { effect_impl->sampler_layout, effect_impl->storage_layout };
 
-		const auto impl = static_cast<technique_data *>(tech.impl);
-		if (impl == nullptr)
-			continue;
+		VkDescriptorSetAllocateInfo alloc_info { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+		alloc_info.descriptorPool = _effect_descriptor_pool;
+		alloc_info.descriptorSetCount = effect.module.num_storage_bindings == 0 ? 1 : 2;
+		alloc_info.pSetLayouts = set_layouts;
 
-		for (pass_data &pass_data : impl->passes)
+		if (vk.AllocateDescriptorSets(_device, &alloc_info, pass_data.set) != VK_SUCCESS)
 		{
-			if (pass_data.begin_info.renderPass != _default_render_pass[0] &&
-				pass_data.begin_info.renderPass != _default_render_pass[1])
-				vk.DestroyRenderPass(_device, pass_data.begin_info.renderPass, nullptr);
-			vk.DestroyFramebuffer(_device, pass_data.begin_info.framebuffer, nullptr);
-			vk.DestroyPipeline(_device, pass_data.pipeline, nullptr);
+			LOG(ERROR) << "Too many effects loaded. Only " << (MAX_EFFECT_DESCRIPTOR_SETS / 2) << " effects can be active simultaneously in Vulkan.";
+			return false;
 		}
-
-		delete impl;
-		tech.impl = nullptr;
 	}
 
-	runtime::unload_effect(index);
+	std::vector<VkWriteDescriptorSet> writes;
+	writes.reserve(pass_info.samplers.size() + pass_info.storages.size());
 
-	if (index < _effect_data.size())
+	for (const reshadefx::sampler_info &info : pass_info.samplers)
 	{
-		effect_data &effect_data = _effect_data[index];
+		VkWriteDescriptorSet &write = writes.emplace_back();
+		write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		write.dstSet = pass_data.set[0];
+		write.dstBinding = info.binding;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.pImageInfo = &effect_impl->sampler_bindings[info.binding];
 
-		vk.DestroyQueryPool(_device, effect_data.query_pool, nullptr);
-		effect_data.query_pool = VK_NULL_HANDLE;
-		vk.DestroyPipelineLayout(_device, effect_data.pipeline_layout, nullptr);
-		effect_data.pipeline_layout = VK_NULL_HANDLE;
-		vk.DestroyDescriptorSetLayout(_device, effect_data.sampler_layout, nullptr);
-		effect_data.sampler_layout = VK_NULL_HANDLE;
-		vk.DestroyDescriptorSetLayout(_device, effect_data.storage_layout, nullptr);
-		effect_data.storage_layout = VK_NULL_HANDLE;
-		vmaDestroyBuffer(_alloc, effect_data.ubo, effect_data.ubo_mem);
-		effect_data.ubo = VK_NULL_HANDLE;
-		effect_data.ubo_mem = VK_NULL_HANDLE;
 #if RESHADE_DEPTH
-		effect_data.depth_image_bindings.clear();
-		effect_data.image_bindings.clear();
+		if (const auto it = effect_impl->depth_image_bindings.find(info.binding); it != effect_impl->depth_image_bindings.end())
+			it->second.push_back(pass_data.set[0]);
 #endif
 	}
+	for (const reshadefx::storage_info &info : pass_info.storages)
+	{
+		VkWriteDescriptorSet &write = writes.emplace_back();
+		write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		write.dstSet = pass_data.set[1];
+		write.dstBinding = info.binding;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		write.pImageInfo = &effect_impl->storage_bindings[info.binding];
+
+		tex_data *const tex_impl = static_cast<tex_data *>(
+			look_up_texture_by_name(info.texture_name).impl);
+
+		pass_data.modified_resources.push_back(tex_impl);
+	}
+
+	vk.UpdateDescriptorSets(_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	return true;
 }
-void reshade::vulkan::runtime_vk::unload_effects()
+void reshade::vulkan::runtime_vk::destroy_technique(technique &technique)
 {
+	const auto impl = static_cast<technique_data *>(technique.impl);
+
 	// Make sure no effect resources are currently in use
 	wait_for_command_buffers();
 
-	for (technique &tech : _techniques)
+	for (const pass_data &pass_data : impl->passes)
 	{
-		const auto impl = static_cast<technique_data *>(tech.impl);
-		if (impl == nullptr)
-			continue;
+		if (pass_data.begin_info.renderPass != _default_render_pass[0] &&
+			pass_data.begin_info.renderPass != _default_render_pass[1])
+			vk.DestroyRenderPass(_device, pass_data.begin_info.renderPass, nullptr);
+		vk.DestroyFramebuffer(_device, pass_data.begin_info.framebuffer, nullptr);
+		vk.DestroyPipeline(_device, pass_data.pipeline, nullptr);
+		vk.FreeDescriptorSets(_device, _effect_descriptor_pool, static_cast<uint32_t>(std::size(pass_data.set)), pass_data.set);
+	}
 
-		for (pass_data &pass_data : impl->passes)
-		{
-			if (pass_data.begin_info.renderPass != _default_render_pass[0] &&
-				pass_data.begin_info.renderPass != _default_render_pass[1])
-				vk.DestroyRenderPass(_device, pass_data.begin_info.renderPass, nullptr);
-			vk.DestroyFramebuffer(_device, pass_data.begin_info.framebuffer, nullptr);
-			vk.DestroyPipeline(_device, pass_data.pipeline, nullptr);
-		}
+	delete impl;
+	technique.impl = nullptr;
+}
+void reshade::vulkan::runtime_vk::destroy_effect(effect &effect)
+{
+	const auto impl = static_cast<effect_data *>(effect.impl);
 
-		delete impl;
-		tech.impl = nullptr;
-	}
+	// Make sure no effect resources are currently in use
+	wait_for_command_buffers();
 
-	runtime::unload_effects();
+	vk.DestroyQueryPool(_device, impl->query_pool, nullptr);
+	vk.DestroyPipelineLayout(_device, impl->pipeline_layout, nullptr);
+	vk.DestroyDescriptorSetLayout(_device, impl->sampler_layout, nullptr);
+	vk.DestroyDescriptorSetLayout(_device, impl->storage_layout, nullptr);
+	vmaDestroyBuffer(_alloc, impl->ubo, impl->ubo_mem);
+	vk.FreeDescriptorSets(_device, _effect_descriptor_pool, 1, &impl->ubo_set);
 
-	if (_effect_descriptor_pool != VK_NULL_HANDLE)
-	{
-		vk.ResetDescriptorPool(_device, _effect_descriptor_pool, 0);
-	}
+	for (const auto &[name, module] : impl->entry_points)
+		vk.DestroyShaderModule(_device, module, nullptr);
 
-	for (const effect_data &data : _effect_data)
-	{
-		vk.DestroyQueryPool(_device, data.query_pool, nullptr);
-		vk.DestroyPipelineLayout(_device, data.pipeline_layout, nullptr);
-		vk.DestroyDescriptorSetLayout(_device, data.sampler_layout, nullptr);
-		vk.DestroyDescriptorSetLayout(_device, data.storage_layout, nullptr);
-		vmaDestroyBuffer(_alloc, data.ubo, data.ubo_mem);
-	}
+	delete impl;
+	effect.impl = nullptr;
+}
+void reshade::vulkan::runtime_vk::unload_effects()
+{
+	runtime::unload_effects();
 
 	for (auto &[hash, sampler] : _effect_sampler_states)
 	{
 		vk.DestroySampler(_device, sampler, nullptr);
 	}
 
-	_effect_data.clear();
 	_effect_sampler_states.clear();
 }
 
@@ -1622,9 +1613,17 @@ bool reshade::vulkan::runtime_vk::init_texture(texture &texture)
 		break;
 	}
 
+	// Textures whose image file is uploaded as is are created with the block-compressed format of that file instead
+	const bool compressed = texture.compressed_format != reshadefx::texture_format::unknown;
+	if (compressed)
+	{
+		impl->formats[0] = convert_compressed_format(texture.compressed_format);
+		impl->formats[1] = convert_compressed_format(texture.compressed_format, true);
+	}
+
 	// Need TRANSFER_DST for texture data upload
 	VkImageUsageFlags usage_flags = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-	if (texture.levels > 1) // Add required TRANSFER_SRC flag for mipmap generation
+	if (texture.levels > 1 && !compressed) // Add required TRANSFER_SRC flag for mipmap generation (block-compressed textures come with all their levels)
 		usage_flags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 	if (texture.render_target)
 		usage_flags |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
@@ -1698,10 +1697,13 @@ bool reshade::vulkan::runtime_vk::init_texture(texture &texture)
 	{
 		transition_layout(vk, _cmd_buffers[_cmd_index].first, impl->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
-		// Clear texture to zero since by default its contents are undefined
-		const VkClearColorValue clear_value = {};
-		const VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
-		vk.CmdClearColorImage(_cmd_buffers[_cmd_index].first, impl->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear_value, 1, &range);
+		// Clear texture to zero since by default its contents are undefined (this is not possible for block-compressed formats, but those are overwritten on upload anyway)
+		if (!compressed)
+		{
+			const VkClearColorValue clear_value = {};
+			const VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+			vk.CmdClearColorImage(_cmd_buffers[_cmd_index].first, impl->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear_value, 1, &range);
+		}
 
 		// Transition to shader read image layout
 		transition_layout(vk, _cmd_buffers[_cmd_index].first, impl->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
@@ -1781,6 +1783,86 @@ void reshade::vulkan::runtime_vk::upload_texture(const texture &texture, const u
 
 	vmaDestroyBuffer(_alloc, intermediate, intermediate_mem);
 }
+void reshade::vulkan::runtime_vk::upload_texture_levels(const texture &texture, const uint8_t *data)
+{
+	auto impl = static_cast<tex_data *>(texture.impl);
+	assert(impl != nullptr && texture.semantic.empty() && data != nullptr);
+
+	// Data of all mipmap levels is stored one after another, but buffer offsets have to be a multiple of four, so add padding between levels where necessary
+	VkDeviceSize total_size = 0;
+	std::vector<size_t> level_sizes(texture.levels);
+	std::vector<VkBufferImageCopy> copy_regions(texture.levels);
+	for (uint32_t level = 0; level < texture.levels; ++level)
+	{
+		const uint32_t width = std::max(texture.width >> level, 1u);
+		const uint32_t height = std::max(texture.height >> level, 1u);
+
+		copy_regions[level].bufferOffset = total_size;
+		copy_regions[level].imageExtent = { width, height, 1u };
+		copy_regions[level].imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+
+		level_sizes[level] = texture_row_pitch(texture.storage_format(), width) * texture_row_count(texture.storage_format(), height);
+		total_size += (level_sizes[level] + 3) & ~size_t(3);
+	}
+
+	// Allocate host memory for upload
+	VkBuffer intermediate = VK_NULL_HANDLE;
+	VmaAllocation intermediate_mem = VK_NULL_HANDLE;
+
+	{   VkBufferCreateInfo create_info { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+		create_info.size = total_size;
+		create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+		VmaAllocationCreateInfo alloc_info = {};
+		alloc_info.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+
+		check_result(vmaCreateBuffer(_alloc, &create_info, &alloc_info, &intermediate, &intermediate_mem, nullptr));
+	}
+
+	uint8_t *mapped_data = nullptr;
+	if (vmaMapMemory(_alloc, intermediate_mem, reinterpret_cast<void **>(&mapped_data)) == VK_SUCCESS)
+	{
+		for (uint32_t level = 0; level < texture.levels; data += level_sizes[level++])
+		{
+			uint8_t *const level_data = mapped_data + copy_regions[level].bufferOffset;
+
+			if (texture.storage_format() == reshadefx::texture_format::rgb10a2)
+			{
+				// Texture is created with 'VK_FORMAT_A2R10G10B10_UNORM_PACK32', which has the red and blue channels the other way around
+				for (size_t i = 0; i < level_sizes[level]; i += 4)
+				{
+					uint32_t value;
+					std::memcpy(&value, data + i, 4);
+					value = (value & 0xC00FFC00) | ((value & 0x3FF) << 20) | ((value >> 20) & 0x3FF);
+					std::memcpy(level_data + i, &value, 4);
+				}
+			}
+			else
+			{
+				std::memcpy(level_data, data, level_sizes[level]);
+			}
+		}
+
+		vmaUnmapMemory(_alloc, intermediate_mem);
+	}
+
+	if (mapped_data != nullptr && begin_command_buffer())
+	{
+		const VkCommandBuffer cmd_list = _cmd_buffers[_cmd_index].first;
+
+		transition_layout(vk, cmd_list, impl->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		vk.CmdCopyBufferToImage(cmd_list, intermediate, impl->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, texture.levels, copy_regions.data());
+		transition_layout(vk, cmd_list, impl->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		execute_command_buffer();
+	}
+
+	vmaDestroyBuffer(_alloc, intermediate, intermediate_mem);
+}
+bool reshade::vulkan::runtime_vk::supports_compressed_format(reshadefx::texture_format format) const
+{
+	return (_supported_compressed_formats & (1u << static_cast<uint32_t>(format))) != 0;
+}
 void reshade::vulkan::runtime_vk::destroy_texture(texture &texture)
 {
 	if (texture.impl == nullptr)
@@ -1839,7 +1921,7 @@ void reshade::vulkan::runtime_vk::generate_mipmaps(const tex_data *impl)
 void reshade::vulkan::runtime_vk::render_technique(technique &technique)
 {
 	const auto impl = static_cast<technique_data *>(technique.impl);
-	effect_data &effect_data = _effect_data[technique.effect_index];
+	effect_data &effect_data = *static_cast<struct effect_data *>(_effects[technique.effect_index].impl);
 
 	// Evaluate queries from oldest frame in queue
 	if (uint64_t timestamps[2];
@@ -1877,9 +1959,13 @@ void reshade::vulkan::runtime_vk::render_technique(technique &technique)
 	if (impl->has_compute_passes)
 		vk.CmdBindDescriptorSets(cmd_list, VK_PIPELINE_BIND_POINT_COMPUTE, effect_data.pipeline_layout, 0, 1, &effect_data.ubo_set, 0, nullptr);
 
-	// Setup shader constants
-	if (effect_data.ubo != VK_NULL_HANDLE)
-		vk.CmdUpdateBuffer(cmd_list, effect_data.ubo, 0, _effects[technique.effect_index].uniform_data_storage.size(), _effects[technique.effect_index].uniform_data_storage.data());
+	// Setup shader constants (only update the parts that changed since the last technique of this effect was rendered)
+	if (effect &effect = _effects[technique.effect_index]; effect_data.ubo != VK_NULL_HANDLE)
+	{
+		for (const auto &[begin, end] : effect.uniform_data_dirty.ranges)
+			vk.CmdUpdateBuffer(cmd_list, effect_data.ubo, begin, end - begin, effect.uniform_data_storage.data() + begin);
+		effect.uniform_data_dirty.clear();
+	}
 
 #if RESHADE_DEPTH
 	if (_depth_image != VK_NULL_HANDLE)
@@ -2592,15 +2678,20 @@ void reshade::vulkan::runtime_vk::update_depth_image_bindings(state_tracking::de
 	// Update image bindings
 	std::vector<VkWriteDescriptorSet> writes;
 
-	for (effect_data &effect_data : _effect_data)
+	// Includes effects that are still being created, whose passes that were not initialized yet take the view from the effect bindings
+	for (const effect *effect : effects_with_device_objects())
 	{
-		for (const auto [binding, sets] : effect_data.depth_image_bindings)
+		effect_data &effect_data = *static_cast<struct effect_data *>(effect->impl);
+
+		for (const auto &[binding, sets] : effect_data.depth_image_bindings)
 		{
+			effect_data.sampler_bindings[binding].imageView = image_binding.imageView;
+
 			for (VkDescriptorSet set : sets)
 			{
 				// Set sampler handle, which should be the same for all writes
-				assert(image_binding.sampler == VK_NULL_HANDLE || image_binding.sampler == effect_data.image_bindings[binding].sampler);
-				image_binding.sampler = effect_data.image_bindings[binding].sampler;
+				assert(image_binding.sampler == VK_NULL_HANDLE || image_binding.sampler == effect_data.sampler_bindings[binding].sampler);
+				image_binding.sampler = effect_data.sampler_bindings[binding].sampler;
 
 				VkWriteDescriptorSet& write = writes.emplace_back();
 				write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
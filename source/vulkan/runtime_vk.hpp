@@ -34,12 +34,18 @@ namespace reshade::vulkan
 		const VkLayerDispatchTable vk;
 
 	private:
-		bool init_effect(size_t index) override;
-		void unload_effect(size_t index) override;
+		bool compile_entry_point(const effect &effect, const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &assembly, std::string &errors) const override;
+		bool init_effect(effect &effect) override;
+		bool init_technique(effect &effect, technique &technique) override;
+		bool init_pass(effect &effect, technique &technique, size_t pass_index) override;
+		void destroy_technique(technique &technique) override;
+		void destroy_effect(effect &effect) override;
 		void unload_effects() override;
 
 		bool init_texture(texture &texture) override;
 		void upload_texture(const texture &texture, const uint8_t *pixels) override;
+		void upload_texture_levels(const texture &texture, const uint8_t *data) override;
+		bool supports_compressed_format(reshadefx::texture_format format) const override;
 		void destroy_texture(texture &texture) override;
 		void generate_mipmaps(const struct tex_data *impl);
 
@@ -67,6 +73,7 @@ namespace reshade::vulkan
 		const uint32_t _queue_family_index;
 		VkPhysicalDeviceProperties _device_props = {};
 		VkPhysicalDeviceMemoryProperties _memory_props = {};
+		uint32_t _supported_compressed_formats = 0; // Bit mask of block-compressed 'reshadefx::texture_format' values that can be sampled from
 		state_tracking_context &_state_tracking;
 
 		VkFence _cmd_fences[NUM_COMMAND_FRAMES + 1] = {};
@@ -95,7 +102,6 @@ namespace reshade::vulkan
 		VkImage _effect_stencil = VK_NULL_HANDLE;
 		VkFormat _effect_stencil_format = VK_FORMAT_UNDEFINED;
 		VkImageView _effect_stencil_view = VK_NULL_HANDLE;
-		std::vector<struct effect_data> _effect_data;
 		VkDescriptorPool _effect_descriptor_pool = VK_NULL_HANDLE;
 		VkDescriptorSetLayout _effect_descriptor_layout = VK_NULL_HANDLE;
 		std::unordered_map<size_t, VkSampler> _effect_sampler_states;
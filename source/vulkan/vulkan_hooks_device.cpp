@@ -96,6 +96,8 @@ VkResult VKAPI_CALL vkCreateDevice(VkPhysicalDevice physicalDevice, const VkDevi
 	assert(enum_queue_families != nullptr);
 	auto enum_device_extensions = s_instance_dispatch.at(dispatch_key_from_handle(physicalDevice)).EnumerateDeviceExtensionProperties;
 	assert(enum_device_extensions != nullptr);
+	auto get_device_features = s_instance_dispatch.at(dispatch_key_from_handle(physicalDevice)).GetPhysicalDeviceFeatures;
+	assert(get_device_features != nullptr);
 
 	uint32_t num_queue_families = 0;
 	enum_queue_families(physicalDevice, &num_queue_families, nullptr);
@@ -178,6 +180,12 @@ VkResult VKAPI_CALL vkCreateDevice(VkPhysicalDevice physicalDevice, const VkDevi
 		enabled_features.shaderImageGatherExtended = true;
 		enabled_features.shaderStorageImageWriteWithoutFormat = true;
 
+		// Enable optional features that ReShade can make use of if they are available
+		VkPhysicalDeviceFeatures supported_features = {};
+		get_device_features(physicalDevice, &supported_features);
+		if (supported_features.textureCompressionBC)
+			enabled_features.textureCompressionBC = true; // Used to upload block-compressed DDS textures as is
+
 		// Enable extensions that ReShade requires
 		add_extension(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, false); // This is optional, see imgui code in 'runtime_vk'
 		add_extension(VK_KHR_IMAGE_FORMAT_LIST_EXTENSION_NAME, true);
@@ -93,6 +93,7 @@ VkResult VKAPI_CALL vkCreateInstance(const VkInstanceCreateInfo *pCreateInfo, co
 	// ---- Core 1_0 commands
 	INIT_INSTANCE_PROC(DestroyInstance);
 	INIT_INSTANCE_PROC(EnumeratePhysicalDevices);
+	INIT_INSTANCE_PROC(GetPhysicalDeviceFeatures);
 	INIT_INSTANCE_PROC(GetPhysicalDeviceFormatProperties);
 	INIT_INSTANCE_PROC(GetPhysicalDeviceProperties);
 	INIT_INSTANCE_PROC(GetPhysicalDeviceMemoryProperties);
@@ -0,0 +1,19 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <cstdio>
+
+// Number of checks that failed so far, which the test returns from 'main'
+inline int g_failed_checks = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+			++g_failed_checks; \
+		} \
+	} while (false)
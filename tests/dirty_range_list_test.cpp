@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "check.hpp"
+#include "runtime_objects.hpp"
+#include <random>
+
+using range = std::pair<size_t, size_t>;
+
+static void test_merge()
+{
+	reshade::dirty_range_list list;
+	CHECK(list.empty());
+
+	list.add(16, 32);
+	list.add(64, 80);
+	CHECK((list.ranges == std::vector<range> { { 16, 32 }, { 64, 80 } }));
+
+	// Inserted in front, without touching the others
+	list.add(0, 8);
+	CHECK((list.ranges == std::vector<range> { { 0, 8 }, { 16, 32 }, { 64, 80 } }));
+
+	// Contained in an existing range
+	list.add(20, 24);
+	CHECK((list.ranges == std::vector<range> { { 0, 8 }, { 16, 32 }, { 64, 80 } }));
+
+	// Touching ranges on both sides are merged
+	list.add(8, 16);
+	CHECK((list.ranges == std::vector<range> { { 0, 32 }, { 64, 80 } }));
+
+	// Overlapping multiple ranges
+	list.add(30, 100);
+	CHECK((list.ranges == std::vector<range> { { 0, 100 } }));
+
+	list.clear();
+	CHECK(list.empty());
+}
+
+static void test_collapse()
+{
+	reshade::dirty_range_list list;
+
+	for (size_t i = 0; i < reshade::dirty_range_list::max_ranges; ++i)
+		list.add(i * 32, i * 32 + 4);
+	CHECK(list.ranges.size() == reshade::dirty_range_list::max_ranges);
+
+	// One range too many collapses everything into a single range spanning all of them
+	list.add(1000, 1004);
+	CHECK((list.ranges == std::vector<range> { { 0, 1004 } }));
+}
+
+static void test_random()
+{
+	std::mt19937 rng(42);
+
+	for (size_t iteration = 0; iteration < 1000; ++iteration)
+	{
+		reshade::dirty_range_list list;
+		bool reference[256] = {};
+		bool collapsed = false;
+
+		for (size_t k = 0; k < 12; ++k)
+		{
+			const size_t begin = rng() % 256;
+			const size_t end = std::min<size_t>(begin + 1 + rng() % 16, 256);
+			std::fill(reference + begin, reference + end, true);
+
+			list.add(begin, end);
+			collapsed |= list.ranges.size() == 1 && list.ranges[0].second - list.ranges[0].first != static_cast<size_t>(std::count(reference, reference + 256, true));
+
+			// Ranges have to be sorted, disjoint and not touching each other
+			CHECK(!list.ranges.empty() && list.ranges.size() <= reshade::dirty_range_list::max_ranges);
+			for (size_t i = 1; i < list.ranges.size(); ++i)
+				CHECK(list.ranges[i - 1].second < list.ranges[i].first);
+
+			// Every modified byte has to be covered, and as long as the list did not collapse, nothing else may be
+			bool covered[256] = {};
+			for (const range &r : list.ranges)
+				std::fill(covered + r.first, covered + r.second, true);
+			for (size_t i = 0; i < 256; ++i)
+				CHECK(reference[i] ? covered[i] : (collapsed || !covered[i]));
+		}
+	}
+}
+
+int main()
+{
+	test_merge();
+	test_collapse();
+	test_random();
+
+	return g_failed_checks != 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "check.hpp"
+#include "runtime_objects.hpp"
+#include "task_scheduler.hpp"
+#include "entry_point_compiler.hpp"
+#include <set>
+#include <mutex>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+static reshade::effect make_effect(size_t num_entry_points)
+{
+	reshade::effect effect;
+	effect.compiled = true;
+	effect.errors = "warning: from parser\n";
+
+	for (size_t i = 0; i < num_entry_points; ++i)
+		effect.module.entry_points.push_back({ "main" + std::to_string(i), i % 2 == 0 ? reshadefx::shader_type::vs : reshadefx::shader_type::ps });
+
+	return effect;
+}
+
+// Stands in for 'runtime::compile_entry_point', which calls the shader compiler of the back-end
+// Later entry points finish first, so that results have to be put back in order
+struct stub_compiler
+{
+	size_t num_entry_points = 0;
+	std::string failing_entry_point;
+	std::mutex mutex;
+	std::set<std::string> compiled;
+	std::set<std::thread::id> threads;
+
+	bool operator()(const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &assembly, std::string &errors)
+	{
+		const size_t index = std::stoul(entry_point.name.substr(4));
+		std::this_thread::sleep_for(std::chrono::milliseconds(num_entry_points - index));
+
+		{	const std::lock_guard<std::mutex> lock(mutex);
+			compiled.insert(entry_point.name);
+			threads.insert(std::this_thread::get_id());
+		}
+
+		cso.assign(entry_point.name.begin(), entry_point.name.end());
+		assembly = "asm " + entry_point.name;
+		errors = "warning: " + entry_point.name + "\n";
+
+		if (entry_point.name == failing_entry_point)
+		{
+			errors += "error: " + entry_point.name + "\n";
+			return false;
+		}
+
+		return true;
+	}
+};
+
+static std::string expected_errors(size_t num_entry_points, const std::string &failing_entry_point = {})
+{
+	std::string errors = "warning: from parser\n";
+	for (size_t i = 0; i < num_entry_points; ++i)
+	{
+		errors += "warning: main" + std::to_string(i) + "\n";
+		if (failing_entry_point == "main" + std::to_string(i))
+			errors += "error: " + failing_entry_point + "\n";
+	}
+	return errors;
+}
+
+static void test_merges_in_order(size_t num_threads)
+{
+	const size_t num_entry_points = 16;
+	reshade::effect effect = make_effect(num_entry_points);
+
+	stub_compiler compiler;
+	compiler.num_entry_points = num_entry_points;
+
+	std::atomic<size_t> num_continuations = 0;
+	size_t num_compiled_in_continuation = 0;
+	{
+		reshade::task_scheduler worker_pool(num_threads);
+
+		reshade::compile_entry_points_parallel(worker_pool, effect,
+			[&compiler](const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &assembly, std::string &errors) {
+				return compiler(entry_point, cso, assembly, errors);
+			},
+			[&]() {
+				num_continuations++;
+				const std::lock_guard<std::mutex> lock(compiler.mutex);
+				num_compiled_in_continuation = compiler.compiled.size();
+			});
+
+		worker_pool.wait_idle();
+	}
+
+	// The continuation runs exactly once, after every entry point was compiled
+	CHECK(num_continuations == 1);
+	CHECK(num_compiled_in_continuation == num_entry_points);
+	CHECK(num_threads == 1 || compiler.threads.size() > 1);
+
+	CHECK(effect.compiled);
+	CHECK(effect.errors == expected_errors(num_entry_points));
+	CHECK(effect.bytecode.size() == num_entry_points);
+	CHECK(effect.assembly.size() == num_entry_points);
+
+	for (size_t i = 0; i < num_entry_points; ++i)
+	{
+		const std::string &name = effect.module.entry_points[i].name;
+		CHECK(std::string(effect.bytecode[i].begin(), effect.bytecode[i].end()) == name);
+		CHECK(effect.assembly[name] == "asm " + name);
+	}
+}
+
+static void test_failure_discards_byte_code()
+{
+	const size_t num_entry_points = 8;
+	reshade::effect effect = make_effect(num_entry_points);
+
+	stub_compiler compiler;
+	compiler.num_entry_points = num_entry_points;
+	compiler.failing_entry_point = "main5";
+
+	bool compiled_in_continuation = true;
+	{
+		reshade::task_scheduler worker_pool(4);
+
+		reshade::compile_entry_points_parallel(worker_pool, effect,
+			[&compiler](const reshadefx::entry_point &entry_point, std::vector<char> &cso, std::string &assembly, std::string &errors) {
+				return compiler(entry_point, cso, assembly, errors);
+			},
+			[&]() { compiled_in_continuation = effect.compiled; });
+
+		worker_pool.wait_idle();
+	}
+
+	// All entry points are still compiled, so that all errors are reported, but none of the byte code is kept
+	CHECK(compiler.compiled.size() == num_entry_points);
+	CHECK(!effect.compiled && !compiled_in_continuation);
+	CHECK(effect.bytecode.empty());
+	CHECK(effect.errors == expected_errors(num_entry_points, "main5"));
+	CHECK(effect.assembly.find("main5") == effect.assembly.end());
+}
+
+static void test_no_entry_points()
+{
+	reshade::effect effect = make_effect(0);
+
+	bool called = false;
+	{
+		reshade::task_scheduler worker_pool(2);
+
+		reshade::compile_entry_points_parallel(worker_pool, effect,
+			[](const reshadefx::entry_point &, std::vector<char> &, std::string &, std::string &) { return false; },
+			[&called]() { called = true; });
+
+		worker_pool.wait_idle();
+	}
+
+	CHECK(called);
+	CHECK(effect.compiled);
+	CHECK(effect.bytecode.empty());
+}
+
+int main()
+{
+	for (const size_t num_threads : { 1, 2, 4 })
+		test_merges_in_order(num_threads);
+
+	test_failure_discards_byte_code();
+	test_no_entry_points();
+
+	return g_failed_checks != 0;
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "check.hpp"
+#include "image_processing.hpp"
+#include <cmath>
+#include <limits>
+#include <random>
+#include <algorithm>
+
+using namespace reshade::image;
+
+static const reshadefx::texture_format s_formats[] = {
+	reshadefx::texture_format::r8,
+	reshadefx::texture_format::r16f,
+	reshadefx::texture_format::rg8,
+	reshadefx::texture_format::rg16f,
+	reshadefx::texture_format::rgba8,
+	reshadefx::texture_format::rgba16f,
+	reshadefx::texture_format::rgb10a2,
+};
+
+static size_t channel_count(reshadefx::texture_format format)
+{
+	switch (format)
+	{
+	case reshadefx::texture_format::r8:
+	case reshadefx::texture_format::r16f:
+		return 1;
+	case reshadefx::texture_format::rg8:
+	case reshadefx::texture_format::rg16f:
+		return 2;
+	default:
+		return 4;
+	}
+}
+static size_t pixel_size(reshadefx::texture_format format)
+{
+	switch (format)
+	{
+	case reshadefx::texture_format::r16f:
+	case reshadefx::texture_format::rg16f:
+	case reshadefx::texture_format::rgba16f:
+		return channel_count(format) * 2;
+	case reshadefx::texture_format::rgb10a2:
+		return 4;
+	default:
+		return channel_count(format);
+	}
+}
+static bool is_8bit_format(reshadefx::texture_format format)
+{
+	return format == reshadefx::texture_format::r8 || format == reshadefx::texture_format::rg8 || format == reshadefx::texture_format::rgba8;
+}
+
+static void test_unpack(std::mt19937 &rng)
+{
+	// Every possible byte value in every channel, followed by a remainder that does not fill a whole vector
+	std::vector<uint8_t> pixels(259 * 4);
+	for (size_t i = 0; i < pixels.size(); ++i)
+		pixels[i] = i < 256 * 4 ? static_cast<uint8_t>(i / 4) : static_cast<uint8_t>(rng());
+
+	for (const bool srgb : { false, true })
+	{
+		for (size_t count = 0; count <= pixels.size() / 4; count += (count < 16 ? 1 : 61))
+		{
+			std::vector<float> expected(count * 4 + 1, -1.0f), actual(count * 4 + 1, -1.0f);
+			reference::unpack_rgba8(pixels.data(), count, srgb, expected.data());
+			unpack_rgba8(pixels.data(), count, srgb, actual.data());
+
+			CHECK(actual == expected);
+			CHECK(actual.back() == -1.0f); // Nothing was written past the end
+		}
+	}
+}
+
+static void test_pack(std::mt19937 &rng)
+{
+	// Mostly values in the normalized range, but also some that have to be clamped and some that are special for half-precision conversion
+	const float special_values[] = {
+		0.0f, -0.0f, 1.0f, -1.0f, 2.0f, 0.5f, 65504.0f, 65520.0f, -65520.0f, 1e-5f, -1e-5f, 6.1e-5f, 1e-8f, 1e30f,
+		std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::denorm_min(),
+	};
+
+	std::vector<float> values(203 * 4);
+	for (size_t i = 0; i < values.size(); ++i)
+		values[i] = (rng() % 8) == 0 ?
+			special_values[rng() % std::size(special_values)] :
+			std::uniform_real_distribution<float>(-0.1f, 1.1f)(rng);
+
+	for (const reshadefx::texture_format format : s_formats)
+	{
+		CHECK(is_convertible_format(format));
+
+		for (const bool srgb : { false, true })
+		{
+			for (size_t count = 0; count <= values.size() / 4; count += (count < 16 ? 1 : 31))
+			{
+				std::vector<uint8_t> expected(count * pixel_size(format) + 1, 0xCD), actual(count * pixel_size(format) + 1, 0xCD);
+				reference::pack(values.data(), count, format, srgb, expected.data());
+				pack(values.data(), count, format, srgb, actual.data());
+
+				CHECK(actual.back() == 0xCD); // Nothing was written past the end
+
+				if (srgb && is_8bit_format(format))
+				{
+					// Color channels are encoded through a lookup table, which may round differently close to the middle between two values
+					for (size_t i = 0; i < expected.size(); ++i)
+						CHECK(std::abs(actual[i] - expected[i]) <= 1);
+				}
+				else
+				{
+					CHECK(actual == expected);
+				}
+			}
+		}
+	}
+
+	// Decoding and encoding sRGB colors again has to return the original values exactly
+	std::vector<uint8_t> pixels(256 * 4), result(256 * 4);
+	for (size_t i = 0; i < pixels.size(); ++i)
+		pixels[i] = static_cast<uint8_t>(i / 4);
+	std::vector<float> linear(pixels.size());
+	unpack_rgba8(pixels.data(), 256, true, linear.data());
+	pack(linear.data(), 256, reshadefx::texture_format::rgba8, true, result.data());
+	CHECK(result == pixels);
+}
+
+static void test_float_to_half()
+{
+	CHECK(reference::float_to_half(0.0f) == 0x0000);
+	CHECK(reference::float_to_half(-0.0f) == 0x8000);
+	CHECK(reference::float_to_half(1.0f) == 0x3C00);
+	CHECK(reference::float_to_half(-2.0f) == 0xC000);
+	CHECK(reference::float_to_half(0.5f) == 0x3800);
+	CHECK(reference::float_to_half(65504.0f) == 0x7BFF);
+	CHECK(reference::float_to_half(65520.0f) == 0x7C00); // Rounds to infinity
+	CHECK(reference::float_to_half(std::numeric_limits<float>::infinity()) == 0x7C00);
+	CHECK(reference::float_to_half(std::numeric_limits<float>::quiet_NaN()) == 0x7E00);
+	CHECK(reference::float_to_half(std::ldexp(1.0f, -24)) == 0x0001); // Smallest subnormal
+	CHECK(reference::float_to_half(std::ldexp(1.0f, -14)) == 0x0400); // Smallest normal
+	CHECK(reference::float_to_half(1.0f + std::ldexp(1.0f, -11)) == 0x3C00); // Ties round to even
+	CHECK(reference::float_to_half(1.0f + 3 * std::ldexp(1.0f, -11)) == 0x3C02);
+}
+
+static void test_downsample(std::mt19937 &rng)
+{
+	const uint32_t sizes[][2] = { { 1, 1 }, { 2, 2 }, { 3, 1 }, { 1, 5 }, { 7, 3 }, { 16, 16 }, { 33, 17 }, { 64, 9 } };
+
+	for (const mipmap_filter filter : { mipmap_filter::box, mipmap_filter::kaiser })
+	{
+		for (const auto &[width, height] : sizes)
+		{
+			std::vector<float> src(size_t(width) * height * 4);
+			for (float &value : src)
+				value = std::uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+
+			const size_t dst_size = size_t(std::max(width / 2, 1u)) * std::max(height / 2, 1u) * 4;
+			std::vector<float> expected(dst_size + 1, -1.0f), actual(dst_size + 1, -1.0f); // Last element checks that nothing was written past the end
+			reference::downsample(src.data(), width, height, filter, expected.data());
+			downsample(src.data(), width, height, filter, actual.data());
+
+			CHECK(actual == expected); // Both sum up the same products in the same order
+		}
+
+		// A flat image has to stay flat, since the filter weights are normalized
+		std::vector<float> flat(16 * 16 * 4, 0.25f), result(8 * 8 * 4);
+		downsample(flat.data(), 16, 16, filter, result.data());
+		for (const float value : result)
+			CHECK(std::abs(value - 0.25f) <= 1e-6f);
+	}
+}
+
+static void test_generate_mipmaps(std::mt19937 &rng)
+{
+	const uint32_t width = 37, height = 20, levels = 7; // Last levels are clamped to a size of one pixel in one dimension
+
+	std::vector<uint8_t> pixels(size_t(width) * height * 4);
+	for (uint8_t &value : pixels)
+		value = static_cast<uint8_t>(rng());
+
+	for (const reshadefx::texture_format format : s_formats)
+	{
+		for (const mipmap_filter filter : { mipmap_filter::box, mipmap_filter::kaiser })
+		{
+			for (const bool srgb : { false, true })
+			{
+				const std::vector<uint8_t> actual = generate_mipmaps(pixels.data(), width, height, levels, format, filter, srgb);
+
+				// Same chain of operations, but using only the reference implementations
+				std::vector<uint8_t> expected;
+				std::vector<float> current(pixels.size()), next;
+				reference::unpack_rgba8(pixels.data(), size_t(width) * height, srgb, current.data());
+				for (uint32_t level = 0; level < levels; ++level)
+				{
+					const uint32_t level_width = std::max(width >> level, 1u);
+					const uint32_t level_height = std::max(height >> level, 1u);
+
+					const size_t offset = expected.size();
+					expected.resize(offset + pixel_size(format) * level_width * level_height);
+					reference::pack(current.data(), size_t(level_width) * level_height, format, srgb, expected.data() + offset);
+
+					next.resize(size_t(std::max(level_width / 2, 1u)) * std::max(level_height / 2, 1u) * 4);
+					reference::downsample(current.data(), level_width, level_height, filter, next.data());
+					current.swap(next);
+				}
+
+				CHECK(actual.size() == expected.size());
+				if (actual.size() != expected.size())
+					continue;
+
+				if (srgb && is_8bit_format(format))
+				{
+					for (size_t i = 0; i < expected.size(); ++i)
+						CHECK(std::abs(actual[i] - expected[i]) <= 1);
+				}
+				else
+				{
+					CHECK(actual == expected);
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(42);
+
+	test_unpack(rng);
+	test_pack(rng);
+	test_float_to_half();
+	test_downsample(rng);
+	test_generate_mipmaps(rng);
+
+	return g_failed_checks != 0;
+}
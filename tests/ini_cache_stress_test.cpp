@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "check.hpp"
+#include "dll_config.hpp"
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+
+std::filesystem::path g_reshade_dll_path;
+std::filesystem::path g_reshade_base_path;
+std::filesystem::path g_target_executable_path;
+
+// Every value consists of identical elements, so that a read that observes a partially applied change is detected
+static bool is_consistent(const std::vector<int> &elements)
+{
+	return !elements.empty() && std::all_of(elements.begin(), elements.end(), [&elements](int element) { return element == elements[0]; });
+}
+
+int main()
+{
+	const std::filesystem::path test_path = std::filesystem::temp_directory_path() / "reshade_ini_cache_stress_test";
+	std::filesystem::remove_all(test_path);
+	std::filesystem::create_directories(test_path);
+
+	constexpr size_t num_files = 4;
+	constexpr size_t num_iterations = 2000;
+
+	std::filesystem::path modified_paths[num_files];
+	for (size_t i = 0; i < num_files; ++i)
+		modified_paths[i] = test_path / ("modified" + std::to_string(i) + ".ini");
+
+	// A file that is only changed on disk, so that it keeps being reloaded while other threads read it
+	const std::filesystem::path reloaded_path = test_path / "reloaded.ini";
+	// Replace it in one go, like the cache does, so that it is never observed partially written
+	const auto write_reloaded_file = [&reloaded_path](int value, std::filesystem::file_time_type modified_at) {
+		std::filesystem::path temp_path = reloaded_path;
+		temp_path += ".tmp";
+		const std::string element = std::to_string(value);
+		std::ofstream(temp_path) << "[Section]\nValue=" << element << ',' << element << ',' << element << ',' << element << '\n';
+		std::filesystem::last_write_time(temp_path, modified_at);
+		std::filesystem::rename(temp_path, reloaded_path);
+	};
+
+	// Use modification times in the past, since the cache does not reload files that changed within the last second
+	const std::filesystem::file_time_type base_time = std::filesystem::file_time_type::clock::now() - std::chrono::minutes(1);
+	write_reloaded_file(0, base_time);
+
+	std::atomic<bool> stop = false;
+	std::atomic<size_t> inconsistent_reads = 0;
+	std::atomic<size_t> missing_reads = 0;
+	std::atomic<size_t> reloaded_reads = 0;
+	std::vector<std::thread> threads;
+
+	// Threads that change and read the files in the cache
+	for (size_t t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&, t]() {
+			for (size_t i = 0; i < num_iterations; ++i)
+			{
+				reshade::ini_file &file = reshade::ini_file::load_cache(modified_paths[(t + i) % num_files]);
+
+				const int value = static_cast<int>(t * num_iterations + i);
+				const int values[4] = { value, value, value, value };
+				file.set("Section", "Key" + std::to_string(i % 8), values);
+
+				std::vector<int> elements;
+				if (!file.get("Section", "Key" + std::to_string((i + 4) % 8), elements))
+					continue; // Key may not have been set by any thread yet
+				if (!is_consistent(elements))
+					inconsistent_reads++;
+			}
+		});
+	}
+
+	// Threads that read the file which keeps being reloaded
+	for (size_t t = 0; t < 2; ++t)
+	{
+		threads.emplace_back([&]() {
+			while (!stop)
+			{
+				const reshade::ini_file &file = reshade::ini_file::load_cache(reloaded_path);
+
+				std::vector<int> elements;
+				if (!file.get("Section", "Value", elements))
+					missing_reads++;
+				else if (!is_consistent(elements))
+					inconsistent_reads++;
+				else if (elements[0] != 0)
+					reloaded_reads++;
+			}
+		});
+	}
+
+	// Thread that changes the reloaded file on disk
+	threads.emplace_back([&]() {
+		for (int i = 1; i <= 200; ++i)
+		{
+			write_reloaded_file(i, base_time + std::chrono::milliseconds(i));
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	// Thread that keeps flushing the cache, like the render thread does every frame
+	threads.emplace_back([&]() {
+		while (!stop)
+			reshade::ini_file::flush_cache();
+	});
+
+	for (size_t t = 0; t < 4; ++t)
+		threads[t].join();
+	threads[6].join();
+	stop = true;
+	for (size_t t = 4; t < threads.size(); ++t)
+		if (threads[t].joinable())
+			threads[t].join();
+
+	CHECK(inconsistent_reads == 0);
+	CHECK(missing_reads == 0);
+	CHECK(reloaded_reads != 0);
+
+	// The last value set for every key has to end up on disk
+	for (size_t i = 0; i < num_files; ++i)
+	{
+		CHECK(reshade::ini_file::flush_cache(modified_paths[i]));
+
+		const reshade::ini_file &cached = reshade::ini_file::load_cache(modified_paths[i]);
+		const reshade::ini_file written(modified_paths[i]);
+
+		for (size_t k = 0; k < 8; ++k)
+		{
+			std::vector<int> cached_elements, written_elements;
+			CHECK(cached.get("Section", "Key" + std::to_string(k), cached_elements));
+			CHECK(written.get("Section", "Key" + std::to_string(k), written_elements));
+			CHECK(is_consistent(written_elements) && cached_elements == written_elements);
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::remove_all(test_path, ec);
+
+	return g_failed_checks != 0;
+}
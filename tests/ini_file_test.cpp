@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "check.hpp"
+#include "dll_config.hpp"
+#include <fstream>
+#include <random>
+#include <sstream>
+
+std::filesystem::path g_reshade_dll_path;
+std::filesystem::path g_reshade_base_path;
+std::filesystem::path g_target_executable_path;
+
+static std::filesystem::path s_test_path;
+
+static void write_text(const std::filesystem::path &path, const std::string &text)
+{
+	std::ofstream(path, std::ios::binary) << text;
+}
+static std::string read_text(const std::filesystem::path &path)
+{
+	std::stringstream text;
+	text << std::ifstream(path, std::ios::binary).rdbuf();
+	return text.str();
+}
+
+static void test_parse()
+{
+	const std::filesystem::path path = s_test_path / "parse.ini";
+	write_text(path,
+		"\xef\xbb\xbf" "global=1\r\n"
+		"; Comment\r\n"
+		"# Comment\n"
+		"// Comment\n"
+		"\n"
+		"[ Section ]\n"
+		"  Spaces  =  a b  \n"
+		"List=1,2.5,-3\n"
+		"Escaped=a,,b,c,,,,d,,\n"
+		"Empty=\n"
+		"Flag\n"
+		"List=4\n"
+		"[Other]\r\n"
+		"Path=C:\\Some Folder\\File.fx\r\n");
+
+	const reshade::ini_file file(path);
+
+	CHECK(file.has("", "global"));
+	CHECK(file.get("", "global"));
+	CHECK(file.has("Section", "Spaces"));
+	CHECK(file.has("Section", "Flag"));
+	CHECK(!file.has("Section", "Missing"));
+	CHECK(!file.has("Missing", "Spaces"));
+
+	std::string spaces;
+	CHECK(file.get("Section", "Spaces", spaces) && spaces == "a b");
+
+	// Keys that appear multiple times have their values appended
+	std::vector<std::string> list;
+	CHECK(file.get("Section", "List", list) && (list == std::vector<std::string> { "1", "2.5", "-3", "4" }));
+
+	int ints[5] = { 9, 9, 9, 9, 9 };
+	CHECK(file.get("Section", "List", ints) && ints[0] == 1 && ints[1] == 2 && ints[2] == -3 && ints[3] == 4 && ints[4] == 0);
+	float floats[5] = {};
+	CHECK(file.get("Section", "List", floats) && floats[0] == 1.0f && floats[1] == 2.5f && floats[2] == -3.0f && floats[3] == 4.0f && floats[4] == 0.0f);
+	unsigned int uints[2] = {};
+	CHECK(file.get("Section", "List", uints, 2) && uints[0] == 1 && uints[1] == 2);
+
+	// ",," is an escaped comma that does not separate elements
+	std::vector<std::string> escaped;
+	CHECK(file.get("Section", "Escaped", escaped) && (escaped == std::vector<std::string> { "a,b", "c,,d," }));
+
+	std::vector<std::string> empty;
+	CHECK(file.get("Section", "Empty", empty) && (empty == std::vector<std::string> { "" }));
+
+	std::filesystem::path value_path;
+	CHECK(file.get("Other", "Path", value_path) && value_path.u8string() == "C:\\Some Folder\\File.fx");
+}
+
+// Splits a value into elements character by character, which is how values were parsed before parsing was changed to work on views into the file data
+static std::vector<std::string> split_reference(const std::string &value)
+{
+	std::vector<std::string> elements;
+	for (size_t offset = 0, base = 0, len = value.size(); offset <= len;)
+	{
+		const size_t found = std::min(value.find_first_of(',', offset), len);
+		if (found + 1 < len && value[found + 1] == ',')
+		{
+			offset = found + 2;
+		}
+		else
+		{
+			std::string &element = elements.emplace_back();
+			while (base < found)
+			{
+				const char c = value[base++];
+				element += c;
+				if (c == ',' && base < found && value[base] == ',')
+					base++;
+			}
+			base = offset = found + 1;
+		}
+	}
+	return elements;
+}
+
+static void test_parse_escapes()
+{
+	const std::filesystem::path path = s_test_path / "escapes.ini";
+
+	// Generate values with random sequences of commas
+	std::mt19937 rng(42);
+	std::vector<std::string> values(1000);
+	std::string text = "[Values]\n";
+	for (size_t i = 0; i < values.size(); ++i)
+	{
+		for (size_t k = rng() % 12; k != 0; --k)
+			values[i] += "ab,"[rng() % 3];
+		text += std::to_string(i) + '=' + values[i] + '\n';
+	}
+	write_text(path, text);
+
+	const reshade::ini_file file(path);
+
+	for (size_t i = 0; i < values.size(); ++i)
+	{
+		std::vector<std::string> elements;
+		CHECK(file.get("Values", std::to_string(i), elements) && elements == split_reference(values[i]));
+	}
+}
+
+static void test_round_trip()
+{
+	const std::filesystem::path path = s_test_path / "round_trip.ini";
+
+	// Escaping cannot represent elements that start or end with a comma or empty elements between others, so those are not tested
+	const std::vector<std::string> elements = { "", "a,b", "x,,y", "1,2,3", "plain", "" };
+	const float floats[3] = { 0.5f, -2.0f, 1000.25f };
+
+	{	reshade::ini_file &file = reshade::ini_file::load_cache(path);
+		file.set("b", "Elements", elements);
+		file.set("b", "Floats", floats);
+		file.set("b", "Int", 42);
+		file.set("b", "Bool", true);
+		file.set("A", "text", std::string("x"));
+		file.set("", "global", std::string("y"));
+		CHECK(reshade::ini_file::flush_cache(path));
+	}
+
+	// Sections and keys are sorted without regard to case, with the global section first
+	CHECK(read_text(path) ==
+		"global=y\n\n"
+		"[A]\n"
+		"text=x\n\n"
+		"[b]\n"
+		"Bool=1\n"
+		"Elements=,a,,b,x,,,,y,1,,2,,3,plain,\n"
+		"Floats=0.500000,-2.000000,1000.250000\n"
+		"Int=42\n\n");
+
+	// Read back with a separate instance that parses the written file
+	const reshade::ini_file file(path);
+
+	std::vector<std::string> read_elements;
+	CHECK(file.get("b", "Elements", read_elements) && read_elements == elements);
+	float read_floats[3] = {};
+	CHECK(file.get("b", "Floats", read_floats) && std::equal(floats, floats + 3, read_floats));
+	int read_int = 0;
+	CHECK(file.get("b", "Int", read_int) && read_int == 42);
+	CHECK(file.get("b", "Bool"));
+	std::string read_text_value;
+	CHECK(file.get("A", "text", read_text_value) && read_text_value == "x");
+}
+
+static void test_snapshot()
+{
+	const std::filesystem::path path = s_test_path / "snapshot.ini";
+	write_text(path, "[A]\nkey=1\n\n");
+
+	reshade::ini_file &file = reshade::ini_file::load_cache(path);
+
+	{	reshade::ini_file copy(file);
+		CHECK(copy.path() == path);
+		CHECK(copy.get("A", "key"));
+
+		// Changing a copy neither affects the original nor the file on disk
+		copy.set("A", "key", 2);
+		int value = 0;
+		CHECK(copy.get("A", "key", value) && value == 2);
+		CHECK(file.get("A", "key", value) && value == 1);
+	}
+
+	CHECK(reshade::ini_file::flush_cache(path));
+	CHECK(read_text(path) == "[A]\nkey=1\n\n");
+
+	// But changes to the original are written
+	file.set("A", "key", 3);
+	CHECK(reshade::ini_file::flush_cache(path));
+	CHECK(read_text(path) == "[A]\nkey=3\n\n");
+}
+
+static void test_save_copy()
+{
+	const std::filesystem::path path = s_test_path / "original.ini";
+	const std::filesystem::path copy_path = s_test_path / "copy.ini";
+	write_text(path, "[A]\nkey=1\n\n");
+
+	reshade::ini_file &file = reshade::ini_file::load_cache(path);
+	file.set("A", "key", 2);
+
+	// A snapshot keeps the contents it was taken with, even if the original changes before it is written
+	const reshade::ini_file snapshot(file);
+	file.set("A", "key", 3);
+
+	CHECK(snapshot.save_copy(copy_path));
+	CHECK(read_text(copy_path) == "[A]\nkey=2\n\n");
+	// Writing a copy neither writes nor resets the modifications of the original
+	CHECK(read_text(path) == "[A]\nkey=1\n\n");
+	CHECK(reshade::ini_file::flush_cache(path));
+	CHECK(read_text(path) == "[A]\nkey=3\n\n");
+
+	// Another instance that opens the copy has to load what was written
+	int value = 0;
+	CHECK(reshade::ini_file::load_cache(copy_path).get("A", "key", value) && value == 2);
+}
+
+int main()
+{
+	s_test_path = std::filesystem::temp_directory_path() / "reshade_ini_file_test";
+	std::filesystem::remove_all(s_test_path);
+	std::filesystem::create_directories(s_test_path);
+
+	test_parse();
+	test_parse_escapes();
+	test_round_trip();
+	test_snapshot();
+	test_save_copy();
+
+	std::error_code ec;
+	std::filesystem::remove_all(s_test_path, ec);
+
+	return g_failed_checks != 0;
+}
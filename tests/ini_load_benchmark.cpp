@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Loads a large generated preset with 'ini_file' and with the line by line loader it replaced, and checks that both read the same contents.
+// Usage: ini_load_benchmark [sections] [keys per section] [iterations]
+
+#include "check.hpp"
+#include "dll_config.hpp"
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <cstdlib>
+#include <algorithm>
+
+std::filesystem::path g_reshade_dll_path;
+std::filesystem::path g_reshade_base_path;
+std::filesystem::path g_target_executable_path;
+
+using reference_sections = std::unordered_map<std::string, std::unordered_map<std::string, std::vector<std::string>>>;
+
+// The previous implementation of 'ini_file::load', which reads the file line by line and copies every part of it into a separate string
+// The stream is not imbued with the "en-us.UTF-8" locale, since that name is specific to Windows and makes no difference to how the bytes are read
+// Carriage returns are removed by hand, which the text mode stream did on Windows
+static void load_reference(const std::filesystem::path &path, reference_sections &sections)
+{
+	std::ifstream file;
+	if (file.open(path); !file)
+		return;
+
+	sections.clear();
+
+	// Remove BOM (0xefbbbf means 0xfeff)
+	if (file.get() != 0xef || file.get() != 0xbb || file.get() != 0xbf)
+		file.seekg(0, std::ios::beg);
+
+	std::string line, section;
+	while (std::getline(file, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		trim(line);
+
+		if (line.empty() || line[0] == ';' || line[0] == '/' || line[0] == '#')
+			continue;
+
+		// Read section name
+		if (line[0] == '[')
+		{
+			section = trim(line.substr(0, line.find(']')), " \t[]");
+			continue;
+		}
+
+		// Read section content
+		const auto assign_index = line.find('=');
+		if (assign_index != std::string::npos)
+		{
+			const std::string key = trim(line.substr(0, assign_index));
+			const std::string value = trim(line.substr(assign_index + 1));
+
+			// Append to key if it already exists
+			std::vector<std::string> &elements = sections[section][key];
+			for (size_t offset = 0, base = 0, len = value.size(); offset <= len;)
+			{
+				// Treat ",," as an escaped comma and only split on single ","
+				const size_t found = std::min(value.find_first_of(',', offset), len);
+				if (found + 1 < len && value[found + 1] == ',')
+				{
+					offset = found + 2;
+				}
+				else
+				{
+					std::string &element = elements.emplace_back();
+					element.reserve(found - base);
+
+					while (base < found)
+					{
+						const char c = value[base++];
+						element += c;
+
+						if (c == ',' && base < found && value[base] == ',')
+							base++; // Skip second comma in a ",," escape sequence
+					}
+
+					base = offset = found + 1;
+				}
+			}
+		}
+		else
+		{
+			sections[section].insert({ line, {} });
+		}
+	}
+}
+
+// Something resembling a preset of a large shader pack, with one section per effect and variables of all kinds
+static std::string make_preset(size_t num_sections, size_t num_keys, std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> float_dist(-10.0f, 10.0f);
+
+	std::string text = "\xef\xbb\xbf" "; Generated preset\r\n";
+	text += "PreprocessorDefinitions=RESHADE_DEPTH_INPUT_IS_REVERSED=0,,1,RESHADE_DEPTH_LINEARIZATION_FAR_PLANE=1000\r\n";
+	text += "Techniques=";
+	for (size_t i = 0; i < num_sections; ++i)
+		text += (i != 0 ? "," : "") + ("Technique" + std::to_string(i)) + "@Effect" + std::to_string(i) + ".fx";
+	text += "\r\n";
+
+	for (size_t i = 0; i < num_sections; ++i)
+	{
+		text += "\r\n[ Effect" + std::to_string(i) + ".fx ]\r\n";
+
+		for (size_t k = 0; k < num_keys; ++k)
+		{
+			text += (k % 7 == 0 ? "  " : "") + ("Variable" + std::to_string(k)) + (k % 5 == 0 ? " = " : "=");
+
+			switch (rng() % 6)
+			{
+			case 0:
+				text += std::to_string(float_dist(rng));
+				break;
+			case 1:
+				text += std::to_string(float_dist(rng)) + ',' + std::to_string(float_dist(rng)) + ',' + std::to_string(float_dist(rng));
+				break;
+			case 2:
+				text += std::to_string(static_cast<int>(rng() % 1000) - 500);
+				break;
+			case 3:
+				text += std::to_string(rng() % 2);
+				break;
+			case 4:
+				text += "Some text,, with an escaped comma,second element,,,third";
+				break;
+			case 5:
+				for (int c = 0; c < 16; ++c)
+					text += (c != 0 ? "," : "") + std::to_string(float_dist(rng));
+				break;
+			}
+
+			text += k % 3 == 0 ? "  \n" : "\r\n";
+		}
+
+		text += "// Comment\r\n# Comment\r\nKeyWithoutValue\r\n";
+	}
+
+	return text;
+}
+
+int main(int argc, char *argv[])
+{
+	const size_t num_sections = argc > 1 ? std::atoi(argv[1]) : 200;
+	const size_t num_keys = argc > 2 ? std::atoi(argv[2]) : 150;
+	const size_t num_iterations = argc > 3 ? std::atoi(argv[3]) : 5;
+
+	if (num_sections == 0 || num_iterations == 0)
+		return 1;
+
+	const std::filesystem::path test_path = std::filesystem::temp_directory_path() / "reshade_ini_load_benchmark";
+	std::filesystem::remove_all(test_path);
+	std::filesystem::create_directories(test_path);
+
+	std::mt19937 rng(42);
+	const std::filesystem::path path = test_path / "preset.ini";
+	const std::string text = make_preset(num_sections, num_keys, rng);
+	std::ofstream(path, std::ios::binary) << text;
+
+	using clock = std::chrono::high_resolution_clock;
+	const auto to_ms = [](clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+
+	// Take the fastest of several runs, so that the file is in the system cache and other processes disturb the result as little as possible
+	reference_sections reference;
+	clock::duration reference_time = clock::duration::max();
+	for (size_t i = 0; i < num_iterations; ++i)
+	{
+		const auto start = clock::now();
+		load_reference(path, reference);
+		reference_time = std::min(reference_time, clock::now() - start);
+	}
+
+	clock::duration load_time = clock::duration::max();
+	for (size_t i = 0; i < num_iterations; ++i)
+	{
+		const auto start = clock::now();
+		const reshade::ini_file ini(path);
+		load_time = std::min(load_time, clock::now() - start);
+	}
+
+	// 'ini_file' also parses every element into numbers while loading, which the previous loader did not do, so measure that part on its own as well
+	clock::duration number_time = clock::duration::max();
+	for (size_t i = 0; i < num_iterations; ++i)
+	{
+		long long int_sum = 0;
+		double float_sum = 0.0;
+		const auto start = clock::now();
+		for (const auto &[section_name, section] : reference)
+		{
+			for (const auto &[key, elements] : section)
+			{
+				for (const std::string &element : elements)
+				{
+					int_sum += std::strtoll(element.c_str(), nullptr, 10);
+					float_sum += std::strtod(element.c_str(), nullptr);
+				}
+			}
+		}
+		number_time = std::min(number_time, clock::now() - start);
+		CHECK(int_sum != 0 && float_sum != 0.0);
+	}
+
+	const reshade::ini_file ini(path);
+
+	size_t num_values = 0;
+	for (const auto &[section_name, section] : reference)
+	{
+		for (const auto &[key, elements] : section)
+		{
+			num_values++;
+
+			std::vector<std::string> loaded;
+			CHECK(ini.get(section_name, key, loaded));
+			CHECK(loaded == elements);
+		}
+	}
+	CHECK(num_values == 2 + num_sections * (num_keys + 1));
+
+	std::printf("%zu sections, %zu keys, %.1f MB\n", reference.size(), num_values, text.size() / 1e6);
+	std::printf("  line by line: %8.2f ms, %6.1f MB/s\n", to_ms(reference_time), text.size() / 1e3 / to_ms(reference_time));
+	std::printf("  ini_file:     %8.2f ms, %6.1f MB/s (%.1fx)\n", to_ms(load_time), text.size() / 1e3 / to_ms(load_time), to_ms(reference_time) / to_ms(load_time));
+	std::printf("    of which parsing numbers: %8.2f ms\n", to_ms(number_time));
+
+	std::error_code ec;
+	std::filesystem::remove_all(test_path, ec);
+
+	return g_failed_checks != 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <zlib.h>
+
+/// <summary>
+/// Minimal PNG decoder for 8-bit RGB and RGBA images, which checks every chunk CRC and uses zlib to inflate the image data, so that it shares no code with the encoder under test.
+/// </summary>
+/// <param name="file">The contents of the PNG file.</param>
+/// <param name="width">Receives the width of the image.</param>
+/// <param name="height">Receives the height of the image.</param>
+/// <param name="bpp">Receives the number of bytes per pixel (3 or 4).</param>
+/// <param name="pixels">Receives the unfiltered image data.</param>
+/// <returns><c>true</c> if the file is valid, <c>false</c> otherwise.</returns>
+inline bool decode_png(const std::vector<uint8_t> &file, uint32_t &width, uint32_t &height, uint32_t &bpp, std::vector<uint8_t> &pixels)
+{
+	const auto read_be32 = [](const uint8_t *p) { return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3]; };
+
+	if (file.size() < 8 || std::memcmp(file.data(), "\x89PNG\r\n\x1A\n", 8) != 0)
+		return false;
+
+	bool has_header = false, has_end = false;
+	std::vector<uint8_t> compressed;
+
+	for (size_t offset = 8; offset < file.size() && !has_end;)
+	{
+		if (file.size() - offset < 12)
+			return false;
+		const uint32_t size = read_be32(file.data() + offset);
+		if (file.size() - offset - 12 < size)
+			return false;
+
+		const uint8_t *const type = file.data() + offset + 4;
+		const uint8_t *const data = type + 4;
+		if (crc32(0, type, 4 + size) != read_be32(data + size))
+			return false;
+
+		if (std::memcmp(type, "IHDR", 4) == 0)
+		{
+			// Only 8-bit RGB or RGBA without interlacing is produced by the encoder
+			if (size != 13 || data[8] != 8 || (data[9] != 2 && data[9] != 6) || data[10] != 0 || data[11] != 0 || data[12] != 0)
+				return false;
+			width = read_be32(data + 0);
+			height = read_be32(data + 4);
+			bpp = data[9] == 6 ? 4 : 3;
+			has_header = true;
+		}
+		else if (std::memcmp(type, "IDAT", 4) == 0)
+		{
+			compressed.insert(compressed.end(), data, data + size);
+		}
+		else if (std::memcmp(type, "IEND", 4) == 0)
+		{
+			has_end = true;
+		}
+
+		offset += 12 + size;
+	}
+
+	if (!has_header || !has_end || width == 0 || height == 0)
+		return false;
+
+	// Inflate into a buffer that is one byte larger than expected, so that trailing data is detected too
+	const size_t row_size = size_t(width) * bpp;
+	std::vector<uint8_t> filtered(height * (row_size + 1) + 1);
+	uLongf filtered_size = static_cast<uLongf>(filtered.size());
+	if (uncompress(filtered.data(), &filtered_size, compressed.data(), static_cast<uLong>(compressed.size())) != Z_OK || filtered_size != height * (row_size + 1))
+		return false;
+
+	pixels.assign(height * row_size, 0);
+	const std::vector<uint8_t> zero_row(row_size);
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		const uint8_t filter = filtered[y * (row_size + 1)];
+		const uint8_t *const src = filtered.data() + y * (row_size + 1) + 1;
+		const uint8_t *const prev = y != 0 ? pixels.data() + (y - 1) * row_size : zero_row.data();
+		uint8_t *const dst = pixels.data() + y * row_size;
+
+		for (size_t i = 0; i < row_size; ++i)
+		{
+			const int a = i >= bpp ? dst[i - bpp] : 0, b = prev[i], c = i >= bpp ? prev[i - bpp] : 0;
+
+			int predicted;
+			switch (filter)
+			{
+			case 0:
+				predicted = 0;
+				break;
+			case 1:
+				predicted = a;
+				break;
+			case 2:
+				predicted = b;
+				break;
+			case 3:
+				predicted = (a + b) / 2;
+				break;
+			case 4:
+			{
+				const int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+				predicted = pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+				break;
+			}
+			default:
+				return false;
+			}
+
+			dst[i] = static_cast<uint8_t>(src[i] + predicted);
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "check.hpp"
+#include "png_decoder.hpp"
+#include "png_encoder.hpp"
+#include "task_scheduler.hpp"
+#include <random>
+
+using namespace reshade::image;
+
+enum class content
+{
+	noise,
+	flat,
+	gradient,
+	pattern, // Repeats with a period that is not a multiple of the row size, so that matches reach across rows and strips
+};
+
+static std::vector<uint8_t> make_image(uint32_t width, uint32_t height, content type, std::mt19937 &rng)
+{
+	std::vector<uint8_t> pixels(size_t(width) * height * 4);
+
+	for (size_t i = 0; i < pixels.size(); ++i)
+	{
+		const size_t x = (i / 4) % width, y = (i / 4) / width;
+
+		switch (type)
+		{
+		case content::noise:
+			pixels[i] = static_cast<uint8_t>(rng());
+			break;
+		case content::flat:
+			pixels[i] = static_cast<uint8_t>(0x40 + (i % 4));
+			break;
+		case content::gradient:
+			pixels[i] = static_cast<uint8_t>(x * (i % 4 + 1) + y * 3);
+			break;
+		case content::pattern:
+			pixels[i] = static_cast<uint8_t>((i % 1237) * 7 + ((i % 1237) == 0 ? rng() : 0));
+			break;
+		}
+	}
+
+	return pixels;
+}
+
+static std::vector<uint8_t> write_file(const png_encoder &encoder)
+{
+	std::vector<uint8_t> file;
+	CHECK(encoder.write([&file](const uint8_t *data, size_t size) {
+		file.insert(file.end(), data, data + size);
+		return true;
+	}));
+	return file;
+}
+
+static void check_decoded(const std::vector<uint8_t> &file, const std::vector<uint8_t> &pixels, uint32_t width, uint32_t height, bool include_alpha)
+{
+	uint32_t decoded_width = 0, decoded_height = 0, decoded_bpp = 0;
+	std::vector<uint8_t> decoded;
+	CHECK(decode_png(file, decoded_width, decoded_height, decoded_bpp, decoded));
+	CHECK(decoded_width == width && decoded_height == height && decoded_bpp == (include_alpha ? 4u : 3u));
+
+	if (decoded.size() != size_t(width) * height * decoded_bpp)
+		return;
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < size_t(width) * height; ++i)
+		for (size_t c = 0; c < decoded_bpp; ++c)
+			mismatches += decoded[i * decoded_bpp + c] != pixels[i * 4 + c];
+	CHECK(mismatches == 0);
+}
+
+static void test_round_trip(std::mt19937 &rng)
+{
+	// Includes single pixels, single rows and columns, odd sizes and rows that are larger than a strip on their own
+	const uint32_t sizes[][2] = { { 1, 1 }, { 1, 1000 }, { 1000, 1 }, { 7, 13 }, { 513, 300 }, { 3000, 90 }, { 70001, 3 } };
+
+	for (const auto &[width, height] : sizes)
+	{
+		for (const content type : { content::noise, content::flat, content::gradient, content::pattern })
+		{
+			const std::vector<uint8_t> pixels = make_image(width, height, type, rng);
+
+			for (const png_compression level : { png_compression::fast, png_compression::balanced, png_compression::max })
+			{
+				for (const bool include_alpha : { true, false })
+				{
+					png_encoder encoder(pixels.data(), width, height, include_alpha, level);
+					for (size_t i = 0; i < encoder.num_strips(); ++i)
+						encoder.encode_strip(i);
+
+					check_decoded(write_file(encoder), pixels, width, height, include_alpha);
+				}
+			}
+		}
+	}
+}
+
+static void test_parallel_strips(std::mt19937 &rng)
+{
+	const uint32_t width = 1920, height = 1080;
+	const std::vector<uint8_t> pixels = make_image(width, height, content::gradient, rng);
+
+	for (const png_compression level : { png_compression::fast, png_compression::balanced, png_compression::max })
+	{
+		// Strips are independent of each other, so the order in which they are encoded must not matter
+		png_encoder serial(pixels.data(), width, height, true, level);
+		CHECK(serial.num_strips() > 1);
+		for (size_t i = serial.num_strips(); i-- > 0;)
+			serial.encode_strip(i);
+
+		png_encoder parallel(pixels.data(), width, height, true, level);
+		{
+			reshade::task_scheduler scheduler(4);
+			for (size_t i = 0; i < parallel.num_strips(); ++i)
+				scheduler.submit([&parallel, i]() { parallel.encode_strip(i); });
+			scheduler.wait_idle();
+		}
+
+		const std::vector<uint8_t> file = write_file(serial);
+		CHECK(write_file(parallel) == file);
+		check_decoded(file, pixels, width, height, true);
+
+		// Make sure the decoder notices corrupted data at all
+		std::vector<uint8_t> corrupted = file, decoded;
+		corrupted[file.size() / 2] ^= 0x10;
+		uint32_t decoded_width, decoded_height, decoded_bpp;
+		CHECK(!decode_png(corrupted, decoded_width, decoded_height, decoded_bpp, decoded));
+	}
+}
+
+static void test_write_failure(std::mt19937 &rng)
+{
+	const std::vector<uint8_t> pixels = make_image(800, 600, content::noise, rng);
+
+	png_encoder encoder(pixels.data(), 800, 600, true, png_compression::fast);
+	for (size_t i = 0; i < encoder.num_strips(); ++i)
+		encoder.encode_strip(i);
+
+	size_t num_calls = 0;
+	CHECK(encoder.write([&num_calls](const uint8_t *, size_t) { ++num_calls; return true; }));
+
+	// Fail every part of the file in turn, after which writing has to stop right away
+	for (size_t fail_at = 0; fail_at < num_calls; ++fail_at)
+	{
+		size_t calls = 0;
+		CHECK(!encoder.write([&calls, fail_at](const uint8_t *, size_t) { return calls++ != fail_at; }));
+		CHECK(calls == fail_at + 1);
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(42);
+
+	test_round_trip(rng);
+	test_parallel_strips(rng);
+	test_write_failure(rng);
+
+	return g_failed_checks != 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Encodes a series of synthetic frames through the same screenshot queue 'runtime::save_screenshot' uses and compares that with encoding them synchronously on the calling thread.
+// Files are kept in memory instead of being written to disk, so that only the capture, queue and encoding steps are measured.
+// Usage: screenshot_benchmark [width] [height] [frames] [queue size] [threads] [compression level]
+
+#include "check.hpp"
+#include "png_decoder.hpp"
+#include "png_encoder.hpp"
+#include "task_scheduler.hpp"
+#include "screenshot_queue.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace reshade::image;
+
+// Something resembling a rendered frame, with smooth areas, edges and some noise, which changes from frame to frame
+static std::vector<uint8_t> make_frame(uint32_t width, uint32_t height, uint32_t index)
+{
+	std::vector<uint8_t> pixels(size_t(width) * height * 4);
+	uint32_t seed = 0x9E3779B9u * (index + 1);
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			uint8_t *const pixel = pixels.data() + (size_t(y) * width + x) * 4;
+			const bool edge = ((x + index * 8) / 64 + y / 64) % 2 != 0;
+			pixel[0] = static_cast<uint8_t>(x * 255 / width + (edge ? 32 : 0) + ((seed >> 24) & 3));
+			pixel[1] = static_cast<uint8_t>(y * 255 / height + ((seed >> 16) & 3));
+			pixel[2] = static_cast<uint8_t>((x + y + index) / 4);
+			pixel[3] = 0xFF;
+		}
+	}
+
+	return pixels;
+}
+
+static std::vector<uint8_t> encode_synchronously(const std::vector<uint8_t> &frame, uint32_t width, uint32_t height, png_compression level)
+{
+	png_encoder encoder(frame.data(), width, height, false, level);
+	for (size_t i = 0; i < encoder.num_strips(); ++i)
+		encoder.encode_strip(i);
+
+	std::vector<uint8_t> file;
+	encoder.write([&file](const uint8_t *data, size_t size) { file.insert(file.end(), data, data + size); return true; });
+	return file;
+}
+
+int main(int argc, char *argv[])
+{
+	const uint32_t width = argc > 1 ? std::atoi(argv[1]) : 1280;
+	const uint32_t height = argc > 2 ? std::atoi(argv[2]) : 720;
+	const uint32_t num_frames = argc > 3 ? std::atoi(argv[3]) : 6;
+	const unsigned int queue_size = argc > 4 ? std::atoi(argv[4]) : 3;
+	const size_t num_threads = argc > 5 ? std::atoi(argv[5]) : 0;
+	const png_compression level = static_cast<png_compression>(std::min(argc > 6 ? std::atoi(argv[6]) : 1, 2));
+
+	if (width == 0 || height == 0 || num_frames == 0)
+		return 1;
+
+	std::vector<std::vector<uint8_t>> frames;
+	for (uint32_t i = 0; i < num_frames; ++i)
+		frames.push_back(make_frame(width, height, i));
+
+	using clock = std::chrono::high_resolution_clock;
+	const auto to_ms = [](clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+
+	// Encode on the calling thread, which is what the render thread used to do
+	std::vector<std::vector<uint8_t>> reference_files;
+	clock::duration sync_max_stall = {};
+	const auto sync_start = clock::now();
+	for (const std::vector<uint8_t> &frame : frames)
+	{
+		const auto start = clock::now();
+		reference_files.push_back(encode_synchronously(frame, width, height, level));
+		sync_max_stall = std::max(sync_max_stall, clock::now() - start);
+	}
+	const auto sync_total = clock::now() - sync_start;
+
+	// Capture into the queue and let the workers encode, like the runtime does now
+	std::mutex files_mutex;
+	std::vector<std::vector<uint8_t>> files;
+	size_t num_results = 0;
+	reshade::task_scheduler worker_pool(num_threads);
+	clock::duration async_max_stall = {};
+	const auto async_start = clock::now();
+	{
+		reshade::screenshot_queue queue(worker_pool);
+
+		for (uint32_t i = 0; i < num_frames; ++i)
+		{
+			const auto start = clock::now();
+
+			std::vector<uint8_t> data = queue.acquire_buffer(frames[i].size(), queue_size);
+			std::memcpy(data.data(), frames[i].data(), data.size()); // Stands in for the readback in 'capture_screenshot'
+
+			queue.submit_png("frame" + std::to_string(i) + ".png", std::move(data), width, height, false, level,
+				[&files_mutex, &files](const std::filesystem::path &, const png_encoder &encoder) {
+					std::vector<uint8_t> file;
+					const bool success = encoder.write([&file](const uint8_t *data, size_t size) { file.insert(file.end(), data, data + size); return true; });
+
+					const std::lock_guard<std::mutex> lock(files_mutex);
+					files.push_back(std::move(file));
+					return success;
+				});
+
+			for (const reshade::screenshot_queue::result &result : queue.finish(false))
+			{
+				CHECK(result.success);
+				num_results++;
+			}
+
+			async_max_stall = std::max(async_max_stall, clock::now() - start);
+		}
+
+		const auto async_submit = clock::now() - async_start;
+		for (const reshade::screenshot_queue::result &result : queue.finish_all())
+		{
+			CHECK(result.success);
+			num_results++;
+		}
+		CHECK(queue.num_pending() == 0);
+		const auto async_total = clock::now() - async_start;
+
+		const double megapixels = double(width) * height * num_frames / 1e6;
+		std::printf("%u frames of %ux%u, compression level %d, queue size %u\n", num_frames, width, height, static_cast<int>(level), queue_size);
+		std::printf("  synchronous: %8.1f ms total, %8.1f ms longest stall, %6.1f MP/s\n", to_ms(sync_total), to_ms(sync_max_stall), megapixels / (to_ms(sync_total) / 1000.0));
+		std::printf("  queued:      %8.1f ms total, %8.1f ms longest stall, %6.1f MP/s (%.1f ms until all frames were submitted)\n", to_ms(async_total), to_ms(async_max_stall), megapixels / (to_ms(async_total) / 1000.0), to_ms(async_submit));
+	}
+
+	// Frames may finish out of order, so match every file against the synchronously encoded ones rather than relying on their order
+	CHECK(num_results == num_frames);
+	CHECK(files.size() == num_frames);
+	std::vector<bool> matched(num_frames);
+	for (const std::vector<uint8_t> &file : files)
+	{
+		uint32_t decoded_width = 0, decoded_height = 0, decoded_bpp = 0;
+		std::vector<uint8_t> decoded;
+		CHECK(decode_png(file, decoded_width, decoded_height, decoded_bpp, decoded));
+		CHECK(decoded_width == width && decoded_height == height && decoded_bpp == 3);
+
+		for (uint32_t i = 0; i < num_frames; ++i)
+		{
+			if (matched[i] || file != reference_files[i])
+				continue;
+			matched[i] = true;
+
+			size_t mismatches = 0;
+			for (size_t k = 0; k < decoded.size() / 3; ++k)
+				mismatches += std::memcmp(decoded.data() + k * 3, frames[i].data() + k * 4, 3) != 0;
+			CHECK(mismatches == 0);
+			break;
+		}
+	}
+	for (uint32_t i = 0; i < num_frames; ++i)
+		CHECK(matched[i]);
+
+	return g_failed_checks != 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "check.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include <memory>
+#include <iterator>
+#include <algorithm>
+
+static const char *const s_source =
+	"uniform float Alpha = 0.5;\n"
+	"uniform float3 Col = float3(1, 2, 3);\n"
+	"uniform int Mode = 2;\n"
+	"uniform float4x4 Mat = float4x4(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);\n"
+	"uniform float NoInit;\n"
+	"float4 PS(float4 pos : SV_Position) : SV_Target { return mul(Mat, float4(Col * Alpha * NoInit, Mode)); }\n"
+	"technique Test { pass { VertexShader = PS; PixelShader = PS; } }\n";
+
+static const char *const s_uniform_names[] = { "Alpha", "Col", "Mode", "Mat", "NoInit" };
+
+enum class language
+{
+	hlsl,
+	glsl,
+};
+
+static reshadefx::module compile(language lang, bool spec_constants, const std::unordered_set<std::string> *restrict_to = nullptr)
+{
+	const std::unique_ptr<reshadefx::codegen> codegen(lang == language::hlsl ?
+		reshadefx::create_codegen_hlsl(50, false, spec_constants, true) :
+		reshadefx::create_codegen_glsl(false, spec_constants, false, false, true));
+	if (restrict_to != nullptr)
+		codegen->restrict_spec_constants(*restrict_to);
+
+	reshadefx::parser parser;
+	CHECK(parser.parse(s_source, codegen.get()));
+
+	reshadefx::module module;
+	codegen->write_result(module);
+	return module;
+}
+
+static bool has_spec_constant(const reshadefx::module &module, const std::string &name)
+{
+	return std::any_of(module.spec_constants.begin(), module.spec_constants.end(),
+		[&name](const reshadefx::uniform_info &info) { return info.name == name; });
+}
+
+static void check_same_layout(const reshadefx::module &module, const reshadefx::module &reference)
+{
+	CHECK(module.total_uniform_size == reference.total_uniform_size);
+	CHECK(module.uniforms.size() == reference.uniforms.size());
+
+	for (size_t i = 0; i < module.uniforms.size() && i < reference.uniforms.size(); ++i)
+	{
+		CHECK(module.uniforms[i].name == reference.uniforms[i].name);
+		CHECK(module.uniforms[i].offset == reference.uniforms[i].offset);
+		CHECK(module.uniforms[i].size == reference.uniforms[i].size);
+	}
+}
+
+static void test_all_uniforms(language lang)
+{
+	// Without a restriction, every variable with an initializer is turned into a constant and removed from the uniform buffer
+	const reshadefx::module module = compile(lang, true);
+
+	CHECK(module.uniforms.size() == 1 && module.uniforms[0].name == "NoInit");
+	CHECK(module.spec_constants.size() == 4);
+	for (const char *const name : { "Alpha", "Col", "Mode", "Mat" })
+		CHECK(has_spec_constant(module, name));
+	CHECK(!has_spec_constant(module, "NoInit"));
+}
+
+static void test_restricted(language lang)
+{
+	const reshadefx::module reference = compile(lang, false);
+	CHECK(reference.spec_constants.empty());
+	CHECK(reference.uniforms.size() == std::size(s_uniform_names));
+
+	// Try every subset of variables, the uniform buffer layout has to stay the same for all of them, so that values can be written without knowing which variables are constants
+	for (unsigned int mask = 0; mask < (1u << std::size(s_uniform_names)); ++mask)
+	{
+		std::unordered_set<std::string> names;
+		for (size_t i = 0; i < std::size(s_uniform_names); ++i)
+			if (mask & (1u << i))
+				names.insert(s_uniform_names[i]);
+
+		const reshadefx::module module = compile(lang, true, &names);
+		check_same_layout(module, reference);
+
+		for (const char *const name : s_uniform_names)
+		{
+			// Only variables that have an initializer can become a constant
+			const bool expected = names.count(name) != 0 && std::string(name) != "NoInit";
+			CHECK(has_spec_constant(module, name) == expected);
+
+			// Code has to read constants from the specialization constant, but all other variables from the uniform buffer
+			CHECK((module.hlsl.find("(SPEC_CONSTANT_" + std::string(name) + ')') != std::string::npos) == expected);
+		}
+	}
+
+	// Names of variables that do not exist are ignored
+	{
+		const std::unordered_set<std::string> names = { "Unknown", "Col" };
+		const reshadefx::module module = compile(lang, true, &names);
+		check_same_layout(module, reference);
+		CHECK(module.spec_constants.size() == 1 && module.spec_constants[0].name == "Col");
+	}
+
+	// The restriction does nothing if specialization constants are disabled
+	{
+		const std::unordered_set<std::string> names = { "Alpha", "Col" };
+		const reshadefx::module module = compile(lang, false, &names);
+		check_same_layout(module, reference);
+		CHECK(module.spec_constants.empty());
+		CHECK(module.hlsl.find("SPEC_CONSTANT_") == std::string::npos);
+	}
+}
+
+int main()
+{
+	for (const language lang : { language::hlsl, language::glsl })
+	{
+		test_all_uniforms(lang);
+		test_restricted(lang);
+	}
+
+	return g_failed_checks != 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "check.hpp"
+#include "task_scheduler.hpp"
+#include <chrono>
+#include <future>
+#include <set>
+
+using namespace std::chrono_literals;
+
+static void test_runs_all_tasks(size_t num_threads)
+{
+	reshade::task_scheduler scheduler(num_threads);
+	CHECK(scheduler.num_threads() == num_threads);
+
+	std::atomic<size_t> counter = 0;
+	for (size_t i = 0; i < 10000; ++i)
+		scheduler.submit([&counter]() { counter++; });
+
+	scheduler.wait_idle();
+	CHECK(counter == 10000);
+}
+
+static void test_waits_for_nested_tasks(size_t num_threads)
+{
+	reshade::task_scheduler scheduler(num_threads);
+
+	// Tasks queued from within other tasks have to be waited for as well
+	std::atomic<size_t> counter = 0;
+	for (size_t i = 0; i < 100; ++i)
+		scheduler.submit([&scheduler, &counter]() {
+			for (size_t k = 0; k < 100; ++k)
+				scheduler.submit([&counter]() { counter++; });
+		});
+
+	scheduler.wait_idle();
+	CHECK(counter == 100 * 100);
+}
+
+static void test_continuation(size_t num_threads)
+{
+	reshade::task_scheduler scheduler(num_threads);
+
+	std::atomic<size_t> counter = 0;
+	std::atomic<size_t> counter_in_continuation = 0;
+	std::atomic<size_t> continuation_calls = 0;
+
+	std::vector<std::function<void()>> tasks;
+	for (size_t i = 0; i < 1000; ++i)
+		tasks.push_back([&counter]() { counter++; });
+
+	scheduler.submit(std::move(tasks), [&]() {
+		counter_in_continuation = counter.load();
+		continuation_calls++;
+	});
+
+	scheduler.wait_idle();
+	CHECK(continuation_calls == 1);
+	CHECK(counter_in_continuation == 1000);
+
+	// Continuation is still called when there is nothing to wait for
+	scheduler.submit({}, [&continuation_calls]() { continuation_calls++; });
+
+	scheduler.wait_idle();
+	CHECK(continuation_calls == 2);
+}
+
+static void test_work_stealing()
+{
+	reshade::task_scheduler scheduler(4);
+
+	// Queue tasks from a worker, which puts them all into the queue of that worker
+	// Each of them blocks until all of them started, so this only finishes if the other workers steal them
+	std::mutex mutex;
+	std::condition_variable all_started;
+	size_t num_started = 0;
+	bool timed_out = false;
+	std::set<std::thread::id> threads;
+
+	scheduler.submit([&]() {
+		for (size_t i = 0; i < 3; ++i)
+			scheduler.submit([&]() {
+				std::unique_lock<std::mutex> lock(mutex);
+				threads.insert(std::this_thread::get_id());
+				if (++num_started == 3)
+					all_started.notify_all();
+				else if (!all_started.wait_for(lock, 10s, [&]() { return num_started == 3; }))
+					timed_out = true;
+			});
+	});
+
+	scheduler.wait_idle();
+	CHECK(!timed_out);
+	CHECK(num_started == 3);
+	CHECK(threads.size() == 3);
+}
+
+static void test_task_group()
+{
+	reshade::task_scheduler scheduler(2);
+	reshade::task_group group;
+
+	// Other work on the pool keeps running until after the group was waited for, so waiting for the whole pool here would never return
+	std::promise<void> release;
+	std::shared_future<void> released = release.get_future().share();
+	std::atomic<bool> unrelated_finished = false;
+	scheduler.submit([released, &unrelated_finished]() {
+		released.wait();
+		unrelated_finished = true;
+	});
+
+	// Tasks of a group can be chained, as long as the last one marks it as done
+	std::atomic<size_t> counter = 0;
+	for (size_t i = 0; i < 10; ++i)
+	{
+		group.add();
+
+		std::vector<std::function<void()>> tasks;
+		for (size_t k = 0; k < 10; ++k)
+			tasks.push_back([&counter]() { std::this_thread::sleep_for(1ms); counter++; });
+
+		scheduler.submit(std::move(tasks), [&group]() { group.done(); });
+	}
+	CHECK(group.num_pending() != 0);
+
+	group.wait();
+	CHECK(group.num_pending() == 0);
+	CHECK(counter == 10 * 10);
+	CHECK(!unrelated_finished);
+
+	release.set_value();
+	scheduler.wait_idle();
+	CHECK(unrelated_finished);
+
+	// Waiting for an empty group returns immediately
+	group.wait();
+}
+
+int main()
+{
+	for (const size_t num_threads : { 1, 2, 8 })
+	{
+		test_runs_all_tasks(num_threads);
+		test_waits_for_nested_tasks(num_threads);
+		test_continuation(num_threads);
+	}
+
+	test_work_stealing();
+	test_task_group();
+
+	return g_failed_checks != 0;
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Measures the throughput of the texture loading pipeline (file read, decode, resize, mipmap generation), once serially and once with every image as a separate task like 'runtime::update_texture_loading' does.
+// Usage: texture_decode_benchmark [--size <width>x<height>] [--count <images>] [--resize <width>x<height>] [--levels <levels>] [--threads <threads>] [image files ...]
+// Without any image files, PNG files of noise with smooth gradients are generated in memory and the decoded pixels are compared against them.
+// Image files are decoded with stb like the runtime does if the submodules are checked out, otherwise with the minimal PNG decoder of the tests, which only reads 8-bit RGB and RGBA PNG files and cannot resize.
+
+#include "check.hpp"
+#include "png_encoder.hpp"
+#include "image_processing.hpp"
+#include "task_scheduler.hpp"
+#include <cmath>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#if HAVE_STB
+#include <stb_image.h>
+#include <stb_image_dds.h>
+#include <stb_image_resize.h>
+#else
+#include "png_decoder.hpp"
+#endif
+
+using namespace reshade;
+
+struct source_image
+{
+	std::string path; // Empty for images generated in memory
+	std::vector<uint8_t> file;
+	std::vector<uint8_t> expected_pixels; // Only set for images generated in memory
+};
+
+struct loaded_image
+{
+	uint32_t width = 0, height = 0;
+	std::vector<uint8_t> pixels; // Decoded and resized image
+	std::vector<uint8_t> levels; // All mipmap levels
+};
+
+static bool read_file(const std::string &path, std::vector<uint8_t> &data)
+{
+	FILE *const file = std::fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+	std::fseek(file, 0, SEEK_END);
+	const long file_size = std::ftell(file);
+	std::fseek(file, 0, SEEK_SET);
+
+	data.resize(file_size > 0 ? static_cast<size_t>(file_size) : 0);
+	const size_t read_size = std::fread(data.data(), 1, data.size(), file);
+	std::fclose(file);
+
+	return file_size >= 0 && read_size == data.size();
+}
+
+static source_image make_image(uint32_t width, uint32_t height, uint32_t index)
+{
+	source_image image;
+	image.expected_pixels.resize(size_t(width) * height * 4);
+
+	uint32_t seed = 0x9E3779B9u * (index + 1);
+	for (size_t i = 0; i < image.expected_pixels.size(); ++i)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		const size_t x = (i / 4) % width, y = (i / 4) / width;
+		image.expected_pixels[i] = static_cast<uint8_t>((i % 4) == 3 ? 0xFF : x * 255 / width + y * 255 / height + (i % 4) * 64 + ((seed >> 24) & 7));
+	}
+
+	image::png_encoder encoder(image.expected_pixels.data(), width, height, true, image::png_compression::fast);
+	for (size_t i = 0; i < encoder.num_strips(); ++i)
+		encoder.encode_strip(i);
+	encoder.write([&image](const uint8_t *data, size_t size) { image.file.insert(image.file.end(), data, data + size); return true; });
+
+	return image;
+}
+
+// Same steps as 'load_image_file' and the mipmap generation in 'runtime::update_texture_loading'
+static bool load_image(const source_image &source, uint32_t resize_width, uint32_t resize_height, uint32_t levels, loaded_image &result)
+{
+	std::vector<uint8_t> file_data;
+	const std::vector<uint8_t> *mem = &source.file;
+	if (!source.path.empty())
+	{
+		if (!read_file(source.path, file_data))
+			return false;
+		mem = &file_data;
+	}
+
+#if HAVE_STB
+	int width = 0, height = 0, channels = 0;
+	unsigned char *filedata = nullptr;
+	if (stbi_dds_test_memory(mem->data(), static_cast<int>(mem->size())))
+		filedata = stbi_dds_load_from_memory(mem->data(), static_cast<int>(mem->size()), &width, &height, &channels, STBI_rgb_alpha);
+	else
+		filedata = stbi_load_from_memory(mem->data(), static_cast<int>(mem->size()), &width, &height, &channels, STBI_rgb_alpha);
+	if (filedata == nullptr)
+		return false;
+
+	result.width = resize_width != 0 ? resize_width : width;
+	result.height = resize_height != 0 ? resize_height : height;
+	result.pixels.resize(size_t(result.width) * result.height * 4);
+
+	if (result.width != uint32_t(width) || result.height != uint32_t(height))
+		stbir_resize_uint8(filedata, width, height, 0, result.pixels.data(), result.width, result.height, 0, 4);
+	else
+		std::memcpy(result.pixels.data(), filedata, result.pixels.size());
+
+	stbi_image_free(filedata);
+#else
+	uint32_t width = 0, height = 0, bpp = 0;
+	std::vector<uint8_t> filedata;
+	if (!decode_png(*mem, width, height, bpp, filedata))
+		return false;
+
+	result.width = width;
+	result.height = height;
+	result.pixels.resize(size_t(width) * height * 4);
+
+	// Expand to RGBA like 'STBI_rgb_alpha' does
+	for (size_t i = 0; i < size_t(width) * height; ++i)
+	{
+		std::memcpy(result.pixels.data() + i * 4, filedata.data() + i * bpp, bpp);
+		if (bpp == 3)
+			result.pixels[i * 4 + 3] = 0xFF;
+	}
+#endif
+
+	result.levels = image::generate_mipmaps(result.pixels.data(), result.width, result.height, levels != 0 ? levels : 1 + static_cast<uint32_t>(std::log2(std::max(result.width, result.height))), reshadefx::texture_format::rgba8, image::mipmap_filter::box, true);
+
+	return true;
+}
+
+static bool parse_size(const char *arg, uint32_t &width, uint32_t &height)
+{
+	return arg != nullptr && std::sscanf(arg, "%ux%u", &width, &height) == 2;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t width = 1024, height = 1024, count = 8, resize_width = 0, resize_height = 0, levels = 0;
+	size_t num_threads = 0;
+	std::vector<source_image> sources;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char *const arg = argv[i];
+		const char *const value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (std::strcmp(arg, "--size") == 0 && parse_size(value, width, height))
+			++i;
+		else if (std::strcmp(arg, "--resize") == 0 && parse_size(value, resize_width, resize_height))
+			++i;
+		else if (std::strcmp(arg, "--count") == 0 && value != nullptr)
+			count = std::atoi(argv[++i]);
+		else if (std::strcmp(arg, "--levels") == 0 && value != nullptr)
+			levels = std::atoi(argv[++i]);
+		else if (std::strcmp(arg, "--threads") == 0 && value != nullptr)
+			num_threads = std::atoi(argv[++i]);
+		else if (arg[0] != '-')
+			sources.push_back({ arg });
+		else
+			return std::fprintf(stderr, "Unknown argument '%s'\n", arg), 1;
+	}
+
+#if !HAVE_STB
+	if (resize_width != 0 || resize_height != 0)
+		return std::fprintf(stderr, "Resizing is not supported without stb\n"), 1;
+#endif
+
+	if (sources.empty())
+	{
+		if (width == 0 || height == 0)
+			return 1;
+		for (uint32_t i = 0; i < count; ++i)
+			sources.push_back(make_image(width, height, i));
+	}
+
+	using clock = std::chrono::high_resolution_clock;
+	const auto to_ms = [](clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+
+	std::vector<loaded_image> serial_results(sources.size());
+	std::vector<bool> serial_success(sources.size());
+	const auto serial_start = clock::now();
+	for (size_t i = 0; i < sources.size(); ++i)
+		serial_success[i] = load_image(sources[i], resize_width, resize_height, levels, serial_results[i]);
+	const auto serial_total = clock::now() - serial_start;
+
+	std::vector<loaded_image> parallel_results(sources.size());
+	std::unique_ptr<bool[]> parallel_success(new bool[sources.size()]()); // Not 'std::vector<bool>', since the elements are written from different threads
+	task_scheduler worker_pool(num_threads);
+	const auto parallel_start = clock::now();
+	for (size_t i = 0; i < sources.size(); ++i)
+		worker_pool.submit([&, i]() { parallel_success[i] = load_image(sources[i], resize_width, resize_height, levels, parallel_results[i]); });
+	worker_pool.wait_idle();
+	const auto parallel_total = clock::now() - parallel_start;
+
+	double megapixels = 0.0;
+	for (size_t i = 0; i < sources.size(); ++i)
+	{
+		if (!serial_success[i])
+		{
+			std::fprintf(stderr, "Failed to load '%s'\n", sources[i].path.c_str());
+			continue;
+		}
+
+		megapixels += double(serial_results[i].width) * serial_results[i].height / 1e6;
+	}
+
+	std::printf("%zu images, %zu worker threads\n", sources.size(), worker_pool.num_threads());
+	std::printf("  serial:   %8.1f ms, %6.1f MP/s\n", to_ms(serial_total), megapixels / (to_ms(serial_total) / 1000.0));
+	std::printf("  parallel: %8.1f ms, %6.1f MP/s\n", to_ms(parallel_total), megapixels / (to_ms(parallel_total) / 1000.0));
+
+	for (size_t i = 0; i < sources.size(); ++i)
+	{
+		CHECK(serial_success[i] && parallel_success[i]);
+		CHECK(parallel_results[i].levels == serial_results[i].levels);
+
+		if (!sources[i].expected_pixels.empty() && resize_width == 0 && resize_height == 0)
+			CHECK(serial_results[i].pixels == sources[i].expected_pixels);
+	}
+
+	return g_failed_checks != 0;
+}
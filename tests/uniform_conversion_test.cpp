@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "check.hpp"
+#include "runtime_objects.hpp"
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+// Element by element conversion, which is what uniform values used to go through
+static uint32_t convert_reference(reshadefx::type::datatype source_type, const void *source, size_t index, bool to_floating_point)
+{
+	uint32_t result = 0;
+	const auto store = [&result](auto value) { static_assert(sizeof(value) == 4); std::memcpy(&result, &value, 4); };
+
+	switch (source_type)
+	{
+	case reshadefx::type::t_bool:
+		to_floating_point ? store(static_cast<const bool *>(source)[index] ? 1.0f : 0.0f) : store(static_cast<const bool *>(source)[index] ? 1u : 0u);
+		break;
+	case reshadefx::type::t_int:
+		to_floating_point ? store(static_cast<float>(static_cast<const int32_t *>(source)[index])) : store(static_cast<const int32_t *>(source)[index]);
+		break;
+	case reshadefx::type::t_uint:
+		to_floating_point ? store(static_cast<float>(static_cast<const uint32_t *>(source)[index])) : store(static_cast<const uint32_t *>(source)[index]);
+		break;
+	case reshadefx::type::t_float:
+		to_floating_point ? store(static_cast<const float *>(source)[index]) : store(static_cast<int32_t>(static_cast<const float *>(source)[index]));
+		break;
+	default:
+		assert(false);
+		break;
+	}
+
+	return result;
+}
+
+// Builds an effect with a lot of uniform variables of mixed types, laid out like in a constant buffer with every variable starting on a new 16-byte register
+static reshade::effect make_effect(size_t num_uniforms)
+{
+	reshade::effect effect;
+
+	uint32_t offset = 0;
+	for (size_t i = 0; i < num_uniforms; ++i)
+	{
+		reshadefx::uniform_info info;
+		info.name = "u" + std::to_string(i);
+
+		switch (i % 6)
+		{
+		case 0: info.type = { reshadefx::type::t_float, 1, 1 }; break;
+		case 1: info.type = { reshadefx::type::t_float, 3, 1 }; break;
+		case 2: info.type = { reshadefx::type::t_int, 1, 1 }; break;
+		case 3: info.type = { reshadefx::type::t_bool, 1, 1 }; break;
+		case 4: info.type = { reshadefx::type::t_float, 4, 4 }; break;
+		case 5: info.type = { reshadefx::type::t_float, 2, 1 }; info.type.array_length = 8; break;
+		}
+
+		const uint32_t element_size = info.type.is_matrix() ? info.type.rows * 16 : info.type.rows * 4;
+		info.size = info.type.is_array() ? (info.type.array_length - 1) * 16 + element_size : element_size;
+		info.offset = offset;
+		offset += (info.size + 15) / 16 * 16;
+
+		reshade::uniform &variable = effect.uniforms.emplace_back(info);
+		variable.effect_index = 0;
+		// Same as in 'runtime::load_effect'
+		variable.stored_as_float = variable.type.is_floating_point();
+		variable.contiguous = !variable.type.is_matrix() && (!variable.type.is_array() || variable.type.rows == 4);
+	}
+
+	effect.uniform_data_storage.resize(offset);
+	return effect;
+}
+
+// Element by element conversion into a temporary buffer for every variable, which is what uniform values used to go through
+static void set_values_element_wise(reshade::effect &effect, const std::vector<reshade::uniform_write> &writes)
+{
+	std::vector<uint32_t> data;
+
+	for (const reshade::uniform_write &write : writes)
+	{
+		const size_t count = std::min(write.count, static_cast<size_t>(write.variable->size / 4));
+		data.resize(count);
+		for (size_t i = 0; i < count; ++i)
+			data[i] = convert_reference(write.type, write.values, i, write.variable->stored_as_float);
+
+		reshade::write_uniform_data(effect, *write.variable, reinterpret_cast<const uint8_t *>(data.data()), count * 4, write.array_index);
+	}
+}
+
+static void benchmark_set_uniform_values(std::mt19937 &rng)
+{
+	constexpr size_t num_uniforms = 600, num_frames = 2000;
+
+	reshade::effect batched = make_effect(num_uniforms), element_wise = make_effect(num_uniforms);
+
+	// Values change every frame (like for the special variables), so that no write is skipped because of unchanged values
+	std::vector<std::vector<float>> float_values(num_frames);
+	std::vector<std::vector<int32_t>> int_values(num_frames);
+	for (size_t frame = 0; frame < num_frames; ++frame)
+	{
+		float_values[frame].resize(16);
+		int_values[frame].resize(16);
+		for (size_t i = 0; i < 16; ++i)
+		{
+			float_values[frame][i] = std::uniform_real_distribution<float>(-10.0f, 10.0f)(rng);
+			int_values[frame][i] = static_cast<int32_t>(frame * 16 + i);
+		}
+	}
+
+	const auto make_writes = [&float_values, &int_values](reshade::effect &effect, size_t frame) {
+		std::vector<reshade::uniform_write> writes;
+		writes.reserve(effect.uniforms.size());
+		for (reshade::uniform &variable : effect.uniforms)
+		{
+			if (variable.type.base == reshadefx::type::t_float)
+				writes.push_back({ &variable, reshadefx::type::t_float, float_values[frame].data(), std::min<size_t>(variable.type.components() * std::max(variable.type.array_length, 1), 16) });
+			else
+				writes.push_back({ &variable, reshadefx::type::t_int, int_values[frame].data(), variable.type.components() });
+		}
+		return writes;
+	};
+
+	std::vector<std::vector<reshade::uniform_write>> batched_writes(num_frames), element_wise_writes(num_frames);
+	for (size_t frame = 0; frame < num_frames; ++frame)
+	{
+		batched_writes[frame] = make_writes(batched, frame);
+		element_wise_writes[frame] = make_writes(element_wise, frame);
+	}
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (size_t frame = 0; frame < num_frames; ++frame)
+		for (const reshade::uniform_write &write : batched_writes[frame])
+			reshade::write_uniform_values(batched, write);
+	const auto batched_end = std::chrono::high_resolution_clock::now();
+	for (size_t frame = 0; frame < num_frames; ++frame)
+		set_values_element_wise(element_wise, element_wise_writes[frame]);
+	const auto element_wise_end = std::chrono::high_resolution_clock::now();
+
+	// Both have to end up with the same contents in the constant buffer
+	CHECK(batched.uniform_data_storage == element_wise.uniform_data_storage);
+	CHECK(!batched.uniform_data_dirty.empty());
+
+	std::printf("Updated %zu uniform variables for %zu frames in %lld us batched, %lld us element by element\n", num_uniforms, num_frames,
+		static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(batched_end - start).count()),
+		static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(element_wise_end - batched_end).count()));
+}
+
+int main()
+{
+	std::mt19937 rng(42);
+
+	constexpr size_t max_count = 67; // Not a multiple of any vector width, so that remainder handling is covered too
+	bool bool_values[max_count];
+	int32_t int_values[max_count];
+	uint32_t uint_values[max_count];
+	float float_values[max_count];
+	for (size_t i = 0; i < max_count; ++i)
+	{
+		bool_values[i] = (rng() & 1) != 0;
+		int_values[i] = static_cast<int32_t>(rng()) >> (rng() % 32);
+		uint_values[i] = static_cast<uint32_t>(rng()) >> (rng() % 32);
+		float_values[i] = std::uniform_real_distribution<float>(-1000.0f, 1000.0f)(rng);
+	}
+
+	const std::pair<reshadefx::type::datatype, const void *> sources[] = {
+		{ reshadefx::type::t_bool, bool_values },
+		{ reshadefx::type::t_int, int_values },
+		{ reshadefx::type::t_uint, uint_values },
+		{ reshadefx::type::t_float, float_values },
+	};
+
+	for (const auto &[source_type, source] : sources)
+	{
+		for (const bool to_floating_point : { false, true })
+		{
+			for (size_t count = 0; count <= max_count; ++count)
+			{
+				// Fill with a marker to detect writes past the requested count
+				uint32_t result[max_count + 1];
+				std::fill(std::begin(result), std::end(result), 0xCDCDCDCD);
+
+				reshade::convert_uniform_values(source_type, source, to_floating_point, result, count);
+
+				for (size_t i = 0; i < count; ++i)
+					CHECK(result[i] == convert_reference(source_type, source, i, to_floating_point));
+				CHECK(result[count] == 0xCDCDCDCD);
+			}
+		}
+	}
+
+	// Compare speed against the element by element conversion for the most common case of integer values stored as floating-point
+	{
+		std::vector<int32_t> values(1 << 20);
+		for (int32_t &value : values)
+			value = static_cast<int32_t>(rng());
+		std::vector<uint32_t> result(values.size());
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < 16; ++i)
+			reshade::convert_uniform_values(reshadefx::type::t_int, values.data(), true, result.data(), values.size());
+		const auto batched = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < 16; ++i)
+			for (size_t k = 0; k < values.size(); ++k)
+				result[k] = convert_reference(reshadefx::type::t_int, values.data(), k, true);
+		const auto element_wise = std::chrono::high_resolution_clock::now();
+
+		std::printf("Converted %zu values in %lld us batched, %lld us element by element\n", values.size() * 16,
+			static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(batched - start).count()),
+			static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(element_wise - batched).count()));
+	}
+
+	benchmark_set_uniform_values(rng);
+
+	return g_failed_checks != 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "check.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include <memory>
+#include <cstdlib>
+#include <algorithm>
+#include <string_view>
+
+static reshadefx::module compile(const std::string &source, reshadefx::codegen *codegen)
+{
+	reshadefx::parser parser;
+	const bool success = parser.parse(source, codegen);
+	CHECK(success);
+	if (!success)
+		std::fprintf(stderr, "%s", parser.errors().c_str());
+
+	reshadefx::module module;
+	codegen->write_result(module);
+	return module;
+}
+static reshadefx::module compile_hlsl(const std::string &source, bool optimize_uniform_layout, unsigned int shader_model = 50)
+{
+	const std::unique_ptr<reshadefx::codegen> codegen(reshadefx::create_codegen_hlsl(shader_model, false, false, optimize_uniform_layout));
+	return compile(source, codegen.get());
+}
+static reshadefx::module compile_glsl(const std::string &source, bool optimize_uniform_layout)
+{
+	const std::unique_ptr<reshadefx::codegen> codegen(reshadefx::create_codegen_glsl(false, false, false, false, optimize_uniform_layout));
+	return compile(source, codegen.get());
+}
+
+static const reshadefx::uniform_info *find_uniform(const reshadefx::module &module, const std::string &name)
+{
+	const auto it = std::find_if(module.uniforms.begin(), module.uniforms.end(),
+		[&name](const reshadefx::uniform_info &info) { return info.name == name; });
+	return it != module.uniforms.end() ? &*it : nullptr;
+}
+
+// Names of the variables in the uniform block of the generated code, in declaration order, together with the rest of their declaration line
+static std::vector<std::pair<std::string, std::string>> uniform_block_declarations(const std::string &code, const std::string &block_start)
+{
+	std::vector<std::pair<std::string, std::string>> declarations;
+
+	size_t offset = code.find(block_start);
+	CHECK(offset != std::string::npos);
+	if (offset == std::string::npos)
+		return declarations;
+
+	for (offset = code.find('\n', offset) + 1; offset < code.size() && code[offset] == '\t';)
+	{
+		const size_t line_end = code.find('\n', offset);
+		const std::string line = code.substr(offset + 1, line_end - offset - 1);
+		offset = line_end + 1;
+
+		// Declarations look like "[row_major] type name[array] : packoffset(cN.x);"
+		const size_t name_start = line.find(' ', line.compare(0, 10, "row_major ") == 0 ? 10 : 0) + 1;
+		const size_t name_end = line.find_first_of("[ ;", name_start);
+		declarations.emplace_back(line.substr(name_start, name_end - name_start), line.substr(name_end));
+	}
+
+	return declarations;
+}
+
+// The rules from https://docs.microsoft.com/windows/win32/direct3dhlsl/dx-graphics-hlsl-packing-rules
+static void check_hlsl_packing_rules(const reshadefx::module &module)
+{
+	std::vector<std::pair<uint32_t, uint32_t>> ranges;
+
+	for (const reshadefx::uniform_info &info : module.uniforms)
+	{
+		CHECK(info.offset % 4 == 0);
+
+		// Arrays and matrices start at a new register, everything else may not cross a register boundary
+		if (info.type.is_array() || info.type.is_matrix())
+			CHECK(info.offset % 16 == 0);
+		else
+			CHECK(info.offset / 16 == (info.offset + info.size - 1) / 16);
+
+		CHECK(info.offset + info.size <= module.total_uniform_size);
+		ranges.emplace_back(info.offset, info.offset + info.size);
+	}
+
+	// Array elements are padded to a full register, but the last one is not, so variables can only overlap if they actually share memory
+	std::sort(ranges.begin(), ranges.end());
+	for (size_t i = 1; i < ranges.size(); ++i)
+		CHECK(ranges[i].first >= ranges[i - 1].second);
+}
+
+// Offsets in the generated code have to match those in the module, since those are used to fill the constant buffer
+static void check_hlsl_packoffsets(const reshadefx::module &module, bool expect_packoffsets)
+{
+	const auto declarations = uniform_block_declarations(module.hlsl, "cbuffer _Globals {");
+	CHECK(declarations.size() == module.uniforms.size());
+
+	for (size_t i = 0; i < declarations.size() && i < module.uniforms.size(); ++i)
+	{
+		const auto &[name, rest] = declarations[i];
+
+		// Declaration order is never changed, only the offsets
+		CHECK(name == module.uniforms[i].name);
+
+		const size_t packoffset = rest.find(" : packoffset(c");
+		CHECK((packoffset != std::string::npos) == expect_packoffsets);
+		if (packoffset == std::string::npos)
+			continue;
+
+		const char *const reg = rest.c_str() + packoffset + 15;
+		char *component = nullptr;
+		uint32_t offset = std::strtoul(reg, &component, 10) * 16;
+		if (*component == '.')
+			offset += static_cast<uint32_t>(std::string_view("xyzw").find(component[1])) * 4;
+
+		CHECK(offset == module.uniforms[i].offset);
+	}
+}
+
+// Variables in a std140 block are placed one after another in declaration order, so computing the layout from the generated code has to give the same offsets as in the module
+static void check_glsl_std140_layout(const reshadefx::module &module)
+{
+	const auto declarations = uniform_block_declarations(module.hlsl, "uniform _Globals {");
+	CHECK(declarations.size() == module.uniforms.size());
+
+	uint32_t offset = 0;
+	for (const auto &[name, rest] : declarations)
+	{
+		const reshadefx::uniform_info *const info = find_uniform(module, name);
+		CHECK(info != nullptr);
+		if (info == nullptr)
+			continue;
+
+		const uint32_t alignment = info->type.is_array() || info->type.is_matrix() ? 16 : (info->type.rows == 3 ? 4 : info->type.rows) * 4;
+		offset = (offset + alignment - 1) / alignment * alignment;
+
+		CHECK(info->offset == offset);
+		offset += info->size;
+	}
+
+	CHECK(offset == module.total_uniform_size);
+}
+
+static void test_vector_gaps()
+{
+	// Declaration order leaves a gap before 'Vec' and 'Col', which the smaller variables can fill
+	const std::string source =
+		"uniform float Alpha;\n"
+		"uniform float4 Vec;\n"
+		"uniform float Beta;\n"
+		"uniform float3 Col;\n";
+
+	{
+		const reshadefx::module module = compile_hlsl(source, true);
+		check_hlsl_packing_rules(module);
+		check_hlsl_packoffsets(module, true);
+
+		CHECK(find_uniform(module, "Vec")->offset == 0);
+		CHECK(find_uniform(module, "Col")->offset == 16);
+		CHECK(find_uniform(module, "Alpha")->offset == 28);
+		CHECK(find_uniform(module, "Beta")->offset == 32);
+		CHECK(module.total_uniform_size == 36);
+
+		CHECK(module.hlsl.find("\tfloat4 Vec : packoffset(c0);\n") != std::string::npos);
+		CHECK(module.hlsl.find("\tfloat3 Col : packoffset(c1);\n") != std::string::npos);
+		CHECK(module.hlsl.find("\tfloat Alpha : packoffset(c1.w);\n") != std::string::npos);
+		CHECK(module.hlsl.find("\tfloat Beta : packoffset(c2);\n") != std::string::npos);
+	}
+
+	{
+		const reshadefx::module module = compile_glsl(source, true);
+		check_glsl_std140_layout(module);
+
+		CHECK(find_uniform(module, "Vec")->offset == 0);
+		CHECK(find_uniform(module, "Col")->offset == 16);
+		CHECK(find_uniform(module, "Alpha")->offset == 28);
+		CHECK(find_uniform(module, "Beta")->offset == 32);
+		CHECK(module.total_uniform_size == 36);
+
+		const auto declarations = uniform_block_declarations(module.hlsl, "uniform _Globals {");
+		CHECK(declarations.size() == 4 &&
+			declarations[0].first == "Vec" && declarations[1].first == "Col" && declarations[2].first == "Alpha" && declarations[3].first == "Beta");
+	}
+
+	// Without the optimization the declaration order is kept
+	{
+		const reshadefx::module module = compile_hlsl(source, false);
+		check_hlsl_packing_rules(module);
+		check_hlsl_packoffsets(module, false);
+		CHECK(find_uniform(module, "Col")->offset == 36);
+		CHECK(module.total_uniform_size == 48);
+	}
+	{
+		const reshadefx::module module = compile_glsl(source, false);
+		check_glsl_std140_layout(module);
+		CHECK(find_uniform(module, "Col")->offset == 48);
+		CHECK(module.total_uniform_size == 60);
+	}
+}
+
+static void test_mixed_layout()
+{
+	// Arrays and matrices of different sizes mixed with scalars and vectors of all widths and base types
+	const std::string source =
+		"uniform float Alpha;\n"
+		"uniform float4 Vec;\n"
+		"uniform bool Enabled;\n"
+		"uniform float3 Col;\n"
+		"uniform float4x4 Mat;\n"
+		"uniform float Arr[3];\n"
+		"uniform int2 Pos;\n"
+		"uniform float3x3 Rot;\n"
+		"uniform uint Count;\n"
+		"uniform float2 Offsets[4];\n"
+		"uniform float2 Size;\n"
+		"uniform float3 Dir;\n"
+		"uniform float2x2 Small;\n"
+		"uniform int Mode;\n";
+
+	for (const bool optimize : { false, true })
+	{
+		const reshadefx::module hlsl = compile_hlsl(source, optimize);
+		check_hlsl_packing_rules(hlsl);
+		check_hlsl_packoffsets(hlsl, optimize);
+
+		const reshadefx::module glsl = compile_glsl(source, optimize);
+		check_glsl_std140_layout(glsl);
+
+		// Sizes do not depend on the layout
+		for (const reshadefx::uniform_info &info : hlsl.uniforms)
+			CHECK(info.size == find_uniform(compile_hlsl(source, !optimize), info.name)->size);
+		for (const reshadefx::uniform_info &info : glsl.uniforms)
+			CHECK(info.size == find_uniform(compile_glsl(source, !optimize), info.name)->size);
+	}
+
+	// Rearranging only happens when it makes the buffer smaller
+	CHECK(compile_hlsl(source, true).total_uniform_size < compile_hlsl(source, false).total_uniform_size);
+	CHECK(compile_glsl(source, true).total_uniform_size < compile_glsl(source, false).total_uniform_size);
+}
+
+static void test_layout_kept_if_not_smaller()
+{
+	// Already tightly packed, so there is nothing to gain
+	const std::string source =
+		"uniform float4x4 Mat;\n"
+		"uniform float3 Col;\n"
+		"uniform float Alpha;\n"
+		"uniform float2 Size;\n"
+		"uniform float2 Pos;\n";
+
+	{
+		const reshadefx::module module = compile_hlsl(source, true);
+		check_hlsl_packing_rules(module);
+		check_hlsl_packoffsets(module, false);
+		CHECK(find_uniform(module, "Alpha")->offset == 76);
+		CHECK(module.total_uniform_size == 96);
+	}
+	{
+		const reshadefx::module module = compile_glsl(source, true);
+		check_glsl_std140_layout(module);
+
+		const auto declarations = uniform_block_declarations(module.hlsl, "uniform _Globals {");
+		CHECK(declarations.size() == 5 && declarations[0].first == "Mat" && declarations[4].first == "Pos");
+		CHECK(module.total_uniform_size == 96);
+	}
+
+	// Shader model 3 assigns registers itself and is never rearranged
+	{
+		const reshadefx::module module = compile_hlsl("uniform float Alpha;\nuniform float4 Vec;\n", true, 30);
+		CHECK(module.hlsl.find("packoffset") == std::string::npos);
+		CHECK(module.hlsl.find("register(c") != std::string::npos);
+	}
+}
+
+int main()
+{
+	test_vector_gaps();
+	test_mixed_layout();
+	test_layout_kept_if_not_smaller();
+
+	return g_failed_checks != 0;
+}
@@ -30,6 +30,7 @@ Options:
   --glsl                    Print GLSL code for the previously specified entry point.
   --hlsl                    Print HLSL code for the previously specified entry point.
   --shader-model <value>    HLSL shader model version. Can be 30, 40, 41, 50, ...
+  --pack-uniforms           Rearrange uniform variables to reduce padding in the constant buffer and report the bytes saved (does not apply to HLSL with shader model 3).
 
   --width                   Value of the 'BUFFER_WIDTH' preprocessor macro.
   --height                  Value of the 'BUFFER_HEIGHT' preprocessor macro.
@@ -53,6 +54,7 @@ int main(int argc, char *argv[])
 	bool debug_info = false;
 	bool invert_y_axis = false;
 	bool spec_constants = false;
+	bool pack_uniforms = false;
 	unsigned int shader_model = 50;
 
 	reshadefx::parser parser;
@@ -101,6 +103,8 @@ int main(int argc, char *argv[])
 				invert_y_axis = true;
 			else if (0 == std::strcmp(arg, "--spec-constants"))
 				spec_constants = true;
+			else if (0 == std::strcmp(arg, "--pack-uniforms"))
+				pack_uniforms = true;
 
 			if (i + 1 >= argc)
 				continue;
@@ -158,13 +162,16 @@ int main(int argc, char *argv[])
 		return 0;
 	}
 
-	std::unique_ptr<reshadefx::codegen> backend;
-	if (print_glsl)
-		backend.reset(reshadefx::create_codegen_glsl(debug_info, spec_constants));
-	else if (print_hlsl)
-		backend.reset(reshadefx::create_codegen_hlsl(shader_model, debug_info, spec_constants));
-	else
-		backend.reset(reshadefx::create_codegen_spirv(true, debug_info, spec_constants, invert_y_axis));
+	const auto create_backend = [&](bool optimize_uniform_layout) -> reshadefx::codegen * {
+		if (print_glsl)
+			return reshadefx::create_codegen_glsl(debug_info, spec_constants, false, false, optimize_uniform_layout);
+		else if (print_hlsl)
+			return reshadefx::create_codegen_hlsl(shader_model, debug_info, spec_constants, optimize_uniform_layout);
+		else
+			return reshadefx::create_codegen_spirv(true, debug_info, spec_constants, false, invert_y_axis, optimize_uniform_layout);
+	};
+
+	const std::unique_ptr<reshadefx::codegen> backend(create_backend(pack_uniforms));
 
 	if (!parser.parse(pp.output(), backend.get()))
 	{
@@ -178,6 +185,19 @@ int main(int argc, char *argv[])
 	reshadefx::module module;
 	backend->write_result(module);
 
+	if (pack_uniforms)
+	{
+		// Compile again with the default layout to figure out how much space was saved
+		reshadefx::parser unpacked_parser;
+		const std::unique_ptr<reshadefx::codegen> unpacked_backend(create_backend(false));
+		unpacked_parser.parse(pp.output(), unpacked_backend.get());
+
+		reshadefx::module unpacked_module;
+		unpacked_backend->write_result(unpacked_module);
+
+		std::cout << "// Uniform buffer size: " << module.total_uniform_size << " bytes (" << (unpacked_module.total_uniform_size - module.total_uniform_size) << " bytes saved)" << std::endl;
+	}
+
 	if (print_glsl || print_hlsl)
 	{
 		std::cout << module.hlsl << std::endl;